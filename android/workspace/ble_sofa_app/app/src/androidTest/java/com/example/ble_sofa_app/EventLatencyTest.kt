@@ -0,0 +1,167 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: EventLatencyTest.tk
+-- Description: Event-to-UI latency of the BLE service updates: system
+--              broadcasts against a StateFlow collected on the main thread
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+package com.example.ble_sofa_app
+
+import android.content.BroadcastReceiver
+import android.content.Context
+import android.content.Intent
+import android.content.IntentFilter
+import android.os.Handler
+import android.os.HandlerThread
+import android.os.Looper
+import android.os.SystemClock
+import android.util.Log
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.platform.app.InstrumentationRegistry
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.cancel
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.launch
+import org.junit.After
+import org.junit.Assert.assertTrue
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.TimeUnit
+
+/**
+ * @brief The GATT callbacks are simulated by a background thread emitting
+ *        timestamped events; the latency is measured when the main thread
+ *        handles them, as the activity does
+ */
+@RunWith(AndroidJUnit4::class)
+class EventLatencyTest {
+    /** @brief Thread emitting the events, as the binder thread of the GATT callbacks */
+    private lateinit var thread : HandlerThread
+    private lateinit var handler : Handler
+
+    private val context : Context = InstrumentationRegistry.getInstrumentation().targetContext
+
+    @Before
+    fun setUp() {
+        thread = HandlerThread("EventLatencyTest")
+        thread.start()
+        handler = Handler(thread.looper)
+    }
+
+    @After
+    fun tearDown() {
+        thread.quitSafely()
+    }
+
+    /**
+     * @brief Emit the events from the background thread, one every EVENT_PERIOD_MS
+     * @param emit Emits one event with its timestamp
+     */
+    private fun emitEvents(emit: (Long) -> Unit) {
+        for (i in 0 until NB_EVENTS) {
+            handler.postDelayed({ emit(SystemClock.elapsedRealtimeNanos()) }, i * EVENT_PERIOD_MS)
+        }
+    }
+
+    /**
+     * @brief Median of the latencies (ns), logged with the 95th percentile
+     * @param name The delivery path
+     * @param latencies The latencies
+     */
+    private fun report(name: String, latencies: List<Long>) : Long {
+        val sorted = latencies.sorted()
+        val median = sorted[sorted.size / 2]
+        val p95 = sorted[sorted.size * 95 / 100]
+        Log.i(TAG, "$name: ${sorted.size} events, latency median %.3f ms, p95 %.3f ms, max %.3f ms"
+            .format(median / 1e6, p95 / 1e6, sorted.last() / 1e6))
+        return median
+    }
+
+    /**
+     * @brief Previous delivery: one system broadcast per event
+     */
+    private fun measureBroadcast() : Long {
+        val latencies : MutableList<Long> = mutableListOf()
+        val done = CountDownLatch(NB_EVENTS)
+        val receiver = object : BroadcastReceiver() {
+            override fun onReceive(context: Context, intent: Intent) {
+                latencies.add(SystemClock.elapsedRealtimeNanos() - intent.getLongExtra(EXTRA_TIMESTAMP, 0L))
+                done.countDown()
+            }
+        }
+        context.registerReceiver(receiver, IntentFilter(ACTION_EVENT), null, Handler(Looper.getMainLooper()))
+
+        emitEvents { timestampNs ->
+            context.sendBroadcast(Intent(ACTION_EVENT).setPackage(context.packageName).putExtra(EXTRA_TIMESTAMP, timestampNs))
+        }
+        assertTrue(done.await(10, TimeUnit.SECONDS))
+        context.unregisterReceiver(receiver)
+        return report("Broadcast", latencies)
+    }
+
+    /**
+     * @brief Current delivery: StateFlow collected on the main thread
+     */
+    private fun measureStateFlow() : Long {
+        val latencies : MutableList<Long> = mutableListOf()
+        val done = CountDownLatch(NB_EVENTS)
+        val flow = MutableStateFlow(ConnectionUpdate(BleService.STATE_DISCONNECTED, 0L))
+        val scope = CoroutineScope(Dispatchers.Main)
+        val started = CountDownLatch(1)
+        scope.launch {
+            started.countDown()
+            flow.collect { update ->
+                if (update.timestampNs != 0L) {
+                    latencies.add(SystemClock.elapsedRealtimeNanos() - update.timestampNs)
+                    done.countDown()
+                }
+            }
+        }
+        assertTrue(started.await(5, TimeUnit.SECONDS))
+
+        // Events spaced enough for each one to be collected: a StateFlow
+        // keeps only the latest value, as the UI needs
+        var state = BleService.STATE_CONNECTED
+        emitEvents { timestampNs ->
+            state = if (state == BleService.STATE_CONNECTED) BleService.STATE_READY else BleService.STATE_CONNECTED
+            flow.value = ConnectionUpdate(state, timestampNs)
+        }
+        assertTrue(done.await(10, TimeUnit.SECONDS))
+        scope.cancel()
+        return report("StateFlow", latencies)
+    }
+
+    @Test
+    fun stateFlowIsFasterThanBroadcast() {
+        val broadcastNs = measureBroadcast()
+        val flowNs = measureStateFlow()
+        assertTrue(flowNs < broadcastNs)
+    }
+
+    companion object {
+        private const val TAG = "EventLatencyTest"
+        private const val ACTION_EVENT = "com.example.ble_sofa_app.test.ACTION_EVENT"
+        private const val EXTRA_TIMESTAMP = "timestamp"
+        /** @brief Events every 5 ms, as telemetry notifications at a short connection interval */
+        private const val EVENT_PERIOD_MS = 5L
+        private const val NB_EVENTS = 200
+    }
+}
@@ -0,0 +1,202 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: GattQueueTest.tk
+-- Description: GATT queue under rapid input: serialization, coalescing,
+--              late completions and tap-to-write latency
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+package com.example.ble_sofa_app
+
+import android.bluetooth.BluetoothGattCharacteristic
+import android.os.Handler
+import android.os.HandlerThread
+import android.os.SystemClock
+import android.util.Log
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import org.junit.After
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.util.UUID
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.TimeUnit
+
+/**
+ * @brief The GATT stack is simulated: a write completes one connection event
+ *        after it starts, as onCharacteristicWrite() does for a write command
+ */
+@RunWith(AndroidJUnit4::class)
+class GattQueueTest {
+    /** @brief Thread running the queue, as the main thread does in BleService */
+    private lateinit var thread : HandlerThread
+    private lateinit var handler : Handler
+
+    /** @brief Operations started and maximum number in flight */
+    private val started : MutableList<ByteArray> = mutableListOf()
+    private var inFlight = 0
+    private var maxInFlight = 0
+
+    /** @brief Tap-to-write latencies (ns) */
+    private val latencies : MutableList<Long> = mutableListOf()
+
+    @Before
+    fun setUp() {
+        thread = HandlerThread("GattQueueTest")
+        thread.start()
+        handler = Handler(thread.looper)
+    }
+
+    @After
+    fun tearDown() {
+        thread.quitSafely()
+    }
+
+    /**
+     * @brief Queue over the simulated stack
+     */
+    private fun createQueue() : GattQueue {
+        lateinit var queue : GattQueue
+        queue = GattQueue(handler, { operation ->
+            inFlight++
+            maxInFlight = maxOf(maxInFlight, inFlight)
+            started.add((operation as GattOperation.Write).payload)
+            handler.postDelayed({
+                inFlight--
+                queue.complete(operation.uuid)
+            }, CONN_INTERVAL_MS)
+            true
+        })
+        queue.onStarted = { _, latencyNs -> latencies.add(latencyNs) }
+        return queue
+    }
+
+    /**
+     * @brief Wait until the queue is idle
+     */
+    private fun drain() {
+        val latch = CountDownLatch(1)
+        handler.postDelayed({ latch.countDown() }, 4 * CONN_INTERVAL_MS)
+        assertTrue(latch.await(5, TimeUnit.SECONDS))
+    }
+
+    @Test
+    fun writesAreSerialized() {
+        val queue = createQueue()
+        for (i in 0 until 20) {
+            queue.enqueue(GattOperation.Write(CONTROL_CHAR_UUID, byteArrayOf(i.toByte()), WRITE_TYPE, false))
+        }
+        drain()
+
+        // One write at a time, none lost, in order
+        assertEquals(1, maxInFlight)
+        assertEquals(20, started.size)
+        started.forEachIndexed { i, payload -> assertEquals(i.toByte(), payload[0]) }
+    }
+
+    @Test
+    fun rapidTapsAreCoalesced() {
+        val queue = createQueue()
+        var state = false
+        for (i in 0 until NB_TAPS) {
+            state = !state
+            queue.enqueue(GattOperation.Write(CONTROL_CHAR_UUID, byteArrayOf(if (state) 0x01 else 0x00), WRITE_TYPE, true))
+            Thread.sleep(TAP_PERIOD_MS)
+        }
+        drain()
+
+        // The last state is always sent, the superseded ones are not
+        assertEquals(1, maxInFlight)
+        assertArrayEquals(byteArrayOf(if (state) 0x01 else 0x00), started.last())
+        assertEquals(NB_TAPS, started.size + queue.nbCoalesced)
+        assertTrue(started.size < NB_TAPS)
+
+        // A tap waits at most for the write in flight
+        val sorted = latencies.sorted()
+        val medianMs = sorted[sorted.size / 2] / 1e6
+        val p95Ms = sorted[sorted.size * 95 / 100] / 1e6
+        Log.i(TAG, "$NB_TAPS taps every $TAP_PERIOD_MS ms: ${started.size} writes, " +
+                "latency median %.2f ms, p95 %.2f ms, max %.2f ms".format(medianMs, p95Ms, sorted.last() / 1e6))
+        assertTrue(p95Ms < 2 * CONN_INTERVAL_MS)
+    }
+
+    @Test
+    fun lateCompletionIsIgnored() {
+        // The first write never completes in time, the next ones complete one
+        // connection event after they start
+        val startedNs : MutableList<Long> = mutableListOf()
+        lateinit var queue : GattQueue
+        queue = GattQueue(handler, { operation ->
+            startedNs.add(SystemClock.elapsedRealtimeNanos())
+            if (startedNs.size > 1) {
+                handler.postDelayed({ queue.complete(operation.uuid) }, CONN_INTERVAL_MS)
+            }
+            true
+        }, TIMEOUT_MS)
+        for (i in 0 until 3) {
+            queue.enqueue(GattOperation.Write(CONTROL_CHAR_UUID, byteArrayOf(i.toByte()), WRITE_TYPE, false))
+        }
+
+        // The completion of the first write arrives while the queue thread is
+        // busy, and is handled after the timeout has started the second one
+        val blocked = CountDownLatch(1)
+        handler.post {
+            blocked.countDown()
+            Thread.sleep(2 * TIMEOUT_MS)
+        }
+        assertTrue(blocked.await(5, TimeUnit.SECONDS))
+        Thread.sleep(TIMEOUT_MS + CONN_INTERVAL_MS)
+        queue.complete(CONTROL_CHAR_UUID)
+        drain()
+
+        // The second write is completed by its own callback, not by the late one
+        assertEquals(3, startedNs.size)
+        assertTrue(startedNs[2] - startedNs[1] >= TimeUnit.MILLISECONDS.toNanos(CONN_INTERVAL_MS))
+    }
+
+    @Test
+    fun completionReportsTheLatestTap() {
+        val queue = createQueue()
+        val completed : MutableList<Pair<String?, Long>> = mutableListOf()
+        queue.onCompleted = { operation, latencyNs -> completed.add(Pair((operation as GattOperation.Write).source, latencyNs)) }
+        for (source in listOf(BleService.SOURCE_ACTIVITY, BleService.SOURCE_TILE, BleService.SOURCE_TILE)) {
+            queue.enqueue(GattOperation.Write(CONTROL_CHAR_UUID, byteArrayOf(0x01), WRITE_TYPE, true, source))
+        }
+        drain()
+
+        // The first write is in flight, the two tile taps are sent as one
+        assertEquals(listOf(BleService.SOURCE_ACTIVITY, BleService.SOURCE_TILE), completed.map { it.first })
+        // A tap completes at least one connection event later
+        assertTrue(completed.all { it.second >= TimeUnit.MILLISECONDS.toNanos(CONN_INTERVAL_MS) })
+    }
+
+    companion object {
+        private const val TAG = "GattQueueTest"
+        /** @brief Connection interval of the simulated link */
+        private const val CONN_INTERVAL_MS = 15L
+        /** @brief Rapid input: one tap every 5 ms */
+        private const val TAP_PERIOD_MS = 5L
+        private const val NB_TAPS = 200
+        /** @brief Completion timeout of the queue */
+        private const val TIMEOUT_MS = 50L
+        private const val WRITE_TYPE = BluetoothGattCharacteristic.WRITE_TYPE_NO_RESPONSE
+        private val CONTROL_CHAR_UUID : UUID = BleService.CONTROL_CHAR_UUID
+    }
+}
@@ -0,0 +1,117 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: LatencyBenchmarkTest.tk
+-- Description: Latency benchmark against a simulated sofa: acknowledgement
+--              matching, dropped commands and CSV export
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+package com.example.ble_sofa_app
+
+import android.os.Handler
+import android.os.HandlerThread
+import android.os.SystemClock
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import org.junit.After
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.TimeUnit
+
+/**
+ * @brief The sofa is simulated: each command frame is acknowledged by a
+ *        telemetry notification ACK_DELAY_MS later, unless it is lost
+ */
+@RunWith(AndroidJUnit4::class)
+class LatencyBenchmarkTest {
+    /** @brief Thread running the benchmark, as the main thread does in BenchmarkActivity */
+    private lateinit var thread : HandlerThread
+    private lateinit var handler : Handler
+
+    @Before
+    fun setUp() {
+        thread = HandlerThread("LatencyBenchmarkTest")
+        thread.start()
+        handler = Handler(thread.looper)
+    }
+
+    @After
+    fun tearDown() {
+        thread.quitSafely()
+    }
+
+    /**
+     * @brief Run a benchmark to its end
+     * @param config The settings
+     * @param lost Returns true if the acknowledgement of a sequence number is lost
+     */
+    private fun run(config: BenchmarkConfig, lost: (Int) -> Boolean) : BenchmarkResult {
+        lateinit var benchmark : LatencyBenchmark
+        var result : BenchmarkResult? = null
+        val done = CountDownLatch(1)
+        benchmark = LatencyBenchmark(handler, config) { sequence, _ ->
+            handler.postDelayed({ benchmark.onWritten(sequence, SystemClock.elapsedRealtimeNanos()) }, WRITE_DELAY_MS)
+            if (!lost(sequence)) {
+                handler.postDelayed({ benchmark.onAck(sequence, SystemClock.elapsedRealtimeNanos()) }, ACK_DELAY_MS)
+            }
+            true
+        }
+        benchmark.onFinished = { finished ->
+            result = finished
+            done.countDown()
+        }
+        benchmark.start()
+        assertTrue(done.await(30, TimeUnit.SECONDS))
+        return result!!
+    }
+
+    @Test
+    fun latencyAndDroppedCommands() {
+        val config = BenchmarkConfig(nbCommands = 100, periodMs = 10, timeoutMs = 200)
+        val result = run(config) { sequence -> sequence % 10 == 0 }
+
+        assertEquals(100, result.samples.size)
+        assertEquals(10, result.nbDropped)
+        assertTrue(result.percentile(0) >= TimeUnit.MILLISECONDS.toNanos(ACK_DELAY_MS))
+        assertTrue(result.percentile(50) < TimeUnit.MILLISECONDS.toNanos(ACK_DELAY_MS + 20))
+        assertTrue(result.samples.all { it.writtenNs != 0L })
+
+        // Settings, summary and header comment lines, column names, one line per command
+        val lines = result.toCsv(listOf("device=test")).trim().lines()
+        assertEquals(4 + 100, lines.size)
+        assertEquals("index,sequence,command,request_ms,write_ms,ack_ms,latency_ms", lines[3])
+        assertTrue(lines[4 + 9].endsWith(","))
+    }
+
+    @Test
+    fun switchingEndsOnStop() {
+        val config = BenchmarkConfig(nbCommands = 5, periodMs = 5, switchRelay = true, timeoutMs = 100)
+        val result = run(config) { false }
+
+        assertEquals(listOf(BleService.COMMAND_UP, BleService.COMMAND_STOP, BleService.COMMAND_UP,
+            BleService.COMMAND_STOP, BleService.COMMAND_STOP), result.samples.map { it.command })
+    }
+
+    companion object {
+        /** @brief Write completion and acknowledgement delays of the simulated link */
+        private const val WRITE_DELAY_MS = 2L
+        private const val ACK_DELAY_MS = 15L
+    }
+}
@@ -0,0 +1,154 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: OptimisticRelayStateTest.tk
+-- Description: Optimistic relay state: confirmation, rollback on a different
+--              firmware state and on a missing acknowledgement
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+package com.example.ble_sofa_app
+
+import android.os.Handler
+import android.os.HandlerThread
+import android.os.SystemClock
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import org.junit.After
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.TimeUnit
+
+/**
+ * @brief The model runs on its own thread, as on the UI thread in MainActivity
+ */
+@RunWith(AndroidJUnit4::class)
+class OptimisticRelayStateTest {
+    private lateinit var thread : HandlerThread
+    private lateinit var handler : Handler
+    private lateinit var model : OptimisticRelayState
+
+    /** @brief Displayed states, in order */
+    private val shown : MutableList<Int> = mutableListOf()
+    private var nbResyncs = 0
+
+    @Before
+    fun setUp() {
+        thread = HandlerThread("OptimisticRelayStateTest")
+        thread.start()
+        handler = Handler(thread.looper)
+        model = OptimisticRelayState(handler, TIMEOUT_MS)
+        model.onChanged = { state -> shown.add(state) }
+        model.onTimeout = { nbResyncs++ }
+    }
+
+    @After
+    fun tearDown() {
+        thread.quitSafely()
+    }
+
+    /**
+     * @brief Run on the model thread after a delay, and wait for it
+     */
+    private fun onModel(delayMs: Long = 0, block: () -> Unit) {
+        val latch = CountDownLatch(1)
+        handler.postDelayed({
+            block()
+            latch.countDown()
+        }, delayMs)
+        assertTrue(latch.await(5, TimeUnit.SECONDS))
+    }
+
+    @Test
+    fun predictionConfirmed() {
+        onModel { model.onFirmwareState(STOP, -1, SystemClock.elapsedRealtimeNanos()) }
+        onModel { model.predict(UP, 7) }
+        // Notification of an older frame: the prediction stays
+        onModel(5) { model.onFirmwareState(STOP, 6, SystemClock.elapsedRealtimeNanos()) }
+        assertEquals(UP, model.displayed)
+        onModel(10) { model.onFirmwareState(UP, 7, SystemClock.elapsedRealtimeNanos()) }
+
+        assertEquals(listOf(STOP, UP), shown)
+        assertEquals(1, model.nbConfirmed)
+        assertEquals(0, model.nbMismatches)
+    }
+
+    @Test
+    fun rollbackOnFirmwareState() {
+        // Up refused at the end-stop: the firmware keeps Stop
+        onModel { model.onFirmwareState(STOP, -1, SystemClock.elapsedRealtimeNanos()) }
+        onModel { model.predict(UP, 8) }
+        onModel(10) { model.onFirmwareState(STOP, 8, SystemClock.elapsedRealtimeNanos()) }
+
+        assertEquals(listOf(STOP, UP, STOP), shown)
+        assertEquals(1, model.nbMismatches)
+    }
+
+    @Test
+    fun rollbackOnTimeout() {
+        onModel { model.onFirmwareState(STOP, -1, SystemClock.elapsedRealtimeNanos()) }
+        onModel { model.predict(UP, 9) }
+        onModel(2 * TIMEOUT_MS) { }
+
+        assertEquals(listOf(STOP, UP, STOP), shown)
+        assertEquals(1, model.nbTimeouts)
+        assertEquals(1, nbResyncs)
+
+        // A late acknowledgement only updates the firmware state
+        onModel { model.onFirmwareState(UP, 9, SystemClock.elapsedRealtimeNanos()) }
+        assertEquals(UP, model.displayed)
+        assertEquals(0, model.nbConfirmed)
+    }
+
+    @Test
+    fun newerTapSupersedes() {
+        onModel { model.onFirmwareState(STOP, -1, SystemClock.elapsedRealtimeNanos()) }
+        onModel { model.predict(UP, 10) }
+        onModel { model.predict(STOP, 11) }
+        // The first frame was coalesced before being sent: only the last one is acknowledged
+        onModel(10) { model.onFirmwareState(STOP, 11, SystemClock.elapsedRealtimeNanos()) }
+
+        assertEquals(listOf(STOP, UP, STOP), shown)
+        assertEquals(1, model.nbConfirmed)
+        assertEquals(0, model.nbTimeouts)
+    }
+
+    @Test
+    fun relaysCompared() {
+        // Down applied with the hold-to-run bit: both relays match
+        onModel { model.onFirmwareState(STOP, -1, SystemClock.elapsedRealtimeNanos()) }
+        onModel { model.predict(DOWN, 12) }
+        onModel(10) { model.onFirmwareState(DOWN or HOLD_TO_RUN, 12, SystemClock.elapsedRealtimeNanos()) }
+        assertEquals(1, model.nbConfirmed)
+
+        // Up overridden by the wired Down button: rolled back to Relay2
+        onModel { model.predict(UP, 13) }
+        onModel(10) { model.onFirmwareState(DOWN, 13, SystemClock.elapsedRealtimeNanos()) }
+        assertEquals(listOf(STOP, DOWN, DOWN or HOLD_TO_RUN, UP, DOWN), shown)
+        assertEquals(1, model.nbMismatches)
+    }
+
+    companion object {
+        private const val STOP = BleService.COMMAND_STOP
+        private const val UP = BleService.COMMAND_UP
+        private const val DOWN = BleService.COMMAND_DOWN
+        private const val HOLD_TO_RUN = 0x80
+        private const val TIMEOUT_MS = 100L
+    }
+}
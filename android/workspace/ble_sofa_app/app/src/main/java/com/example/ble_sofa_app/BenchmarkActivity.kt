@@ -0,0 +1,209 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: BenchmarkActivity.tk
+-- Description: Latency benchmark screen: settings, results and CSV export
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+package com.example.ble_sofa_app
+
+import android.content.ComponentName
+import android.content.Context
+import android.content.Intent
+import android.content.ServiceConnection
+import android.os.Build
+import android.os.Bundle
+import android.os.Handler
+import android.os.IBinder
+import android.os.Looper
+import android.util.Log
+import android.widget.Button
+import android.widget.CheckBox
+import android.widget.EditText
+import android.widget.TextView
+import androidx.activity.ComponentActivity
+import androidx.lifecycle.Lifecycle
+import androidx.lifecycle.lifecycleScope
+import androidx.lifecycle.repeatOnLifecycle
+import kotlinx.coroutines.launch
+import java.io.File
+import java.io.IOException
+import java.text.SimpleDateFormat
+import java.util.Date
+import java.util.Locale
+
+class BenchmarkActivity : ComponentActivity() {
+    /** @brief Bound BLE service */
+    private var bleService : BleService? = null
+
+    /** @brief Benchmark in progress, null if none */
+    private var benchmark : LatencyBenchmark? = null
+
+    /** @brief Last result, for the export */
+    private var result : BenchmarkResult? = null
+
+    //--------------------------------
+    // Activity life cycle
+    //--------------------------------
+
+    override fun onCreate(savedInstanceState: Bundle?) {
+        super.onCreate(savedInstanceState)
+        setContentView(R.layout.activity_benchmark)
+
+        val startButton = findViewById<Button>(R.id.benchmarkStartBtn)
+        startButton.setOnClickListener {
+            if (benchmark?.running == true) {
+                benchmark?.stop()
+            }
+            else {
+                startBenchmark()
+            }
+        }
+
+        val exportButton = findViewById<Button>(R.id.benchmarkExportBtn)
+        exportButton.isEnabled = false
+        exportButton.setOnClickListener { exportResult() }
+
+        // Bind with the service
+        if (!bindService(Intent(this, BleService::class.java), serviceConnection, Context.BIND_AUTO_CREATE)) {
+            Log.d(TAG, "Failed to bind GATT service")
+        }
+    }
+
+    override fun onResume() {
+        super.onResume()
+        // Measured at the connection priority of the control screen
+        bleService?.setControlActive(true)
+    }
+
+    override fun onPause() {
+        super.onPause()
+        bleService?.setControlActive(false)
+    }
+
+    override fun onStop() {
+        super.onStop()
+        // The acknowledgements are only collected while the screen is visible
+        benchmark?.stop()
+    }
+
+    override fun onDestroy() {
+        benchmark?.stop()
+        bleService?.onFrameWritten = null
+        unbindService(serviceConnection)
+        super.onDestroy()
+    }
+
+    //--------------------------------
+    // Benchmark
+    //--------------------------------
+
+    /**
+     * @brief Read the settings and start the benchmark over the current connection
+     */
+    private fun startBenchmark() {
+        val service = bleService ?: return
+        val status = findViewById<TextView>(R.id.benchmarkResult)
+        if (service.getConnectionState() != BleService.STATE_READY) {
+            status.setText(R.string.benchmark_not_connected)
+            return
+        }
+
+        val config = BenchmarkConfig(
+            nbCommands = findViewById<EditText>(R.id.benchmarkCount).text.toString().toIntOrNull()?.coerceIn(1, MAX_COMMANDS) ?: DEFAULT_COMMANDS,
+            periodMs = findViewById<EditText>(R.id.benchmarkPeriod).text.toString().toLongOrNull()?.coerceAtLeast(MIN_PERIOD_MS) ?: DEFAULT_PERIOD_MS,
+            switchRelay = findViewById<CheckBox>(R.id.benchmarkSwitchRelay).isChecked,
+            label = findViewById<EditText>(R.id.benchmarkLabel).text.toString().trim()
+        )
+        val run = LatencyBenchmark(Handler(Looper.getMainLooper()), config) { sequence, command ->
+            service.sendCommandFrame(sequence, command, BleService.SOURCE_BENCHMARK)
+        }
+        run.onProgress = { sent -> status.text = getString(R.string.benchmark_progress, sent, config.nbCommands) }
+        run.onFinished = { finished ->
+            Log.i(TAG, finished.summary())
+            status.text = finished.summary()
+            result = finished
+            benchmark = null
+            findViewById<Button>(R.id.benchmarkStartBtn).setText(R.string.benchmark_start)
+            findViewById<Button>(R.id.benchmarkExportBtn).isEnabled = true
+        }
+        service.onFrameWritten = run::onWritten
+        benchmark = run
+        findViewById<Button>(R.id.benchmarkStartBtn).setText(R.string.benchmark_stop)
+        run.start()
+    }
+
+    /**
+     * @brief Write the last result as CSV in the application files
+     *        (adb pull /sdcard/Android/data/com.example.ble_sofa_app/files/)
+     */
+    private fun exportResult() {
+        val finished = result ?: return
+        val date = SimpleDateFormat("yyyyMMdd_HHmmss", Locale.US).format(Date())
+        val label = finished.config.label.replace(Regex("[^A-Za-z0-9_-]"), "_")
+        val file = File(getExternalFilesDir(null), if (label.isEmpty()) "benchmark_$date.csv" else "benchmark_${date}_$label.csv")
+        val header = listOf("date=$date", "device=${Build.MANUFACTURER} ${Build.MODEL}", "android=${Build.VERSION.SDK_INT}")
+        try {
+            file.writeText(finished.toCsv(header))
+            Log.i(TAG, "Benchmark exported: ${file.absolutePath}")
+            findViewById<TextView>(R.id.benchmarkResult).text = "${finished.summary()}\n${file.absolutePath}"
+        } catch (exception: IOException) {
+            Log.w(TAG, "Benchmark export failed: ${exception.message}")
+        }
+    }
+
+    //--------------------------------
+    // BLE service
+    //--------------------------------
+
+    /**
+     * @brief Service connection: the acknowledgements come from the telemetry notifications
+     */
+    private val serviceConnection : ServiceConnection = object : ServiceConnection {
+        override fun onServiceConnected(componentName: ComponentName, service: IBinder) {
+            val bluetooth = (service as BleService.LocalBinder).getService()
+            bleService = bluetooth
+            bluetooth.setControlActive(lifecycle.currentState.isAtLeast(Lifecycle.State.RESUMED))
+            lifecycleScope.launch {
+                repeatOnLifecycle(Lifecycle.State.STARTED) {
+                    bluetooth.notifications.collect { notification ->
+                        if (notification.uuid != BleService.TELEMETRY_CHAR_UUID) { return@collect }
+                        val update = BleService.decodeTelemetry(notification.value, notification.timestampNs) ?: return@collect
+                        if (update.ack >= 0) {
+                            benchmark?.onAck(update.ack, update.timestampNs)
+                        }
+                    }
+                }
+            }
+        }
+
+        override fun onServiceDisconnected(componentName: ComponentName) {
+            bleService = null
+        }
+    }
+
+    companion object {
+        /** @brief Debug TAG */
+        private const val TAG = "BenchmarkActivity"
+        /** @brief Default settings and limits: the sequence numbers of the
+         *         commands waiting for their acknowledgement must not wrap */
+        private const val DEFAULT_COMMANDS = 200
+        private const val MAX_COMMANDS = 10000
+        private const val DEFAULT_PERIOD_MS = 100L
+        private const val MIN_PERIOD_MS = 5L
+    }
+}
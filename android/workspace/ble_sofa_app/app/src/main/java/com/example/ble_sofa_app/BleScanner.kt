@@ -15,7 +15,7 @@
 -- File Name: BleScanner.tk
 -- Description: Class used to perform BLE scanning
 --
--- Last update: 2023-09-09
+-- Last update: 2026-10-18
 --
 -------------------------------------------------------------------------------*/
 
@@ -25,10 +25,12 @@ import android.bluetooth.BluetoothAdapter
 import android.bluetooth.BluetoothDevice
 import android.bluetooth.BluetoothManager
 import android.bluetooth.le.ScanCallback
+import android.bluetooth.le.ScanFilter
 import android.bluetooth.le.ScanResult
 import android.bluetooth.le.ScanSettings
 import android.content.Context
 import android.os.Handler
+import android.os.ParcelUuid
 import android.util.Log
 
 /**
@@ -78,7 +80,9 @@ class BleScanner(val activity: MainActivity, private val handler: Handler) {
     }
 
     /**
-     * @brief Start the scanning process, scan for 10 seconds
+     * @brief Start the scanning process, scan for 10 seconds: only the devices
+     *        advertising the control service are reported, the controller
+     *        matching the filter when it supports offloaded filtering
      */
     fun startScan() {
         if (!blePermission.checkBlePermission(activity)) {
@@ -89,14 +93,19 @@ class BleScanner(val activity: MainActivity, private val handler: Handler) {
         val scanSettings = ScanSettings.Builder()
             .setScanMode(ScanSettings.SCAN_MODE_LOW_LATENCY)
             .build()
+        val scanFilters = listOf(
+            ScanFilter.Builder()
+                .setServiceUuid(ParcelUuid(BleService.CONTROL_SERVICE_UUID))
+                .build()
+        )
 
         // Scan for 10 seconds
         handler.postDelayed({
             stopScan()
         }, 10000)
 
-        bluetoothAdapter?.bluetoothLeScanner?.startScan(null, scanSettings, scanCallback)
-        Log.d(TAG, "BLE scanning started...")
+        bluetoothAdapter?.bluetoothLeScanner?.startScan(scanFilters, scanSettings, scanCallback)
+        Log.d(TAG, "BLE scanning started, offloaded filtering: ${bluetoothAdapter?.isOffloadedFilteringSupported}")
     }
 
     /**
@@ -13,28 +13,70 @@
 -- Project Name: BLE Sofa Application
 -- Version: 0.1.0
 -- File Name: BleService.tk
--- Description: Class used to manage BLE operations
+-- Description: Class used to manage BLE operations, optionally kept connected
+--              as a foreground service for the tiles and the widget
 --
--- Last update: 2023-09-09
+-- Last update: 2026-10-18
 --
 -------------------------------------------------------------------------------*/
 
 package com.example.ble_sofa_app
 
+import android.app.NotificationChannel
+import android.app.NotificationManager
+import android.app.PendingIntent
 import android.app.Service
 import android.bluetooth.BluetoothAdapter
+import android.bluetooth.BluetoothDevice
 import android.bluetooth.BluetoothGatt
 import android.bluetooth.BluetoothGattCallback
-import android.bluetooth.BluetoothGattService
+import android.bluetooth.BluetoothGattCharacteristic
+import android.bluetooth.BluetoothGattDescriptor
 import android.bluetooth.BluetoothProfile
+import android.content.Context
 import android.content.Intent
+import android.content.pm.ServiceInfo
 import android.os.Binder
+import android.os.Build
 import android.os.Handler
 import android.os.IBinder
 import android.os.Looper
+import android.os.SystemClock
 import android.util.Log
+import androidx.core.app.NotificationCompat
+import kotlinx.coroutines.channels.BufferOverflow
+import kotlinx.coroutines.flow.MutableSharedFlow
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.SharedFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asSharedFlow
+import kotlinx.coroutines.flow.asStateFlow
 import java.util.UUID
 
+/**
+ * @brief Connection state update
+ * @param state STATE_DISCONNECTED, STATE_CONNECTED or STATE_READY
+ * @param timestampNs Time of the GATT event (SystemClock.elapsedRealtimeNanos)
+ */
+data class ConnectionUpdate(val state: Int, val timestampNs: Long)
+
+/**
+ * @brief Relay state reported by the telemetry notifications
+ * @param state The applied command byte: bits [1:0] relays, bit [7] hold-to-run
+ * @param endstop The end-stop status, -1 if not reported
+ * @param ack Sequence number of the last command frame received, -1 if not reported
+ * @param timestampNs Time of the notification (SystemClock.elapsedRealtimeNanos)
+ */
+data class RelayUpdate(val state: Int, val endstop: Int, val ack: Int, val timestampNs: Long)
+
+/**
+ * @brief Characteristic notification
+ * @param uuid The UUID of the characteristic
+ * @param value The notified value
+ * @param timestampNs Time of the notification (SystemClock.elapsedRealtimeNanos)
+ */
+class Notification(val uuid: UUID, val value: ByteArray, val timestampNs: Long)
+
 /**
  * @brief BLE Android service
  */
@@ -63,17 +105,269 @@ class BleService : Service() {
     private var blePermission : BlePermissions = BlePermissions()
 
     /** @brief Bluetooth connection state */
-    private var connectionState = STATE_DISCONNECTED
+    private val connectionFlow = MutableStateFlow(ConnectionUpdate(STATE_DISCONNECTED, 0L))
+
+    /** @brief Relay state, null until the first telemetry notification */
+    private val relayFlow = MutableStateFlow<RelayUpdate?>(null)
+
+    /** @brief Notifications, emitted from the GATT callback thread without suspending */
+    private val notificationFlow = MutableSharedFlow<Notification>(extraBufferCapacity = 16, onBufferOverflow = BufferOverflow.DROP_OLDEST)
+
+    /** @brief BLE runtime permissions needed */
+    private val permissionFlow = MutableSharedFlow<Unit>(extraBufferCapacity = 1, onBufferOverflow = BufferOverflow.DROP_OLDEST)
+
+    /** @brief Characteristics of the connected device, resolved once after the discovery */
+    private val characteristics : HashMap<UUID, BluetoothGattCharacteristic> = HashMap()
+
+    /** @brief GATT operations, one at a time, run on the main thread */
+    private val gattQueue = GattQueue(Handler(Looper.getMainLooper()), ::startOperation).apply {
+        onCompleted = { operation, latencyNs ->
+            if (operation is GattOperation.Write) {
+                if (operation.source == SOURCE_BENCHMARK) {
+                    onFrameWritten?.invoke(operation.payload[1].toInt() and 0xFF, SystemClock.elapsedRealtimeNanos())
+                }
+                else {
+                    operation.source?.let { source -> recordTapLatency(source, latencyNs) }
+                }
+            }
+        }
+    }
+
+    /** @brief Control screen in the foreground: the connection is tuned for latency */
+    private var controlActive = false
+
+    /** @brief Connection priority last requested, -1 if none */
+    private var connectionPriority = -1
+
+    /** @brief Main thread handler */
+    private val mainHandler = Handler(Looper.getMainLooper())
+
+    /** @brief Connection kept in the background, reconnected when lost */
+    private var keepConnected = false
+
+    /** @brief Service running in the foreground, with its notification */
+    private var foreground = false
+
+    /** @brief STOP requested before the connection was ready */
+    private class PendingCommand(val command: Int, val source: String, val tapNs: Long)
+    private var pendingCommand : PendingCommand? = null
+
+    /** @brief Sequence number of the last command frame, 1 to 255 */
+    private var commandSequence = 0
+
+    /** @brief Last tap-to-write latencies (ns) per command source */
+    private val tapLatencies : HashMap<String, ArrayDeque<Long>> = HashMap()
+
+    /** @brief Leave the foreground once the tile or widget commands are idle */
+    private val idleStop = Runnable {
+        if (!keepConnected) {
+            leaveForeground()
+            stopSelf()
+        }
+    }
+
+    //----------------------------------------------------------------
+    // Public variables
+    //----------------------------------------------------------------
+    /** @brief Connection state, with the time of the GATT event */
+    val connection : StateFlow<ConnectionUpdate> = connectionFlow.asStateFlow()
+
+    /** @brief Relay state from the telemetry notifications, null when unknown */
+    val relayState : StateFlow<RelayUpdate?> = relayFlow.asStateFlow()
+
+    /** @brief All the characteristic notifications */
+    val notifications : SharedFlow<Notification> = notificationFlow.asSharedFlow()
+
+    /** @brief BLE runtime permissions to request */
+    val permissionRequests : SharedFlow<Unit> = permissionFlow.asSharedFlow()
+
+    /** @brief Called on the main thread when a benchmark command frame is written,
+     *         with its sequence number and the time of the write completion */
+    var onFrameWritten : ((Int, Long) -> Unit)? = null
 
     //----------------------------------------------------------------
     // Private functions
     //----------------------------------------------------------------
     /**
-     * @brief Send a message to the activity via an intent
+     * @brief Publish a connection state, with the time of the GATT event
+     */
+    private fun updateConnection(state: Int) {
+        connectionFlow.value = ConnectionUpdate(state, SystemClock.elapsedRealtimeNanos())
+    }
+
+    /**
+     * @brief Ask the activity to request the BLE runtime permissions
+     */
+    private fun requestPermissions() {
+        permissionFlow.tryEmit(Unit)
+    }
+
+    /**
+     * @brief Log the tap-to-write latency of a motion command: from the tap
+     *        to the completion of its write, for each command source
+     * @param source The command source (SOURCE_*)
+     * @param latencyNs The latency
+     */
+    private fun recordTapLatency(source: String, latencyNs: Long) {
+        val latencies = tapLatencies.getOrPut(source) { ArrayDeque() }
+        latencies.addLast(latencyNs)
+        if (latencies.size > NB_TAP_LATENCIES) { latencies.removeFirst() }
+        val sorted = latencies.sorted()
+        Log.i(TAG, "Tap to write ($source): %.1f ms, median %.1f ms over %d taps"
+            .format(latencyNs / 1e6, sorted[sorted.size / 2] / 1e6, sorted.size))
+    }
+
+    /**
+     * @brief Send the STOP requested while connecting, unless it is too old
+     *        to still match the user intent
+     */
+    private fun flushPendingCommand() {
+        val command = pendingCommand ?: return
+        pendingCommand = null
+        if (SystemClock.elapsedRealtimeNanos() - command.tapNs < PENDING_COMMAND_TIMEOUT_NS) {
+            sendCommand(command.command, command.source, command.tapNs)
+        }
+        else {
+            Log.w(TAG, "Command ${command.command} from ${command.source} dropped: connection too slow")
+        }
+    }
+
+    /**
+     * @brief Run in the foreground with a notification, so the connection
+     *        survives the activity; called on each start request, as each
+     *        startForegroundService() expects a startForeground()
+     */
+    private fun enterForeground() {
+        mainHandler.removeCallbacks(idleStop)
+
+        val manager = getSystemService(Context.NOTIFICATION_SERVICE) as NotificationManager
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
+            manager.createNotificationChannel(NotificationChannel(CHANNEL_ID, getString(R.string.channel_name), NotificationManager.IMPORTANCE_LOW))
+        }
+        val notification = NotificationCompat.Builder(this, CHANNEL_ID)
+            .setSmallIcon(R.drawable.ic_sofa)
+            .setContentTitle(getString(R.string.notification_title))
+            .setContentText(getString(R.string.notification_text))
+            .setOngoing(true)
+            .addAction(0, getString(R.string.command_stop), commandIntent(this, COMMAND_STOP, SOURCE_NOTIFICATION))
+            .addAction(0, getString(R.string.disconnect), PendingIntent.getService(this, 0,
+                Intent(this, BleService::class.java).setAction(ACTION_STOP_FOREGROUND), PendingIntent.FLAG_IMMUTABLE))
+            .build()
+
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) {
+            startForeground(NOTIFICATION_ID, notification, ServiceInfo.FOREGROUND_SERVICE_TYPE_CONNECTED_DEVICE)
+        }
+        else {
+            startForeground(NOTIFICATION_ID, notification)
+        }
+        foreground = true
+    }
+
+    /**
+     * @brief Back to a bound service: the connection is closed with the last client
      */
-    private fun broadcastUpdate(action: String) {
-        val intent = Intent(action)
-        sendBroadcast(intent)
+    private fun leaveForeground() {
+        mainHandler.removeCallbacks(idleStop)
+        if (foreground) {
+            stopForeground(STOP_FOREGROUND_REMOVE)
+            foreground = false
+        }
+    }
+
+    /**
+     * @brief Start a queued GATT operation on its cached characteristic
+     * @param operation The operation
+     * @return true if the operation was started, its completion callback follows
+     */
+    private fun startOperation(operation: GattOperation) : Boolean {
+        val gatt = bluetoothGatt ?: return false
+        val characteristic = characteristics[operation.uuid] ?: run {
+            Log.w(TAG, "Characteristic not found: ${operation.uuid}")
+            return false
+        }
+
+        // Check and get permissions
+        if (!blePermission.checkBlePermission(this)) {
+            Log.w(TAG, "Bluetooth permissions requested")
+            requestPermissions()
+            return false
+        }
+
+        return when (operation) {
+            is GattOperation.Write -> {
+                characteristic.writeType = operation.writeType
+                characteristic.value = operation.payload
+                gatt.writeCharacteristic(characteristic)
+            }
+            is GattOperation.Read -> gatt.readCharacteristic(characteristic)
+            is GattOperation.EnableNotifications -> {
+                val descriptor = characteristic.getDescriptor(CLIENT_CONFIGURATION_UUID) ?: return false
+                gatt.setCharacteristicNotification(characteristic, true)
+                descriptor.value = BluetoothGattDescriptor.ENABLE_NOTIFICATION_VALUE
+                gatt.writeDescriptor(descriptor)
+            }
+        }
+    }
+
+    /**
+     * @brief Connection tuning, once the characteristics are resolved: high
+     *        priority (shortest connection interval) while the control screen
+     *        is active, balanced in the background
+     */
+    private fun tuneConnection() {
+        val gatt = bluetoothGatt ?: return
+        if (characteristics.isEmpty()) { return }
+
+        // Check and get permissions
+        if (!blePermission.checkBlePermission(this)) {
+            Log.w(TAG, "Bluetooth permissions requested")
+            requestPermissions()
+            return
+        }
+
+        val priority = if (controlActive) BluetoothGatt.CONNECTION_PRIORITY_HIGH else BluetoothGatt.CONNECTION_PRIORITY_BALANCED
+        if ((priority != connectionPriority) && gatt.requestConnectionPriority(priority)) {
+            connectionPriority = priority
+            Log.d(TAG, "Connection priority requested: ${if (controlActive) "high" else "balanced"}")
+        }
+    }
+
+    /**
+     * @brief Prefer the LE 2M PHY if the phone supports it: the link layer
+     *        keeps LE 1M if the device does not, onPhyUpdate() reports the result
+     */
+    private fun selectPhy() {
+        val gatt = bluetoothGatt ?: return
+
+        // Check and get permissions
+        if (!blePermission.checkBlePermission(this)) {
+            Log.w(TAG, "Bluetooth permissions requested")
+            requestPermissions()
+            return
+        }
+
+        if (Build.VERSION.SDK_INT < Build.VERSION_CODES.O) {
+            Log.d(TAG, "PHY selection not available before Android 8")
+        }
+        else if (bluetoothAdapter?.isLe2MPhySupported == true) {
+            gatt.setPreferredPhy(BluetoothDevice.PHY_LE_2M_MASK, BluetoothDevice.PHY_LE_2M_MASK, BluetoothDevice.PHY_OPTION_NO_PREFERRED)
+        }
+        else {
+            Log.d(TAG, "LE 2M PHY not supported by the phone")
+            gatt.readPhy()
+        }
+    }
+
+    /**
+     * @brief PHY name for the logs
+     */
+    private fun phyName(phy: Int) : String {
+        return when (phy) {
+            BluetoothDevice.PHY_LE_1M -> "LE 1M"
+            BluetoothDevice.PHY_LE_2M -> "LE 2M"
+            BluetoothDevice.PHY_LE_CODED -> "LE Coded"
+            else -> "unknown ($phy)"
+        }
     }
 
     /**
@@ -83,14 +377,16 @@ class BleService : Service() {
         override fun onConnectionStateChange(gatt: BluetoothGatt?, status: Int, newState: Int) {
             if (newState == BluetoothProfile.STATE_CONNECTED) {
                 Log.d(TAG, "Successfully connected to GATT server")
-                connectionState = STATE_CONNECTED
-                broadcastUpdate(ACTION_GATT_CONNECTED)
+                updateConnection(STATE_CONNECTED)
+                gatt?.device?.address?.let { address ->
+                    getSharedPreferences(PREFS_NAME, Context.MODE_PRIVATE).edit().putString(PREF_LAST_ADDRESS, address).apply()
+                }
 
                 // Perform services discovery
                 // Check and get permissions
                 if (!blePermission.checkBlePermission(applicationContext)) {
                     Log.w(TAG, "Bluetooth permissions requested")
-                    broadcastUpdate(ACTION_REQUIRE_PERMISSIONS)
+                    requestPermissions()
                     return
                 }
 
@@ -101,10 +397,99 @@ class BleService : Service() {
             }
             else if (newState == BluetoothProfile.STATE_DISCONNECTED) {
                 Log.d(TAG, "Disconnected from GATT server")
-                connectionState = STATE_DISCONNECTED
-                broadcastUpdate(ACTION_GATT_DISCONNECTED)
+                updateConnection(STATE_DISCONNECTED)
+                gattQueue.clear()
+                Handler(Looper.getMainLooper()).post {
+                    characteristics.clear()
+                    connectionPriority = -1
+                    relayFlow.value = null
+                    // Background reconnection as long as the link is kept: autoConnect
+                    // waits for the device without the timeout of a direct connection
+                    if (keepConnected && blePermission.checkBlePermission(this@BleService)) {
+                        bluetoothGatt?.let { gatt ->
+                            val device = gatt.device
+                            gatt.close()
+                            bluetoothGatt = device.connectGatt(this@BleService, true, bluetoothGattCallback)
+                        }
+                    }
+                }
+            }
+        }
+
+        override fun onServicesDiscovered(gatt: BluetoothGatt?, status: Int) {
+            if ((gatt == null) || (status != BluetoothGatt.GATT_SUCCESS)) {
+                Log.w(TAG, "Services discovery failed: $status")
+                return
+            }
+
+            // Resolve the characteristics once, instead of on every write
+            Handler(Looper.getMainLooper()).post {
+                characteristics.clear()
+                gatt.services.forEach { service ->
+                    service.characteristics.forEach { characteristic ->
+                        characteristics[characteristic.uuid] = characteristic
+                    }
+                }
+                if (characteristics[CONTROL_CHAR_UUID]?.service?.uuid != CONTROL_SERVICE_UUID) {
+                    Log.w(TAG, "Control characteristic not found")
+                }
+                Log.d(TAG, "${characteristics.size} characteristics discovered")
+                tuneConnection()
+                selectPhy()
+                updateConnection(STATE_READY)
+                // A command tapped while connecting goes first
+                flushPendingCommand()
+                if (characteristics.containsKey(TELEMETRY_CHAR_UUID)) {
+                    gattQueue.enqueue(GattOperation.EnableNotifications(TELEMETRY_CHAR_UUID))
+                }
             }
         }
+
+        override fun onPhyUpdate(gatt: BluetoothGatt?, txPhy: Int, rxPhy: Int, status: Int) {
+            Log.i(TAG, "PHY updated: TX ${phyName(txPhy)}, RX ${phyName(rxPhy)} (status $status)")
+        }
+
+        override fun onPhyRead(gatt: BluetoothGatt?, txPhy: Int, rxPhy: Int, status: Int) {
+            Log.i(TAG, "PHY: TX ${phyName(txPhy)}, RX ${phyName(rxPhy)} (status $status)")
+        }
+
+        /**
+         * @brief Connection parameters applied: hidden in BluetoothGattCallback,
+         *        still dispatched to a method of the same signature
+         */
+        @Suppress("unused")
+        fun onConnectionUpdated(gatt: BluetoothGatt?, interval: Int, latency: Int, timeout: Int, status: Int) {
+            Log.i(TAG, "Connection interval %.2f ms, latency $latency, supervision timeout ${timeout * 10} ms (status $status)".format(interval * 1.25))
+        }
+
+        @Deprecated("Deprecated in API 33, still called up to API 32")
+        override fun onCharacteristicWrite(gatt: BluetoothGatt?, characteristic: BluetoothGattCharacteristic?, status: Int) {
+            characteristic?.let { gattQueue.complete(it.uuid) }
+        }
+
+        override fun onDescriptorWrite(gatt: BluetoothGatt?, descriptor: BluetoothGattDescriptor?, status: Int) {
+            descriptor?.let { gattQueue.complete(it.characteristic.uuid) }
+        }
+
+        @Deprecated("Deprecated in API 33, still called up to API 32")
+        override fun onCharacteristicChanged(gatt: BluetoothGatt?, characteristic: BluetoothGattCharacteristic?) {
+            val uuid = characteristic?.uuid ?: return
+            val value = characteristic.value?.copyOf() ?: return
+            val timestampNs = SystemClock.elapsedRealtimeNanos()
+            notificationFlow.tryEmit(Notification(uuid, value, timestampNs))
+            if (uuid == TELEMETRY_CHAR_UUID) {
+                decodeTelemetry(value, timestampNs)?.let { relayFlow.value = it }
+            }
+        }
+
+        @Deprecated("Deprecated in API 33, still called up to API 32")
+        override fun onCharacteristicRead(gatt: BluetoothGatt?, characteristic: BluetoothGattCharacteristic?, status: Int) {
+            characteristic ?: return
+            if ((characteristic.uuid == TELEMETRY_CHAR_UUID) && (status == BluetoothGatt.GATT_SUCCESS)) {
+                decodeTelemetry(characteristic.value, SystemClock.elapsedRealtimeNanos())?.let { relayFlow.value = it }
+            }
+            gattQueue.complete(characteristic.uuid)
+        }
     }
 
     //----------------------------------------------------------------
@@ -119,11 +504,66 @@ class BleService : Service() {
     }
 
     /**
-     * @brief On call to unbinService from the activity, cleanup the current connection
+     * @brief On call to unbinService from the last client, cleanup the current
+     *        connection unless it is kept in the foreground
+     * @return true to be called again after the next clients unbind
      */
     override fun onUnbind(intent: Intent?): Boolean {
+        if (!foreground) {
+            close()
+        }
+        return true
+    }
+
+    override fun onRebind(intent: Intent?) {
+        appIntent = intent
+    }
+
+    /**
+     * @brief Start requests:
+     *          - ACTION_START_FOREGROUND: keep the connection in the background
+     *          - ACTION_STOP_FOREGROUND: back to a connection owned by the clients
+     *          - ACTION_COMMAND: motion command from the widget or the notification
+     *        A restart by the system restores the persistent connection
+     */
+    override fun onStartCommand(intent: Intent?, flags: Int, startId: Int): Int {
+        if ((bluetoothAdapter == null) && !initialize()) {
+            stopSelf()
+            return START_NOT_STICKY
+        }
+
+        val action = intent?.action ?: if (isKeepConnected(this)) ACTION_START_FOREGROUND else null
+        when (action) {
+            ACTION_START_FOREGROUND -> {
+                keepConnected = true
+                enterForeground()
+                connectLast()
+            }
+            ACTION_STOP_FOREGROUND -> {
+                keepConnected = false
+                getSharedPreferences(PREFS_NAME, Context.MODE_PRIVATE).edit().putBoolean(PREF_KEEP_CONNECTED, false).apply()
+                leaveForeground()
+                stopSelf()
+            }
+            ACTION_COMMAND -> {
+                // Started with startForegroundService(): the notification is required
+                enterForeground()
+                // The tap time is not known: the latency starts at the delivery of the intent
+                val command = intent?.getIntExtra(EXTRA_COMMAND, COMMAND_STOP) ?: COMMAND_STOP
+                sendCommand(command, intent?.getStringExtra(EXTRA_SOURCE) ?: SOURCE_WIDGET)
+                if (!keepConnected) {
+                    mainHandler.postDelayed(idleStop, IDLE_TIMEOUT_MS)
+                }
+            }
+            else -> stopSelf()
+        }
+        return if (keepConnected) START_STICKY else START_NOT_STICKY
+    }
+
+    override fun onDestroy() {
+        mainHandler.removeCallbacks(idleStop)
         close()
-        return super.onUnbind(intent)
+        super.onDestroy()
     }
 
     /**
@@ -156,7 +596,7 @@ class BleService : Service() {
                 // Check and get permissions
                 if (!blePermission.checkBlePermission(this)) {
                     Log.w(TAG, "Bluetooth permissions requested")
-                    broadcastUpdate(ACTION_REQUIRE_PERMISSIONS)
+                    requestPermissions()
                     return false
                 }
 
@@ -187,74 +627,302 @@ class BleService : Service() {
             // Check and get permissions
             if (!blePermission.checkBlePermission(this)) {
                 Log.w(TAG, "Bluetooth permissions requested")
-                broadcastUpdate(ACTION_REQUIRE_PERMISSIONS)
+                requestPermissions()
                 return false
             }
 
             gatt.close()
             bluetoothGatt = null
+            gattQueue.clear()
+            characteristics.clear()
+            connectionPriority = -1
             // Notify main activity
-            connectionState = STATE_DISCONNECTED
-            broadcastUpdate(ACTION_GATT_DISCONNECTED)
+            updateConnection(STATE_DISCONNECTED)
+            relayFlow.value = null
+        }
+
+        return true
+    }
+
+    /**
+     * @brief Connect to the last device connected, if not connected yet
+     * @return false if there is no device to connect to, or if the connection
+     *         could not be started
+     */
+    fun connectLast() : Boolean {
+        if (getConnectionState() != STATE_DISCONNECTED) { return true }
+        if ((bluetoothAdapter == null) && !initialize()) { return false }
+
+        bluetoothGatt?.let { gatt ->
+            // Check and get permissions
+            if (!blePermission.checkBlePermission(this)) {
+                Log.w(TAG, "Bluetooth permissions requested")
+                requestPermissions()
+                return false
+            }
+            return gatt.connect()
+        }
+        val address = getLastAddress() ?: run {
+            Log.w(TAG, "No device connected before")
+            return false
+        }
+        return connect(address)
+    }
+
+    /**
+     * @brief Send a motion command over the current connection, as a command
+     *        frame acknowledged in the telemetry: a command not sent yet is
+     *        replaced by the newer one. Before the connection is ready, the
+     *        last device is connected and only a STOP is kept: an Up or Down
+     *        tap is dropped, the sofa must not start moving seconds later
+     * @param command COMMAND_UP, COMMAND_DOWN or COMMAND_STOP
+     * @param source The command source (SOURCE_*), for the tap-to-write latency logs
+     * @param tapNs Time of the tap (SystemClock.elapsedRealtimeNanos)
+     * @return The frame sequence number, -1 if the command was not sent
+     */
+    fun sendCommand(command: Int, source: String, tapNs: Long = SystemClock.elapsedRealtimeNanos()) : Int {
+        if ((getConnectionState() != STATE_READY) || !characteristics.containsKey(CONTROL_CHAR_UUID)) {
+            if (command == COMMAND_STOP) {
+                Log.d(TAG, "Command $command from $source waits for the connection")
+                pendingCommand = PendingCommand(command, source, tapNs)
+            }
+            else {
+                Log.w(TAG, "Command $command from $source dropped: not connected, tap again once connected")
+            }
+            connectLast()
+            return -1
+        }
+
+        commandSequence = (commandSequence % 255) + 1
+        val write = GattOperation.Write(CONTROL_CHAR_UUID, encodeCommand(commandSequence, command),
+            BluetoothGattCharacteristic.WRITE_TYPE_NO_RESPONSE, true, source)
+        write.requestedNs = tapNs
+        gattQueue.enqueue(write)
+        return commandSequence
+    }
+
+    /**
+     * @brief Read the telemetry, to resynchronize the relay state when a
+     *        notification is missing
+     */
+    fun refreshRelayState() {
+        if ((getConnectionState() == STATE_READY) && characteristics.containsKey(TELEMETRY_CHAR_UUID)) {
+            gattQueue.enqueue(GattOperation.Read(TELEMETRY_CHAR_UUID))
         }
+    }
 
+    /**
+     * @brief Send a command frame, not coalesced: its sequence number is
+     *        acknowledged by the next telemetry notification
+     * @param sequence The frame sequence number (1 to 255, 0 is a legacy command)
+     * @param command The command byte
+     * @param source The command source (SOURCE_*)
+     * @return false if the connection is not ready
+     */
+    fun sendCommandFrame(sequence: Int, command: Int, source: String) : Boolean {
+        if ((getConnectionState() != STATE_READY) || !characteristics.containsKey(CONTROL_CHAR_UUID)) {
+            return false
+        }
+        gattQueue.enqueue(GattOperation.Write(CONTROL_CHAR_UUID, encodeCommand(sequence, command),
+            BluetoothGattCharacteristic.WRITE_TYPE_NO_RESPONSE, false, source))
         return true
     }
 
+    /**
+     * @brief Get the address of the last device connected, to connect to it
+     *        directly at launch without scanning
+     * @return The device address, null if none
+     */
+    fun getLastAddress() : String? {
+        return getSharedPreferences(PREFS_NAME, Context.MODE_PRIVATE).getString(PREF_LAST_ADDRESS, null)
+    }
+
     /**
      * @brief Get the current connection state
      * @return The current connection state
      */
     fun getConnectionState() : Int {
-        return connectionState
+        return connectionFlow.value.state
     }
 
     /**
-     * @brief Write a Gatt characteristic
+     * @brief Control screen shown or hidden: raise the connection priority
+     *        while the user controls the sofa, drop it back in the background
+     * @param active true if the control screen is in the foreground
+     */
+    fun setControlActive(active: Boolean) {
+        controlActive = active
+        tuneConnection()
+    }
+
+    /**
+     * @brief Queue a Gatt characteristic write, sent once the previous operations complete
      * @param uuidService The UUID of the Gatt service
      * @param uuidChar The UUID of the Gatt characteristic
      * @param writeType The type of write operation (WRITE_TYPE_DEFAULT or WRITE_TYPE_NO_RESPONSE)
      * @param payload The byte array to be written to the characteristic
+     * @param coalesce true for a state write: a newer state replaces it while it waits
+     * @return false if not connected or if the characteristic is not found,
+     *         true if the write is queued
      */
-    fun writeCharacteristics(uuidService: UUID, uuidChar: UUID, writeType: Int, payload: ByteArray) {
-        bluetoothGatt?.let { gatt ->
-            // Check and get permissions
-            if (!blePermission.checkBlePermission(this)) {
-                Log.w(TAG, "Bluetooth permissions requested")
-                broadcastUpdate(ACTION_REQUIRE_PERMISSIONS)
-                return
-            }
+    fun writeCharacteristics(uuidService: UUID, uuidChar: UUID, writeType: Int, payload: ByteArray, coalesce: Boolean = false) : Boolean {
+        if (bluetoothGatt == null) {
+            Log.w(TAG, "Not connected to a BLE device")
+            return false
+        }
 
-            val gattService : BluetoothGattService = gatt.getService(uuidService)
-            if (gattService != null) {
-                val serviceChar = gattService.getCharacteristic(uuidChar)
-                if (serviceChar != null) {
-                    serviceChar.writeType = writeType
-                    serviceChar.value = payload
-                    gatt.writeCharacteristic(serviceChar)
-                }
-                else {
-                    Log.w(TAG, "Characteristic not found")
-                }
-            }
-            else {
-                Log.w(TAG, "Service not found")
-            }
-        } ?: error("Not connected to a BLE device!")
+        if (characteristics[uuidChar]?.service?.uuid != uuidService) {
+            Log.w(TAG, "Characteristic not found")
+            return false
+        }
+        gattQueue.enqueue(GattOperation.Write(uuidChar, payload, writeType, coalesce))
+        return true
     }
 
     companion object {
         /** @brief Debug TAG */
         private const val TAG = "BleService"
-        /** @brief Broadcast message: indicate a new connection to a GATT server */
-        const val ACTION_GATT_CONNECTED = "com.example.ble_control.ACTION_GATT_CONNECTED"
-        /** @brief Broadcast message: indicate a disconnection from a GATT server */
-        const val ACTION_GATT_DISCONNECTED = "com.example.ble_control.ACTION_GATT_DISCONNECTED"
-        /** @brief Broadcast message: request BLE runtime permissions */
-        const val ACTION_REQUIRE_PERMISSIONS = "com.example.ble_control.ACTION_REQUIRE_PERMISSIONS"
         /** @brief  Enum for internal connection state - disconnected */
         const val STATE_DISCONNECTED = 0
         /** @brief  Enum for internal connection state - connected */
         const val STATE_CONNECTED = 2
+        /** @brief  Enum for internal connection state - connected, characteristics resolved */
+        const val STATE_READY = 3
+        /** @brief Preferences: last device connected, connection kept in the background */
+        private const val PREFS_NAME = "ble_service"
+        private const val PREF_LAST_ADDRESS = "last_address"
+        private const val PREF_KEEP_CONNECTED = "keep_connected"
+        /** @brief Start actions and their extras */
+        const val ACTION_START_FOREGROUND = "com.example.ble_sofa_app.ACTION_START_FOREGROUND"
+        const val ACTION_STOP_FOREGROUND = "com.example.ble_sofa_app.ACTION_STOP_FOREGROUND"
+        const val ACTION_COMMAND = "com.example.ble_sofa_app.ACTION_COMMAND"
+        const val EXTRA_COMMAND = "com.example.ble_sofa_app.EXTRA_COMMAND"
+        const val EXTRA_SOURCE = "com.example.ble_sofa_app.EXTRA_SOURCE"
+        /** @brief Motion commands: control characteristic byte (motion.h) */
+        const val COMMAND_STOP = 0x00
+        const val COMMAND_UP = 0x01
+        const val COMMAND_DOWN = 0x02
+        /** @brief Command sources, for the tap-to-write latency logs */
+        const val SOURCE_ACTIVITY = "activity"
+        const val SOURCE_TILE = "tile"
+        const val SOURCE_WIDGET = "widget"
+        const val SOURCE_NOTIFICATION = "notification"
+        const val SOURCE_BENCHMARK = "benchmark"
+        /** @brief Number of latencies kept per source for the median */
+        private const val NB_TAP_LATENCIES = 50
+        /** @brief A command older than this when the connection is ready is dropped */
+        private const val PENDING_COMMAND_TIMEOUT_NS = 5_000_000_000L
+        /** @brief Delay before leaving the foreground after a widget command */
+        private const val IDLE_TIMEOUT_MS = 30_000L
+        /** @brief Foreground notification */
+        private const val CHANNEL_ID = "ble_connection"
+        private const val NOTIFICATION_ID = 1
+        /** @brief Control service of the sofa */
+        val CONTROL_SERVICE_UUID : UUID = UUID.fromString("0000ff10-0000-1000-8000-00805f9b34fb")
+        /** @brief Control characteristic: relays state */
+        val CONTROL_CHAR_UUID : UUID = UUID.fromString("0000ff11-0000-1000-8000-00805f9b34fb")
+        /** @brief Telemetry characteristic: notified on each relay or end-stop change */
+        val TELEMETRY_CHAR_UUID : UUID = UUID.fromString("0000ff17-0000-1000-8000-00805f9b34fb")
+        /** @brief Client characteristic configuration descriptor */
+        private val CLIENT_CONFIGURATION_UUID : UUID = UUID.fromString("00002902-0000-1000-8000-00805f9b34fb")
+        /** @brief Telemetry record types (protocol.hpp) */
+        private const val TELEMETRY_STATE = 0x40
+        private const val TELEMETRY_ENDSTOP = 0x41
+        private const val TELEMETRY_ACK = 0x42
+        /** @brief Command frame: version, sequence number, Motion record (type, size, command) */
+        private const val FRAME_VERSION = 1
+        private const val RECORD_MOTION = 0x01
+
+        /**
+         * @brief Decode the applied command, the end-stop status and the
+         *        acknowledged command frame of a telemetry frame: version,
+         *        sequence number, then type/size/value records
+         * @param frame The telemetry frame
+         * @param timestampNs Time of the notification
+         * @return The relay state, null if the frame has no State record
+         */
+        fun decodeTelemetry(frame: ByteArray, timestampNs: Long) : RelayUpdate? {
+            var state = -1
+            var endstop = -1
+            var ack = -1
+            var pos = 2
+            while (pos + 2 <= frame.size) {
+                val type = frame[pos].toInt() and 0xFF
+                val size = frame[pos + 1].toInt() and 0xFF
+                if (pos + 2 + size > frame.size) { break }
+                if ((size == 1) && (type == TELEMETRY_STATE)) { state = frame[pos + 2].toInt() and 0xFF }
+                if ((size == 1) && (type == TELEMETRY_ENDSTOP)) { endstop = frame[pos + 2].toInt() and 0xFF }
+                if ((size == 1) && (type == TELEMETRY_ACK)) { ack = frame[pos + 2].toInt() and 0xFF }
+                pos += 2 + size
+            }
+            return if (state >= 0) RelayUpdate(state, endstop, ack, timestampNs) else null
+        }
+
+        /**
+         * @brief Encode a command frame (protocol.hpp)
+         * @param sequence The frame sequence number
+         * @param command The command byte
+         * @return The frame
+         */
+        fun encodeCommand(sequence: Int, command: Int) : ByteArray {
+            return byteArrayOf(FRAME_VERSION.toByte(), sequence.toByte(), RECORD_MOTION.toByte(), 1, command.toByte())
+        }
+
+        /**
+         * @brief Check whether the connection is kept in the background
+         * @param context The application context
+         * @return true if the foreground connection is enabled
+         */
+        fun isKeepConnected(context: Context) : Boolean {
+            return context.getSharedPreferences(PREFS_NAME, Context.MODE_PRIVATE).getBoolean(PREF_KEEP_CONNECTED, false)
+        }
+
+        /**
+         * @brief Enable or disable the connection kept in the background; to be
+         *        called from the foreground, where a foreground service can start
+         * @param context The application context
+         * @param enabled true to keep the connection
+         */
+        fun setKeepConnected(context: Context, enabled: Boolean) {
+            context.getSharedPreferences(PREFS_NAME, Context.MODE_PRIVATE).edit().putBoolean(PREF_KEEP_CONNECTED, enabled).apply()
+            val intent = Intent(context, BleService::class.java)
+            if (enabled) {
+                intent.action = ACTION_START_FOREGROUND
+                if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
+                    context.startForegroundService(intent)
+                }
+                else {
+                    context.startService(intent)
+                }
+            }
+            else {
+                intent.action = ACTION_STOP_FOREGROUND
+                context.startService(intent)
+            }
+        }
+
+        /**
+         * @brief Intent starting the service for a motion command, for the
+         *        widget and the notification buttons
+         * @param context The application context
+         * @param command COMMAND_UP, COMMAND_DOWN or COMMAND_STOP
+         * @param source The command source (SOURCE_*)
+         * @return The pending intent
+         */
+        fun commandIntent(context: Context, command: Int, source: String) : PendingIntent {
+            val intent = Intent(context, BleService::class.java)
+                .setAction(ACTION_COMMAND)
+                .putExtra(EXTRA_COMMAND, command)
+                .putExtra(EXTRA_SOURCE, source)
+            // One pending intent per command and source
+            val requestCode = (if (source == SOURCE_WIDGET) 0x10 else 0x20) + command
+            val flags = PendingIntent.FLAG_IMMUTABLE or PendingIntent.FLAG_UPDATE_CURRENT
+            return if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
+                PendingIntent.getForegroundService(context, requestCode, intent, flags)
+            }
+            else {
+                PendingIntent.getService(context, requestCode, intent, flags)
+            }
+        }
     }
 }
@@ -0,0 +1,214 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: GattQueue.tk
+-- Description: Serialized GATT operation queue, with latest-state coalescing
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+package com.example.ble_sofa_app
+
+import android.os.Handler
+import android.os.SystemClock
+import android.util.Log
+import java.util.UUID
+
+/**
+ * @brief GATT operation waiting in the queue
+ * @param uuid The UUID of the characteristic
+ */
+sealed class GattOperation(val uuid: UUID) {
+    /** @brief Time of the request (SystemClock.elapsedRealtimeNanos) */
+    var requestedNs : Long = SystemClock.elapsedRealtimeNanos()
+        internal set
+
+    /** @brief Token given when the operation starts, 0 while it waits */
+    var token : Long = 0
+        internal set
+
+    /**
+     * @brief Characteristic write
+     * @param payload The byte array to be written
+     * @param writeType WRITE_TYPE_DEFAULT or WRITE_TYPE_NO_RESPONSE
+     * @param coalesce true if a later write to the same characteristic
+     *                 supersedes this one while it is still waiting
+     * @param source Origin of the request for the latency logs, null if none
+     */
+    class Write(uuid: UUID, payload: ByteArray, val writeType: Int, val coalesce: Boolean, source: String? = null) : GattOperation(uuid) {
+        /** @brief Latest payload requested */
+        var payload : ByteArray = payload
+            internal set
+        /** @brief Origin of the latest request */
+        var source : String? = source
+            internal set
+    }
+
+    /**
+     * @brief Characteristic read
+     */
+    class Read(uuid: UUID) : GattOperation(uuid)
+
+    /**
+     * @brief Notifications enabled through the client configuration descriptor
+     */
+    class EnableNotifications(uuid: UUID) : GattOperation(uuid)
+}
+
+/**
+ * @brief Android runs one GATT operation at a time per connection, and drops
+ *        an operation started before the previous one completed: the queue
+ *        starts the next operation from the completion callback only. All the
+ *        queue state is confined to the handler thread.
+ * @param handler Handler of the thread running the queue
+ * @param executor Starts an operation, returns false if it could not be started
+ * @param timeoutMs Delay after which an operation without completion is dropped
+ */
+class GattQueue(
+    private val handler: Handler,
+    private val executor: (GattOperation) -> Boolean,
+    private val timeoutMs: Long = DEFAULT_TIMEOUT_MS
+) {
+    //----------------------------------------------------------------
+    // Private variables
+    //----------------------------------------------------------------
+    /** @brief Operations waiting, oldest first */
+    private val pending : ArrayDeque<GattOperation> = ArrayDeque()
+    /** @brief Operation started, waiting for its completion */
+    private var inFlight : GattOperation? = null
+    /** @brief Token of the operation in flight (0 if none), read by the GATT callback thread */
+    @Volatile private var inFlightToken : Long = 0
+    /** @brief Last token given */
+    private var lastToken : Long = 0
+
+    /** @brief Completion timeout of the operation in flight */
+    private val timeout = Runnable {
+        inFlight?.let { operation ->
+            Log.w(TAG, "GATT operation timeout: ${operation.uuid}")
+            setInFlight(null)
+        }
+        next()
+    }
+
+    //----------------------------------------------------------------
+    // Public variables
+    //----------------------------------------------------------------
+    /** @brief Called when an operation starts, with its request-to-start latency (ns) */
+    var onStarted : ((GattOperation, Long) -> Unit)? = null
+
+    /** @brief Called when an operation completes, with its request-to-completion latency (ns) */
+    var onCompleted : ((GattOperation, Long) -> Unit)? = null
+
+    /** @brief Number of writes superseded before being sent */
+    var nbCoalesced : Int = 0
+        private set
+
+    //----------------------------------------------------------------
+    // Private functions
+    //----------------------------------------------------------------
+    /**
+     * @brief Set the operation in flight and publish its token
+     * @param operation The operation started, null if none
+     */
+    private fun setInFlight(operation: GattOperation?) {
+        inFlight = operation
+        inFlightToken = operation?.token ?: 0
+    }
+
+    /**
+     * @brief Start the oldest operation waiting, if none is in flight
+     */
+    private fun next() {
+        while ((inFlight == null) && pending.isNotEmpty()) {
+            val operation = pending.removeFirst()
+            // The token is published before the start: the completion may
+            // arrive before the executor returns
+            operation.token = ++lastToken
+            setInFlight(operation)
+            onStarted?.invoke(operation, SystemClock.elapsedRealtimeNanos() - operation.requestedNs)
+            if (executor(operation)) {
+                handler.postDelayed(timeout, timeoutMs)
+            }
+            else {
+                Log.w(TAG, "GATT operation not started: ${operation.uuid}")
+                setInFlight(null)
+            }
+        }
+    }
+
+    //----------------------------------------------------------------
+    // Public functions
+    //----------------------------------------------------------------
+    /**
+     * @brief Queue an operation. A coalescing write replaces the payload of a
+     *        write to the same characteristic still waiting, so only the
+     *        latest state is sent
+     * @param operation The operation
+     */
+    fun enqueue(operation: GattOperation) {
+        handler.post {
+            if ((operation is GattOperation.Write) && operation.coalesce) {
+                val waiting = pending.lastOrNull { it is GattOperation.Write && it.coalesce && it.uuid == operation.uuid }
+                if (waiting is GattOperation.Write) {
+                    waiting.payload = operation.payload
+                    waiting.source = operation.source
+                    waiting.requestedNs = operation.requestedNs
+                    nbCoalesced++
+                    return@post
+                }
+            }
+            pending.addLast(operation)
+            next()
+        }
+    }
+
+    /**
+     * @brief An operation completed (GATT callback): start the next one.
+     *        The token of the operation in flight is taken when the callback
+     *        arrives, so a late completion of an operation dropped on timeout
+     *        does not complete the next operation on the same characteristic
+     * @param uuid The UUID of the characteristic
+     */
+    fun complete(uuid: UUID) {
+        val token = inFlightToken
+        handler.post {
+            val operation = inFlight
+            if ((operation != null) && (operation.token == token) && (operation.uuid == uuid)) {
+                handler.removeCallbacks(timeout)
+                setInFlight(null)
+                onCompleted?.invoke(operation, SystemClock.elapsedRealtimeNanos() - operation.requestedNs)
+                next()
+            }
+        }
+    }
+
+    /**
+     * @brief Drop all the operations, on disconnection
+     */
+    fun clear() {
+        handler.post {
+            handler.removeCallbacks(timeout)
+            pending.clear()
+            setInFlight(null)
+        }
+    }
+
+    companion object {
+        /** @brief Debug TAG */
+        private const val TAG = "GattQueue"
+        /** @brief Completion timeout: a supervision timeout covers a lost link */
+        const val DEFAULT_TIMEOUT_MS = 2000L
+    }
+}
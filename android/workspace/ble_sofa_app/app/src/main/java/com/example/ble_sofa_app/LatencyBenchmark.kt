@@ -0,0 +1,262 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: LatencyBenchmark.tk
+-- Description: End-to-end latency benchmark: command frames sent at a fixed
+--              rate, timed up to their acknowledgement in the telemetry
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+package com.example.ble_sofa_app
+
+import android.os.Handler
+import android.os.SystemClock
+
+/**
+ * @brief Benchmark settings
+ * @param nbCommands Number of command frames
+ * @param periodMs Delay between two commands
+ * @param switchRelay true to alternate Up and Stop, so the relay switches on
+ *                    each command; false to repeat Stop, only acknowledged
+ * @param timeoutMs A command not acknowledged after this delay is dropped
+ * @param label Free text identifying the setup (connection parameters, firmware)
+ */
+data class BenchmarkConfig(
+    val nbCommands: Int = 200,
+    val periodMs: Long = 100,
+    val switchRelay: Boolean = false,
+    val timeoutMs: Long = 1000,
+    val label: String = ""
+)
+
+/**
+ * @brief One command, times from SystemClock.elapsedRealtimeNanos, 0 if not reached
+ * @param index Command index
+ * @param sequence Frame sequence number
+ * @param command The command byte
+ * @param requestNs Time of the request
+ */
+class BenchmarkSample(val index: Int, val sequence: Int, val command: Int, val requestNs: Long) {
+    /** @brief Write queued to the Bluetooth stack */
+    var writtenNs : Long = 0
+        internal set
+    /** @brief Telemetry notification acknowledging the command */
+    var ackNs : Long = 0
+        internal set
+
+    /** @brief Request to acknowledgement latency, -1 if dropped */
+    val latencyNs : Long
+        get() = if (ackNs != 0L) ackNs - requestNs else -1
+}
+
+/**
+ * @brief Benchmark result
+ * @param config The settings
+ * @param samples The commands, in order
+ */
+class BenchmarkResult(val config: BenchmarkConfig, val samples: List<BenchmarkSample>) {
+    /** @brief Latencies of the acknowledged commands, sorted */
+    private val latencies : List<Long> = samples.filter { it.ackNs != 0L }.map { it.latencyNs }.sorted()
+
+    /** @brief Commands not acknowledged in time, or not sent */
+    val nbDropped : Int = samples.size - latencies.size
+
+    /**
+     * @brief Latency percentile
+     * @param percent 0 to 100
+     * @return The latency (ns), -1 if no command was acknowledged
+     */
+    fun percentile(percent: Int) : Long {
+        if (latencies.isEmpty()) { return -1 }
+        return latencies[minOf(latencies.size - 1, latencies.size * percent / 100)]
+    }
+
+    /**
+     * @brief Summary for the screen and the logs
+     */
+    fun summary() : String {
+        return "%d commands every %d ms: min %.1f ms, median %.1f ms, p99 %.1f ms, %d dropped"
+            .format(samples.size, config.periodMs, percentile(0) / 1e6, percentile(50) / 1e6, percentile(99) / 1e6, nbDropped)
+    }
+
+    /**
+     * @brief CSV export: settings and summary as comment lines, then one line
+     *        per command, times in ms from the first request
+     * @param header Extra comment lines (device, firmware)
+     */
+    fun toCsv(header: List<String> = emptyList()) : String {
+        val origin = samples.firstOrNull()?.requestNs ?: 0L
+        val ms = { ns: Long -> if (ns != 0L) "%.3f".format((ns - origin) / 1e6) else "" }
+        val builder = StringBuilder()
+        header.forEach { builder.append("# ").append(it).append('\n') }
+        builder.append("# label=${config.label},nb_commands=${config.nbCommands},period_ms=${config.periodMs}," +
+                "switch_relay=${config.switchRelay},timeout_ms=${config.timeoutMs}\n")
+        builder.append("# min_ms=%.3f,median_ms=%.3f,p99_ms=%.3f,dropped=%d\n"
+            .format(percentile(0) / 1e6, percentile(50) / 1e6, percentile(99) / 1e6, nbDropped))
+        builder.append("index,sequence,command,request_ms,write_ms,ack_ms,latency_ms\n")
+        samples.forEach { sample ->
+            val latency = if (sample.latencyNs >= 0) "%.3f".format(sample.latencyNs / 1e6) else ""
+            builder.append("${sample.index},${sample.sequence},${sample.command},${ms(sample.requestNs)}," +
+                    "${ms(sample.writtenNs)},${ms(sample.ackNs)},$latency\n")
+        }
+        return builder.toString()
+    }
+}
+
+/**
+ * @brief Sends the command frames at a fixed rate and matches the
+ *        acknowledgements: the firmware notifies the sequence number of each
+ *        frame received, a frame lost on the way is never acknowledged. All
+ *        the state is confined to the handler thread.
+ * @param handler Handler of the thread running the benchmark
+ * @param config The settings
+ * @param send Sends a command frame (sequence number, command byte), returns
+ *             false if it could not be queued
+ */
+class LatencyBenchmark(
+    private val handler: Handler,
+    private val config: BenchmarkConfig,
+    private val send: (Int, Int) -> Boolean
+) {
+    //----------------------------------------------------------------
+    // Private variables
+    //----------------------------------------------------------------
+    /** @brief Commands sent so far */
+    private val samples : MutableList<BenchmarkSample> = mutableListOf()
+    /** @brief Commands waiting for their acknowledgement, oldest first */
+    private val outstanding : ArrayDeque<BenchmarkSample> = ArrayDeque()
+    /** @brief Start time (SystemClock.uptimeMillis), for a drift-free rate */
+    private var startMs = 0L
+
+    /** @brief Send the next command, then wait for the last acknowledgements */
+    private val sendNext : Runnable = object : Runnable {
+        override fun run() {
+            val index = samples.size
+            if (index >= config.nbCommands) {
+                handler.postDelayed(finish, config.timeoutMs)
+                return
+            }
+
+            // Up on even commands when switching, always ending on Stop
+            val command = if (config.switchRelay && (index % 2 == 0) && (index < config.nbCommands - 1)) BleService.COMMAND_UP else BleService.COMMAND_STOP
+            val sample = BenchmarkSample(index, sequenceOf(index), command, SystemClock.elapsedRealtimeNanos())
+            samples.add(sample)
+            expire(sample.requestNs)
+            if (send(sample.sequence, command)) {
+                outstanding.addLast(sample)
+            }
+            onProgress?.invoke(index + 1)
+            handler.postAtTime(this, startMs + (index + 1) * config.periodMs)
+        }
+    }
+
+    /** @brief End of the benchmark */
+    private val finish = Runnable {
+        running = false
+        outstanding.clear()
+        onFinished?.invoke(BenchmarkResult(config, samples.toList()))
+    }
+
+    //----------------------------------------------------------------
+    // Public variables
+    //----------------------------------------------------------------
+    /** @brief Called after each command sent, with the number of commands sent */
+    var onProgress : ((Int) -> Unit)? = null
+
+    /** @brief Called with the result once the last command is acknowledged or dropped */
+    var onFinished : ((BenchmarkResult) -> Unit)? = null
+
+    /** @brief Benchmark in progress */
+    var running : Boolean = false
+        private set
+
+    //----------------------------------------------------------------
+    // Private functions
+    //----------------------------------------------------------------
+    /**
+     * @brief Sequence number of a command: 1 to 255, 0 is reserved for the legacy commands
+     */
+    private fun sequenceOf(index: Int) : Int {
+        return (index % 255) + 1
+    }
+
+    /**
+     * @brief Drop the commands waiting for longer than the timeout
+     */
+    private fun expire(nowNs: Long) {
+        val timeoutNs = config.timeoutMs * 1_000_000
+        while (outstanding.isNotEmpty() && (nowNs - outstanding.first().requestNs > timeoutNs)) {
+            outstanding.removeFirst()
+        }
+    }
+
+    //----------------------------------------------------------------
+    // Public functions
+    //----------------------------------------------------------------
+    /**
+     * @brief Start sending the commands
+     */
+    fun start() {
+        handler.post {
+            if (running) { return@post }
+            running = true
+            samples.clear()
+            outstanding.clear()
+            startMs = SystemClock.uptimeMillis()
+            sendNext.run()
+        }
+    }
+
+    /**
+     * @brief Stop early: the result covers the commands already sent, and a
+     *        final Stop is sent if the relay was switched
+     */
+    fun stop() {
+        handler.post {
+            if (!running) { return@post }
+            handler.removeCallbacks(sendNext)
+            handler.removeCallbacks(finish)
+            if (config.switchRelay) {
+                send(sequenceOf(samples.size), BleService.COMMAND_STOP)
+            }
+            finish.run()
+        }
+    }
+
+    /**
+     * @brief A command frame write completed
+     * @param sequence The frame sequence number
+     * @param timestampNs Time of the completion
+     */
+    fun onWritten(sequence: Int, timestampNs: Long) {
+        handler.post {
+            outstanding.lastOrNull { (it.sequence == sequence) && (it.writtenNs == 0L) }?.writtenNs = timestampNs
+        }
+    }
+
+    /**
+     * @brief Telemetry notification with the last command frame acknowledged
+     * @param ack The acknowledged sequence number
+     * @param timestampNs Time of the notification
+     */
+    fun onAck(ack: Int, timestampNs: Long) {
+        handler.post {
+            val sample = outstanding.firstOrNull { it.sequence == ack } ?: return@post
+            sample.ackNs = timestampNs
+            outstanding.remove(sample)
+        }
+    }
+}
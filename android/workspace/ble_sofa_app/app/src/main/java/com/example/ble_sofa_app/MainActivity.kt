@@ -15,31 +15,38 @@
 -- File Name: MainActivity.tk
 -- Description: Main activity
 --
--- Last update: 2023-09-09
+-- Last update: 2026-10-18
 --
 -------------------------------------------------------------------------------*/
 package com.example.ble_sofa_app
 
-import android.bluetooth.BluetoothGattCharacteristic
-import android.content.BroadcastReceiver
+import android.Manifest
 import android.content.ComponentName
 import android.content.Context
 import android.content.Intent
-import android.content.IntentFilter
 import android.content.ServiceConnection
 import android.content.pm.PackageManager
 import android.graphics.Color
+import android.os.Build
 import android.os.Bundle
 import android.os.Handler
 import android.os.IBinder
+import android.os.Looper
+import android.os.Process
+import android.os.SystemClock
 import android.util.Log
 import android.widget.AdapterView.OnItemClickListener
 import android.widget.ArrayAdapter
 import android.widget.Button
 import android.widget.ListView
+import android.widget.Switch
 import android.widget.TextView
 import androidx.activity.ComponentActivity
-import java.util.UUID
+import androidx.lifecycle.Lifecycle
+import androidx.lifecycle.lifecycleScope
+import androidx.lifecycle.repeatOnLifecycle
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.launch
 
 class MainActivity : ComponentActivity() {
     private lateinit var bleScanner : BleScanner
@@ -53,14 +60,27 @@ class MainActivity : ComponentActivity() {
     // BLE connection state
     private var connected : Boolean = false
 
-    // Relay states
+    // Relay states, as displayed
     private var relay1State : Boolean = false
     private var relay2State : Boolean = false
 
-    // List of scanned devices
+    // Relays command predicted on the taps, reconciled with the firmware state
+    private val relayModel : OptimisticRelayState = OptimisticRelayState(Handler(Looper.getMainLooper())).apply {
+        onChanged = { state -> updateRelayButtons(if (state >= 0) state else 0x00) }
+        onTimeout = { bleService?.refreshRelayState() }
+    }
+
+    // List of scanned devices, and their addresses in the same order
     private var deviceList : MutableList<String> = mutableListOf()
+    private var deviceAddresses : MutableList<String> = mutableListOf()
     private var arrayAdapter : ArrayAdapter<String>? = null
 
+    // Application start to connected and ready times are logged once
+    private var launchLogged : Boolean = false
+
+    // Collection of the BLE service updates
+    private var serviceUpdates : Job? = null
+
     // BLE permissions manager
     private var blePermission : BlePermissions = BlePermissions()
 
@@ -98,9 +118,7 @@ class MainActivity : ComponentActivity() {
         listView.onItemClickListener =
             OnItemClickListener { parent, view, position, id ->
                 // Get the device address
-                val itemValue = listView.getItemAtPosition(position) as String
-                val pattern = Regex("(?<=\\().+?(?=\\))")
-                val address = pattern.findAll(itemValue).map{it.value}.toList()[0]
+                val address = deviceAddresses[position]
 
                 Log.d(TAG, "Click on device: $address")
 
@@ -138,57 +156,59 @@ class MainActivity : ComponentActivity() {
 
         // Define and setup buttons to control the relays
         val relay1Button = findViewById<Button>(R.id.relay1Btn);
-        updateButtonState(relay1Button, false, R.string.relay1_on)
         val relay2Button = findViewById<Button>(R.id.relay2Btn);
-        updateButtonState(relay2Button, false, R.string.relay2_on)
+        updateRelayButtons(0x00)
 
         relay1Button.setOnClickListener {
-            if (!relay1State) {
-                Log.d(TAG, "Turn on Relay1...")
-                this.writeRelaysState(byteArrayOf(0x01))
-                relay1State = true
-                updateButtonState(relay1Button, true, R.string.relay1_off)
-                // Turning relay1 on automatically turns relay2 off
-                relay2State = false
-                updateButtonState(relay2Button, false, R.string.relay2_on)
-            }
-            else {
-                Log.d(TAG, "Turn off Relay1.")
-                this.writeRelaysState(byteArrayOf(0x00))
-                relay1State = false
-                updateButtonState(relay1Button, false, R.string.relay1_on)
-            }
+            val tapNs = SystemClock.elapsedRealtimeNanos()
+            // Turning relay1 on automatically turns relay2 off
+            val command = if (!relay1State) BleService.COMMAND_UP else BleService.COMMAND_STOP
+            Log.d(TAG, if (!relay1State) "Turn on Relay1..." else "Turn off Relay1.")
+            // Shown at once, reconciled with the telemetry acknowledging the frame
+            relayModel.predict(command, this.writeRelaysState(command, tapNs), tapNs)
         }
 
         relay2Button.setOnClickListener {
-            if (!relay2State) {
-                Log.d(TAG, "Turn on Relay2...")
-                this.writeRelaysState(byteArrayOf(0x02))
-                relay2State = true
-                updateButtonState(relay2Button, true, R.string.relay2_off)
-                // Turning relay2 on automatically turns relay1 off
-                relay1State = false
-                updateButtonState(relay1Button, false, R.string.relay1_on)
-            }
-            else {
-                Log.d(TAG, "Turn off Relay2.")
-                this.writeRelaysState(byteArrayOf(0x00))
-                relay2State = false
-                updateButtonState(relay2Button, false, R.string.relay2_on)
+            val tapNs = SystemClock.elapsedRealtimeNanos()
+            // Turning relay2 on automatically turns relay1 off
+            val command = if (!relay2State) BleService.COMMAND_DOWN else BleService.COMMAND_STOP
+            Log.d(TAG, if (!relay2State) "Turn on Relay2..." else "Turn off Relay2.")
+            relayModel.predict(command, this.writeRelaysState(command, tapNs), tapNs)
+        }
+
+        // Tap-to-relay latency benchmark
+        findViewById<Button>(R.id.benchmarkBtn).setOnClickListener {
+            startActivity(Intent(this, BenchmarkActivity::class.java))
+        }
+
+        // Connection kept by the foreground service, for the tiles and the widget
+        val keepConnectedSwitch = findViewById<Switch>(R.id.keepConnectedSwitch)
+        keepConnectedSwitch.isChecked = BleService.isKeepConnected(this)
+        keepConnectedSwitch.setOnCheckedChangeListener { _, checked ->
+            if (checked && (Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU) &&
+                (checkSelfPermission(Manifest.permission.POST_NOTIFICATIONS) != PackageManager.PERMISSION_GRANTED)) {
+                // The service runs without it, but its notification is hidden
+                requestPermissions(arrayOf(Manifest.permission.POST_NOTIFICATIONS), REQUEST_NOTIFICATION_CODE)
             }
+            BleService.setKeepConnected(this, checked)
         }
     }
 
     override fun onResume() {
         super.onResume()
-        // Register the GATT update receiver to communicate with the BLE service
-        registerReceiver(gattUpdateReceiver, makeGattUpdateIntentFilter())
+        // Low latency connection while controlling
+        bleService?.setControlActive(true)
     }
 
     override fun onPause() {
         super.onPause()
-        // Unregister the GATT update receiver
-        unregisterReceiver(gattUpdateReceiver)
+        // Back to a balanced connection in the background
+        bleService?.setControlActive(false)
+    }
+
+    override fun onStop() {
+        super.onStop()
+        Log.i(TAG, "Relay state ${relayModel.summary()}")
     }
 
     override fun onRequestPermissionsResult(
@@ -225,13 +245,37 @@ class MainActivity : ComponentActivity() {
         }
         // Update devices list
         deviceList.clear()
+        deviceAddresses.clear()
         val itemDevices = bleScanner.getDeviceList()
         itemDevices.forEach {itemDevice ->
             deviceList.add("${itemDevice.value.name} (${itemDevice.key})")
+            deviceAddresses.add(itemDevice.key)
         }
         arrayAdapter?.notifyDataSetChanged()
     }
 
+    /**
+     * @brief Log the time since the application process started, for the
+     *        first connection only
+     * @param step The launch step reached
+     */
+    private fun logLaunchTime(step: String) {
+        if (launchLogged) { return }
+        val elapsedMs = SystemClock.elapsedRealtime() - Process.getStartElapsedRealtime()
+        Log.i(TAG, "Launch to $step: $elapsedMs ms")
+    }
+
+    /**
+     * @brief Update the relay buttons to a relays state
+     * @param state The relay bits of the command byte (bit [0]: Relay1, bit [1]: Relay2)
+     */
+    private fun updateRelayButtons(state: Int) {
+        relay1State = (state and RELAY1_MASK) != 0
+        relay2State = (state and RELAY2_MASK) != 0
+        updateButtonState(findViewById(R.id.relay1Btn), relay1State, if (relay1State) R.string.relay1_off else R.string.relay1_on)
+        updateButtonState(findViewById(R.id.relay2Btn), relay2State, if (relay2State) R.string.relay2_off else R.string.relay2_on)
+    }
+
     /**
      * @brief Update the textview indicating the connection state
      * @param connectionState A string indicating the new connection state
@@ -273,43 +317,85 @@ class MainActivity : ComponentActivity() {
                 }
                 // Perform device connection
                 Log.d(TAG, "Bluetooth service initialized")
+                bluetooth.setControlActive(lifecycle.currentState.isAtLeast(Lifecycle.State.RESUMED))
+                collectServiceUpdates(bluetooth)
+
+                // Connect directly to the last sofa, without scanning
+                bluetooth.getLastAddress()?.let { address ->
+                    if (bluetooth.getConnectionState() == BleService.STATE_DISCONNECTED) {
+                        Log.d(TAG, "Connect to the last device: $address")
+                        bluetooth.connect(address)
+                    }
+                }
             }
         }
 
         override fun onServiceDisconnected(componentName: ComponentName) {
+            serviceUpdates?.cancel()
+            serviceUpdates = null
             bleService = null
         }
     }
 
     /**
-     * @brief Broadcast communication with the BLE service
+     * @brief Collect the state updates of the BLE service while the activity
+     *        is visible: they are delivered on the main thread, without going
+     *        through the system broadcasts
+     * @param service The bound BLE service
      */
-    private val gattUpdateReceiver : BroadcastReceiver = object : BroadcastReceiver() {
-        override fun onReceive(context: Context, intent: Intent) {
-            when (intent.action) {
-                BleService.ACTION_GATT_CONNECTED -> {
-                    connected = true
-                    updateConnectionState(R.string.connected)
+    private fun collectServiceUpdates(service: BleService) {
+        serviceUpdates?.cancel()
+        serviceUpdates = lifecycleScope.launch {
+            repeatOnLifecycle(Lifecycle.State.STARTED) {
+                launch {
+                    service.connection.collect { update ->
+                        logEventLatency("connection", update.timestampNs)
+                        when (update.state) {
+                            BleService.STATE_CONNECTED -> {
+                                connected = true
+                                updateConnectionState(R.string.connected)
+                                logLaunchTime("connected")
+                            }
+                            BleService.STATE_READY -> {
+                                connected = true
+                                updateConnectionState(R.string.connected)
+                                logLaunchTime("ready")
+                                launchLogged = true
+                            }
+                            else -> {
+                                connected = false
+                                updateConnectionState(R.string.disconnected)
+                                relayModel.reset()
+                            }
+                        }
+                    }
                 }
-                BleService.ACTION_GATT_DISCONNECTED -> {
-                    connected = false
-                    updateConnectionState(R.string.disconnected)
+                launch {
+                    service.relayState.collect { update ->
+                        update?.let {
+                            logEventLatency("relay", it.timestampNs)
+                            relayModel.onFirmwareState(it.state, it.ack, it.timestampNs)
+                        }
+                    }
                 }
-                BleService.ACTION_REQUIRE_PERMISSIONS -> {
-                    blePermission.requestBlePermissions(this@MainActivity)
+                launch {
+                    service.permissionRequests.collect {
+                        blePermission.requestBlePermissions(this@MainActivity)
+                    }
                 }
             }
         }
     }
 
     /**
-     * @brief Intent filter for broadcast communication with the BLE service
+     * @brief Log the delay from a GATT event to its handling on the main thread
+     * @param name The event name
+     * @param timestampNs Time of the GATT event, 0 for the initial state
      */
-    private fun makeGattUpdateIntentFilter() : IntentFilter? {
-        return IntentFilter().apply {
-            addAction(BleService.ACTION_GATT_CONNECTED)
-            addAction(BleService.ACTION_GATT_DISCONNECTED)
-        }
+    private fun logEventLatency(name: String, timestampNs: Long) {
+        if (timestampNs == 0L) { return }
+        val latencyUs = (SystemClock.elapsedRealtimeNanos() - timestampNs) / 1000
+        Log.d(TAG, "Event to UI ($name): $latencyUs us")
     }
 
     //--------------------------------
@@ -317,21 +403,24 @@ class MainActivity : ComponentActivity() {
     //--------------------------------
 
     /**
-     * Setup the relays state using the dedicated GATT service
+     * Setup the relays state using the dedicated GATT service: a state not
+     * sent yet is replaced by the newer one. Same path as the tiles, so their
+     * tap-to-write latencies compare
+     * @param command The relays command
+     * @param tapNs Time of the tap
+     * @return The frame sequence number, -1 if not sent
      */
-    private fun writeRelaysState(payload: ByteArray) {
-        // Primary service
-        val relaysServiceUUID = UUID.fromString("0000ff10-0000-1000-8000-00805f9b34fb")
-        // GATT characteristic
-        val relaysStateCharUUID = UUID.fromString("0000ff11-0000-1000-8000-00805f9b34fb")
-        // Write without response
-        val writeType = BluetoothGattCharacteristic.WRITE_TYPE_NO_RESPONSE
-
-        bleService?.writeCharacteristics(relaysServiceUUID, relaysStateCharUUID, writeType, payload)
+    private fun writeRelaysState(command: Int, tapNs: Long) : Int {
+        return bleService?.sendCommand(command, BleService.SOURCE_ACTIVITY, tapNs) ?: -1
     }
 
     companion object {
         /** @brief Debug TAG */
         private const val TAG = "MainActivity"
+        /** @brief Relay bits of the applied command byte */
+        private const val RELAY1_MASK = 0x01
+        private const val RELAY2_MASK = 0x02
+        /** @brief Notification permission request, for the foreground connection */
+        private const val REQUEST_NOTIFICATION_CODE = 2
     }
 }
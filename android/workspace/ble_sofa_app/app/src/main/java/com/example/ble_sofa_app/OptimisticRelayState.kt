@@ -0,0 +1,201 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: OptimisticRelayState.tk
+-- Description: Optimistic relay state: predicted on the tap, reconciled with
+--              the state notified or read from the firmware
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+package com.example.ble_sofa_app
+
+import android.os.Handler
+import android.os.SystemClock
+import android.util.Log
+
+/**
+ * @brief The UI shows the predicted command as soon as it is sent. The
+ *        telemetry acknowledging its frame gives the state the firmware
+ *        applied: the prediction is confirmed when both relays match, or
+ *        rolled back when the firmware applied something else (end-stop
+ *        reached, wired button).
+ *        Without acknowledgement in time, the display falls back to the last
+ *        firmware state. All the state is confined to the handler thread.
+ * @param handler Handler of the UI thread
+ * @param timeoutMs Delay after which a prediction not acknowledged is dropped
+ */
+class OptimisticRelayState(private val handler: Handler, private val timeoutMs: Long = DEFAULT_TIMEOUT_MS) {
+    //----------------------------------------------------------------
+    // Private variables
+    //----------------------------------------------------------------
+    /** @brief Command predicted, waiting for the acknowledgement of its frame */
+    private class Prediction(val command: Int, val sequence: Int, val predictedNs: Long)
+    private var prediction : Prediction? = null
+
+    /** @brief Last state applied by the firmware, -1 if unknown */
+    private var confirmed : Int = -1
+
+    /** @brief Prediction to acknowledgement delays (ns), and time shown wrong before a rollback (ns) */
+    private val confirmLatencies : ArrayDeque<Long> = ArrayDeque()
+    private val divergences : ArrayDeque<Long> = ArrayDeque()
+
+    /** @brief No acknowledgement in time: back to the firmware state */
+    private val timeout = Runnable {
+        prediction?.let { expired ->
+            nbTimeouts++
+            recordDivergence(expired, confirmed, SystemClock.elapsedRealtimeNanos(), "no acknowledgement")
+            prediction = null
+            onTimeout?.invoke()
+            notifyChanged(expired.command)
+        }
+    }
+
+    //----------------------------------------------------------------
+    // Public variables
+    //----------------------------------------------------------------
+    /** @brief Called when the displayed state changes, with the new state */
+    var onChanged : ((Int) -> Unit)? = null
+
+    /** @brief Called when a prediction times out, to read the firmware state */
+    var onTimeout : (() -> Unit)? = null
+
+    /** @brief State to display: the prediction, else the firmware state (-1 if unknown) */
+    val displayed : Int
+        get() = prediction?.command ?: confirmed
+
+    /** @brief Predictions made, confirmed, rolled back on a different state, dropped on timeout */
+    var nbPredictions : Int = 0
+        private set
+    var nbConfirmed : Int = 0
+        private set
+    var nbMismatches : Int = 0
+        private set
+    var nbTimeouts : Int = 0
+        private set
+
+    //----------------------------------------------------------------
+    // Private functions
+    //----------------------------------------------------------------
+    /**
+     * @brief Keep the last NB_SAMPLES values
+     */
+    private fun record(samples: ArrayDeque<Long>, value: Long) {
+        samples.addLast(value)
+        if (samples.size > NB_SAMPLES) { samples.removeFirst() }
+    }
+
+    /**
+     * @brief Median of the recorded values (ns), -1 if none
+     */
+    private fun median(samples: ArrayDeque<Long>) : Long {
+        return if (samples.isEmpty()) -1 else samples.sorted()[samples.size / 2]
+    }
+
+    /**
+     * @brief Log a prediction rolled back
+     */
+    private fun recordDivergence(expired: Prediction, state: Int, nowNs: Long, reason: String) {
+        val durationNs = nowNs - expired.predictedNs
+        record(divergences, durationNs)
+        Log.w(TAG, "Prediction %02x rolled back to %02x after %.1f ms (%s)"
+            .format(expired.command, state and 0xFF, durationNs / 1e6, reason))
+    }
+
+    /**
+     * @brief Notify the UI if the displayed state changed
+     */
+    private fun notifyChanged(previous: Int) {
+        if (displayed != previous) {
+            onChanged?.invoke(displayed)
+        }
+    }
+
+    //----------------------------------------------------------------
+    // Public functions
+    //----------------------------------------------------------------
+    /**
+     * @brief A command was sent: display it at once
+     * @param command The command byte
+     * @param sequence Sequence number of its frame, -1 if it was not sent yet
+     * @param nowNs Time of the tap
+     */
+    fun predict(command: Int, sequence: Int, nowNs: Long = SystemClock.elapsedRealtimeNanos()) {
+        val previous = displayed
+        handler.removeCallbacks(timeout)
+        // A newer command supersedes the one waiting: only the last is reconciled
+        prediction = Prediction(command, sequence, nowNs)
+        nbPredictions++
+        handler.postDelayed(timeout, timeoutMs)
+        notifyChanged(previous)
+    }
+
+    /**
+     * @brief Firmware state, from a telemetry notification or read
+     * @param state The applied command byte
+     * @param ack Sequence number of the last command frame received, -1 if unknown
+     * @param timestampNs Time of the notification
+     */
+    fun onFirmwareState(state: Int, ack: Int, timestampNs: Long) {
+        val previous = displayed
+        confirmed = state
+        val pending = prediction
+        if ((pending != null) && (pending.sequence >= 0) && (ack == pending.sequence)) {
+            // The firmware applied the predicted command, or overrode it
+            handler.removeCallbacks(timeout)
+            prediction = null
+            if ((state and RELAYS_MASK) == (pending.command and RELAYS_MASK)) {
+                nbConfirmed++
+                record(confirmLatencies, timestampNs - pending.predictedNs)
+            }
+            else {
+                nbMismatches++
+                recordDivergence(pending, state, timestampNs, "firmware state")
+            }
+        }
+        // Otherwise an older frame or a local change: the prediction is kept
+        notifyChanged(previous)
+    }
+
+    /**
+     * @brief Connection lost: nothing left to reconcile
+     */
+    fun reset() {
+        val previous = displayed
+        handler.removeCallbacks(timeout)
+        prediction = null
+        confirmed = -1
+        notifyChanged(previous)
+    }
+
+    /**
+     * @brief Prediction accuracy, for the logs
+     */
+    fun summary() : String {
+        return "%d predictions: %d confirmed (median %.1f ms), %d rolled back, %d timed out (median %.1f ms shown wrong)"
+            .format(nbPredictions, nbConfirmed, median(confirmLatencies) / 1e6, nbMismatches, nbTimeouts, median(divergences) / 1e6)
+    }
+
+    companion object {
+        /** @brief Debug TAG */
+        private const val TAG = "OptimisticRelayState"
+        /** @brief Default acknowledgement timeout */
+        const val DEFAULT_TIMEOUT_MS = 1000L
+        /** @brief Relay bits of the applied command byte, the hold-to-run bit is not predicted */
+        private const val RELAYS_MASK = 0x03
+        /** @brief Number of latencies kept for the medians */
+        private const val NB_SAMPLES = 100
+    }
+}
@@ -0,0 +1,132 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: SofaTileService.tk
+-- Description: Quick Settings tiles: Up, Down and Stop commands over the
+--              connection of the BLE service
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+package com.example.ble_sofa_app
+
+import android.content.ComponentName
+import android.content.Context
+import android.content.Intent
+import android.content.ServiceConnection
+import android.os.IBinder
+import android.os.SystemClock
+import android.service.quicksettings.Tile
+import android.service.quicksettings.TileService
+import android.util.Log
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.cancel
+import kotlinx.coroutines.launch
+
+/**
+ * @brief Tile sending one motion command. The BLE service is bound while the
+ *        Quick Settings panel is open: the last device is connected as soon as
+ *        the panel opens, if the link is not kept in the background, so the
+ *        tap only writes the command
+ * @param command BleService.COMMAND_UP, COMMAND_DOWN or COMMAND_STOP
+ */
+abstract class SofaTileService(private val command: Int) : TileService() {
+    //----------------------------------------------------------------
+    // Private variables
+    //----------------------------------------------------------------
+    /** @brief Bound BLE service, null while the panel is closed */
+    private var bleService : BleService? = null
+    private var bound = false
+
+    /** @brief Collection of the connection state while the panel is open */
+    private var scope : CoroutineScope? = null
+
+    /** @brief Binding to the BLE service */
+    private val serviceConnection : ServiceConnection = object : ServiceConnection {
+        override fun onServiceConnected(componentName: ComponentName, service: IBinder) {
+            val bluetooth = (service as BleService.LocalBinder).getService()
+            bleService = bluetooth
+            if (bluetooth.initialize()) {
+                bluetooth.connectLast()
+            }
+            scope?.launch {
+                bluetooth.connection.collect { update -> updateTile(update.state) }
+            }
+        }
+
+        override fun onServiceDisconnected(componentName: ComponentName) {
+            bleService = null
+            updateTile(BleService.STATE_DISCONNECTED)
+        }
+    }
+
+    //----------------------------------------------------------------
+    // Private functions
+    //----------------------------------------------------------------
+    /**
+     * @brief Show the tile active once the command can be written
+     * @param state The connection state
+     */
+    private fun updateTile(state: Int) {
+        qsTile?.let { tile ->
+            tile.state = if (state == BleService.STATE_READY) Tile.STATE_ACTIVE else Tile.STATE_INACTIVE
+            tile.updateTile()
+        }
+    }
+
+    //----------------------------------------------------------------
+    // Public functions
+    //----------------------------------------------------------------
+    override fun onStartListening() {
+        super.onStartListening()
+        scope = CoroutineScope(Job() + Dispatchers.Main)
+        bound = bindService(Intent(this, BleService::class.java), serviceConnection, Context.BIND_AUTO_CREATE)
+    }
+
+    override fun onStopListening() {
+        scope?.cancel()
+        scope = null
+        if (bound) {
+            unbindService(serviceConnection)
+            bound = false
+        }
+        bleService = null
+        super.onStopListening()
+    }
+
+    override fun onClick() {
+        super.onClick()
+        val tapNs = SystemClock.elapsedRealtimeNanos()
+        bleService?.sendCommand(command, BleService.SOURCE_TILE, tapNs) ?: run {
+            Log.w(TAG, "BLE service not bound: command $command dropped")
+        }
+    }
+
+    companion object {
+        /** @brief Debug TAG */
+        private const val TAG = "SofaTileService"
+    }
+}
+
+/** @brief Up tile */
+class UpTileService : SofaTileService(BleService.COMMAND_UP)
+
+/** @brief Down tile */
+class DownTileService : SofaTileService(BleService.COMMAND_DOWN)
+
+/** @brief Stop tile */
+class StopTileService : SofaTileService(BleService.COMMAND_STOP)
@@ -0,0 +1,44 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: SofaWidgetProvider.tk
+-- Description: Home screen widget: Up, Down and Stop buttons
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+package com.example.ble_sofa_app
+
+import android.appwidget.AppWidgetManager
+import android.appwidget.AppWidgetProvider
+import android.content.Context
+import android.widget.RemoteViews
+
+/**
+ * @brief The buttons start the BLE service directly with the command: it
+ *        writes over the kept connection, or connects to the last device first
+ */
+class SofaWidgetProvider : AppWidgetProvider() {
+    override fun onUpdate(context: Context, appWidgetManager: AppWidgetManager, appWidgetIds: IntArray) {
+        val views = RemoteViews(context.packageName, R.layout.widget_sofa).apply {
+            setOnClickPendingIntent(R.id.widgetUpBtn, BleService.commandIntent(context, BleService.COMMAND_UP, BleService.SOURCE_WIDGET))
+            setOnClickPendingIntent(R.id.widgetStopBtn, BleService.commandIntent(context, BleService.COMMAND_STOP, BleService.SOURCE_WIDGET))
+            setOnClickPendingIntent(R.id.widgetDownBtn, BleService.commandIntent(context, BleService.COMMAND_DOWN, BleService.SOURCE_WIDGET))
+        }
+        appWidgetIds.forEach { appWidgetId ->
+            appWidgetManager.updateAppWidget(appWidgetId, views)
+        }
+    }
+}
@@ -0,0 +1,144 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: adv_state.c
+-- Description: Advertising data with the sofa state in a manufacturer
+--              specific record, rate-limited updates
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "adv_state.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+// AD types (Bluetooth Assigned Numbers)
+#define ADV_TYPE_FLAGS              0x01
+#define ADV_TYPE_INCOMPLETE_UUID16  0x02
+#define ADV_TYPE_COMPLETE_NAME      0x09
+#define ADV_TYPE_MANUFACTURER       0xFF
+
+// LE General Discoverable, BR/EDR not supported
+#define ADV_FLAGS                   0x06
+#define ADV_SERVICE_UUID16          0xFF10
+
+// Manufacturer specific record: company identifier and state
+#define ADV_RECORD_SIZE             6
+
+// Record fields
+#define ADV_RECORD_SEQUENCE         3
+#define ADV_RECORD_COMMAND          4
+#define ADV_RECORD_ENDSTOP          5
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Append an AD structure: length, type, value
+ */
+static void adv_state_append(adv_state_t * adv, uint8_t type, const uint8_t * value, uint8_t size) {
+    adv->data[adv->len++] = size + 1;
+    adv->data[adv->len++] = type;
+    memcpy(&adv->data[adv->len], value, size);
+    adv->len += size;
+}
+
+/**
+ * @brief Check whether the advertised state differs
+ */
+static bool adv_state_changed(const adv_state_t * adv, uint8_t command, uint8_t endstop) {
+    const uint8_t * record = &adv->data[adv->offset];
+    return (record[ADV_RECORD_COMMAND] != command) || (record[ADV_RECORD_ENDSTOP] != endstop);
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file adv_state.h
+ * @name adv_state_init
+ */
+void adv_state_init(adv_state_t * adv, const char * name, uint8_t command, uint8_t endstop) {
+    memset(adv, 0, sizeof(adv_state_t));
+    adv->min_interval_ms = ADV_STATE_MIN_INTERVAL_MS;
+
+    const uint8_t flags = ADV_FLAGS;
+    const uint8_t uuid[2] = { (uint8_t)ADV_SERVICE_UUID16, (uint8_t)(ADV_SERVICE_UUID16 >> 8) };
+    const uint8_t record[ADV_RECORD_SIZE] = {
+        (uint8_t)ADV_STATE_COMPANY_ID, (uint8_t)(ADV_STATE_COMPANY_ID >> 8), ADV_STATE_VERSION, 0, command, endstop,
+    };
+
+    // The name takes what the other structures leave
+    size_t name_len = strlen(name);
+    size_t name_max = ADV_STATE_MAX_DATA_SIZE - (2 + sizeof(flags)) - (2 + sizeof(uuid)) - (2 + sizeof(record)) - 2;
+    if (name_len > name_max) { name_len = name_max; }
+
+    adv_state_append(adv, ADV_TYPE_FLAGS, &flags, sizeof(flags));
+    adv_state_append(adv, ADV_TYPE_COMPLETE_NAME, (const uint8_t *)name, (uint8_t)name_len);
+    adv_state_append(adv, ADV_TYPE_INCOMPLETE_UUID16, uuid, sizeof(uuid));
+    adv->offset = adv->len + 2;
+    adv_state_append(adv, ADV_TYPE_MANUFACTURER, record, sizeof(record));
+}
+
+/**
+ * @file adv_state.h
+ * @name adv_state_update
+ */
+bool adv_state_update(adv_state_t * adv, uint8_t command, uint8_t endstop, uint64_t now_us) {
+    // Back to the advertised state before the deadline: nothing to send
+    if (!adv_state_changed(adv, command, endstop)) {
+        adv->pending = false;
+        return false;
+    }
+
+    if ((adv->nb_updates > 0) && (now_us - adv->last_update_us < (uint64_t)adv->min_interval_ms * 1000)) {
+        if (!adv->pending) { adv->nb_deferred++; }
+        adv->pending = true;
+        return false;
+    }
+
+    uint8_t * record = &adv->data[adv->offset];
+    record[ADV_RECORD_SEQUENCE] = ++adv->sequence;
+    record[ADV_RECORD_COMMAND] = command;
+    record[ADV_RECORD_ENDSTOP] = endstop;
+    adv->pending = false;
+    adv->last_update_us = now_us;
+    adv->nb_updates++;
+
+    return true;
+}
+
+/**
+ * @file adv_state.h
+ * @name adv_state_set_min_interval
+ */
+void adv_state_set_min_interval(adv_state_t * adv, uint32_t min_interval_ms) {
+    adv->min_interval_ms = min_interval_ms;
+}
+
+/**
+ * @file adv_state.h
+ * @name adv_state_next_deadline_us
+ */
+uint64_t adv_state_next_deadline_us(const adv_state_t * adv) {
+    if (!adv->pending) { return 0; }
+    return adv->last_update_us + (uint64_t)adv->min_interval_ms * 1000;
+}
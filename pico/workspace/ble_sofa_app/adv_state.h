@@ -0,0 +1,107 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: adv_state.h
+-- Description: Advertising data with the sofa state in a manufacturer
+--              specific record, rate-limited updates
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef ADV_STATE_H
+#define ADV_STATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Maximum legacy advertising data size */
+#define ADV_STATE_MAX_DATA_SIZE     31
+/** @brief Company identifier reserved for tests (no assigned identifier) */
+#define ADV_STATE_COMPANY_ID        0xFFFF
+/** @brief State record version */
+#define ADV_STATE_VERSION           1
+/** @brief Default minimum time between two advertising data updates */
+#define ADV_STATE_MIN_INTERVAL_MS   250
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    uint8_t data[ADV_STATE_MAX_DATA_SIZE];  /**> Advertising data, for gap_advertisements_set_data() */
+    uint8_t len;                            /**> Advertising data size */
+    uint8_t offset;                         /**> Offset of the state record in data */
+    uint8_t sequence;                       /**> Incremented on each advertised change */
+    bool pending;                           /**> A change waits for the rate limit */
+    uint32_t min_interval_ms;               /**> Minimum time between two advertised changes */
+    uint64_t last_update_us;                /**> Time of the last advertised change */
+    uint32_t nb_updates;                    /**> Number of advertised changes */
+    uint32_t nb_deferred;                   /**> Number of changes delayed by the rate limit */
+} adv_state_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Build the advertising data: flags, complete local name, control
+ *        service UUID (FF10) and the manufacturer specific state record,
+ *        little-endian:
+ *        - [0..1] Company identifier (ADV_STATE_COMPANY_ID)
+ *        - [2]    Record version
+ *        - [3]    Sequence number, incremented on each change
+ *        - [4]    Applied command byte
+ *        - [5]    End-stop status
+ *
+ * @param adv The advertising state
+ * @param name The local name, truncated to fit
+ * @param command Initial command byte
+ * @param endstop Initial end-stop status
+ */
+void adv_state_init(adv_state_t * adv, const char * name, uint8_t command, uint8_t endstop);
+
+/**
+ * @brief Update the state record if the state changed and the last update
+ *        is older than min_interval_ms, otherwise mark it pending
+ *
+ * @param adv The advertising state
+ * @param command Applied command byte
+ * @param endstop End-stop status
+ * @param now_us Current time in microseconds
+ * @return true if the advertising data changed and must be set again
+ */
+bool adv_state_update(adv_state_t * adv, uint8_t command, uint8_t endstop, uint64_t now_us);
+
+/**
+ * @brief Change the rate limit, applied to the pending change too
+ *
+ * @param adv The advertising state
+ * @param min_interval_ms Minimum time between two advertised changes
+ */
+void adv_state_set_min_interval(adv_state_t * adv, uint32_t min_interval_ms);
+
+/**
+ * @brief Get the time at which a pending change can be advertised
+ *
+ * @param adv The advertising state
+ * @return uint64_t The deadline in microseconds, 0 if no change is pending
+ */
+uint64_t adv_state_next_deadline_us(const adv_state_t * adv);
+
+#endif // ADV_STATE_H
@@ -0,0 +1,58 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: aes128.h
+-- Description: AES-128 encryption tuned for the Cortex-M0+: single T-table
+--              and S-box in SRAM, code executed from RAM
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef AES128_H
+#define AES128_H
+
+#include <stdint.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Number of rounds */
+#define AES128_NB_ROUNDS  10
+/** @brief Number of 32-bit words of the expanded key */
+#define AES128_RK_WORDS   (4 * (AES128_NB_ROUNDS + 1))
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Expand a 128-bit key into the round keys
+ *
+ * @param rk The round keys (AES128_RK_WORDS words)
+ * @param key The 16 bytes key
+ */
+void aes128_setup(uint32_t * rk, const uint8_t * key);
+
+/**
+ * @brief Encrypt one 16 bytes block
+ *
+ * @param rk The round keys computed by aes128_setup()
+ * @param plaintext The 16 bytes input block
+ * @param ciphertext The 16 bytes output block
+ */
+void aes128_encrypt(const uint32_t * rk, const uint8_t * plaintext, uint8_t * ciphertext);
+
+#endif // AES128_H
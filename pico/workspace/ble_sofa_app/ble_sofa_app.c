@@ -15,7 +15,7 @@
 -- File Name: ble_sofa_app.c
 -- Description: Control of two relays via BLE to turn on/off two 12V DC fans
 --
--- Last update: 2023-09-24
+-- Last update: 2026-10-18
 --
 -------------------------------------------------------------------------------*/
 
@@ -23,14 +23,41 @@
 
 #include "btstack_run_loop.h"
 #include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/structs/scb.h"
+#include "hardware/flash.h"
+#include "hardware/watchdog.h"
+#include "pico/flash.h"
 #include "btstack_event.h"
 #include "pico/cyw43_arch.h"
 #include "pico/btstack_cyw43.h"
 #include "btstack.h"
 #include "ble/gatt-service/nordic_spp_service_server.h"
-#include "mygatt.h"
 
 #include "relay.h"
+#include "power.h"
+#include "ecc_keys.h"
+#include "deadman.h"
+#include "motion.h"
+#include "changeover.h"
+#include "button.h"
+#include "mem_report.h"
+#include "cpuprof.h"
+#include "gatt_service.h"
+#include "adv_state.h"
+#include "ota.h"
+#include "params.h"
+#include "crc32.h"
+#include "pico/unique_id.h"
+#ifdef BLE_SOFA_TOUCH_PADS
+#include "touch_pad.h"
+#endif
+#ifdef BLE_SOFA_USB_CDC
+#include "tusb.h"
+#include "usb_link.h"
+#endif
 
 //----------------------------------------------------------------
 // Constants
@@ -41,6 +68,20 @@
 #define RELAY1_GPIO   6
 #define RELAY2_GPIO   7
 
+// Local Up/Down buttons, active low with internal pull-ups
+#define BUTTON_UP_GPIO    10
+#define BUTTON_DOWN_GPIO  11
+
+// Capacitive Up/Down touch pads, 1 MOhm external pull-up each
+#define TOUCH_UP_GPIO     12
+#define TOUCH_DOWN_GPIO   13
+#define TOUCH_THRESHOLD   40
+
+// End-stop switches, normally closed to ground: open (high) at the end of
+// travel or if the wire is cut
+#define ENDSTOP_UP_GPIO   14
+#define ENDSTOP_DOWN_GPIO 15
+
 // Global variables
 
 /** @brief Structure to control Relay1 */
@@ -49,33 +90,118 @@ relay_t relay1;
 /** @brief Structure to control Relay2 */
 relay_t relay2;
 
+/** @brief Power manager: clock scaling and residency counters */
+power_manager_t power;
+
+/** @brief Hold-to-run deadman */
+deadman_t deadman;
+
+/** @brief Run loop CPU profiler */
+cpuprof_t cpuprof;
+
+/** @brief Profiler cycle counter: cycles and timer at the last clk_sys change */
+static struct {
+    uint64_t base_cycles;
+    uint64_t base_us;
+    uint32_t mhz;
+} cpuprof_clock;
+
+/** @brief Relay command path shared by BLE writes, buttons and the deadman */
+motion_t motion;
+
+/** @brief Up button debouncer */
+button_t button_up;
+
+/** @brief Down button debouncer */
+button_t button_down;
+
+/** @brief Hardware alarm cutting the relays, independent from the run loop */
+static int deadman_alarm_num = -1;
+
+/** @brief Up/Down changeover dead-time on the relay outputs */
+static changeover_t changeover;
+
+/** @brief Hardware alarm driving a line once the changeover dead-time is over */
+static int changeover_alarm_num = -1;
+
+/** @brief Run loop worker notified of relay changes made in interrupt context */
+static async_when_pending_worker_t motion_worker;
+
+/** @brief Firmware update receiver */
+static ota_t ota;
+
+/** @brief Run loop worker programming the received firmware sectors */
+static async_when_pending_worker_t ota_worker;
+
+/** @brief Reboot delay once the firmware is staged, to send the last status */
+#define OTA_REBOOT_DELAY_MS 1000
+
+/** @brief Timeout to pause the other core before a flash operation */
+#define OTA_FLASH_TIMEOUT_MS 100
+
+/** @brief Runtime parameters: advertising, connection and timeouts */
+static params_t params;
+
+/** @brief Run loop worker applying and storing the changed parameters */
+static async_when_pending_worker_t params_worker;
+
+/** @brief Parameters revisions applied to the modules and written to the flash */
+static uint32_t params_revision_applied = 0;
+static uint32_t params_revision_stored = 0;
+
+/** @brief BTstack TLV tag of the stored parameters ('SPRM') */
+#define PARAMS_TLV_TAG  (((uint32_t)'S' << 24) | ((uint32_t)'P' << 16) | ((uint32_t)'R' << 8) | 'M')
+
+#ifdef BLE_SOFA_USB_CDC
+/** @brief Wired control channel on the USB CDC interface */
+static usb_link_t usb_link;
+
+/** @brief Run loop worker running the TinyUSB device task */
+static async_when_pending_worker_t usb_worker;
+#endif
+
 //----------------------------------------------------------------------------------
 // Bluetooth variables
 //----------------------------------------------------------------------------------
 
 #define REPORT_INTERVAL_MS 3000
+
 #define MAX_NR_CONNECTIONS 3 
+#define ADV_LOCAL_NAME "ble-sofa"
 
-/** @brief LED Command characteristic */
-#define ATT_CHARACTERISTIC_0000FF11_VALUE_HANDLE 0x0006
+// LE Data Length Extension: largest LL payload and its transmit time on the 1M PHY
+#define LE_DATA_LENGTH_MAX_OCTETS  251
+#define LE_DATA_LENGTH_MAX_TIME_US 2120
 
-/** @brief Advertisements information */
-const uint8_t adv_data[] = {
-    2, BLUETOOTH_DATA_TYPE_FLAGS, 0x06, 
-    9, BLUETOOTH_DATA_TYPE_COMPLETE_LOCAL_NAME, 'b', 'l', 'e','-', 's', 'o', 'f', 'a',
-    // Incomplete List of 16-bit Service Class UUIDs -- FF10 - only valid for testing!
-    3, BLUETOOTH_DATA_TYPE_INCOMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS, 0x10, 0xff,
-};
-const uint8_t adv_data_len = sizeof(adv_data);
+/** @brief Advertising data, with the sofa state for connectionless observers */
+static adv_state_t adv_state;
 
 /** @brief HCI registration callback */
 static btstack_packet_callback_registration_t hci_event_callback_registration;
 
-// Data: command the relays status:
-//   - bit [0]: '0' = Relay1 OFF, '1' = Relay1 ON
-//   - bit [1]: '0' = Relay2 OFF, '1' = Relay2 ON
-static uint8_t data = 0x00;
-static int data_len = 1; // Data length in byte
+/** @brief Power manager deadline timer */
+static btstack_timer_source_t power_timer;
+
+/** @brief Advertising data update timer, for the changes delayed by the rate limit */
+static btstack_timer_source_t adv_timer;
+
+/** @brief Reboot timer, once a firmware update is staged */
+static btstack_timer_source_t ota_reboot_timer;
+
+/** @brief Rollback timer of the parameters on trial */
+static btstack_timer_source_t params_timer;
+
+/** @brief Connected central, for the connection parameter update requests */
+static hci_con_handle_t le_con_handle = HCI_CON_HANDLE_INVALID;
+
+/** @brief Connection that wrote the last BLE command, owner of a BLE motion */
+static hci_con_handle_t ble_command_con_handle = HCI_CON_HANDLE_INVALID;
+
+/** @brief Connections waiting for their data length request, sent once the
+ *         controller accepts a command */
+static hci_con_handle_t data_length_con_handles[MAX_NR_CONNECTIONS] = {
+    HCI_CON_HANDLE_INVALID, HCI_CON_HANDLE_INVALID, HCI_CON_HANDLE_INVALID
+};
 
 //----------------------------------------------------------------------------------
 // Bluetooth static functions
@@ -83,9 +209,18 @@ static int data_len = 1; // Data length in byte
 
 // Prototypes
 static void hci_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
-static uint16_t att_read_callback(hci_con_handle_t con_handle, uint16_t att_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size);
-static int att_write_callback(hci_con_handle_t con_handle, uint16_t att_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size);
 static void att_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+static void power_handle_event(power_event_t event);
+static void ble_power_on(void);
+static void deadman_handle_kick(void);
+static void deadman_handle_stop(void);
+static void motion_apply(uint8_t command, motion_source_t source);
+static void changeover_alarm_callback(uint alarm_num);
+static void adv_handle_update(void);
+static void ble_request_conn_params(void);
+static void ble_queue_data_length(hci_con_handle_t con_handle, bool queue);
+static void ble_send_data_length(void);
+static uint32_t cpuprof_cycles(void);
 
 /**
  * @brief Host Controller Interface (HCI) Packet Handler
@@ -119,10 +254,22 @@ static void hci_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *p
           conn_interval = hci_subevent_le_connection_complete_get_conn_interval(packet);
           printf("LE Connection - Connection Interval: %u.%02u ms\n", conn_interval * 125 / 100, 25 * (conn_interval & 3));
           printf("LE Connection - Connection Latency: %u\n", hci_subevent_le_connection_complete_get_conn_latency(packet));
+          deadman_set_conn_interval(&deadman, conn_interval);
+
+          // Request the runtime connection parameters (15 ms by default, for iOS 11+)
+          le_con_handle = con_handle;
+          ble_request_conn_params();
 
-          // Request min con_interval 15ms for iOS 11+
-          printf("LE Connection - Request 15 ms connection interval\n");
-          gap_request_connection_parameter_update(con_handle, 12, 12, 0, 0x0048);
+          // Request the largest LL payload, so that a full ATT PDU of the
+          // negotiated MTU goes in one packet (ignored if not supported)
+          ble_queue_data_length(con_handle, true);
+          break;
+        case HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE:
+          printf("LE Connection - Data length: TX %u, RX %u octets\n",
+                    hci_subevent_le_data_length_change_get_max_tx_octets(packet),
+                    hci_subevent_le_data_length_change_get_max_rx_octets(packet));
+          gatt_service_set_data_length(hci_subevent_le_data_length_change_get_max_tx_octets(packet),
+                                       hci_subevent_le_data_length_change_get_max_rx_octets(packet));
           break;
         case HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE:
           // Print connection parameters (without using floating point operations)
@@ -131,69 +278,21 @@ static void hci_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *p
           printf("LE Connection - Connection Param update - connection interval %u.%02u ms, latency %u\n", 
                     conn_interval * 125 / 100,
                     25 * (conn_interval & 3), hci_subevent_le_connection_update_complete_get_conn_latency(packet));
+          deadman_set_conn_interval(&deadman, conn_interval);
           break;
         default:
           break;
       }
       break;
+    case HCI_EVENT_DISCONNECTION_COMPLETE:
+      ble_queue_data_length(hci_event_disconnection_complete_get_connection_handle(packet), false);
+      break;
     default:
       break;
   }
-}
 
-/**
- * @brief ATT client read callback
- * 
- * @param connection_handle 
- * @param att_handle 
- * @param offset 
- * @param buffer 
- * @param buffer_size 
- * @return uint16_t 
- */
-static uint16_t att_read_callback(hci_con_handle_t connection_handle, uint16_t att_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
-    UNUSED(connection_handle);
-
-    //printf("> att_read_callback: att_handle %04x, offset %04x, buff size %04x\n", att_handle, offset, buffer_size);
-
-    if (att_handle == ATT_CHARACTERISTIC_0000FF11_VALUE_HANDLE) {
-        return att_read_callback_handle_blob((const uint8_t *)&data, data_len, offset, buffer, buffer_size);
-    }
-
-    return 0;
-}
-
-/**
- * @brief ATT client write callback
- * 
- * @param connection_handle 
- * @param att_handle 
- * @param transaction_mode 
- * @param offset 
- * @param buffer 
- * @param buffer_size 
- * @return int 
- */
-static int att_write_callback(hci_con_handle_t connection_handle, uint16_t att_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
-    UNUSED(connection_handle);
-    UNUSED(transaction_mode);
-    UNUSED(offset);
-    UNUSED(buffer_size);
-
-    //printf("> att_write_callback: att_handle %04x, offset %04x, buff size %04x\n", att_handle, offset, buffer_size);
-    if ((buffer == NULL) || (att_handle != ATT_CHARACTERISTIC_0000FF11_VALUE_HANDLE)) { return 0; }
-
-    // Update data
-    data = *buffer;
-    //printf("> Update data\t- data = %02x\n", data);
-
-    // Process data
-    // - Bit [0] is used to set Relay1 on/off
-    if (data & 0x01) { relay_on(&relay1); } else { relay_off(&relay1); }
-    // - Bit [1] is used to set Relay2 on/off
-    if (data & 0x02) { relay_on(&relay2); } else { relay_off(&relay2); }
-    
-    return 0;
+  // Any event may free the command slot (command complete or status)
+  ble_send_data_length();
 }
 
 /**
@@ -213,15 +312,948 @@ static void att_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *p
   switch (hci_event_packet_get_type(packet)) {
     case ATT_EVENT_CONNECTED:
       printf("Connected\n");
+      gatt_service_connected(att_event_connected_get_handle(packet));
+      power_handle_event(POWER_EVENT_CONNECTED);
       break;
     case ATT_EVENT_DISCONNECTED:
       printf("Disconnected\n");
+      gatt_service_disconnected(att_event_disconnected_get_handle(packet));
+      le_con_handle = HCI_CON_HANDLE_INVALID;
+      // The hold-to-run client is gone: stop now rather than at the deadline.
+      // A motion from the button, USB or another connection goes on
+      if (deadman.armed && (motion.last_source == MOTION_SOURCE_BLE) &&
+          (ble_command_con_handle == att_event_disconnected_get_handle(packet))) {
+        deadman_handle_stop();
+      }
+      power_handle_event(POWER_EVENT_DISCONNECTED);
+      // Parameters on trial may have broken the link: back to the stored set
+      if (params_rollback(&params)) { printf("Parameters - set on trial rolled back\n"); }
+      break;
+    case ATT_EVENT_MTU_EXCHANGE_COMPLETE:
+      mem_report_set_mtu(att_event_mtu_exchange_complete_get_MTU(packet));
+      gatt_service_set_mtu(att_event_mtu_exchange_complete_get_MTU(packet));
       break;
     default:
       break;
   }
 }
 
+/**
+ * @brief Turn on the Bluetooth controller, once the LE Secure Connections
+ *        key pair is available
+ */
+static void ble_power_on(void) {
+    hci_power_control(HCI_POWER_ON);
+}
+
+/**
+ * @brief Pairing passkey, printed on the sofa label: BLE_SOFA_PASSKEY if set
+ *        at build time, derived from the flash unique ID otherwise
+ *
+ * @return uint32_t The 6-digit passkey
+ */
+static uint32_t ble_passkey(void) {
+#ifdef BLE_SOFA_PASSKEY
+    return (uint32_t)BLE_SOFA_PASSKEY % 1000000;
+#else
+    pico_unique_board_id_t id;
+    pico_get_unique_board_id(&id);
+    return crc32_update(0, id.id, PICO_UNIQUE_BOARD_ID_SIZE_BYTES) % 1000000;
+#endif
+}
+
+/**
+ * @brief Link allowed to change the firmware or the parameters: encrypted with a full-size
+ *        key, after a passkey pairing, and bonded
+ *
+ * @param con_handle The connection handle
+ * @return true if the link is secured
+ */
+static bool ble_link_secured(hci_con_handle_t con_handle) {
+    return (gap_encryption_key_size(con_handle) == 16) && gap_authenticated(con_handle) && gap_bonded(con_handle);
+}
+
+/**
+ * @brief Request the connection parameters of the runtime set
+ */
+static void ble_request_conn_params(void) {
+    uint16_t interval_max = (uint16_t)params_get(&params, PARAM_CONN_INTERVAL_MAX);
+
+    if (le_con_handle == HCI_CON_HANDLE_INVALID) { return; }
+    printf("LE Connection - Request %u.%02u ms connection interval\n", interval_max * 125 / 100, 25 * (interval_max & 3));
+    gap_request_connection_parameter_update(le_con_handle,
+                                            (uint16_t)params_get(&params, PARAM_CONN_INTERVAL_MIN),
+                                            interval_max,
+                                            (uint16_t)params_get(&params, PARAM_CONN_LATENCY),
+                                            (uint16_t)params_get(&params, PARAM_SUPERVISION_TIMEOUT));
+}
+
+/**
+ * @brief Add or remove a connection waiting for its data length request
+ *
+ * @param con_handle The connection handle
+ * @param queue true to add the connection, false to remove it
+ */
+static void ble_queue_data_length(hci_con_handle_t con_handle, bool queue) {
+    for (int i = 0; i < MAX_NR_CONNECTIONS; i++) {
+        if (data_length_con_handles[i] == con_handle) { data_length_con_handles[i] = HCI_CON_HANDLE_INVALID; }
+    }
+    if (!queue) { return; }
+    for (int i = 0; i < MAX_NR_CONNECTIONS; i++) {
+        if (data_length_con_handles[i] == HCI_CON_HANDLE_INVALID) {
+            data_length_con_handles[i] = con_handle;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Send the data length requests waiting for the controller, one per
+ *        free command slot
+ */
+static void ble_send_data_length(void) {
+    for (int i = 0; i < MAX_NR_CONNECTIONS; i++) {
+        if (data_length_con_handles[i] == HCI_CON_HANDLE_INVALID) { continue; }
+        if (!hci_can_send_command_packet_now()) { return; }
+        hci_send_cmd(&hci_le_set_data_length, data_length_con_handles[i], LE_DATA_LENGTH_MAX_OCTETS, LE_DATA_LENGTH_MAX_TIME_US);
+        data_length_con_handles[i] = HCI_CON_HANDLE_INVALID;
+    }
+}
+
+/**
+ * @brief Set the advertising parameters of the runtime set
+ */
+static void ble_set_adv_params(void) {
+    uint16_t adv_interval = (uint16_t)params_get(&params, PARAM_ADV_INTERVAL);
+    uint8_t adv_type = 0;
+    bd_addr_t null_addr;
+    memset(null_addr, 0, 6);
+    gap_advertisements_set_params(adv_interval, adv_interval, adv_type, 0, null_addr, 0x07, 0x00);
+}
+
+//----------------------------------------------------------------
+// Hold-to-run deadman
+//----------------------------------------------------------------
+
+/**
+ * @brief Deadman alarm interrupt: cut the relays if the keep-alive is late
+ *
+ * @param alarm_num The hardware alarm number
+ * @note Runs in interrupt context, whatever the state of the BTstack run loop
+ */
+static void deadman_alarm_callback(uint alarm_num) {
+    if (deadman_trip(&deadman, time_us_64())) {
+        motion_apply(MOTION_STOP, MOTION_SOURCE_DEADMAN);
+    }
+    else if (deadman.armed) {
+        // The deadline has been pushed by a keep-alive in the meantime
+        if (hardware_alarm_set_target(alarm_num, from_us_since_boot(deadman.deadline_us))) {
+            deadman_alarm_callback(alarm_num);
+        }
+    }
+}
+
+/**
+ * @brief Keep-alive received: push the deadline and re-arm the alarm
+ */
+static void deadman_handle_kick(void) {
+    // The 64-bit deadline is also read by the alarm interrupt
+    uint32_t irq_status = save_and_disable_interrupts();
+    uint64_t deadline = deadman_kick(&deadman, time_us_64());
+    restore_interrupts(irq_status);
+
+    if (hardware_alarm_set_target(deadman_alarm_num, from_us_since_boot(deadline))) {
+        deadman_alarm_callback(deadman_alarm_num);
+    }
+}
+
+/**
+ * @brief Stop a hold-to-run motion immediately
+ */
+static void deadman_handle_stop(void) {
+    deadman_disarm(&deadman);
+    motion_apply(MOTION_STOP, MOTION_SOURCE_DEADMAN);
+}
+
+//----------------------------------------------------------------
+// Motion command path
+//----------------------------------------------------------------
+
+/**
+ * @brief Drive the relays, the released line first so that Up and Down
+ *        are never on together. On a reversal, the other line is driven by
+ *        the changeover alarm once the released contacts had the dead-time
+ *        to open
+ *
+ * @param relays Relay outputs (bit [0]: Relay1, bit [1]: Relay2)
+ * @param context Unused
+ * @note Called with the interrupts disabled, or from an interrupt
+ */
+static void motion_output(uint8_t relays, void * context) {
+    UNUSED(context);
+    uint64_t retry_us;
+    uint8_t driven = changeover_update(&changeover, relays, time_us_64(), &retry_us);
+
+    if (!(driven & MOTION_UP)) { relay_off(&relay1); }
+    if (!(driven & MOTION_DOWN)) { relay_off(&relay2); }
+    if (driven & MOTION_UP) { relay_on(&relay1); }
+    if (driven & MOTION_DOWN) { relay_on(&relay2); }
+
+    if ((retry_us != 0) && hardware_alarm_set_target(changeover_alarm_num, from_us_since_boot(retry_us))) {
+        // Already over: the next update drives the line
+        changeover_alarm_callback(changeover_alarm_num);
+    }
+}
+
+/**
+ * @brief Changeover alarm interrupt: drive the deferred line if the
+ *        command still requests it
+ *
+ * @param alarm_num The hardware alarm number
+ */
+static void changeover_alarm_callback(uint alarm_num) {
+    UNUSED(alarm_num);
+    uint32_t irq_status = save_and_disable_interrupts();
+    motion_output(motion.command & MOTION_RELAYS_MASK, NULL);
+    restore_interrupts(irq_status);
+}
+
+/**
+ * @brief Apply a command to the relays now, and let the run loop update the
+ *        power state
+ *
+ * @param command The command byte
+ * @param source The command source
+ * @note Callable from the run loop, the GPIO interrupt and the alarm interrupts
+ */
+static void motion_apply(uint8_t command, motion_source_t source) {
+    uint32_t irq_status = save_and_disable_interrupts();
+    motion_command(&motion, command, source);
+    restore_interrupts(irq_status);
+
+    async_context_set_work_pending(cyw43_arch_async_context(), &motion_worker);
+}
+
+/**
+ * @brief Run loop side of a relay change
+ */
+static void motion_worker_handler(async_context_t * context, async_when_pending_worker_t * worker) {
+    UNUSED(context);
+    UNUSED(worker);
+    cpuprof_enter(&cpuprof, CPUPROF_SLOT_WORKER, cpuprof_cycles());
+    if (motion.last_source == MOTION_SOURCE_DEADMAN) {
+        printf("Deadman - relays cut (%u trips)\n", deadman.nb_trips);
+    }
+
+    gatt_service_update();
+#ifdef BLE_SOFA_USB_CDC
+    usb_link_update(&usb_link);
+#endif
+    adv_handle_update();
+    power_handle_event(motion_is_moving(&motion) ? POWER_EVENT_MOTION_START : POWER_EVENT_MOTION_STOP);
+
+    // Sofa stopped: program the update sectors deferred while it moved
+    if (!motion_is_moving(&motion) && ota_pending(&ota)) { async_context_set_work_pending(cyw43_arch_async_context(), &ota_worker); }
+    cpuprof_exit(&cpuprof, cpuprof_cycles());
+}
+
+//----------------------------------------------------------------
+// Control service handlers
+//----------------------------------------------------------------
+
+/**
+ * @brief Command byte received from a client, over BLE or USB
+ *
+ * @param command The command byte
+ * @param source The command source
+ */
+static void client_command_apply(uint8_t command, motion_source_t source) {
+    // - Bit [7]: hold-to-run, arm the deadman before any relay is turned on
+    if ((command & MOTION_HOLD_TO_RUN) && (command & MOTION_RELAYS_MASK)) { deadman_handle_kick(); } else { deadman_disarm(&deadman); }
+
+    // - Bits [1:0] set Relay1/Relay2 on/off
+    motion_apply(command, source);
+}
+
+/**
+ * @brief Command byte written by a BLE client
+ *
+ * @param con_handle The client connection
+ * @param command The command byte
+ */
+static void ble_command_apply(hci_con_handle_t con_handle, uint8_t command) {
+    ble_command_con_handle = con_handle;
+    client_command_apply(command, MOTION_SOURCE_BLE);
+}
+
+/**
+ * @brief Any control write brings the system clock back to full speed
+ */
+static void ble_activity(void) {
+    power_handle_event(POWER_EVENT_ATT_WRITE);
+}
+
+/**
+ * @brief Time source of the control service
+ *
+ * @return uint64_t Time since boot in microseconds
+ */
+static uint64_t ble_time_us(void) {
+    return time_us_64();
+}
+
+#ifdef BLE_SOFA_USB_CDC
+//----------------------------------------------------------------
+// USB control channel
+//----------------------------------------------------------------
+
+/**
+ * @brief Command byte received on the USB CDC interface
+ *
+ * @param command The command byte
+ */
+static void usb_command_apply(uint8_t command) {
+    client_command_apply(command, MOTION_SOURCE_USB);
+}
+
+/**
+ * @brief Queue a telemetry frame to the host, and send it without waiting
+ *        for the FIFO to fill
+ *
+ * @param data The stream bytes
+ * @param size The number of bytes
+ * @return true if the bytes were queued
+ */
+static bool usb_write(const uint8_t * data, uint16_t size) {
+    if (!tud_cdc_connected() || (tud_cdc_write_available() < size)) { return false; }
+    tud_cdc_write(data, size);
+    tud_cdc_write_flush();
+    return true;
+}
+
+/**
+ * @brief TinyUSB: data received, read straight into the link receive buffer
+ *        where the frames are decoded
+ *
+ * @param itf The CDC interface
+ */
+void tud_cdc_rx_cb(uint8_t itf) {
+    UNUSED(itf);
+    while (tud_cdc_available() > 0) {
+        uint16_t capacity;
+        uint8_t * buffer = usb_link_rx_buffer(&usb_link, &capacity);
+        uint32_t len = tud_cdc_read(buffer, capacity);
+        if (len == 0) { break; }
+        usb_link_received(&usb_link, (uint16_t)len);
+    }
+}
+
+/**
+ * @brief TinyUSB: the host opened (DTR set) or closed the port
+ *
+ * @param itf The CDC interface
+ * @param dtr Data terminal ready
+ * @param rts Request to send
+ */
+void tud_cdc_line_state_cb(uint8_t itf, bool dtr, bool rts) {
+    UNUSED(itf);
+    UNUSED(rts);
+    usb_link_set_connected(&usb_link, dtr);
+
+    // A hold-to-run host is gone: stop now rather than at the deadline
+    if (!dtr && deadman.armed && (motion.last_source == MOTION_SOURCE_USB)) { deadman_handle_stop(); }
+}
+
+/**
+ * @brief TinyUSB: an event was queued, from the USB interrupt
+ *
+ * @param rhport The USB port
+ * @param eventid The event type
+ * @param in_isr true in interrupt context
+ */
+void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr) {
+    UNUSED(rhport);
+    UNUSED(eventid);
+    UNUSED(in_isr);
+    async_context_set_work_pending(cyw43_arch_async_context(), &usb_worker);
+}
+
+/**
+ * @brief Run loop side of the USB events: the run loop only wakes up for
+ *        them, no polling timer keeps the low power state busy
+ */
+static void usb_worker_handler(async_context_t * context, async_when_pending_worker_t * worker) {
+    UNUSED(context);
+    UNUSED(worker);
+    cpuprof_enter(&cpuprof, CPUPROF_SLOT_WORKER, cpuprof_cycles());
+    tud_task();
+    cpuprof_exit(&cpuprof, cpuprof_cycles());
+}
+#endif
+
+//----------------------------------------------------------------
+// Advertised state
+//----------------------------------------------------------------
+
+/**
+ * @brief Advertise the current state, at most every adv_state.min_interval_ms,
+ *        and re-arm the timer of a delayed change
+ */
+static void adv_handle_update(void) {
+    uint64_t now = time_us_64();
+
+    if (adv_state_update(&adv_state, motion.command, gatt_service_endstop_status(), now)) {
+        gap_advertisements_set_data(adv_state.len, adv_state.data);
+    }
+
+    btstack_run_loop_remove_timer(&adv_timer);
+    uint64_t deadline = adv_state_next_deadline_us(&adv_state);
+    if (deadline != 0) {
+        btstack_run_loop_set_timer(&adv_timer, (uint32_t)((deadline - now) / 1000) + 1);
+        btstack_run_loop_add_timer(&adv_timer);
+    }
+}
+
+/**
+ * @brief Rate limit elapsed: advertise the delayed change
+ *
+ * @param ts The timer source
+ */
+static void adv_timer_handler(btstack_timer_source_t * ts) {
+    UNUSED(ts);
+    cpuprof_enter(&cpuprof, CPUPROF_SLOT_TIMER, cpuprof_cycles());
+    adv_handle_update();
+    cpuprof_exit(&cpuprof, cpuprof_cycles());
+}
+
+//----------------------------------------------------------------
+// Firmware update
+//----------------------------------------------------------------
+
+/** @brief Flash operation run by flash_safe_execute() */
+typedef struct {
+    uint32_t offset;        /**> Flash offset */
+    const uint8_t * data;   /**> Data to program, NULL to erase */
+    uint32_t size;          /**> Size in bytes */
+} ota_flash_op_t;
+
+/**
+ * @brief Erase or program, with the interrupts disabled and the other core paused
+ *
+ * @param param The flash operation
+ */
+static void ota_flash_op(void * param) {
+    const ota_flash_op_t * op = (const ota_flash_op_t *)param;
+    if (op->data == NULL) { flash_range_erase(op->offset, op->size); } else { flash_range_program(op->offset, op->data, op->size); }
+}
+
+/**
+ * @brief Erase a flash range while the application runs
+ *
+ * @return false if the other core could not be paused; the update fails
+ */
+static bool ota_flash_erase(uint32_t offset, uint32_t size, void * context) {
+    UNUSED(context);
+    ota_flash_op_t op = { .offset = offset, .data = NULL, .size = size };
+    return flash_safe_execute(&ota_flash_op, &op, OTA_FLASH_TIMEOUT_MS) == PICO_OK;
+}
+
+/**
+ * @brief Program a flash range while the application runs
+ *
+ * @return false if the other core could not be paused; the update fails
+ */
+static bool ota_flash_program(uint32_t offset, const uint8_t * data, uint32_t size, void * context) {
+    UNUSED(context);
+    ota_flash_op_t op = { .offset = offset, .data = data, .size = size };
+    return flash_safe_execute(&ota_flash_op, &op, OTA_FLASH_TIMEOUT_MS) == PICO_OK;
+}
+
+/**
+ * @brief The flash is only written while both relays are off: with the
+ *        interrupts disabled, neither the deadman alarm nor the end-stop
+ *        interrupt could cut them
+ */
+static bool ota_flash_allowed(void * context) {
+    UNUSED(context);
+    return !motion_is_moving(&motion);
+}
+
+/** @brief Flash operations of the update receiver */
+static const ota_flash_t ota_flash = {
+    .base = (const uint8_t *)XIP_BASE,
+    .erase = &ota_flash_erase,
+    .program = &ota_flash_program,
+    .context = NULL,
+    .allowed = &ota_flash_allowed,
+};
+
+/**
+ * @brief Erase a flash range at boot, from RAM: the image is being replaced.
+ *        flash_range_erase() and flash_range_program() run from RAM and only
+ *        call the boot ROM
+ */
+static bool __not_in_flash_func(ota_boot_erase)(uint32_t offset, uint32_t size, void * context) {
+    (void)context;
+    flash_range_erase(offset, size);
+    return true;
+}
+
+/**
+ * @brief Program a flash range at boot, from RAM: the image is being replaced
+ */
+static bool __not_in_flash_func(ota_boot_program)(uint32_t offset, const uint8_t * data, uint32_t size, void * context) {
+    (void)context;
+    flash_range_program(offset, data, size);
+    return true;
+}
+
+/**
+ * @brief Copy the staged image over the running one, then reset: nothing
+ *        past this point may execute from flash
+ *
+ * @param meta The update record
+ */
+static void __not_in_flash_func(ota_boot_swap)(const ota_meta_t * meta) {
+    // On the stack, not in .rodata: bank A is rewritten under it. Assigned
+    // field by field, an initializer may be copied from flash
+    ota_flash_t boot_flash;
+    boot_flash.base = (const uint8_t *)XIP_BASE;
+    boot_flash.erase = &ota_boot_erase;
+    boot_flash.program = &ota_boot_program;
+    boot_flash.context = NULL;
+    boot_flash.allowed = NULL;
+
+    save_and_disable_interrupts();
+    ota_swap(&boot_flash, meta);
+    scb_hw->aircr = (0x05FA << M0PLUS_AIRCR_VECTKEY_LSB) | M0PLUS_AIRCR_SYSRESETREQ_BITS;
+    while (true) { }
+}
+
+/**
+ * @brief Update receiver event: buffer ready or status changed
+ *
+ * @param context Unused
+ */
+static void ota_handle_event(void * context) {
+    UNUSED(context);
+    async_context_set_work_pending(cyw43_arch_async_context(), &ota_worker);
+}
+
+/**
+ * @brief Staged image: reboot to copy it
+ *
+ * @param ts The timer source
+ */
+static void ota_reboot_handler(btstack_timer_source_t * ts) {
+    UNUSED(ts);
+    watchdog_reboot(0, 0, 0);
+}
+
+/**
+ * @brief Run loop worker: program the received sectors, notify the status,
+ *        and reboot once the image is staged
+ *
+ * @param context The async context
+ * @param worker The worker
+ */
+static void ota_worker_handler(async_context_t * context, async_when_pending_worker_t * worker) {
+    UNUSED(context);
+    UNUSED(worker);
+    cpuprof_enter(&cpuprof, CPUPROF_SLOT_WORKER, cpuprof_cycles());
+    ota_state_t state = ota.state;
+    ota_flush(&ota);
+    gatt_service_update();
+
+    if ((state != OTA_STATE_READY) && (ota.state == OTA_STATE_READY)) {
+        printf("Update - %lu bytes staged at %lu B/s, rebooting\n", (unsigned long)ota.size, (unsigned long)ota_throughput(&ota));
+        btstack_run_loop_set_timer(&ota_reboot_timer, OTA_REBOOT_DELAY_MS);
+        btstack_run_loop_add_timer(&ota_reboot_timer);
+    }
+    cpuprof_exit(&cpuprof, cpuprof_cycles());
+}
+
+//----------------------------------------------------------------
+// Runtime parameters
+//----------------------------------------------------------------
+
+/**
+ * @brief Parameters applied or stored: let the run loop worker handle it
+ *
+ * @param context Not used
+ */
+static void params_handle_event(void * context) {
+    UNUSED(context);
+    async_context_set_work_pending(cyw43_arch_async_context(), &params_worker);
+}
+
+/**
+ * @brief Trial period elapsed without commit: back to the stored set
+ *
+ * @param ts The timer source
+ */
+static void params_timer_handler(btstack_timer_source_t * ts) {
+    UNUSED(ts);
+    cpuprof_enter(&cpuprof, CPUPROF_SLOT_TIMER, cpuprof_cycles());
+    if (params_expire(&params, time_us_64())) { printf("Parameters - no commit, rolled back\n"); }
+    cpuprof_exit(&cpuprof, cpuprof_cycles());
+}
+
+/**
+ * @brief Load the stored parameters, the defaults are kept if the record is
+ *        missing, corrupted or invalid
+ */
+static void params_load_stored(void) {
+    const btstack_tlv_t * tlv_impl;
+    void * tlv_context;
+    params_record_t record;
+
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    int len = tlv_impl->get_tag(tlv_context, PARAMS_TLV_TAG, (uint8_t *)&record, sizeof(record));
+    if ((len == (int)sizeof(record)) && params_load(&params, &record)) {
+        printf("Parameters - stored set loaded\n");
+    }
+    params_revision_applied = params.revision;
+    params_revision_stored = params.store_revision;
+}
+
+/**
+ * @brief Run loop worker: apply the changed set to every module in one go,
+ *        store the committed set, and re-arm the rollback timer
+ *
+ * @param context The async context
+ * @param worker The worker
+ */
+static void params_worker_handler(async_context_t * context, async_when_pending_worker_t * worker) {
+    UNUSED(context);
+    UNUSED(worker);
+    cpuprof_enter(&cpuprof, CPUPROF_SLOT_WORKER, cpuprof_cycles());
+
+    if (params.revision != params_revision_applied) {
+        params_revision_applied = params.revision;
+        ble_set_adv_params();
+        ble_request_conn_params();
+        deadman_set_timing(&deadman, (uint16_t)params_get(&params, PARAM_KEEPALIVE_PERIOD_MS), (uint8_t)params_get(&params, PARAM_MISSED_INTERVALS));
+        power_set_idle_timeout(&power, params_get(&params, PARAM_CONNECTED_IDLE_MS));
+        power_handle_event(POWER_EVENT_TIMEOUT);
+        adv_state_set_min_interval(&adv_state, params_get(&params, PARAM_ADV_MIN_INTERVAL_MS));
+        adv_handle_update();
+        changeover_set_dead_time(&changeover, (uint16_t)params_get(&params, PARAM_CHANGEOVER_MS));
+    }
+
+    if (params.store_revision != params_revision_stored) {
+        const btstack_tlv_t * tlv_impl;
+        void * tlv_context;
+        params_revision_stored = params.store_revision;
+        btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+        tlv_impl->store_tag(tlv_context, PARAMS_TLV_TAG, (const uint8_t *)&params.stored, sizeof(params.stored));
+        printf("Parameters - set committed\n");
+    }
+
+    btstack_run_loop_remove_timer(&params_timer);
+    uint64_t deadline = params_next_deadline_us(&params);
+    if (deadline != 0) {
+        uint64_t now = time_us_64();
+        btstack_run_loop_set_timer(&params_timer, (deadline > now) ? (uint32_t)((deadline - now) / 1000) + 1 : 0);
+        btstack_run_loop_add_timer(&params_timer);
+    }
+
+    cpuprof_exit(&cpuprof, cpuprof_cycles());
+}
+
+//----------------------------------------------------------------
+// End-stops
+//----------------------------------------------------------------
+
+/**
+ * @brief End-stop edge interrupt: cut the relay of the blocked direction
+ *        first, then update the command state and let the run loop notify
+ *
+ * @param gpio The GPIO number
+ */
+static void endstop_irq_callback(uint gpio) {
+    uint8_t direction = (gpio == ENDSTOP_UP_GPIO) ? MOTION_UP : MOTION_DOWN;
+    bool active = gpio_get(gpio);
+
+    // Single register write, before any bookkeeping
+    if (active) { gpio_clr_mask(1u << ((direction == MOTION_UP) ? RELAY1_GPIO : RELAY2_GPIO)); }
+
+    uint32_t irq_status = save_and_disable_interrupts();
+    motion_limit(&motion, direction, active);
+    restore_interrupts(irq_status);
+
+    async_context_set_work_pending(cyw43_arch_async_context(), &motion_worker);
+}
+
+/**
+ * @brief Initialize an end-stop input and apply its current level
+ *
+ * @param gpio The GPIO number
+ */
+static void endstop_gpio_init(uint gpio) {
+    gpio_init(gpio);
+    gpio_set_dir(gpio, GPIO_IN);
+    gpio_pull_up(gpio);
+    gpio_set_irq_enabled(gpio, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true);
+
+    uint32_t irq_status = save_and_disable_interrupts();
+    motion_limit(&motion, (gpio == ENDSTOP_UP_GPIO) ? MOTION_UP : MOTION_DOWN, gpio_get(gpio));
+    restore_interrupts(irq_status);
+}
+
+//----------------------------------------------------------------
+// Local Up/Down buttons
+//----------------------------------------------------------------
+
+/**
+ * @brief Apply a debounced button event: a press drives its direction, a
+ *        release stops the motor only if that direction is still driven
+ *
+ * @param event The button event
+ * @param direction MOTION_UP or MOTION_DOWN
+ */
+static void button_apply(button_event_t event, uint8_t direction) {
+    if (event == BUTTON_EVENT_PRESS) {
+        // A local press takes over a hold-to-run BLE command
+        deadman_disarm(&deadman);
+        motion_apply(direction, MOTION_SOURCE_BUTTON);
+    }
+    else if ((event == BUTTON_EVENT_RELEASE) && ((motion.command & MOTION_RELAYS_MASK) == direction)) {
+        motion_apply(MOTION_STOP, MOTION_SOURCE_BUTTON);
+    }
+}
+
+/**
+ * @brief Debounce timer: confirm the button level once it stopped bouncing
+ *
+ * @param id The alarm identifier
+ * @param user_data The GPIO number
+ * @return int64_t 0 when settled, otherwise minus the delay before the next check
+ */
+static int64_t button_settle_callback(alarm_id_t id, void * user_data) {
+    UNUSED(id);
+    uint gpio = (uint)(uintptr_t)user_data;
+    button_t * button = (gpio == BUTTON_UP_GPIO) ? &button_up : &button_down;
+    uint8_t direction = (gpio == BUTTON_UP_GPIO) ? MOTION_UP : MOTION_DOWN;
+    button_event_t event;
+
+    uint32_t delay_us = button_settle(button, !gpio_get(gpio), time_us_32(), &event);
+    button_apply(event, direction);
+
+    return -(int64_t)delay_us;
+}
+
+/**
+ * @brief Button edge interrupt: timestamp the edge, apply a leading edge
+ *        immediately and start the debounce timer
+ *
+ * @param gpio The GPIO number
+ */
+static void button_irq_callback(uint gpio) {
+    uint32_t now = time_us_32();
+    button_t * button = (gpio == BUTTON_UP_GPIO) ? &button_up : &button_down;
+    uint8_t direction = (gpio == BUTTON_UP_GPIO) ? MOTION_UP : MOTION_DOWN;
+
+    bool settling = button->settling;
+    button_apply(button_edge(button, !gpio_get(gpio), now), direction);
+
+    if (!settling) {
+        add_alarm_in_us(BUTTON_DEBOUNCE_US, &button_settle_callback, (void *)(uintptr_t)gpio, true);
+    }
+}
+
+#ifdef BLE_SOFA_TOUCH_PADS
+/**
+ * @brief Touch pad event: same behaviour as the wired buttons
+ *
+ * @param channel The pad channel, 0 = Up, 1 = Down
+ * @param event The press/release event
+ */
+static void touch_pad_event(uint channel, button_event_t event) {
+    button_apply(event, (channel == 0) ? MOTION_UP : MOTION_DOWN);
+}
+#endif
+
+/**
+ * @brief GPIO interrupt: dispatch the edges to the end-stops and the buttons
+ *
+ * @param gpio The GPIO number
+ * @param events The GPIO interrupt events
+ */
+static void gpio_irq_callback(uint gpio, uint32_t events) {
+    UNUSED(events);
+    if ((gpio == ENDSTOP_UP_GPIO) || (gpio == ENDSTOP_DOWN_GPIO)) { endstop_irq_callback(gpio); }
+    else if ((gpio == BUTTON_UP_GPIO) || (gpio == BUTTON_DOWN_GPIO)) { button_irq_callback(gpio); }
+}
+
+/**
+ * @brief Initialize a button input: pull-up, interrupt on both edges
+ *
+ * @param gpio The GPIO number
+ */
+static void button_gpio_init(uint gpio) {
+    gpio_init(gpio);
+    gpio_set_dir(gpio, GPIO_IN);
+    gpio_pull_up(gpio);
+    gpio_set_irq_enabled(gpio, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true);
+}
+
+//----------------------------------------------------------------
+// CPU profiling
+//----------------------------------------------------------------
+
+/**
+ * @brief Cycle counter: the 64-bit microsecond timer scaled by clk_sys,
+ *        rebased on each clock change by cpuprof_set_clock()
+ *
+ * @return uint32_t Current cycle count (wrapping)
+ * @note Monotonic, no wrap to miss during a long sleep, and safe from
+ *       interrupts; the resolution is 1 us
+ */
+static uint32_t cpuprof_cycles(void) {
+    uint32_t irq = save_and_disable_interrupts();
+    uint64_t cycles = cpuprof_clock.base_cycles + (time_us_64() - cpuprof_clock.base_us) * cpuprof_clock.mhz;
+    restore_interrupts(irq);
+    return (uint32_t)cycles;
+}
+
+/**
+ * @brief The system clock changed: the cycles counted so far are kept at the
+ *        previous frequency
+ */
+static void cpuprof_set_clock(void) {
+    uint32_t irq = save_and_disable_interrupts();
+    uint64_t now = time_us_64();
+    cpuprof_clock.base_cycles += (now - cpuprof_clock.base_us) * cpuprof_clock.mhz;
+    cpuprof_clock.base_us = now;
+    cpuprof_clock.mhz = clock_get_hz(clk_sys) / 1000000;
+    restore_interrupts(irq);
+}
+
+/**
+ * @brief Profiled hci_packet_handler()
+ */
+static void cpuprof_hci_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
+    cpuprof_enter(&cpuprof, CPUPROF_SLOT_HCI_EVENT, cpuprof_cycles());
+    hci_packet_handler(packet_type, channel, packet, size);
+    cpuprof_exit(&cpuprof, cpuprof_cycles());
+}
+
+/**
+ * @brief Profiled att_packet_handler()
+ */
+static void cpuprof_att_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
+    cpuprof_enter(&cpuprof, CPUPROF_SLOT_ATT_EVENT, cpuprof_cycles());
+    att_packet_handler(packet_type, channel, packet, size);
+    cpuprof_exit(&cpuprof, cpuprof_cycles());
+}
+
+/**
+ * @brief Profiled gatt_service_read()
+ */
+static uint16_t cpuprof_att_read_callback(hci_con_handle_t connection_handle, uint16_t att_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size) {
+    cpuprof_enter(&cpuprof, CPUPROF_SLOT_ATT_READ, cpuprof_cycles());
+    uint16_t len = gatt_service_read(connection_handle, att_handle, offset, buffer, buffer_size);
+    cpuprof_exit(&cpuprof, cpuprof_cycles());
+    return len;
+}
+
+/**
+ * @brief Profiled gatt_service_write()
+ */
+static int cpuprof_att_write_callback(hci_con_handle_t connection_handle, uint16_t att_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size) {
+    cpuprof_enter(&cpuprof, CPUPROF_SLOT_ATT_WRITE, cpuprof_cycles());
+    int status = gatt_service_write(connection_handle, att_handle, transaction_mode, offset, buffer, buffer_size);
+    cpuprof_exit(&cpuprof, cpuprof_cycles());
+    return status;
+}
+
+//----------------------------------------------------------------
+// Power management
+//----------------------------------------------------------------
+
+/**
+ * @brief Switch the system clock according to the power state
+ *
+ * @param state The power state to be applied
+ * @note Called from the run loop only, so no CYW43 SPI transfer is in progress
+ */
+static void power_apply(power_state_t state) {
+    if (state == POWER_STATE_FULL) {
+        if (clock_get_hz(clk_sys) == POWER_FULL_CLK_KHZ * 1000) { return; }
+        uint32_t start = time_us_32();
+        set_sys_clock_khz(POWER_FULL_CLK_KHZ, false);
+        cpuprof_set_clock();
+        power_account_wakeup(&power, time_us_32() - start);
+    }
+    else {
+        if (clock_get_hz(clk_sys) == POWER_LOW_CLK_KHZ * 1000) { return; }
+        set_sys_clock_khz(POWER_LOW_CLK_KHZ, false);
+        cpuprof_set_clock();
+    }
+}
+
+/**
+ * @brief Power deadline timer: re-evaluate the state once the link went quiet
+ *
+ * @param ts The timer source
+ */
+static void power_timer_handler(btstack_timer_source_t * ts) {
+    UNUSED(ts);
+    cpuprof_enter(&cpuprof, CPUPROF_SLOT_TIMER, cpuprof_cycles());
+    power_handle_event(POWER_EVENT_TIMEOUT);
+    cpuprof_exit(&cpuprof, cpuprof_cycles());
+}
+
+/**
+ * @brief Feed an event to the power manager, apply the resulting state and
+ *        re-arm the deadline timer
+ *
+ * @param event The power event
+ */
+static void power_handle_event(power_event_t event) {
+    uint64_t now = time_us_64();
+
+    power_apply(power_notify(&power, event, now));
+
+    btstack_run_loop_remove_timer(&power_timer);
+    uint64_t deadline = power_next_deadline_us(&power);
+    if (deadline != 0) {
+        btstack_run_loop_set_timer(&power_timer, (uint32_t)((deadline - now) / 1000) + 1);
+        btstack_run_loop_add_timer(&power_timer);
+    }
+}
+
+/**
+ * @brief Tickless run loop: process pending work, then sleep (WFE) until the
+ *        next run loop timer or a CYW43/GPIO event raises work
+ * @note Replaces btstack_run_loop_execute() to account the sleep residency.
+ *       With pico_cyw43_arch_poll, the CYW43 driver, BTstack, the timers and
+ *       the workers only run from async_context_poll(): the wait returns as
+ *       soon as an interrupt sets work pending or the next timer is due, so
+ *       the time spent in it is the sleep time
+ */
+static void power_run_loop_execute(void) {
+    async_context_t * context = cyw43_arch_async_context();
+
+    uint32_t last = cpuprof_cycles();
+
+    while (true) {
+        cpuprof_enter(&cpuprof, CPUPROF_SLOT_POLL, cpuprof_cycles());
+        async_context_poll(context);
+        cpuprof_exit(&cpuprof, cpuprof_cycles());
+
+        uint32_t start = time_us_32();
+        async_context_wait_for_work_until(context, at_the_end_of_time);
+        power_account_sleep(&power, time_us_32() - start);
+
+        // Profiling window, the idle time is derived from the handler times
+        uint32_t now = cpuprof_cycles();
+        cpuprof_account(&cpuprof, now - last);
+        last = now;
+    }
+}
+
 //----------------------------------------------------------------
 // Functions
 //----------------------------------------------------------------
@@ -232,14 +1264,51 @@ static void att_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *p
  */
 int main(void)
 {
+    // Staged firmware update: copy it over the running image, then reset
+    ota_meta_t ota_meta;
+    if (ota_boot_pending(&ota_flash, &ota_meta)) { ota_boot_swap(&ota_meta); }
+
+    // Paint the stacks before they are used
+    mem_report_init();
+
+    // CPU profiler, cycles counted at the boot clock
+    cpuprof_init(&cpuprof);
+    cpuprof_set_clock();
+
     // Initialize the relays output
     relay_init(&relay1, RELAY1_GPIO);
     relay_init(&relay2, RELAY2_GPIO);
 
-    // Turn off relay 1
-    relay_off(&relay1);
-    // Turn off relay 2
-    relay_off(&relay2);
+    // Turn off relay 1 and relay 2, the changeover alarm drives a reversed
+    // line once the dead-time is over
+    changeover_init(&changeover, CHANGEOVER_DEAD_TIME_MS);
+    changeover_alarm_num = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(changeover_alarm_num, &changeover_alarm_callback);
+    motion_init(&motion, &motion_output, NULL);
+
+    // Hold-to-run deadman on a dedicated hardware alarm
+    deadman_init(&deadman);
+    deadman_alarm_num = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(deadman_alarm_num, &deadman_alarm_callback);
+
+    // Control service and advertised state, before the motion worker can run
+    gatt_service_config_t service = {
+        .motion = &motion,
+        .deadman = &deadman,
+        .power = &power,
+        .cpuprof = &cpuprof,
+        .ota = &ota,
+        .params = &params,
+        .command = &ble_command_apply,
+        .activity = &ble_activity,
+        .now_us = &ble_time_us,
+        .secured = &ble_link_secured,
+    };
+    ota_init(&ota, &ota_flash, &ota_handle_event, NULL);
+    params_init(&params, &params_handle_event, NULL);
+    gatt_service_init(&service);
+    adv_state_init(&adv_state, ADV_LOCAL_NAME, motion.command, gatt_service_endstop_status());
+    btstack_run_loop_set_timer_handler(&adv_timer, &adv_timer_handler);
 
     // Wait a moment
     sleep_ms(2000);
@@ -250,41 +1319,95 @@ int main(void)
     // Turn off the wireless LED
     cyw43_arch_gpio_put(WL_LED_GPIO, false);
 
+    // Run loop side of the relay changes
+    motion_worker.do_work = &motion_worker_handler;
+    async_context_add_when_pending_worker(cyw43_arch_async_context(), &motion_worker);
+    ota_worker.do_work = &ota_worker_handler;
+    async_context_add_when_pending_worker(cyw43_arch_async_context(), &ota_worker);
+    btstack_run_loop_set_timer_handler(&ota_reboot_timer, &ota_reboot_handler);
+    params_worker.do_work = &params_worker_handler;
+    async_context_add_when_pending_worker(cyw43_arch_async_context(), &params_worker);
+    btstack_run_loop_set_timer_handler(&params_timer, &params_timer_handler);
+
+    // Stored runtime parameters, once the flash TLV is available
+    params_load_stored();
+    deadman_set_timing(&deadman, (uint16_t)params_get(&params, PARAM_KEEPALIVE_PERIOD_MS), (uint8_t)params_get(&params, PARAM_MISSED_INTERVALS));
+    adv_state_set_min_interval(&adv_state, params_get(&params, PARAM_ADV_MIN_INTERVAL_MS));
+    changeover_set_dead_time(&changeover, (uint16_t)params_get(&params, PARAM_CHANGEOVER_MS));
+
+#ifdef BLE_SOFA_USB_CDC
+    // Wired control channel, same commands and telemetry as the control service
+    usb_link_config_t usb_config = {
+        .motion = &motion,
+        .power = &power,
+        .command = &usb_command_apply,
+        .activity = &ble_activity,
+        .now_us = &ble_time_us,
+        .write = &usb_write,
+    };
+    usb_link_init(&usb_link, &usb_config);
+    usb_worker.do_work = &usb_worker_handler;
+    async_context_add_when_pending_worker(cyw43_arch_async_context(), &usb_worker);
+    tusb_init();
+#endif
+
+    // End-stops and local Up/Down buttons, once the motion worker can be notified
+    gpio_set_irq_callback(&gpio_irq_callback);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+    endstop_gpio_init(ENDSTOP_UP_GPIO);
+    endstop_gpio_init(ENDSTOP_DOWN_GPIO);
+    button_init(&button_up);
+    button_init(&button_down);
+    button_gpio_init(BUTTON_UP_GPIO);
+    button_gpio_init(BUTTON_DOWN_GPIO);
+
+#ifdef BLE_SOFA_TOUCH_PADS
+    // Capacitive touch pads, measured by PIO and filtered every TOUCH_PAD_PERIOD_MS
+    const uint touch_gpios[] = { TOUCH_UP_GPIO, TOUCH_DOWN_GPIO };
+    if (!touch_pad_init(touch_gpios, 2, TOUCH_THRESHOLD, &touch_pad_event)) {
+        printf("Touch pads - no PIO state machine available\n");
+    }
+#endif
+
     // Initialize the Logical Link Control and Adaptation Layer Protocol (L2CAP) layer
     l2cap_init();
-    // Initialize Security Manager (SM)
+    // Initialize Security Manager (SM): LE Secure Connections, bonding, and
+    // MITM protection with the passkey of the label, entered on the central.
+    // Only the firmware update and parameters writes require such a link
     sm_init();
+    sm_set_io_capabilities(IO_CAPABILITY_DISPLAY_ONLY);
+    sm_set_authentication_requirements(SM_AUTHREQ_SECURE_CONNECTION | SM_AUTHREQ_MITM_PROTECTION | SM_AUTHREQ_BONDING);
+    sm_use_fixed_passkey_in_display_role(ble_passkey());
+    printf("Pairing - passkey %06lu\n", (unsigned long)ble_passkey());
     // Initialize Attribute Protocol
-    att_server_init(profile_data, att_read_callback, att_write_callback);
+    att_server_init(gatt_service_get_db(), cpuprof_att_read_callback, cpuprof_att_write_callback);
 
     // Setup advertisements
-    uint16_t adv_int_min = 0x0030;
-    uint16_t adv_int_max = 0x0030;
-    uint8_t adv_type = 0;
-    bd_addr_t null_addr;
-    memset(null_addr, 0, 6);
-    gap_advertisements_set_params(adv_int_min, adv_int_max, adv_type, 0, null_addr, 0x07, 0x00);
-    gap_advertisements_set_data(adv_data_len, (uint8_t *) adv_data);
+    ble_set_adv_params();
+    gap_advertisements_set_data(adv_state.len, adv_state.data);
     gap_advertisements_enable(true);
 
     // Register HCI events callback
-    hci_event_callback_registration.callback = &hci_packet_handler;
+    hci_event_callback_registration.callback = &cpuprof_hci_packet_handler;
     hci_add_event_handler(&hci_event_callback_registration);
 
     // Register for ATT events
-    att_server_register_packet_handler(att_packet_handler);
+    att_server_register_packet_handler(cpuprof_att_packet_handler);
 
-    // Initialize data
-    data = 0x00;
-    data_len = 1;
-
-    hci_power_control(HCI_POWER_ON);
+    // Set the cached ECDH key pair (or generate it on core1), then power on
+    ecc_keys_init(&ble_power_on);
 
     // Turn on the LED to indicate that BLE is fully initialized
     cyw43_arch_gpio_put(WL_LED_GPIO, true);
 
+    // Start in low power state: only advertising until a central connects
+    power_init(&power, time_us_64());
+    power_set_idle_timeout(&power, params_get(&params, PARAM_CONNECTED_IDLE_MS));
+    btstack_run_loop_set_timer_handler(&power_timer, &power_timer_handler);
+    power_apply(POWER_STATE_LOW);
+
     // Endless loop
-    btstack_run_loop_execute();
+    power_run_loop_execute();
 
     return 0;
 }
@@ -10,9 +10,11 @@
 #define ENABLE_LOG_INFO
 #define ENABLE_LOG_ERROR
 #define ENABLE_PRINTF_HEXDUMP
+#define ENABLE_LE_SECURE_CONNECTIONS
 
 // BTstack configuration: buffers, sizes, ...
 #define HCI_OUTGOING_PRE_BUFFER_SIZE 4
+// ATT MTU accepted up to HCI_ACL_PAYLOAD_SIZE - 4 (L2CAP header) = 255
 #define HCI_ACL_PAYLOAD_SIZE (255 + 4)
 #define HCI_ACL_CHUNK_SIZE_ALIGNMENT 4
 #define MAX_NR_HCI_CONNECTIONS 1
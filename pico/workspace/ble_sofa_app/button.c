@@ -0,0 +1,84 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: button.c
+-- Description: Edge-timestamped button debouncer (leading-edge acceptance,
+--              level confirmation after the bounce window)
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "button.h"
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file button.h
+ * @name button_init
+ */
+void button_init(button_t * button) {
+    memset(button, 0, sizeof(button_t));
+}
+
+/**
+ * @file button.h
+ * @name button_edge
+ */
+button_event_t button_edge(button_t * button, bool pressed, uint32_t now_us) {
+    button_event_t event = BUTTON_EVENT_NONE;
+
+    button->nb_edges++;
+
+    // First edge after a stable period: accept it without waiting
+    if (!button->settling && (pressed != button->pressed)) {
+        button->pressed = pressed;
+        event = pressed ? BUTTON_EVENT_PRESS : BUTTON_EVENT_RELEASE;
+    }
+
+    // Following edges within the window are bounces
+    button->settling = true;
+    button->last_edge_us = now_us;
+
+    return event;
+}
+
+/**
+ * @file button.h
+ * @name button_settle
+ */
+uint32_t button_settle(button_t * button, bool pressed, uint32_t now_us, button_event_t * event) {
+    *event = BUTTON_EVENT_NONE;
+
+    if (!button->settling) { return 0; }
+
+    // Still bouncing: check again once the window after the last edge is over
+    uint32_t elapsed = now_us - button->last_edge_us;
+    if (elapsed < BUTTON_DEBOUNCE_US) { return BUTTON_DEBOUNCE_US - elapsed; }
+
+    button->settling = false;
+
+    // The stable level differs from the accepted one (glitch or missed edge)
+    if (pressed != button->pressed) {
+        button->pressed = pressed;
+        button->nb_glitches++;
+        *event = pressed ? BUTTON_EVENT_PRESS : BUTTON_EVENT_RELEASE;
+    }
+
+    return 0;
+}
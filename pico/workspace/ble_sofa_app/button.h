@@ -0,0 +1,88 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: button.h
+-- Description: Edge-timestamped button debouncer (leading-edge acceptance,
+--              level confirmation after the bounce window)
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Time without edge after which the input level is considered stable */
+#define BUTTON_DEBOUNCE_US  5000
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef enum {
+    BUTTON_EVENT_NONE = 0,
+    BUTTON_EVENT_PRESS,
+    BUTTON_EVENT_RELEASE
+} button_event_t;
+
+typedef struct {
+    bool pressed;           /**> Debounced state */
+    bool settling;          /**> Edges seen less than BUTTON_DEBOUNCE_US ago */
+    uint32_t last_edge_us;  /**> Timestamp of the last edge */
+    uint32_t nb_edges;      /**> Number of edges, bounces included */
+    uint32_t nb_glitches;   /**> Accepted edges reverted by the confirmation */
+} button_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Initialize the debouncer, released
+ *
+ * @param button The button structure
+ */
+void button_init(button_t * button);
+
+/**
+ * @brief Process an edge, called from the GPIO interrupt.
+ *        The first edge after a stable period is accepted immediately.
+ *
+ * @param button The button structure
+ * @param pressed The input level after the edge (true = pressed)
+ * @param now_us Edge timestamp in microseconds
+ * @return button_event_t The event to be applied now
+ */
+button_event_t button_edge(button_t * button, bool pressed, uint32_t now_us);
+
+/**
+ * @brief Confirm the level once the bounce window is over, called from the
+ *        debounce timer
+ *
+ * @param button The button structure
+ * @param pressed The current input level (true = pressed)
+ * @param now_us Current time in microseconds
+ * @param event The event to be applied now
+ * @return uint32_t 0 if settled, otherwise the delay before the next check in microseconds
+ */
+uint32_t button_settle(button_t * button, bool pressed, uint32_t now_us, button_event_t * event);
+
+#endif // BUTTON_H
@@ -0,0 +1,78 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: changeover.c
+-- Description: Up/Down changeover dead-time: a line is only driven once the
+--              other one has been released for the dead-time
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "changeover.h"
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file changeover.h
+ * @name changeover_init
+ */
+void changeover_init(changeover_t * changeover, uint16_t dead_time_ms) {
+    memset(changeover, 0, sizeof(changeover_t));
+    changeover_set_dead_time(changeover, dead_time_ms);
+}
+
+/**
+ * @file changeover.h
+ * @name changeover_set_dead_time
+ */
+void changeover_set_dead_time(changeover_t * changeover, uint16_t dead_time_ms) {
+    changeover->dead_time_us = (uint32_t)dead_time_ms * 1000;
+}
+
+/**
+ * @file changeover.h
+ * @name changeover_update
+ */
+uint8_t changeover_update(changeover_t * changeover, uint8_t relays, uint64_t now_us, uint64_t * retry_us) {
+    *retry_us = 0;
+
+    // Released lines: the other one waits for the contacts to open
+    for (int line = 0; line < 2; line++) {
+        uint8_t mask = 1u << line;
+        if ((changeover->driven & mask) && !(relays & mask)) {
+            changeover->driven &= ~mask;
+            changeover->ready_us[1 - line] = now_us + changeover->dead_time_us;
+        }
+    }
+
+    for (int line = 0; line < 2; line++) {
+        uint8_t mask = 1u << line;
+        if (!(relays & mask) || (changeover->driven & mask)) { continue; }
+        if (changeover->driven & (1u << (1 - line))) { continue; }
+
+        if (now_us < changeover->ready_us[line]) {
+            changeover->nb_deferred++;
+            if ((*retry_us == 0) || (changeover->ready_us[line] < *retry_us)) { *retry_us = changeover->ready_us[line]; }
+            continue;
+        }
+        changeover->driven |= mask;
+    }
+
+    return changeover->driven;
+}
@@ -0,0 +1,82 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: changeover.h
+-- Description: Up/Down changeover dead-time: a line is only driven once the
+--              other one has been released for the dead-time
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef CHANGEOVER_H
+#define CHANGEOVER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Default dead-time between the release of a line and the drive of
+ *         the other one: above the release time of the relay contacts */
+#define CHANGEOVER_DEAD_TIME_MS     50
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    uint8_t driven;             /**> Lines driven (bit [0]: Up, bit [1]: Down) */
+    uint32_t dead_time_us;      /**> Release of a line to drive of the other one */
+    uint64_t ready_us[2];       /**> Time from which each line may be driven */
+    uint32_t nb_deferred;       /**> Updates deferring a drive for the dead-time */
+} changeover_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Initialize the changeover, no line driven
+ *
+ * @param changeover The changeover structure
+ * @param dead_time_ms The dead-time
+ */
+void changeover_init(changeover_t * changeover, uint16_t dead_time_ms);
+
+/**
+ * @brief Update the dead-time, applied from the next release
+ *
+ * @param changeover The changeover structure
+ * @param dead_time_ms The dead-time
+ */
+void changeover_set_dead_time(changeover_t * changeover, uint16_t dead_time_ms);
+
+/**
+ * @brief Lines to drive for the requested ones: the lines not requested are
+ *        released at once, a requested line is driven only once the other
+ *        one has been released for the dead-time, and never with it
+ *
+ * @param changeover The changeover structure
+ * @param relays Requested lines (bit [0]: Up, bit [1]: Down)
+ * @param now_us Current time in microseconds
+ * @param retry_us Output time at which a deferred line may be driven, 0 if none
+ * @return uint8_t The lines to drive now, to release first when they are not set
+ * @note Not reentrant: callers from thread and interrupt context must be serialized
+ */
+uint8_t changeover_update(changeover_t * changeover, uint8_t relays, uint64_t now_us, uint64_t * retry_us);
+
+#endif // CHANGEOVER_H
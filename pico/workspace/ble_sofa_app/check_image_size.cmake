@@ -0,0 +1,18 @@
+# Fail the build when the flash image does not fit in an update bank: the
+# bootloader swap copies OTA_BANK_SIZE bytes, anything past it would be
+# overwritten by the staged image or lost on the next update.
+#
+# Usage: cmake -DIMAGE=<image.bin> -DOTA_HEADER=<ota.h> -P check_image_size.cmake
+
+file(STRINGS ${OTA_HEADER} BANK_SIZE_LINE REGEX "^#define OTA_BANK_SIZE ")
+if (NOT BANK_SIZE_LINE MATCHES "\\(([0-9]+) \\* 1024\\)")
+  message(FATAL_ERROR "OTA_BANK_SIZE not found in ${OTA_HEADER}")
+endif()
+math(EXPR BANK_SIZE "${CMAKE_MATCH_1} * 1024")
+
+file(SIZE ${IMAGE} IMAGE_SIZE)
+if (IMAGE_SIZE GREATER BANK_SIZE)
+  message(FATAL_ERROR "${IMAGE}: ${IMAGE_SIZE} bytes, larger than the ${BANK_SIZE} bytes of an update bank")
+endif()
+math(EXPR IMAGE_FREE "${BANK_SIZE} - ${IMAGE_SIZE}")
+message(STATUS "${IMAGE}: ${IMAGE_SIZE} bytes, ${IMAGE_FREE} bytes left in the update bank")
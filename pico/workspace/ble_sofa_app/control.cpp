@@ -0,0 +1,62 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: control.cpp
+-- Description: C interface of the TLV control protocol codec (protocol.hpp)
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include "control.h"
+#include "protocol.hpp"
+
+static_assert(CONTROL_TELEMETRY_SIZE == protocol::kTelemetrySize, "telemetry size mismatch");
+static_assert(CONTROL_LEGACY_VERSION == protocol::kLegacyVersion, "legacy version mismatch");
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file control.h
+ * @name control_decode_command
+ */
+int control_decode_command(const uint8_t * data, uint16_t size, control_command_t * command) {
+    protocol::Command decoded{};
+    protocol::Status status = protocol::decode_command(data, size, decoded);
+
+    command->version = decoded.version;
+    command->sequence = decoded.sequence;
+    command->has_motion = decoded.has_motion;
+    command->motion = decoded.motion;
+
+    return static_cast<int>(status);
+}
+
+/**
+ * @file control.h
+ * @name control_encode_telemetry
+ */
+uint16_t control_encode_telemetry(const control_telemetry_t * telemetry, uint8_t * data) {
+    protocol::Telemetry frame{};
+    frame.sequence = telemetry->sequence;
+    frame.state = telemetry->state;
+    frame.endstop = telemetry->endstop;
+    frame.ack = telemetry->ack;
+    frame.power = telemetry->power;
+    frame.uptime_ms = telemetry->uptime_ms;
+
+    return static_cast<uint16_t>(protocol::encode_telemetry(frame, data, CONTROL_TELEMETRY_SIZE));
+}
@@ -0,0 +1,89 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: control.h
+-- Description: C interface of the TLV control protocol codec (protocol.hpp)
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Size of a telemetry frame (protocol::kTelemetrySize) */
+#define CONTROL_TELEMETRY_SIZE 20
+
+/** @brief Version reported for a legacy single byte command (protocol::kLegacyVersion) */
+#define CONTROL_LEGACY_VERSION 0
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    uint8_t version;    /**> Frame version, 0 for a legacy single byte */
+    uint8_t sequence;   /**> Frame sequence number */
+    bool has_motion;    /**> A motion command is present */
+    uint8_t motion;     /**> Command byte (see motion.h) */
+} control_command_t;
+
+typedef struct {
+    uint8_t sequence;   /**> Telemetry sequence number */
+    uint8_t state;      /**> Applied command byte */
+    uint8_t endstop;    /**> End-stop status */
+    uint8_t ack;        /**> Sequence number of the last command frame */
+    uint8_t power;      /**> Power state */
+    uint32_t uptime_ms; /**> Time since boot (ms) */
+} control_telemetry_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Decode a control characteristic write: legacy byte or command frame
+ *
+ * @param data The written value
+ * @param size The written size
+ * @param command Output command
+ * @return int 0 on success, protocol::Status value otherwise
+ */
+int control_decode_command(const uint8_t * data, uint16_t size, control_command_t * command);
+
+/**
+ * @brief Encode a telemetry frame
+ *
+ * @param telemetry The telemetry content
+ * @param data Output buffer, at least CONTROL_TELEMETRY_SIZE bytes
+ * @return uint16_t Frame size
+ */
+uint16_t control_encode_telemetry(const control_telemetry_t * telemetry, uint8_t * data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONTROL_H
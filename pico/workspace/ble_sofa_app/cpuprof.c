@@ -0,0 +1,154 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: cpuprof.c
+-- Description: Run loop CPU profiler: per-handler call count, self and
+--              worst cycles, idle time, and compact binary snapshot
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "cpuprof.h"
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+static const char * cpuprof_names[CPUPROF_NB_SLOTS] = {
+    "poll", "hci_event", "att_event", "att_read", "att_write", "timer", "worker",
+};
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Store a 32-bit value, little-endian
+ */
+static void cpuprof_store_32(uint8_t * buffer, uint32_t value) {
+    buffer[0] = (uint8_t)value;
+    buffer[1] = (uint8_t)(value >> 8);
+    buffer[2] = (uint8_t)(value >> 16);
+    buffer[3] = (uint8_t)(value >> 24);
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file cpuprof.h
+ * @name cpuprof_init
+ */
+void cpuprof_init(cpuprof_t * prof) {
+    memset(prof, 0, sizeof(cpuprof_t));
+}
+
+/**
+ * @file cpuprof.h
+ * @name cpuprof_reset
+ */
+void cpuprof_reset(cpuprof_t * prof) {
+    memset(prof->slots, 0, sizeof(prof->slots));
+    prof->window_cycles = 0;
+    prof->busy_cycles = 0;
+    prof->nb_overflows = 0;
+}
+
+/**
+ * @file cpuprof.h
+ * @name cpuprof_enter
+ */
+void cpuprof_enter(cpuprof_t * prof, cpuprof_slot_id_t slot, uint32_t now_cycles) {
+    if (prof->depth < CPUPROF_MAX_DEPTH) {
+        prof->stack_slot[prof->depth] = (uint8_t)slot;
+        prof->stack_start[prof->depth] = now_cycles;
+        prof->stack_child[prof->depth] = 0;
+    }
+    else if (prof->nb_overflows < UINT16_MAX) {
+        prof->nb_overflows++;
+    }
+    prof->depth++;
+}
+
+/**
+ * @file cpuprof.h
+ * @name cpuprof_exit
+ */
+void cpuprof_exit(cpuprof_t * prof, uint32_t now_cycles) {
+    if (prof->depth == 0) { return; }
+    prof->depth--;
+
+    // Too deep: its time is left to the enclosing handler
+    if (prof->depth >= CPUPROF_MAX_DEPTH) { return; }
+
+    uint32_t cycles = now_cycles - prof->stack_start[prof->depth];
+    cpuprof_slot_t * slot = &prof->slots[prof->stack_slot[prof->depth]];
+
+    slot->count++;
+    slot->self_cycles += cycles - prof->stack_child[prof->depth];
+    if (cycles > slot->max_cycles) { slot->max_cycles = cycles; }
+
+    // The enclosing handler does not account this time as its own
+    if (prof->depth > 0) { prof->stack_child[prof->depth - 1] += cycles; }
+    else { prof->busy_cycles += cycles; }
+}
+
+/**
+ * @file cpuprof.h
+ * @name cpuprof_account
+ */
+void cpuprof_account(cpuprof_t * prof, uint32_t elapsed_cycles) {
+    prof->window_cycles += elapsed_cycles;
+}
+
+/**
+ * @file cpuprof.h
+ * @name cpuprof_idle_cycles
+ */
+uint64_t cpuprof_idle_cycles(const cpuprof_t * prof) {
+    // A handler started before the reset may end after it
+    return (prof->window_cycles > prof->busy_cycles) ? prof->window_cycles - prof->busy_cycles : 0;
+}
+
+/**
+ * @file cpuprof.h
+ * @name cpuprof_snapshot
+ */
+void cpuprof_snapshot(const cpuprof_t * prof, uint8_t * snapshot) {
+    snapshot[0] = CPUPROF_VERSION;
+    snapshot[1] = CPUPROF_NB_SLOTS;
+    snapshot[2] = (uint8_t)prof->nb_overflows;
+    snapshot[3] = (uint8_t)(prof->nb_overflows >> 8);
+    cpuprof_store_32(&snapshot[4], (uint32_t)(prof->window_cycles / 1000));
+    cpuprof_store_32(&snapshot[8], (uint32_t)(cpuprof_idle_cycles(prof) / 1000));
+
+    for (int i = 0; i < CPUPROF_NB_SLOTS; i++) {
+        uint8_t * record = &snapshot[CPUPROF_HEADER_SIZE + CPUPROF_SLOT_SIZE * i];
+        cpuprof_store_32(&record[0], prof->slots[i].count);
+        cpuprof_store_32(&record[4], (uint32_t)(prof->slots[i].self_cycles / 1000));
+        cpuprof_store_32(&record[8], prof->slots[i].max_cycles);
+    }
+}
+
+/**
+ * @file cpuprof.h
+ * @name cpuprof_slot_name
+ */
+const char * cpuprof_slot_name(cpuprof_slot_id_t slot) {
+    return (slot < CPUPROF_NB_SLOTS) ? cpuprof_names[slot] : "?";
+}
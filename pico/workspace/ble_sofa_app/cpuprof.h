@@ -0,0 +1,150 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: cpuprof.h
+-- Description: Run loop CPU profiler: per-handler call count, self and
+--              worst cycles, idle time, and compact binary snapshot
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef CPUPROF_H
+#define CPUPROF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Snapshot format version */
+#define CPUPROF_VERSION         1
+/** @brief Maximum handler nesting (a handler called from another one) */
+#define CPUPROF_MAX_DEPTH       8
+/** @brief Snapshot header size */
+#define CPUPROF_HEADER_SIZE     12
+/** @brief Snapshot size per slot */
+#define CPUPROF_SLOT_SIZE       12
+/** @brief Snapshot size */
+#define CPUPROF_SNAPSHOT_SIZE   (CPUPROF_HEADER_SIZE + CPUPROF_SLOT_SIZE * CPUPROF_NB_SLOTS)
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef enum {
+    CPUPROF_SLOT_POLL = 0,      /**> async_context_poll(): CYW43 driver, BTstack HCI/L2CAP */
+    CPUPROF_SLOT_HCI_EVENT,     /**> hci_packet_handler() */
+    CPUPROF_SLOT_ATT_EVENT,     /**> att_packet_handler() */
+    CPUPROF_SLOT_ATT_READ,      /**> att_read_callback() */
+    CPUPROF_SLOT_ATT_WRITE,     /**> att_write_callback() */
+    CPUPROF_SLOT_TIMER,         /**> Run loop timers of the application */
+    CPUPROF_SLOT_WORKER,        /**> Async context workers of the application */
+    CPUPROF_NB_SLOTS
+} cpuprof_slot_id_t;
+
+typedef struct {
+    uint32_t count;         /**> Number of calls */
+    uint64_t self_cycles;   /**> Cycles spent in the handler, nested handlers excluded */
+    uint32_t max_cycles;    /**> Worst call, nested handlers included */
+} cpuprof_slot_t;
+
+typedef struct {
+    cpuprof_slot_t slots[CPUPROF_NB_SLOTS];     /**> Per-handler counters */
+    uint64_t window_cycles;                     /**> Cycles elapsed since the reset */
+    uint64_t busy_cycles;                       /**> Cycles spent in the outermost handlers */
+    uint16_t nb_overflows;                      /**> Handlers nested too deep to be profiled */
+    uint8_t depth;                              /**> Current nesting depth */
+    uint8_t stack_slot[CPUPROF_MAX_DEPTH];      /**> Slot of each nesting level */
+    uint32_t stack_start[CPUPROF_MAX_DEPTH];    /**> Entry timestamp of each level */
+    uint32_t stack_child[CPUPROF_MAX_DEPTH];    /**> Cycles of the nested handlers */
+} cpuprof_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Initialize the profiler
+ *
+ * @param prof The profiler structure
+ */
+void cpuprof_init(cpuprof_t * prof);
+
+/**
+ * @brief Reset the counters, the handlers in progress are kept
+ *
+ * @param prof The profiler structure
+ */
+void cpuprof_reset(cpuprof_t * prof);
+
+/**
+ * @brief Enter a handler
+ *
+ * @param prof The profiler structure
+ * @param slot The handler slot
+ * @param now_cycles Current cycle counter (wrapping)
+ */
+void cpuprof_enter(cpuprof_t * prof, cpuprof_slot_id_t slot, uint32_t now_cycles);
+
+/**
+ * @brief Leave the last entered handler
+ *
+ * @param prof The profiler structure
+ * @param now_cycles Current cycle counter (wrapping)
+ */
+void cpuprof_exit(cpuprof_t * prof, uint32_t now_cycles);
+
+/**
+ * @brief Account a run loop iteration
+ *
+ * @param prof The profiler structure
+ * @param elapsed_cycles Cycles elapsed during the iteration
+ */
+void cpuprof_account(cpuprof_t * prof, uint32_t elapsed_cycles);
+
+/**
+ * @brief Get the idle time: the window minus the outermost handlers, so
+ *        that a handler never counts as idle
+ *
+ * @param prof The profiler structure
+ * @return uint64_t Idle cycles since the reset
+ */
+uint64_t cpuprof_idle_cycles(const cpuprof_t * prof);
+
+/**
+ * @brief Serialize the counters, little-endian, cycle totals in kilocycles:
+ *        - [0]      Version
+ *        - [1]      Number of slots
+ *        - [2..3]   Handlers not profiled, nesting deeper than CPUPROF_MAX_DEPTH
+ *        - [4..7]   Window (kcycles)
+ *        - [8..11]  Idle (kcycles)
+ *        - [12..]   Per slot: calls, self (kcycles), worst call (cycles)
+ *
+ * @param prof The profiler structure
+ * @param snapshot Output buffer of CPUPROF_SNAPSHOT_SIZE bytes
+ */
+void cpuprof_snapshot(const cpuprof_t * prof, uint8_t * snapshot);
+
+/**
+ * @brief Get the name of a slot
+ *
+ * @param slot The handler slot
+ * @return const char* The name
+ */
+const char * cpuprof_slot_name(cpuprof_slot_id_t slot);
+
+#endif // CPUPROF_H
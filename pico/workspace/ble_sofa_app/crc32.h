@@ -0,0 +1,42 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: crc32.h
+-- Description: CRC-32 (IEEE 802.3) used to validate records stored in flash
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Update a CRC-32 with a block of data
+ *
+ * @param crc The current CRC value (0 to start a new computation)
+ * @param data The data block
+ * @param len The data block length in bytes
+ * @return uint32_t The updated CRC value
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t * data, size_t len);
+
+#endif // CRC32_H
@@ -0,0 +1,98 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: deadman.c
+-- Description: Hold-to-run deadman: relays are cut when keep-alive writes
+--              stop arriving
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "deadman.h"
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file deadman.h
+ * @name deadman_init
+ */
+void deadman_init(deadman_t * deadman) {
+    memset(deadman, 0, sizeof(deadman_t));
+    deadman->keepalive_ms = DEADMAN_KEEPALIVE_PERIOD_MS;
+    deadman->missed_intervals = DEADMAN_MISSED_INTERVALS;
+    deadman_set_conn_interval(deadman, DEADMAN_DEFAULT_CONN_INTERVAL);
+}
+
+/**
+ * @file deadman.h
+ * @name deadman_set_conn_interval
+ */
+void deadman_set_conn_interval(deadman_t * deadman, uint16_t conn_interval) {
+    // A write is delayed to the next connection event, and each lost packet
+    // costs one more connection interval
+    deadman->conn_interval = conn_interval;
+    deadman->timeout_us = (uint32_t)deadman->keepalive_ms * 1000 + (uint32_t)deadman->missed_intervals * conn_interval * 1250;
+}
+
+/**
+ * @file deadman.h
+ * @name deadman_set_timing
+ */
+void deadman_set_timing(deadman_t * deadman, uint16_t keepalive_ms, uint8_t missed_intervals) {
+    deadman->keepalive_ms = keepalive_ms;
+    deadman->missed_intervals = missed_intervals;
+    deadman_set_conn_interval(deadman, deadman->conn_interval);
+}
+
+/**
+ * @file deadman.h
+ * @name deadman_kick
+ */
+uint64_t deadman_kick(deadman_t * deadman, uint64_t now_us) {
+    if (deadman->armed) {
+        uint32_t gap = (uint32_t)(now_us - deadman->last_kick_us);
+        if (gap > deadman->max_gap_us) { deadman->max_gap_us = gap; }
+    }
+
+    deadman->last_kick_us = now_us;
+    deadman->deadline_us = now_us + deadman->timeout_us;
+    deadman->armed = true;
+
+    return deadman->deadline_us;
+}
+
+/**
+ * @file deadman.h
+ * @name deadman_disarm
+ */
+void deadman_disarm(deadman_t * deadman) {
+    deadman->armed = false;
+}
+
+/**
+ * @file deadman.h
+ * @name deadman_trip
+ */
+bool deadman_trip(deadman_t * deadman, uint64_t now_us) {
+    if (!deadman->armed || (now_us < deadman->deadline_us)) { return false; }
+
+    deadman->armed = false;
+    deadman->nb_trips++;
+    return true;
+}
@@ -0,0 +1,110 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: deadman.h
+-- Description: Hold-to-run deadman: relays are cut when keep-alive writes
+--              stop arriving
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef DEADMAN_H
+#define DEADMAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Keep-alive write period expected from the client in hold-to-run mode */
+#define DEADMAN_KEEPALIVE_PERIOD_MS  100
+/** @brief Number of connection intervals a keep-alive may be late */
+#define DEADMAN_MISSED_INTERVALS       4
+/** @brief Connection interval assumed before the first connection event (1.25 ms units) */
+#define DEADMAN_DEFAULT_CONN_INTERVAL 24
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    volatile bool armed;        /**> Hold-to-run motion in progress */
+    uint16_t keepalive_ms;      /**> Keep-alive period expected from the client */
+    uint8_t missed_intervals;   /**> Connection intervals a keep-alive may be late */
+    uint16_t conn_interval;     /**> Current connection interval (1.25 ms units) */
+    uint32_t timeout_us;        /**> Maximum time between two keep-alives */
+    uint64_t deadline_us;       /**> Time at which the relays are cut */
+    uint64_t last_kick_us;      /**> Time of the last keep-alive */
+    uint32_t nb_trips;          /**> Number of relay cuts due to a late keep-alive */
+    uint32_t max_gap_us;        /**> Worst observed time between two keep-alives */
+} deadman_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Initialize the deadman, disarmed, with the default timing
+ *
+ * @param deadman The deadman structure
+ */
+void deadman_init(deadman_t * deadman);
+
+/**
+ * @brief Update the timeout from the connection interval
+ *
+ * @param deadman The deadman structure
+ * @param conn_interval Connection interval in 1.25 ms units
+ */
+void deadman_set_conn_interval(deadman_t * deadman, uint16_t conn_interval);
+
+/**
+ * @brief Update the timeout from the keep-alive timing, applied from the
+ *        next keep-alive
+ *
+ * @param deadman The deadman structure
+ * @param keepalive_ms Keep-alive period expected from the client
+ * @param missed_intervals Number of connection intervals a keep-alive may be late
+ */
+void deadman_set_timing(deadman_t * deadman, uint16_t keepalive_ms, uint8_t missed_intervals);
+
+/**
+ * @brief Keep-alive: arm the deadman or push its deadline
+ *
+ * @param deadman The deadman structure
+ * @param now_us Current time in microseconds
+ * @return uint64_t The new deadline in microseconds
+ */
+uint64_t deadman_kick(deadman_t * deadman, uint64_t now_us);
+
+/**
+ * @brief Disarm the deadman (motion stopped by the client)
+ *
+ * @param deadman The deadman structure
+ */
+void deadman_disarm(deadman_t * deadman);
+
+/**
+ * @brief Check the deadline, called from the alarm interrupt
+ *
+ * @param deadman The deadman structure
+ * @param now_us Current time in microseconds
+ * @return true if the relays must be cut now (the deadman is then disarmed)
+ */
+bool deadman_trip(deadman_t * deadman, uint64_t now_us);
+
+#endif // DEADMAN_H
@@ -0,0 +1,77 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: ecc_cache.c
+-- Description: Cached P-256 key pair record, rotation policy and ECC profiling
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "crc32.h"
+#include "ecc_cache.h"
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file ecc_cache.h
+ * @name ecc_cache_record_init
+ */
+void ecc_cache_record_init(ecc_cache_record_t * record, const uint8_t * public_key, const uint8_t * private_key) {
+    memset(record, 0, sizeof(ecc_cache_record_t));
+    memcpy(record->public_key, public_key, sizeof(record->public_key));
+    memcpy(record->private_key, private_key, sizeof(record->private_key));
+    ecc_cache_record_seal(record);
+}
+
+/**
+ * @file ecc_cache.h
+ * @name ecc_cache_record_seal
+ */
+void ecc_cache_record_seal(ecc_cache_record_t * record) {
+    record->crc = crc32_update(0, (const uint8_t *)record, offsetof(ecc_cache_record_t, crc));
+}
+
+/**
+ * @file ecc_cache.h
+ * @name ecc_cache_record_valid
+ */
+bool ecc_cache_record_valid(const ecc_cache_record_t * record) {
+    return record->crc == crc32_update(0, (const uint8_t *)record, offsetof(ecc_cache_record_t, crc));
+}
+
+/**
+ * @file ecc_cache.h
+ * @name ecc_cache_record_expired
+ */
+bool ecc_cache_record_expired(const ecc_cache_record_t * record) {
+    return record->nb_pairings >= ECC_CACHE_MAX_PAIRINGS;
+}
+
+/**
+ * @file ecc_cache.h
+ * @name ecc_profile_record
+ */
+void ecc_profile_record(ecc_profile_t * profile, ecc_step_t step, uint32_t duration_us) {
+    ecc_step_stats_t * stats = &profile->steps[step];
+
+    stats->count++;
+    stats->total_us += duration_us;
+    if (duration_us > stats->max_us) { stats->max_us = duration_us; }
+}
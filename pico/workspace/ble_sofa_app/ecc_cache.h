@@ -0,0 +1,118 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: ecc_cache.h
+-- Description: Cached P-256 key pair record, rotation policy and ECC profiling
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef ECC_CACHE_H
+#define ECC_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Number of pairings before the cached key pair is rotated. The key
+ *         pair is only used when pairing, and boots do not write the record */
+#define ECC_CACHE_MAX_PAIRINGS  8
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+/**
+ * @brief Key pair record, stored as is in the BTstack TLV. The private key is
+ *        in clear, with the same protection as the bonding keys stored by
+ *        BTstack in the same TLV: anyone reading the flash gets both
+ */
+typedef struct {
+    uint8_t public_key[64];     /**> P-256 public key (X, Y) */
+    uint8_t private_key[32];    /**> P-256 private key, in clear */
+    uint16_t reserved;          /**> Unused (zero), formerly the boot count */
+    uint16_t nb_pairings;       /**> Number of pairings using this key pair */
+    uint32_t crc;               /**> CRC-32 of the fields above */
+} ecc_cache_record_t;
+
+typedef enum {
+    ECC_STEP_KEYGEN = 0,    /**> Key pair generation (uECC_make_key) */
+    ECC_STEP_DHKEY,         /**> DH key computation (uECC_shared_secret) */
+    ECC_STEP_PAIRING,       /**> Whole pairing, from start to completion */
+    ECC_NB_STEPS
+} ecc_step_t;
+
+typedef struct {
+    uint32_t count;     /**> Number of executions */
+    uint32_t total_us;  /**> Cumulated duration */
+    uint32_t max_us;    /**> Worst duration */
+} ecc_step_stats_t;
+
+typedef struct {
+    ecc_step_stats_t steps[ECC_NB_STEPS];   /**> Per step timings */
+    uint32_t nb_cache_hits;                 /**> Boots using the cached key pair */
+    uint32_t nb_cache_misses;               /**> Boots generating a key pair */
+    uint32_t nb_rotations;                  /**> Key pairs generated in background */
+} ecc_profile_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Initialize a record with a fresh key pair and seal it
+ *
+ * @param record The record structure
+ * @param public_key The 64 bytes public key
+ * @param private_key The 32 bytes private key
+ */
+void ecc_cache_record_init(ecc_cache_record_t * record, const uint8_t * public_key, const uint8_t * private_key);
+
+/**
+ * @brief Update the record CRC after a modification
+ *
+ * @param record The record structure
+ */
+void ecc_cache_record_seal(ecc_cache_record_t * record);
+
+/**
+ * @brief Check the record integrity
+ *
+ * @param record The record structure
+ * @return true if the CRC matches
+ */
+bool ecc_cache_record_valid(const ecc_cache_record_t * record);
+
+/**
+ * @brief Check whether the rotation policy requires a new key pair
+ *
+ * @param record The record structure
+ * @return true if the key pair has been used for too many pairings
+ */
+bool ecc_cache_record_expired(const ecc_cache_record_t * record);
+
+/**
+ * @brief Add a timing measurement to the profile
+ *
+ * @param profile The profile structure
+ * @param step The measured ECC step
+ * @param duration_us The measured duration in microseconds
+ */
+void ecc_profile_record(ecc_profile_t * profile, ecc_step_t step, uint32_t duration_us);
+
+#endif // ECC_CACHE_H
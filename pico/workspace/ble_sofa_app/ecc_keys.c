@@ -0,0 +1,336 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: ecc_keys.c
+-- Description: LE Secure Connections key pair pre-generated on core1 and
+--              cached in flash
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/rand.h"
+#include "pico/cyw43_arch.h"
+#include "btstack.h"
+#include "uECC.h"
+
+#include "ecc_keys.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief BTstack TLV tag of the cached key pair record ('ECCK') */
+#define ECC_KEYS_TLV_TAG  (((uint32_t)'E' << 24) | ((uint32_t)'C' << 16) | ((uint32_t)'C' << 8) | 'K')
+
+/** @brief BTstack TLV tag of the rotated key pair record, used from the next boot ('ECCN') */
+#define ECC_KEYS_NEXT_TLV_TAG  (((uint32_t)'E' << 24) | ((uint32_t)'C' << 16) | ((uint32_t)'C' << 8) | 'N')
+
+/** @brief Key pair generation attempts on core1 before giving up */
+#define ECC_KEYS_KEYGEN_TRIES  3
+
+//----------------------------------------------------------------
+// Global variables
+//----------------------------------------------------------------
+
+/** @brief ECC profiling counters, only updated on core0 */
+static ecc_profile_t ecc_profile;
+
+/** @brief Record of the key pair in use, counting its pairings */
+static ecc_cache_record_t ecc_record;
+
+/** @brief Record generated by core1 */
+static ecc_cache_record_t ecc_next_record;
+
+/** @brief A rotated key pair record is stored, waiting for the next boot */
+static bool ecc_next_stored = false;
+
+/** @brief Duration of the core1 key pair generation, recorded by the store worker */
+static uint32_t ecc_next_keygen_us = 0;
+
+/** @brief All the core1 key pair generation attempts failed */
+static bool ecc_next_failed = false;
+
+/** @brief Key pair returned to BTstack, kept apart from a record rotated meanwhile */
+static uint8_t ecc_active_public_key[64];
+static uint8_t ecc_active_private_key[32];
+static bool ecc_active_set = false;
+
+/** @brief Set while core1 is generating a key pair */
+static volatile bool ecc_core1_busy = false;
+
+/** @brief The key pair in use must be set from the next record (cache miss) */
+static bool ecc_key_pending = false;
+
+/** @brief Key pair ready callback */
+static ecc_keys_ready_callback_t ecc_ready_callback = NULL;
+
+/** @brief Pairing start timestamp */
+static uint32_t ecc_pairing_start_us = 0;
+
+/** @brief BTstack TLV instance */
+static const btstack_tlv_t * ecc_tlv_impl = NULL;
+static void * ecc_tlv_context = NULL;
+
+/** @brief Run loop worker storing the key pair generated by core1 */
+static async_when_pending_worker_t ecc_store_worker;
+
+/** @brief SM events registration */
+static btstack_packet_callback_registration_t ecc_sm_event_callback_registration;
+
+//----------------------------------------------------------------
+// Profiling wrappers (-Wl,--wrap)
+//----------------------------------------------------------------
+
+int __real_uECC_make_key(uint8_t public_key[uECC_BYTES*2], uint8_t private_key[uECC_BYTES]);
+int __real_uECC_shared_secret(const uint8_t public_key[uECC_BYTES*2], const uint8_t private_key[uECC_BYTES], uint8_t secret[uECC_BYTES]);
+
+static int ecc_keys_rng(uint8_t * dest, unsigned size);
+
+/**
+ * @brief Key pair generation, used by BTstack and by core1. BTstack gets the
+ *        cached key pair instead of a generation that would block the run
+ *        loop
+ */
+int __wrap_uECC_make_key(uint8_t public_key[uECC_BYTES*2], uint8_t private_key[uECC_BYTES]) {
+    // Core1 times its own generation and hands the duration over with the
+    // key pair: the profile has a single writer
+    if (get_core_num() != 0) { return __real_uECC_make_key(public_key, private_key); }
+
+    if (ecc_active_set) {
+        memcpy(public_key, ecc_active_public_key, sizeof(ecc_active_public_key));
+        memcpy(private_key, ecc_active_private_key, sizeof(ecc_active_private_key));
+        // BTstack set its own random source before this call, core1 needs ours
+        uECC_set_rng(&ecc_keys_rng);
+        return 1;
+    }
+
+    uint32_t start = time_us_32();
+    int status = __real_uECC_make_key(public_key, private_key);
+    ecc_profile_record(&ecc_profile, ECC_STEP_KEYGEN, time_us_32() - start);
+    return status;
+}
+
+/**
+ * @brief Timed DH key computation, used by BTstack during pairing
+ */
+int __wrap_uECC_shared_secret(const uint8_t public_key[uECC_BYTES*2], const uint8_t private_key[uECC_BYTES], uint8_t secret[uECC_BYTES]) {
+    uint32_t start = time_us_32();
+    int status = __real_uECC_shared_secret(public_key, private_key, secret);
+    ecc_profile_record(&ecc_profile, ECC_STEP_DHKEY, time_us_32() - start);
+    return status;
+}
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Random number generator for micro-ecc, safe to use from both cores
+ */
+static int ecc_keys_rng(uint8_t * dest, unsigned size) {
+    while (size > 0) {
+        uint32_t rnd = get_rand_32();
+        unsigned len = (size < 4) ? size : 4;
+        memcpy(dest, &rnd, len);
+        dest += len;
+        size -= len;
+    }
+    return 1;
+}
+
+/**
+ * @brief Set the key pair returned to BTstack from the current record
+ */
+static void ecc_keys_activate(void) {
+    memcpy(ecc_active_public_key, ecc_record.public_key, sizeof(ecc_active_public_key));
+    memcpy(ecc_active_private_key, ecc_record.private_key, sizeof(ecc_active_private_key));
+    ecc_active_set = true;
+}
+
+/**
+ * @brief Store the record of the key pair in use in flash
+ */
+static void ecc_keys_store(void) {
+    ecc_cache_record_seal(&ecc_record);
+    ecc_tlv_impl->store_tag(ecc_tlv_context, ECC_KEYS_TLV_TAG, (const uint8_t *)&ecc_record, sizeof(ecc_record));
+}
+
+/**
+ * @brief Core1 entry point: generate a key pair, then wait (lockout victim).
+ *        The store worker is set pending on failure too, so that a boot
+ *        waiting for the key pair goes on
+ */
+static void ecc_keys_core1_entry(void) {
+    // Allow core0 to pause core1 while writing to flash
+    multicore_lockout_victim_init();
+
+    uint8_t public_key[64];
+    uint8_t private_key[32];
+    ecc_next_failed = true;
+    for (int i = 0; (i < ECC_KEYS_KEYGEN_TRIES) && ecc_next_failed; i++) {
+        uint32_t start = time_us_32();
+        if (uECC_make_key(public_key, private_key)) {
+            ecc_next_keygen_us = time_us_32() - start;
+            ecc_cache_record_init(&ecc_next_record, public_key, private_key);
+            ecc_next_failed = false;
+        }
+    }
+    async_context_set_work_pending(cyw43_arch_async_context(), &ecc_store_worker);
+    memset(private_key, 0, sizeof(private_key));
+    ecc_core1_busy = false;
+
+    while (true) { __wfe(); }
+}
+
+/**
+ * @brief Start a background key pair generation on core1
+ */
+static void ecc_keys_start_generation(void) {
+    if (ecc_core1_busy) { return; }
+    ecc_core1_busy = true;
+    multicore_reset_core1();
+    multicore_launch_core1(ecc_keys_core1_entry);
+}
+
+/**
+ * @brief Run loop worker: store the key pair generated by core1
+ */
+static void ecc_keys_store_worker(async_context_t * context, async_when_pending_worker_t * worker) {
+    (void)context;
+    (void)worker;
+
+    if (ecc_next_failed) {
+        printf("ECC key pair generation failed on core1\n");
+        if (ecc_key_pending) {
+            // Cache miss at boot: without an active key pair, BTstack
+            // generates its own on core0 (timed by the wrapper). It is not
+            // cached, the next boot tries core1 again
+            ecc_key_pending = false;
+            if (ecc_ready_callback) { ecc_ready_callback(); }
+        }
+        // A failed rotation is tried again at the next pairing
+        return;
+    }
+
+    ecc_profile_record(&ecc_profile, ECC_STEP_KEYGEN, ecc_next_keygen_us);
+
+    if (ecc_key_pending) {
+        // Cache miss at boot: the Security Manager is waiting for this key pair
+        ecc_key_pending = false;
+        ecc_record = ecc_next_record;
+        ecc_keys_activate();
+        ecc_keys_store();
+        if (ecc_ready_callback) { ecc_ready_callback(); }
+    }
+    else {
+        // Rotation: stored apart until the next boot, the record in use keeps
+        // counting the pairings made with the key pair the SM still holds
+        ecc_profile.nb_rotations++;
+        ecc_tlv_impl->store_tag(ecc_tlv_context, ECC_KEYS_NEXT_TLV_TAG, (const uint8_t *)&ecc_next_record, sizeof(ecc_next_record));
+        ecc_next_stored = true;
+    }
+    memset(&ecc_next_record, 0, sizeof(ecc_next_record));
+}
+
+/**
+ * @brief Security Manager events: pairing timing and rotation policy
+ */
+static void ecc_keys_sm_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
+    UNUSED(channel);
+    UNUSED(size);
+
+    if (packet_type != HCI_EVENT_PACKET) { return; }
+
+    switch (hci_event_packet_get_type(packet)) {
+        case SM_EVENT_PAIRING_STARTED:
+            ecc_pairing_start_us = time_us_32();
+            break;
+        case SM_EVENT_PAIRING_COMPLETE:
+            ecc_profile_record(&ecc_profile, ECC_STEP_PAIRING, time_us_32() - ecc_pairing_start_us);
+            if (sm_event_pairing_complete_get_status(packet) != ERROR_CODE_SUCCESS) { break; }
+
+            if (ecc_record.nb_pairings < UINT16_MAX) { ecc_record.nb_pairings++; }
+            ecc_keys_store();
+            if (!ecc_next_stored && ecc_cache_record_expired(&ecc_record)) { ecc_keys_start_generation(); }
+            break;
+        default:
+            break;
+    }
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file ecc_keys.h
+ * @name ecc_keys_init
+ */
+void ecc_keys_init(ecc_keys_ready_callback_t ready_callback) {
+    ecc_ready_callback = ready_callback;
+
+    // Random source for both cores
+    uECC_set_rng(&ecc_keys_rng);
+
+    ecc_store_worker.do_work = &ecc_keys_store_worker;
+    async_context_add_when_pending_worker(cyw43_arch_async_context(), &ecc_store_worker);
+
+    ecc_sm_event_callback_registration.callback = &ecc_keys_sm_packet_handler;
+    sm_add_event_handler(&ecc_sm_event_callback_registration);
+
+    btstack_tlv_get_instance(&ecc_tlv_impl, &ecc_tlv_context);
+
+    // A key pair rotated during the previous boot replaces the one in use:
+    // one write per rotation, the record in use is stored before the
+    // rotated one is deleted
+    int len = ecc_tlv_impl->get_tag(ecc_tlv_context, ECC_KEYS_NEXT_TLV_TAG, (uint8_t *)&ecc_record, sizeof(ecc_record));
+    if ((len == (int)sizeof(ecc_record)) && ecc_cache_record_valid(&ecc_record)) {
+        ecc_keys_store();
+        ecc_tlv_impl->delete_tag(ecc_tlv_context, ECC_KEYS_NEXT_TLV_TAG);
+    }
+    else {
+        len = ecc_tlv_impl->get_tag(ecc_tlv_context, ECC_KEYS_TLV_TAG, (uint8_t *)&ecc_record, sizeof(ecc_record));
+    }
+
+    if ((len == (int)sizeof(ecc_record)) && ecc_cache_record_valid(&ecc_record)) {
+        // Cache hit: no key generation on the run loop
+        ecc_profile.nb_cache_hits++;
+        ecc_keys_activate();
+
+        // No other write at boot: the record only changes with the pairings
+        if (ecc_cache_record_expired(&ecc_record)) { ecc_keys_start_generation(); }
+
+        if (ecc_ready_callback) { ecc_ready_callback(); }
+    }
+    else {
+        // Cache miss: generate on core1, the callback is called from the store worker
+        ecc_profile.nb_cache_misses++;
+        ecc_key_pending = true;
+        ecc_keys_start_generation();
+    }
+}
+
+/**
+ * @file ecc_keys.h
+ * @name ecc_keys_get_profile
+ */
+const ecc_profile_t * ecc_keys_get_profile(void) {
+    return &ecc_profile;
+}
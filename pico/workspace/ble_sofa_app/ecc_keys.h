@@ -0,0 +1,60 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: ecc_keys.h
+-- Description: LE Secure Connections key pair pre-generated on core1 and
+--              cached in flash
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef ECC_KEYS_H
+#define ECC_KEYS_H
+
+#include "ecc_cache.h"
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+/** @brief Called once the local key pair is available to the Security Manager */
+typedef void (*ecc_keys_ready_callback_t)(void);
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Load the cached key pair, returned to BTstack crypto in place of
+ *        its key generation (uECC_make_key wrapper on core0).
+ *        If there is no valid cached key pair, it is generated on core1 first
+ *        (or by BTstack on core0 if core1 fails, without caching it).
+ *        If the cached key pair is expired, the next one is generated on core1
+ *        in background and stored apart: it replaces the key pair in use at the
+ *        next boot, until then the pairings still count against the old one.
+ *
+ * @param ready_callback Called (from the run loop) when the key pair is set
+ * @note Must be called after sm_init() and before hci_power_control()
+ */
+void ecc_keys_init(ecc_keys_ready_callback_t ready_callback);
+
+/**
+ * @brief Get the ECC profiling counters
+ *
+ * @return const ecc_profile_t* The profile structure
+ */
+const ecc_profile_t * ecc_keys_get_profile(void);
+
+#endif // ECC_KEYS_H
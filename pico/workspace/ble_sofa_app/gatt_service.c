@@ -0,0 +1,490 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: gatt_service.c
+-- Description: Control (FF10) and firmware update (FF30) services: attribute
+--              database, ATT read/write callbacks and notifications
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "btstack_config.h"
+#include "bluetooth_gatt.h"
+#include "btstack_defines.h"
+#include "btstack_util.h"
+#include "ble/att_db.h"
+#include "ble/att_server.h"
+#include "mygatt.h"
+
+#include "gatt_service.h"
+#include "control.h"
+#include "ecc_keys.h"
+#include "mem_report.h"
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+/** @brief Notification state of a connected client */
+typedef struct {
+    hci_con_handle_t con_handle;        /**> HCI_CON_HANDLE_INVALID if the entry is free */
+    bool endstop_notify_enabled;        /**> End-stop notifications enabled by the client */
+    uint8_t endstop_status_sent;        /**> Last end-stop status sent to the client */
+    bool telemetry_notify_enabled;      /**> Telemetry notifications enabled by the client */
+    uint32_t telemetry_state_sent;      /**> Last telemetry state sent (acknowledged frame, command, end-stop status) */
+    uint8_t telemetry_sequence;         /**> Telemetry frame sequence number */
+    bool ota_notify_enabled;            /**> Update status notifications enabled by the client */
+    uint32_t ota_revision_sent;         /**> Revision of the last update status sent to the client */
+} gatt_client_t;
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+/** @brief Application state and handlers */
+static gatt_service_config_t service;
+
+/** @brief Connected clients, by connection handle */
+static gatt_client_t clients[MAX_NR_HCI_CONNECTIONS];
+
+/** @brief Last end-stop status logged */
+static uint8_t endstop_status_logged = 0x00;
+
+/** @brief Sequence number of the last command frame received */
+static uint8_t command_ack = 0;
+
+/** @brief Link parameters of the connection, for the status record */
+static status_link_t link;
+
+// Control characteristic: command the relays status, held in motion.command.
+// Written either as one legacy byte or as a protocol.hpp command frame
+// carrying the same byte:
+//   - bit [0]: '0' = Relay1 OFF, '1' = Relay1 ON
+//   - bit [1]: '0' = Relay2 OFF, '1' = Relay2 ON
+//   - bit [7]: '0' = Latched, '1' = Hold-to-run: the command must be repeated
+//              every keep-alive period (PARAM_KEEPALIVE_PERIOD_MS, by default
+//              DEADMAN_KEEPALIVE_PERIOD_MS), otherwise the relays are cut
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Encode the current state as a telemetry frame
+ *
+ * @param frame Output buffer of CONTROL_TELEMETRY_SIZE bytes
+ * @param sequence Telemetry sequence number
+ * @return uint16_t The frame size
+ */
+static uint16_t telemetry_encode(uint8_t * frame, uint8_t sequence) {
+    control_telemetry_t telemetry;
+    telemetry.sequence = sequence;
+    telemetry.state = service.motion->command;
+    telemetry.endstop = gatt_service_endstop_status();
+    telemetry.ack = command_ack;
+    telemetry.power = (uint8_t)service.power->state;
+    telemetry.uptime_ms = (uint32_t)(service.now_us() / 1000);
+    return control_encode_telemetry(&telemetry, frame);
+}
+
+/**
+ * @brief Check that a write may change the firmware or its stored
+ *        parameters: the attribute database
+ *        already requires an authenticated link, the application also
+ *        checks that it is bonded with a full-size key
+ */
+static bool gatt_service_secured(hci_con_handle_t connection_handle) {
+    return (service.secured != NULL) && service.secured(connection_handle);
+}
+
+/**
+ * @brief Telemetry state compared to the last notification: a command frame
+ *        is acknowledged by a notification even when the state is unchanged,
+ *        so the client can time its round trip
+ */
+static uint32_t telemetry_state(void) {
+    return ((uint32_t)command_ack << 16) | ((uint32_t)service.motion->command << 8) | gatt_service_endstop_status();
+}
+
+/**
+ * @brief Find the notification state of a connection
+ *
+ * @param con_handle The connection handle, HCI_CON_HANDLE_INVALID for a free entry
+ * @return gatt_client_t* The entry, NULL if not found
+ */
+static gatt_client_t * gatt_client_get(hci_con_handle_t con_handle) {
+    for (int i = 0; i < MAX_NR_HCI_CONNECTIONS; i++) {
+        if (clients[i].con_handle == con_handle) { return &clients[i]; }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Decode a client configuration descriptor write
+ *
+ * @param buffer The written value
+ * @param buffer_size The written size
+ * @param enabled Output: notifications enabled
+ * @return int 0 on success, ATT error code otherwise
+ */
+static int gatt_client_configuration(const uint8_t * buffer, uint16_t buffer_size, bool * enabled) {
+    if (buffer_size != 2) { return ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH; }
+    *enabled = (little_endian_read_16(buffer, 0) == GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
+    return 0;
+}
+
+/**
+ * @brief Notify one client of the changes since its last notifications
+ */
+static void gatt_client_update(gatt_client_t * client) {
+    hci_con_handle_t con_handle = client->con_handle;
+
+    // End-stop reached or left
+    uint8_t status = gatt_service_endstop_status();
+    if (status != client->endstop_status_sent) {
+        if (client->endstop_notify_enabled) {
+            if (att_server_notify(con_handle, ATT_CHARACTERISTIC_0000FF14_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE, &status, 1) == ERROR_CODE_SUCCESS) {
+                client->endstop_status_sent = status;
+            }
+        }
+        else {
+            client->endstop_status_sent = status;
+        }
+    }
+
+    // Applied command, end-stop status or acknowledged frame changed: notify the telemetry
+    uint32_t state = telemetry_state();
+    if (state != client->telemetry_state_sent) {
+        if (client->telemetry_notify_enabled) {
+            uint8_t frame[CONTROL_TELEMETRY_SIZE];
+            uint16_t len = telemetry_encode(frame, client->telemetry_sequence);
+            if (att_server_notify(con_handle, ATT_CHARACTERISTIC_0000FF17_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE, frame, len) == ERROR_CODE_SUCCESS) {
+                client->telemetry_state_sent = state;
+                client->telemetry_sequence++;
+            }
+        }
+        else {
+            client->telemetry_state_sent = state;
+        }
+    }
+
+    // Update status changed: the client resumes from the expected offset
+    if (service.ota->revision != client->ota_revision_sent) {
+        if (client->ota_notify_enabled) {
+            uint8_t ota_status_record[OTA_STATUS_SIZE];
+            uint32_t revision = service.ota->revision;
+            ota_status(service.ota, ota_status_record);
+            if (att_server_notify(con_handle, ATT_CHARACTERISTIC_0000FF31_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE, ota_status_record, sizeof(ota_status_record)) == ERROR_CODE_SUCCESS) {
+                client->ota_revision_sent = revision;
+            }
+        }
+        else {
+            client->ota_revision_sent = service.ota->revision;
+        }
+    }
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file gatt_service.h
+ * @name gatt_service_init
+ */
+void gatt_service_init(const gatt_service_config_t * config) {
+    service = *config;
+    for (int i = 0; i < MAX_NR_HCI_CONNECTIONS; i++) {
+        memset(&clients[i], 0, sizeof(gatt_client_t));
+        clients[i].con_handle = HCI_CON_HANDLE_INVALID;
+    }
+    endstop_status_logged = gatt_service_endstop_status();
+    status_link_init(&link);
+}
+
+/**
+ * @file gatt_service.h
+ * @name gatt_service_get_db
+ */
+const uint8_t * gatt_service_get_db(void) {
+    return profile_data;
+}
+
+/**
+ * @file gatt_service.h
+ * @name gatt_service_read
+ */
+uint16_t gatt_service_read(hci_con_handle_t connection_handle, uint16_t att_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size) {
+
+    //printf("> att_read_callback: att_handle %04x, offset %04x, buff size %04x\n", att_handle, offset, buffer_size);
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF11_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        uint8_t data = service.motion->command;
+        return att_read_callback_handle_blob(&data, 1, offset, buffer, buffer_size);
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF12_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        // Power statistics, little-endian:
+        //   - [0..3]   Low clock residency (ms)
+        //   - [4..7]   Full clock residency (ms)
+        //   - [8..11]  Sleep time (ms)
+        //   - [12..15] Number of state transitions
+        //   - [16..19] Number of wake-ups
+        //   - [20..23] Cumulated clock restore latency (us)
+        //   - [24..27] Worst clock restore latency (us)
+        power_stats_t stats;
+        uint8_t record[28];
+        power_get_stats(service.power, service.now_us(), &stats);
+        little_endian_store_32(record, 0, (uint32_t)(stats.residency_us[POWER_STATE_LOW] / 1000));
+        little_endian_store_32(record, 4, (uint32_t)(stats.residency_us[POWER_STATE_FULL] / 1000));
+        little_endian_store_32(record, 8, (uint32_t)(stats.sleep_us / 1000));
+        little_endian_store_32(record, 12, stats.nb_transitions);
+        little_endian_store_32(record, 16, stats.nb_wakeups);
+        little_endian_store_32(record, 20, stats.wake_latency_us_total);
+        little_endian_store_32(record, 24, stats.wake_latency_us_max);
+        return att_read_callback_handle_blob(record, sizeof(record), offset, buffer, buffer_size);
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF13_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        // ECC profile, little-endian:
+        //   - [0..35]  Key generation, DH key, pairing: count, total (us), max (us)
+        //   - [36..39] Number of boots using the cached key pair
+        //   - [40..43] Number of boots generating the key pair
+        //   - [44..47] Number of background key rotations
+        const ecc_profile_t * profile = ecc_keys_get_profile();
+        uint8_t record[48];
+        for (int i = 0; i < ECC_NB_STEPS; i++) {
+            little_endian_store_32(record, 12 * i + 0, profile->steps[i].count);
+            little_endian_store_32(record, 12 * i + 4, profile->steps[i].total_us);
+            little_endian_store_32(record, 12 * i + 8, profile->steps[i].max_us);
+        }
+        little_endian_store_32(record, 36, profile->nb_cache_hits);
+        little_endian_store_32(record, 40, profile->nb_cache_misses);
+        little_endian_store_32(record, 44, profile->nb_rotations);
+        return att_read_callback_handle_blob(record, sizeof(record), offset, buffer, buffer_size);
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF14_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        uint8_t status = gatt_service_endstop_status();
+        return att_read_callback_handle_blob(&status, 1, offset, buffer, buffer_size);
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF15_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        // Memory usage, see mem_report_get_record()
+        uint8_t record[MEM_REPORT_RECORD_SIZE];
+        mem_report_get_record(record);
+        return att_read_callback_handle_blob(record, sizeof(record), offset, buffer, buffer_size);
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF16_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        // CPU profile, see cpuprof_snapshot()
+        uint8_t snapshot[CPUPROF_SNAPSHOT_SIZE];
+        cpuprof_snapshot(service.cpuprof, snapshot);
+        return att_read_callback_handle_blob(snapshot, sizeof(snapshot), offset, buffer, buffer_size);
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF17_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        // Telemetry frame, see protocol.hpp; the size query does not use a sequence
+        // number, shared with the notifications of the connection
+        gatt_client_t * client = gatt_client_get(connection_handle);
+        uint8_t sequence = 0;
+        if (client != NULL) { sequence = (buffer != NULL) ? client->telemetry_sequence++ : client->telemetry_sequence; }
+        uint8_t frame[CONTROL_TELEMETRY_SIZE];
+        uint16_t len = telemetry_encode(frame, sequence);
+        return att_read_callback_handle_blob(frame, len, offset, buffer, buffer_size);
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF18_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        // Status record, see status_snapshot()
+        uint8_t record[STATUS_RECORD_SIZE];
+        status_snapshot(service.motion, service.deadman, service.power, &link, service.now_us(), record);
+        return att_read_callback_handle_blob(record, sizeof(record), offset, buffer, buffer_size);
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF19_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        // Applied parameters and last command result, see params_snapshot()
+        uint8_t snapshot[PARAMS_SNAPSHOT_SIZE];
+        params_snapshot(service.params, snapshot);
+        return att_read_callback_handle_blob(snapshot, sizeof(snapshot), offset, buffer, buffer_size);
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF31_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        // Update status, see ota_status()
+        uint8_t status[OTA_STATUS_SIZE];
+        ota_status(service.ota, status);
+        return att_read_callback_handle_blob(status, sizeof(status), offset, buffer, buffer_size);
+    }
+
+    return 0;
+}
+
+/**
+ * @file gatt_service.h
+ * @name gatt_service_write
+ */
+int gatt_service_write(hci_con_handle_t connection_handle, uint16_t att_handle, uint16_t transaction_mode, uint16_t offset, uint8_t * buffer, uint16_t buffer_size) {
+    UNUSED(transaction_mode);
+    UNUSED(offset);
+
+    //printf("> att_write_callback: att_handle %04x, offset %04x, buff size %04x\n", att_handle, offset, buffer_size);
+    if (buffer == NULL) { return 0; }
+
+    // Client configuration descriptors: notifications of this connection only
+    gatt_client_t * client = gatt_client_get(connection_handle);
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF14_0000_1000_8000_00805F9B34FB_01_CLIENT_CONFIGURATION_HANDLE) {
+        if (client == NULL) { return ATT_ERROR_UNLIKELY_ERROR; }
+        int error = gatt_client_configuration(buffer, buffer_size, &client->endstop_notify_enabled);
+        client->endstop_status_sent = gatt_service_endstop_status();
+        return error;
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF16_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        // Any write starts a new profiling window
+        cpuprof_reset(service.cpuprof);
+        return 0;
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF17_0000_1000_8000_00805F9B34FB_01_CLIENT_CONFIGURATION_HANDLE) {
+        if (client == NULL) { return ATT_ERROR_UNLIKELY_ERROR; }
+        int error = gatt_client_configuration(buffer, buffer_size, &client->telemetry_notify_enabled);
+        client->telemetry_state_sent = telemetry_state();
+        return error;
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF19_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        // The whole set is checked before anything is applied: a rejected
+        // command leaves the parameters unchanged, the reason is in the snapshot
+        if (!gatt_service_secured(connection_handle)) { return ATT_ERROR_INSUFFICIENT_AUTHENTICATION; }
+        if (!params_control(service.params, buffer, buffer_size, service.now_us())) { return ATT_ERROR_VALUE_NOT_ALLOWED; }
+        return 0;
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF31_0000_1000_8000_00805F9B34FB_01_CLIENT_CONFIGURATION_HANDLE) {
+        if (client == NULL) { return ATT_ERROR_UNLIKELY_ERROR; }
+        int error = gatt_client_configuration(buffer, buffer_size, &client->ota_notify_enabled);
+        client->ota_revision_sent = service.ota->revision;
+        return error;
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF31_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        if (!gatt_service_secured(connection_handle)) { return ATT_ERROR_INSUFFICIENT_AUTHENTICATION; }
+        ota_state_t state = service.ota->state;
+        if (!ota_control(service.ota, buffer, buffer_size, service.now_us())) { return ATT_ERROR_VALUE_NOT_ALLOWED; }
+        // Update started (refused while moving): the sofa is stopped before
+        // the first erase, the hold-to-run deadman disarmed
+        if ((state != OTA_STATE_RECEIVING) && (service.ota->state == OTA_STATE_RECEIVING)) { service.command(connection_handle, MOTION_STOP); }
+        return 0;
+    }
+
+    if (att_handle == ATT_CHARACTERISTIC_0000FF32_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) {
+        // Written without response: a dropped packet is reported through the status
+        if (!gatt_service_secured(connection_handle)) { return ATT_ERROR_INSUFFICIENT_AUTHENTICATION; }
+        ota_data(service.ota, buffer, buffer_size, service.now_us());
+        return 0;
+    }
+
+    if (att_handle != ATT_CHARACTERISTIC_0000FF11_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE) { return 0; }
+
+    // Any write brings the system clock back to full speed
+    service.activity();
+
+    // Legacy command byte or command frame
+    control_command_t command;
+    if (control_decode_command(buffer, buffer_size, &command) != 0) { return ATT_ERROR_VALUE_NOT_ALLOWED; }
+    command_ack = command.sequence;
+    if (command.has_motion) { service.command(connection_handle, command.motion); }
+
+    // Acknowledge each frame in its own notification, before the next write
+    // is processed: the client times its round trip
+    if (command.version != CONTROL_LEGACY_VERSION) { gatt_service_update(); }
+
+    return 0;
+}
+
+/**
+ * @file gatt_service.h
+ * @name gatt_service_connected
+ */
+void gatt_service_connected(hci_con_handle_t connection_handle) {
+    gatt_client_t * client = gatt_client_get(HCI_CON_HANDLE_INVALID);
+    if (client == NULL) {
+        printf("GATT - no client entry left for connection %04x\n", connection_handle);
+        return;
+    }
+
+    // Notifications disabled until the client writes its configuration
+    memset(client, 0, sizeof(gatt_client_t));
+    client->con_handle = connection_handle;
+    client->endstop_status_sent = gatt_service_endstop_status();
+    client->telemetry_state_sent = telemetry_state();
+    client->ota_revision_sent = service.ota->revision;
+}
+
+/**
+ * @file gatt_service.h
+ * @name gatt_service_disconnected
+ */
+void gatt_service_disconnected(hci_con_handle_t connection_handle) {
+    gatt_client_t * client = gatt_client_get(connection_handle);
+    if (client != NULL) { client->con_handle = HCI_CON_HANDLE_INVALID; }
+    status_link_init(&link);
+}
+
+/**
+ * @file gatt_service.h
+ * @name gatt_service_set_mtu
+ */
+void gatt_service_set_mtu(uint16_t mtu) {
+    link.mtu = mtu;
+}
+
+/**
+ * @file gatt_service.h
+ * @name gatt_service_set_data_length
+ */
+void gatt_service_set_data_length(uint16_t tx_octets, uint16_t rx_octets) {
+    link.tx_octets = tx_octets;
+    link.rx_octets = rx_octets;
+}
+
+/**
+ * @file gatt_service.h
+ * @name gatt_service_update
+ */
+void gatt_service_update(void) {
+    // End-stop reached or left: notify the client
+    uint8_t status = gatt_service_endstop_status();
+    if (status != endstop_status_logged) {
+        printf("End-stop - status %02x (%u cuts)\n", status, service.motion->nb_limit_cuts);
+        endstop_status_logged = status;
+    }
+
+    // Each client is notified of the changes since its own last notifications
+    for (int i = 0; i < MAX_NR_HCI_CONNECTIONS; i++) {
+        if (clients[i].con_handle != HCI_CON_HANDLE_INVALID) { gatt_client_update(&clients[i]); }
+    }
+}
+
+/**
+ * @file gatt_service.h
+ * @name gatt_service_endstop_status
+ */
+uint8_t gatt_service_endstop_status(void) {
+    return motion_endstop_status(service.motion);
+}
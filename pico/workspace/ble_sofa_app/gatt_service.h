@@ -0,0 +1,154 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: gatt_service.h
+-- Description: Control (FF10) and firmware update (FF30) services: attribute
+--              database, ATT read/write callbacks and notifications
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef GATT_SERVICE_H
+#define GATT_SERVICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bluetooth.h"
+
+#include "motion.h"
+#include "deadman.h"
+#include "power.h"
+#include "cpuprof.h"
+#include "status.h"
+#include "ota.h"
+#include "params.h"
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+/** @brief Apply a command byte written to the control characteristic by a connection */
+typedef void (*gatt_service_command_callback_t)(hci_con_handle_t con_handle, uint8_t command);
+
+/** @brief Client activity (any control write), before the command is applied */
+typedef void (*gatt_service_activity_callback_t)(void);
+
+/** @brief Time since boot in microseconds */
+typedef uint64_t (*gatt_service_time_callback_t)(void);
+
+/** @brief Check that a link is encrypted, authenticated and bonded */
+typedef bool (*gatt_service_secured_callback_t)(hci_con_handle_t con_handle);
+
+typedef struct {
+    motion_t * motion;                          /**> Relay command state */
+    deadman_t * deadman;                        /**> Hold-to-run deadman */
+    power_manager_t * power;                    /**> Power manager */
+    cpuprof_t * cpuprof;                        /**> CPU profiler */
+    ota_t * ota;                                /**> Firmware update receiver */
+    params_t * params;                          /**> Runtime parameters */
+    gatt_service_command_callback_t command;    /**> Control command handler */
+    gatt_service_activity_callback_t activity;  /**> Client activity handler */
+    gatt_service_time_callback_t now_us;        /**> Time source */
+    gatt_service_secured_callback_t secured;    /**> Link security, required to write the parameters and update characteristics */
+} gatt_service_config_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Initialize the service, no client connected
+ *
+ * @param config The application state and handlers, copied
+ */
+void gatt_service_init(const gatt_service_config_t * config);
+
+/**
+ * @brief Get the attribute database generated from mygatt.gatt
+ *
+ * @return const uint8_t* The database, for att_server_init()
+ */
+const uint8_t * gatt_service_get_db(void);
+
+/**
+ * @brief ATT read callback
+ *
+ * @param con_handle The connection handle
+ * @param att_handle The attribute handle
+ * @param offset Read offset
+ * @param buffer Output buffer, NULL to get the value size
+ * @param buffer_size Output buffer size
+ * @return uint16_t Number of bytes read, or value size
+ */
+uint16_t gatt_service_read(hci_con_handle_t con_handle, uint16_t att_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size);
+
+/**
+ * @brief ATT write callback
+ *
+ * @param con_handle The connection handle
+ * @param att_handle The attribute handle
+ * @param transaction_mode ATT transaction mode
+ * @param offset Write offset
+ * @param buffer The written value
+ * @param buffer_size The written size
+ * @return int 0 on success, ATT error code otherwise
+ */
+int gatt_service_write(hci_con_handle_t con_handle, uint16_t att_handle, uint16_t transaction_mode, uint16_t offset, uint8_t * buffer, uint16_t buffer_size);
+
+/**
+ * @brief A client connected: its notifications are sent once it enables them
+ *
+ * @param con_handle The connection handle
+ */
+void gatt_service_connected(hci_con_handle_t con_handle);
+
+/**
+ * @brief A client disconnected: its notifications are disabled
+ *
+ * @param con_handle The connection handle
+ */
+void gatt_service_disconnected(hci_con_handle_t con_handle);
+
+/**
+ * @brief The ATT MTU exchange completed
+ *
+ * @param mtu The negotiated ATT MTU
+ */
+void gatt_service_set_mtu(uint16_t mtu);
+
+/**
+ * @brief The LE data length of the connection changed
+ *
+ * @param tx_octets Maximum LL payload sent
+ * @param rx_octets Maximum LL payload received
+ */
+void gatt_service_set_data_length(uint16_t tx_octets, uint16_t rx_octets);
+
+/**
+ * @brief Notify the end-stop status, the telemetry and the update status if
+ *        they changed, called from the run loop after a relay or update change
+ */
+void gatt_service_update(void);
+
+/**
+ * @brief Get the end-stop status byte:
+ *        bits [1:0] active end-stops (Up, Down), bits [5:4] last end-stop reached
+ *
+ * @return uint8_t The end-stop status
+ */
+uint8_t gatt_service_endstop_status(void);
+
+#endif // GATT_SERVICE_H
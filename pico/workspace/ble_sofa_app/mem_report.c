@@ -0,0 +1,155 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: mem_report.c
+-- Description: Firmware memory usage: stacks of both cores, heap and
+--              BTstack static pools
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+
+#include "btstack_config.h"
+#include "btstack_util.h"
+#include "ble/le_device_db.h"
+
+#include "mem_report.h"
+
+//----------------------------------------------------------------
+// Linker symbols (memmap_default.ld)
+//----------------------------------------------------------------
+
+extern uint32_t __StackBottom;
+extern uint32_t __StackTop;
+extern uint32_t __StackOneBottom;
+extern uint32_t __StackOneTop;
+extern char end;
+extern char __HeapLimit;
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+/** @brief BTstack pool counters */
+static memmon_pool_t mem_pools[MEM_REPORT_NB_POOLS];
+
+//----------------------------------------------------------------
+// BTstack pool wrappers (-Wl,--wrap)
+//----------------------------------------------------------------
+
+void * __real_btstack_memory_hci_connection_get(void);
+void __real_btstack_memory_hci_connection_free(void * entry);
+void * __real_btstack_memory_sm_lookup_entry_get(void);
+void __real_btstack_memory_sm_lookup_entry_free(void * entry);
+void * __real_btstack_memory_whitelist_entry_get(void);
+void __real_btstack_memory_whitelist_entry_free(void * entry);
+
+void * __wrap_btstack_memory_hci_connection_get(void) {
+    void * entry = __real_btstack_memory_hci_connection_get();
+    memmon_pool_get(&mem_pools[MEM_REPORT_POOL_HCI_CONNECTION], entry != NULL);
+    return entry;
+}
+
+void __wrap_btstack_memory_hci_connection_free(void * entry) {
+    memmon_pool_free(&mem_pools[MEM_REPORT_POOL_HCI_CONNECTION]);
+    __real_btstack_memory_hci_connection_free(entry);
+}
+
+void * __wrap_btstack_memory_sm_lookup_entry_get(void) {
+    void * entry = __real_btstack_memory_sm_lookup_entry_get();
+    memmon_pool_get(&mem_pools[MEM_REPORT_POOL_SM_LOOKUP_ENTRY], entry != NULL);
+    return entry;
+}
+
+void __wrap_btstack_memory_sm_lookup_entry_free(void * entry) {
+    memmon_pool_free(&mem_pools[MEM_REPORT_POOL_SM_LOOKUP_ENTRY]);
+    __real_btstack_memory_sm_lookup_entry_free(entry);
+}
+
+void * __wrap_btstack_memory_whitelist_entry_get(void) {
+    void * entry = __real_btstack_memory_whitelist_entry_get();
+    memmon_pool_get(&mem_pools[MEM_REPORT_POOL_WHITELIST_ENTRY], entry != NULL);
+    return entry;
+}
+
+void __wrap_btstack_memory_whitelist_entry_free(void * entry) {
+    memmon_pool_free(&mem_pools[MEM_REPORT_POOL_WHITELIST_ENTRY]);
+    __real_btstack_memory_whitelist_entry_free(entry);
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file mem_report.h
+ * @name mem_report_init
+ */
+void mem_report_init(void) {
+    // Keep a margin below the current frame, used by the calls below
+    uint32_t marker;
+    memmon_stack_paint(&__StackBottom, &marker - 64);
+    memmon_stack_paint(&__StackOneBottom, &__StackOneTop);
+
+    memmon_pool_init(&mem_pools[MEM_REPORT_POOL_HCI_CONNECTION], MAX_NR_HCI_CONNECTIONS);
+    memmon_pool_init(&mem_pools[MEM_REPORT_POOL_SM_LOOKUP_ENTRY], MAX_NR_SM_LOOKUP_ENTRIES);
+    memmon_pool_init(&mem_pools[MEM_REPORT_POOL_WHITELIST_ENTRY], MAX_NR_WHITELIST_ENTRIES);
+    memmon_pool_init(&mem_pools[MEM_REPORT_POOL_LE_DEVICE_DB], MAX_NR_LE_DEVICE_DB_ENTRIES);
+    memmon_pool_init(&mem_pools[MEM_REPORT_POOL_ACL_PAYLOAD], HCI_ACL_PAYLOAD_SIZE);
+}
+
+/**
+ * @file mem_report.h
+ * @name mem_report_set_mtu
+ */
+void mem_report_set_mtu(uint16_t mtu) {
+    // ATT PDU plus the L2CAP basic header
+    memmon_pool_set(&mem_pools[MEM_REPORT_POOL_ACL_PAYLOAD], mtu + 4);
+}
+
+/**
+ * @file mem_report.h
+ * @name mem_report_get_pool
+ */
+const memmon_pool_t * mem_report_get_pool(mem_report_pool_t pool) {
+    return &mem_pools[pool];
+}
+
+/**
+ * @file mem_report.h
+ * @name mem_report_get_record
+ */
+void mem_report_get_record(uint8_t * record) {
+    struct mallinfo heap = mallinfo();
+
+    // The device database is not allocated from a pool, read its level
+    memmon_pool_set(&mem_pools[MEM_REPORT_POOL_LE_DEVICE_DB], (uint16_t)le_device_db_count());
+
+    little_endian_store_32(record, 0, (uint32_t)((&__StackTop - &__StackBottom) * sizeof(uint32_t)));
+    little_endian_store_32(record, 4, memmon_stack_used(&__StackBottom, &__StackTop));
+    little_endian_store_32(record, 8, (uint32_t)((&__StackOneTop - &__StackOneBottom) * sizeof(uint32_t)));
+    little_endian_store_32(record, 12, memmon_stack_used(&__StackOneBottom, &__StackOneTop));
+    little_endian_store_32(record, 16, (uint32_t)(&__HeapLimit - &end));
+    little_endian_store_32(record, 20, (uint32_t)heap.arena);
+    little_endian_store_32(record, 24, (uint32_t)heap.uordblks);
+
+    for (int i = 0; i < MEM_REPORT_NB_POOLS; i++) {
+        little_endian_store_16(record, 28 + 8 * i + 0, mem_pools[i].capacity);
+        little_endian_store_16(record, 28 + 8 * i + 2, mem_pools[i].used);
+        little_endian_store_16(record, 28 + 8 * i + 4, mem_pools[i].peak);
+        little_endian_store_16(record, 28 + 8 * i + 6, mem_pools[i].nb_failures);
+    }
+}
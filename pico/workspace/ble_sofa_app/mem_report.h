@@ -0,0 +1,90 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: mem_report.h
+-- Description: Firmware memory usage: stacks of both cores, heap and
+--              BTstack static pools
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef MEM_REPORT_H
+#define MEM_REPORT_H
+
+#include <stdint.h>
+
+#include "memmon.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Size of the memory usage record */
+#define MEM_REPORT_RECORD_SIZE  (28 + 8 * MEM_REPORT_NB_POOLS)
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef enum {
+    MEM_REPORT_POOL_HCI_CONNECTION = 0, /**> MAX_NR_HCI_CONNECTIONS */
+    MEM_REPORT_POOL_SM_LOOKUP_ENTRY,    /**> MAX_NR_SM_LOOKUP_ENTRIES */
+    MEM_REPORT_POOL_WHITELIST_ENTRY,    /**> MAX_NR_WHITELIST_ENTRIES */
+    MEM_REPORT_POOL_LE_DEVICE_DB,       /**> MAX_NR_LE_DEVICE_DB_ENTRIES */
+    MEM_REPORT_POOL_ACL_PAYLOAD,        /**> HCI_ACL_PAYLOAD_SIZE bytes, used by the ATT MTU */
+    MEM_REPORT_NB_POOLS
+} mem_report_pool_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Paint the unused part of the core0 stack and the core1 stack
+ * @note Must be called first in main(), before core1 is launched
+ */
+void mem_report_init(void);
+
+/**
+ * @brief Account the ATT MTU negotiated with a client in the ACL payload pool
+ *
+ * @param mtu The ATT MTU
+ */
+void mem_report_set_mtu(uint16_t mtu);
+
+/**
+ * @brief Get the usage counters of a pool
+ *
+ * @param pool The pool
+ * @return const memmon_pool_t* The pool counters
+ */
+const memmon_pool_t * mem_report_get_pool(mem_report_pool_t pool);
+
+/**
+ * @brief Serialize the memory usage, little-endian:
+ *        - [0..3]   Core0 stack size (bytes)
+ *        - [4..7]   Core0 stack high-water mark (bytes)
+ *        - [8..11]  Core1 stack size (bytes)
+ *        - [12..15] Core1 stack high-water mark (bytes)
+ *        - [16..19] Heap size (bytes)
+ *        - [20..23] Heap obtained from the system by malloc (bytes)
+ *        - [24..27] Heap in use (bytes)
+ *        - [28..]   Per pool: capacity, used, peak, failures (16-bit each)
+ *
+ * @param record Output record of MEM_REPORT_RECORD_SIZE bytes
+ */
+void mem_report_get_record(uint8_t * record);
+
+#endif // MEM_REPORT_H
@@ -0,0 +1,92 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: memmon.c
+-- Description: Memory monitoring: stack painting with high-water marks and
+--              static pool usage counters
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "memmon.h"
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file memmon.h
+ * @name memmon_stack_paint
+ */
+void memmon_stack_paint(uint32_t * bottom, uint32_t * top) {
+    for (uint32_t * p = bottom; p < top; p++) {
+        *p = MEMMON_STACK_PATTERN;
+    }
+}
+
+/**
+ * @file memmon.h
+ * @name memmon_stack_used
+ */
+uint32_t memmon_stack_used(const uint32_t * bottom, const uint32_t * top) {
+    const uint32_t * p = bottom;
+
+    // The deepest frame is the lowest word that has been overwritten
+    while ((p < top) && (*p == MEMMON_STACK_PATTERN)) { p++; }
+
+    return (uint32_t)(top - p) * sizeof(uint32_t);
+}
+
+/**
+ * @file memmon.h
+ * @name memmon_pool_init
+ */
+void memmon_pool_init(memmon_pool_t * pool, uint16_t capacity) {
+    memset(pool, 0, sizeof(memmon_pool_t));
+    pool->capacity = capacity;
+}
+
+/**
+ * @file memmon.h
+ * @name memmon_pool_get
+ */
+void memmon_pool_get(memmon_pool_t * pool, bool success) {
+    if (!success) {
+        pool->nb_failures++;
+        return;
+    }
+
+    pool->used++;
+    if (pool->used > pool->peak) { pool->peak = pool->used; }
+}
+
+/**
+ * @file memmon.h
+ * @name memmon_pool_free
+ */
+void memmon_pool_free(memmon_pool_t * pool) {
+    if (pool->used > 0) { pool->used--; }
+}
+
+/**
+ * @file memmon.h
+ * @name memmon_pool_set
+ */
+void memmon_pool_set(memmon_pool_t * pool, uint16_t used) {
+    pool->used = used;
+    if (used > pool->peak) { pool->peak = used; }
+}
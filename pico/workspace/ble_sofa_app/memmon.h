@@ -0,0 +1,100 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: memmon.h
+-- Description: Memory monitoring: stack painting with high-water marks and
+--              static pool usage counters
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef MEMMON_H
+#define MEMMON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Pattern written to the unused part of the stacks */
+#define MEMMON_STACK_PATTERN    0xDEADBEEFu
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    uint16_t capacity;      /**> Number of entries of the pool */
+    uint16_t used;          /**> Entries currently in use */
+    uint16_t peak;          /**> Highest number of entries in use */
+    uint16_t nb_failures;   /**> Allocations refused, pool exhausted */
+} memmon_pool_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Paint a stack area with MEMMON_STACK_PATTERN
+ *
+ * @param bottom Lowest word of the area
+ * @param top End of the area (excluded)
+ * @note Must not cover the live part of the stack being painted
+ */
+void memmon_stack_paint(uint32_t * bottom, uint32_t * top);
+
+/**
+ * @brief Get the stack high-water mark, for a stack growing downwards
+ *
+ * @param bottom Lowest word of the stack
+ * @param top Initial stack pointer (excluded)
+ * @return uint32_t Worst stack usage in bytes
+ */
+uint32_t memmon_stack_used(const uint32_t * bottom, const uint32_t * top);
+
+/**
+ * @brief Initialize a pool counter
+ *
+ * @param pool The pool counter
+ * @param capacity Number of entries of the pool
+ */
+void memmon_pool_init(memmon_pool_t * pool, uint16_t capacity);
+
+/**
+ * @brief Account an allocation attempt
+ *
+ * @param pool The pool counter
+ * @param success false if the pool was exhausted
+ */
+void memmon_pool_get(memmon_pool_t * pool, bool success);
+
+/**
+ * @brief Account the release of an entry
+ *
+ * @param pool The pool counter
+ */
+void memmon_pool_free(memmon_pool_t * pool);
+
+/**
+ * @brief Set the usage of a pool read as a level (database entries, buffer bytes)
+ *
+ * @param pool The pool counter
+ * @param used Entries currently in use
+ */
+void memmon_pool_set(memmon_pool_t * pool, uint16_t used);
+
+#endif // MEMMON_H
@@ -0,0 +1,107 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: motion.c
+-- Description: Motion command path shared by BLE writes and local inputs
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "motion.h"
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file motion.h
+ * @name motion_init
+ */
+void motion_init(motion_t * motion, motion_output_callback_t output, void * output_context) {
+    memset(motion, 0, sizeof(motion_t));
+    motion->output = output;
+    motion->output_context = output_context;
+    motion->output(MOTION_STOP, motion->output_context);
+}
+
+/**
+ * @file motion.h
+ * @name motion_command
+ */
+uint8_t motion_command(motion_t * motion, uint8_t command, motion_source_t source) {
+    uint8_t relays = command & MOTION_RELAYS_MASK;
+
+    // Never drive the Up and Down lines at the same time
+    if (relays == MOTION_RELAYS_MASK) {
+        motion->nb_rejected++;
+        relays = MOTION_STOP;
+    }
+
+    // Never drive past an end-stop
+    if (relays & motion->limits) {
+        motion->nb_blocked++;
+        relays &= ~motion->limits;
+    }
+
+    // Leaving the end-stop: the position is no longer known
+    if (relays != MOTION_STOP) { motion->position = MOTION_POSITION_UNKNOWN; }
+
+    motion->output(relays, motion->output_context);
+    motion->command = (command & ~MOTION_RELAYS_MASK) | relays;
+    motion->last_source = source;
+    motion->nb_commands[source]++;
+
+    return relays;
+}
+
+/**
+ * @file motion.h
+ * @name motion_limit
+ */
+bool motion_limit(motion_t * motion, uint8_t direction, bool active) {
+    if (!active) {
+        motion->limits &= ~direction;
+        return false;
+    }
+
+    motion->limits |= direction;
+    motion->position = (direction == MOTION_UP) ? MOTION_POSITION_UP_END : MOTION_POSITION_DOWN_END;
+
+    if (!(motion->command & direction)) { return false; }
+
+    motion->command &= ~direction;
+    motion->output(motion->command & MOTION_RELAYS_MASK, motion->output_context);
+    motion->nb_limit_cuts++;
+
+    return true;
+}
+
+/**
+ * @file motion.h
+ * @name motion_is_moving
+ */
+bool motion_is_moving(const motion_t * motion) {
+    return (motion->command & MOTION_RELAYS_MASK) != 0;
+}
+
+/**
+ * @file motion.h
+ * @name motion_endstop_status
+ */
+uint8_t motion_endstop_status(const motion_t * motion) {
+    return (uint8_t)(motion->limits | (motion->position << 4));
+}
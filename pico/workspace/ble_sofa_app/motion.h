@@ -0,0 +1,130 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: motion.h
+-- Description: Motion command path shared by BLE writes and local inputs
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef MOTION_H
+#define MOTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+// Command byte, same encoding as the control characteristic:
+//   - bit [0]: Relay1 (Up line of the motor)
+//   - bit [1]: Relay2 (Down line of the motor)
+//   - bit [7]: Hold-to-run
+#define MOTION_STOP         0x00
+#define MOTION_UP           0x01
+#define MOTION_DOWN         0x02
+#define MOTION_RELAYS_MASK  0x03
+#define MOTION_HOLD_TO_RUN  0x80
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef enum {
+    MOTION_SOURCE_BLE = 0,  /**> Control characteristic write */
+    MOTION_SOURCE_BUTTON,   /**> Local Up/Down button */
+    MOTION_SOURCE_DEADMAN,  /**> Hold-to-run keep-alive timeout */
+    MOTION_SOURCE_USB,      /**> Command frame received on the USB CDC interface */
+    MOTION_NB_SOURCES
+} motion_source_t;
+
+typedef enum {
+    MOTION_POSITION_UNKNOWN = 0,    /**> Somewhere between the end-stops */
+    MOTION_POSITION_UP_END,         /**> Up end-stop reached */
+    MOTION_POSITION_DOWN_END        /**> Down end-stop reached */
+} motion_position_t;
+
+/** @brief Drive the relay outputs (bit [0]: Relay1, bit [1]: Relay2) */
+typedef void (*motion_output_callback_t)(uint8_t relays, void * context);
+
+typedef struct {
+    volatile uint8_t command;                   /**> Last applied command */
+    volatile uint8_t limits;                    /**> Directions blocked by an end-stop */
+    motion_position_t position;                 /**> Last end-stop reached */
+    motion_source_t last_source;                /**> Source of the last command */
+    motion_output_callback_t output;            /**> Relay outputs driver */
+    void * output_context;                      /**> Relay outputs driver context */
+    uint32_t nb_commands[MOTION_NB_SOURCES];    /**> Number of commands per source */
+    uint32_t nb_rejected;                       /**> Commands requesting both directions */
+    uint32_t nb_blocked;                        /**> Commands blocked by an end-stop */
+    uint32_t nb_limit_cuts;                     /**> Motions cut by an end-stop */
+} motion_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Initialize the motion command path, relays off
+ *
+ * @param motion The motion structure
+ * @param output The relay outputs driver
+ * @param output_context The relay outputs driver context
+ */
+void motion_init(motion_t * motion, motion_output_callback_t output, void * output_context);
+
+/**
+ * @brief Apply a command to the relays.
+ *        Requesting both directions at once stops the motor, and a direction
+ *        whose end-stop is active is not driven.
+ *
+ * @param motion The motion structure
+ * @param command The command byte
+ * @param source The command source
+ * @return uint8_t The relay outputs actually applied
+ * @note Not reentrant: callers from thread and interrupt context must be serialized
+ */
+uint8_t motion_command(motion_t * motion, uint8_t command, motion_source_t source);
+
+/**
+ * @brief Update an end-stop, cutting the matching direction if it is driven
+ *
+ * @param motion The motion structure
+ * @param direction MOTION_UP or MOTION_DOWN
+ * @param active true if the end-stop is reached
+ * @return true if the motion has been cut
+ * @note Not reentrant: callers from thread and interrupt context must be serialized
+ */
+bool motion_limit(motion_t * motion, uint8_t direction, bool active);
+
+/**
+ * @brief Check whether a relay is on
+ *
+ * @param motion The motion structure
+ * @return true if the motor is driven
+ */
+bool motion_is_moving(const motion_t * motion);
+
+/**
+ * @brief Get the end-stop status byte:
+ *        bits [1:0] active end-stops (Up, Down), bits [5:4] last end-stop reached
+ *
+ * @param motion The motion structure
+ * @return uint8_t The end-stop status
+ */
+uint8_t motion_endstop_status(const motion_t * motion);
+
+#endif // MOTION_H
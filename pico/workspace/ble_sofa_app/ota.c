@@ -0,0 +1,404 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: ota.c
+-- Description: Firmware update: streamed image written to the inactive flash
+--              bank by sectors, CRC verification and copy at boot
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "ota.h"
+#include "crc32.h"
+
+#ifdef LIB_PICO_PLATFORM
+#include "pico.h"
+/** @brief Run from SRAM: the running image is overwritten */
+#define OTA_RAM_FUNC(func_name) __not_in_flash_func(func_name)
+#else
+#define OTA_RAM_FUNC(func_name) func_name
+#endif
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Read a 32-bit little-endian value
+ */
+static uint32_t ota_read_32(const uint8_t * buffer) {
+    return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+/**
+ * @brief Store a 32-bit value, little-endian
+ */
+static void ota_store_32(uint8_t * buffer, uint32_t value) {
+    buffer[0] = (uint8_t)value;
+    buffer[1] = (uint8_t)(value >> 8);
+    buffer[2] = (uint8_t)(value >> 16);
+    buffer[3] = (uint8_t)(value >> 24);
+}
+
+/**
+ * @brief Status changed: let the application notify it
+ */
+static void ota_changed(ota_t * ota) {
+    ota->revision++;
+    if (ota->event) { ota->event(ota->event_context); }
+}
+
+/**
+ * @brief Enter the error state
+ */
+static void ota_fail(ota_t * ota, ota_error_t error) {
+    ota->state = OTA_STATE_ERROR;
+    ota->error = error;
+    ota_changed(ota);
+}
+
+/**
+ * @brief Refuse a command or data without failing the transfer: the error is
+ *        reported once in the status
+ */
+static void ota_refuse(ota_t * ota, ota_error_t error) {
+    if (ota->error == error) { return; }
+    ota->error = error;
+    ota_changed(ota);
+}
+
+/**
+ * @brief Check that the flash may be written now
+ */
+static bool ota_allowed(const ota_t * ota) {
+    const ota_flash_t * flash = ota->flash;
+    return (flash->allowed == NULL) || flash->allowed(flash->context);
+}
+
+/**
+ * @brief Drop the transfer and the buffered data
+ */
+static void ota_reset(ota_t * ota) {
+    ota->state = OTA_STATE_IDLE;
+    ota->error = OTA_ERROR_NONE;
+    ota->size = 0;
+    ota->crc = 0;
+    ota->received = 0;
+    ota->programmed = 0;
+    ota->fill = 0;
+    ota->gap = false;
+    for (int i = 0; i < OTA_NB_BUFFERS; i++) { ota->buffers[i].ready = false; }
+}
+
+/**
+ * @brief Write a buffer to the staged bank, erasing its sector first
+ *
+ * @return false if the erase or the program failed
+ */
+static bool ota_program_buffer(ota_t * ota, ota_buffer_t * buffer) {
+    const ota_flash_t * flash = ota->flash;
+    uint32_t offset = OTA_BANK_B_OFFSET + buffer->offset;
+
+    if (!flash->erase(offset, OTA_SECTOR_SIZE, flash->context)) { return false; }
+
+    // The last sector is padded with the erased value, and programmed by pages
+    uint32_t size = ota->size - buffer->offset;
+    if (size > OTA_SECTOR_SIZE) { size = OTA_SECTOR_SIZE; }
+    uint32_t padded = (size + OTA_PAGE_SIZE - 1) / OTA_PAGE_SIZE * OTA_PAGE_SIZE;
+    memset(&buffer->data[size], 0xFF, padded - size);
+    if (!flash->program(offset, buffer->data, padded, flash->context)) { return false; }
+
+    ota->programmed += size;
+    buffer->ready = false;
+    return true;
+}
+
+/**
+ * @brief Current buffer full, or last byte received: hand it to ota_flush()
+ */
+static void ota_buffer_done(ota_t * ota) {
+    ota->buffers[ota->fill].ready = true;
+    ota->fill = (ota->fill + 1) % OTA_NB_BUFFERS;
+    ota_changed(ota);
+}
+
+/**
+ * @brief Check the staged image and write the update record
+ */
+static void ota_stage(ota_t * ota) {
+    const ota_flash_t * flash = ota->flash;
+
+    if (crc32_update(0, &flash->base[OTA_BANK_B_OFFSET], ota->size) != ota->crc) {
+        ota_fail(ota, OTA_ERROR_CRC);
+        return;
+    }
+
+    uint8_t page[OTA_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    ota_store_32(&page[0], OTA_META_MAGIC);
+    ota_store_32(&page[4], ota->size);
+    ota_store_32(&page[8], ota->crc);
+    ota_store_32(&page[12], crc32_update(0, page, 12));
+    if (!flash->erase(OTA_META_OFFSET, OTA_SECTOR_SIZE, flash->context) ||
+        !flash->program(OTA_META_OFFSET, page, sizeof(page), flash->context)) {
+        ota_fail(ota, OTA_ERROR_FLASH);
+        return;
+    }
+
+    ota->state = OTA_STATE_READY;
+    ota_changed(ota);
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file ota.h
+ * @name ota_init
+ */
+void ota_init(ota_t * ota, const ota_flash_t * flash, ota_event_callback_t event, void * event_context) {
+    memset(ota, 0, sizeof(ota_t));
+    ota->flash = flash;
+    ota->event = event;
+    ota->event_context = event_context;
+}
+
+/**
+ * @file ota.h
+ * @name ota_control
+ */
+bool ota_control(ota_t * ota, const uint8_t * command, uint16_t len, uint64_t now_us) {
+    if (len == 0) { ota_fail(ota, OTA_ERROR_COMMAND); return false; }
+
+    switch (command[0]) {
+        case OTA_CMD_START: {
+            if (len != 9) { ota_fail(ota, OTA_ERROR_COMMAND); return false; }
+            uint32_t size = ota_read_32(&command[1]);
+            uint32_t crc = ota_read_32(&command[5]);
+
+            // Sofa moving: no flash erase may block the relay cutoff
+            if (!ota_allowed(ota)) {
+                ota_refuse(ota, OTA_ERROR_BUSY);
+                return false;
+            }
+
+            // Same image: resume from the next offset expected
+            if ((ota->state == OTA_STATE_RECEIVING) && (size == ota->size) && (crc == ota->crc)) {
+                ota->error = OTA_ERROR_NONE;
+                ota->gap = false;
+                ota_changed(ota);
+                return true;
+            }
+            if ((ota->state == OTA_STATE_VERIFYING) || (ota->state == OTA_STATE_READY)) {
+                ota_fail(ota, OTA_ERROR_STATE);
+                return false;
+            }
+
+            ota_reset(ota);
+            if ((size == 0) || (size > OTA_BANK_SIZE)) { ota_fail(ota, OTA_ERROR_SIZE); return false; }
+            ota->state = OTA_STATE_RECEIVING;
+            ota->size = size;
+            ota->crc = crc;
+            ota->start_us = now_us;
+            ota->last_us = now_us;
+            ota->nb_gaps = 0;
+            ota->nb_overruns = 0;
+            ota_changed(ota);
+            return true;
+        }
+        case OTA_CMD_COMMIT:
+            if ((ota->state != OTA_STATE_RECEIVING) || (ota->received != ota->size)) {
+                ota_fail(ota, OTA_ERROR_STATE);
+                return false;
+            }
+            ota->state = OTA_STATE_VERIFYING;
+            ota_changed(ota);
+            return true;
+        case OTA_CMD_ABORT:
+            // A staged image stays staged: it is only replaced by a new transfer
+            if (ota->state != OTA_STATE_READY) { ota_reset(ota); }
+            ota_changed(ota);
+            return true;
+        default:
+            ota_fail(ota, OTA_ERROR_COMMAND);
+            return false;
+    }
+}
+
+/**
+ * @file ota.h
+ * @name ota_data
+ */
+bool ota_data(ota_t * ota, const uint8_t * packet, uint16_t len, uint64_t now_us) {
+    if (ota->state != OTA_STATE_RECEIVING) { return false; }
+    if (len <= OTA_DATA_HEADER_SIZE) { return false; }
+
+    // Refused while the sofa moves, until the client resumes with START
+    if ((ota->error == OTA_ERROR_BUSY) || !ota_allowed(ota)) {
+        ota_refuse(ota, OTA_ERROR_BUSY);
+        return false;
+    }
+
+    uint32_t offset = ota_read_32(packet);
+    const uint8_t * payload = &packet[OTA_DATA_HEADER_SIZE];
+    uint32_t size = len - OTA_DATA_HEADER_SIZE;
+
+    if ((offset > ota->size) || (size > ota->size - offset)) {
+        ota_fail(ota, OTA_ERROR_SIZE);
+        return false;
+    }
+
+    // Out of sequence (lost or resent packets), or no buffer free: report the
+    // expected offset once, the client goes back to it
+    uint32_t free_size = 0;
+    for (int i = 0; i < OTA_NB_BUFFERS; i++) {
+        if (!ota->buffers[(ota->fill + i) % OTA_NB_BUFFERS].ready) { free_size += OTA_SECTOR_SIZE; } else { break; }
+    }
+    free_size -= ota->received % OTA_SECTOR_SIZE;
+    if ((offset != ota->received) || (size > free_size)) {
+        if (offset != ota->received) { ota->nb_gaps++; } else { ota->nb_overruns++; }
+        if (!ota->gap) {
+            ota->gap = true;
+            ota_changed(ota);
+        }
+        return false;
+    }
+    ota->gap = false;
+
+    while (size > 0) {
+        ota_buffer_t * buffer = &ota->buffers[ota->fill];
+        uint32_t pos = ota->received % OTA_SECTOR_SIZE;
+        uint32_t chunk = OTA_SECTOR_SIZE - pos;
+        if (chunk > size) { chunk = size; }
+        if (pos == 0) { buffer->offset = ota->received; }
+
+        memcpy(&buffer->data[pos], payload, chunk);
+        ota->received += chunk;
+        payload += chunk;
+        size -= chunk;
+
+        if (((ota->received % OTA_SECTOR_SIZE) == 0) || (ota->received == ota->size)) { ota_buffer_done(ota); }
+    }
+    ota->last_us = now_us;
+
+    return true;
+}
+
+/**
+ * @file ota.h
+ * @name ota_flush
+ */
+void ota_flush(ota_t * ota) {
+    // Nothing left for a failed transfer; deferred while the sofa moves
+    if (!ota_pending(ota) || !ota_allowed(ota)) { return; }
+
+    // Oldest buffer first: the one to be filled next, if it is still full
+    for (int i = 0; i < OTA_NB_BUFFERS; i++) {
+        ota_buffer_t * buffer = &ota->buffers[(ota->fill + i) % OTA_NB_BUFFERS];
+        if (buffer->ready && !ota_program_buffer(ota, buffer)) {
+            ota_fail(ota, OTA_ERROR_FLASH);
+            return;
+        }
+    }
+
+    if ((ota->state == OTA_STATE_VERIFYING) && (ota->programmed == ota->size)) { ota_stage(ota); }
+}
+
+/**
+ * @file ota.h
+ * @name ota_pending
+ */
+bool ota_pending(const ota_t * ota) {
+    if ((ota->state != OTA_STATE_RECEIVING) && (ota->state != OTA_STATE_VERIFYING)) { return false; }
+    for (int i = 0; i < OTA_NB_BUFFERS; i++) {
+        if (ota->buffers[i].ready) { return true; }
+    }
+    return ota->state == OTA_STATE_VERIFYING;
+}
+
+/**
+ * @file ota.h
+ * @name ota_status
+ */
+void ota_status(const ota_t * ota, uint8_t * status) {
+    uint32_t nb_errors = ota->nb_gaps + ota->nb_overruns;
+
+    status[0] = (uint8_t)ota->state;
+    status[1] = (uint8_t)ota->error;
+    ota_store_32(&status[2], ota->received);
+    ota_store_32(&status[6], ota->size);
+    ota_store_32(&status[10], ota->programmed);
+    ota_store_32(&status[14], ota_throughput(ota));
+    status[18] = (uint8_t)((nb_errors > 0xFFFF) ? 0xFF : nb_errors);
+    status[19] = (uint8_t)((nb_errors > 0xFFFF) ? 0xFF : (nb_errors >> 8));
+}
+
+/**
+ * @file ota.h
+ * @name ota_throughput
+ */
+uint32_t ota_throughput(const ota_t * ota) {
+    uint64_t elapsed_us = ota->last_us - ota->start_us;
+    if (elapsed_us == 0) { return 0; }
+    return (uint32_t)((uint64_t)ota->received * 1000000 / elapsed_us);
+}
+
+/**
+ * @file ota.h
+ * @name ota_boot_pending
+ */
+bool ota_boot_pending(const ota_flash_t * flash, ota_meta_t * meta) {
+    const uint8_t * record = &flash->base[OTA_META_OFFSET];
+
+    meta->magic = ota_read_32(&record[0]);
+    meta->size = ota_read_32(&record[4]);
+    meta->crc = ota_read_32(&record[8]);
+    meta->check = ota_read_32(&record[12]);
+
+    if ((meta->magic != OTA_META_MAGIC) || (meta->check != crc32_update(0, record, 12))) { return false; }
+    if ((meta->size == 0) || (meta->size > OTA_BANK_SIZE)) { return false; }
+
+    return crc32_update(0, &flash->base[OTA_BANK_B_OFFSET], meta->size) == meta->crc;
+}
+
+/**
+ * @file ota.h
+ * @name ota_swap
+ */
+void OTA_RAM_FUNC(ota_swap)(const ota_flash_t * flash, const ota_meta_t * meta) {
+    static uint8_t sector[OTA_SECTOR_SIZE];
+
+    // The operations and the record may sit in the sectors being rewritten:
+    // read them once, field by field (a structure copy may call memcpy)
+    const uint8_t * base = flash->base;
+    ota_erase_t erase = flash->erase;
+    ota_program_t program = flash->program;
+    void * context = flash->context;
+    uint32_t size = meta->size;
+
+    for (uint32_t offset = 0; offset < size; offset += OTA_SECTOR_SIZE) {
+        // Plain loop: memcpy may run from flash
+        const uint8_t * src = &base[OTA_BANK_B_OFFSET + offset];
+        for (uint32_t i = 0; i < OTA_SECTOR_SIZE; i++) { sector[i] = src[i]; }
+
+        erase(OTA_BANK_A_OFFSET + offset, OTA_SECTOR_SIZE, context);
+        program(OTA_BANK_A_OFFSET + offset, sector, OTA_SECTOR_SIZE, context);
+    }
+
+    erase(OTA_META_OFFSET, OTA_SECTOR_SIZE, context);
+}
@@ -0,0 +1,244 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: ota.h
+-- Description: Firmware update: streamed image written to the inactive flash
+--              bank by sectors, CRC verification and copy at boot
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef OTA_H
+#define OTA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Flash erase and program unit, and size of the receive buffers:
+ *         erased sector by sector while receiving, to bound the time the
+ *         interrupts are disabled */
+#define OTA_SECTOR_SIZE     4096
+/** @brief Flash page size, smallest program size */
+#define OTA_PAGE_SIZE       256
+
+/** @brief Flash layout: running image, staged image, update record */
+#define OTA_BANK_SIZE       (960 * 1024)
+#define OTA_BANK_A_OFFSET   0
+#define OTA_BANK_B_OFFSET   OTA_BANK_SIZE
+#define OTA_META_OFFSET     (2 * OTA_BANK_SIZE)
+
+/** @brief Number of receive buffers: one is filled while the other is programmed */
+#define OTA_NB_BUFFERS      2
+
+/** @brief Data packet header: image offset of the payload */
+#define OTA_DATA_HEADER_SIZE    4
+/** @brief Status record size, fits a notification at the default MTU */
+#define OTA_STATUS_SIZE         20
+
+/** @brief Update record magic ("OTA1") */
+#define OTA_META_MAGIC      0x3141544F
+
+// Control commands
+#define OTA_CMD_START       0x01    /**> Size (4 bytes), CRC-32 (4 bytes): start or resume */
+#define OTA_CMD_COMMIT      0x02    /**> Whole image received: verify and stage it */
+#define OTA_CMD_ABORT       0x03    /**> Drop the transfer */
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef enum {
+    OTA_STATE_IDLE = 0,     /**> No transfer */
+    OTA_STATE_RECEIVING,    /**> Receiving the image */
+    OTA_STATE_VERIFYING,    /**> Programming the last sectors, then checking the CRC */
+    OTA_STATE_READY,        /**> Image staged, copied at the next boot */
+    OTA_STATE_ERROR         /**> Transfer failed, see ota_error_t */
+} ota_state_t;
+
+typedef enum {
+    OTA_ERROR_NONE = 0,     /**> No error */
+    OTA_ERROR_COMMAND,      /**> Unknown or malformed command */
+    OTA_ERROR_STATE,        /**> Command or data not expected in this state */
+    OTA_ERROR_SIZE,         /**> Image larger than a bank, or data past its end */
+    OTA_ERROR_CRC,          /**> Staged image does not match the CRC */
+    OTA_ERROR_FLASH,        /**> Flash erase or program failed */
+    OTA_ERROR_BUSY          /**> Sofa moving: START again once stopped, the transfer resumes */
+} ota_error_t;
+
+/** @brief Erase a flash range, aligned on sectors; false on failure */
+typedef bool (*ota_erase_t)(uint32_t offset, uint32_t size, void * context);
+/** @brief Program a flash range, aligned on pages; false on failure */
+typedef bool (*ota_program_t)(uint32_t offset, const uint8_t * data, uint32_t size, void * context);
+/** @brief Check that the flash may be written now: the relays cannot be cut
+ *         while the interrupts are disabled */
+typedef bool (*ota_allowed_t)(void * context);
+/** @brief Notify that a buffer is ready to program or the status changed */
+typedef void (*ota_event_callback_t)(void * context);
+
+typedef struct {
+    const uint8_t * base;   /**> Memory-mapped flash contents (XIP) */
+    ota_erase_t erase;      /**> Erase operation */
+    ota_program_t program;  /**> Program operation */
+    void * context;         /**> Operations context */
+    ota_allowed_t allowed;  /**> Writes allowed now, NULL if always */
+} ota_flash_t;
+
+typedef struct {
+    uint32_t magic;         /**> OTA_META_MAGIC */
+    uint32_t size;          /**> Staged image size */
+    uint32_t crc;           /**> Staged image CRC-32 */
+    uint32_t check;         /**> CRC-32 of the fields above */
+} ota_meta_t;
+
+typedef struct {
+    uint8_t data[OTA_SECTOR_SIZE];  /**> Sector contents */
+    uint32_t offset;                /**> Image offset of the sector */
+    bool ready;                     /**> Full, waiting to be programmed */
+} ota_buffer_t;
+
+typedef struct {
+    const ota_flash_t * flash;          /**> Flash operations */
+    ota_event_callback_t event;         /**> Buffer ready or status changed */
+    void * event_context;               /**> Event callback context */
+    ota_state_t state;                  /**> Transfer state */
+    ota_error_t error;                  /**> Last error */
+    uint32_t size;                      /**> Image size */
+    uint32_t crc;                       /**> Expected image CRC-32 */
+    uint32_t received;                  /**> Next image offset expected */
+    uint32_t programmed;                /**> Bytes written to the flash */
+    ota_buffer_t buffers[OTA_NB_BUFFERS];   /**> Receive buffers */
+    uint8_t fill;                       /**> Buffer being filled */
+    bool gap;                           /**> Out of sequence data reported */
+    uint64_t start_us;                  /**> First data of the transfer */
+    uint64_t last_us;                   /**> Last data of the transfer */
+    uint32_t revision;                  /**> Incremented on each status change */
+    uint32_t nb_gaps;                   /**> Packets out of sequence */
+    uint32_t nb_overruns;               /**> Packets dropped, both buffers full */
+} ota_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Initialize the update receiver, idle
+ *
+ * @param ota The update receiver
+ * @param flash Flash operations, kept by reference
+ * @param event Buffer ready or status changed callback
+ * @param event_context Event callback context
+ */
+void ota_init(ota_t * ota, const ota_flash_t * flash, ota_event_callback_t event, void * event_context);
+
+/**
+ * @brief Control command, written to the OTA control characteristic
+ *
+ * @param ota The update receiver
+ * @param command The command: OTA_CMD_* and its arguments
+ * @param len The command size
+ * @param now_us Current time in microseconds
+ * @return true if the command was accepted
+ * @note A START with the size and CRC of the transfer in progress resumes
+ *       it: the status then gives the offset to send next. A START while
+ *       the flash writes are not allowed is refused with OTA_ERROR_BUSY,
+ *       the transfer in progress is kept.
+ */
+bool ota_control(ota_t * ota, const uint8_t * command, uint16_t len, uint64_t now_us);
+
+/**
+ * @brief Data packet, written without response to the OTA data characteristic:
+ *        image offset (4 bytes, little-endian), then the payload
+ *
+ * @param ota The update receiver
+ * @param packet The packet
+ * @param len The packet size
+ * @param now_us Current time in microseconds
+ * @return true if the payload was stored; a packet out of sequence or
+ *         arriving while both buffers are full is dropped, and reported once
+ *         through the status until the expected offset is received. A packet
+ *         arriving while the flash writes are not allowed is dropped with
+ *         OTA_ERROR_BUSY, until the client resumes with START
+ */
+bool ota_data(ota_t * ota, const uint8_t * packet, uint16_t len, uint64_t now_us);
+
+/**
+ * @brief Program the ready buffers, then verify and stage the image once
+ *        committed; called from the run loop after an event. Nothing is
+ *        written while the flash writes are not allowed
+ *
+ * @param ota The update receiver
+ */
+void ota_flush(ota_t * ota);
+
+/**
+ * @brief Check whether ota_flush() has flash work left, deferred while the
+ *        writes were not allowed
+ *
+ * @param ota The update receiver
+ * @return true if a buffer is ready or the committed image is not staged yet
+ */
+bool ota_pending(const ota_t * ota);
+
+/**
+ * @brief Serialize the status, little-endian:
+ *        - [0]      State
+ *        - [1]      Last error
+ *        - [2..5]   Next image offset expected
+ *        - [6..9]   Image size
+ *        - [10..13] Bytes written to the flash
+ *        - [14..17] Sustained throughput (bytes/s) since the first data
+ *        - [18..19] Packets out of sequence or dropped (saturated)
+ *
+ * @param ota The update receiver
+ * @param status Output record of OTA_STATUS_SIZE bytes
+ */
+void ota_status(const ota_t * ota, uint8_t * status);
+
+/**
+ * @brief Sustained throughput since the first data packet
+ *
+ * @param ota The update receiver
+ * @return uint32_t Bytes per second
+ */
+uint32_t ota_throughput(const ota_t * ota);
+
+/**
+ * @brief Check at boot whether a verified image is staged
+ *
+ * @param flash Flash operations
+ * @param meta Output update record
+ * @return true if the update record is valid and the staged image matches its CRC
+ */
+bool ota_boot_pending(const ota_flash_t * flash, ota_meta_t * meta);
+
+/**
+ * @brief Copy the staged image over the running one, sector by sector,
+ *        then erase the update record
+ *
+ * @param flash Flash operations, running from RAM
+ * @param meta The update record
+ * @note On the target, this function and the flash operations run from RAM
+ *       with the interrupts disabled, then the caller resets. The staged bank
+ *       and the update record are kept until the copy completes, so a copy
+ *       interrupted after the first sectors is redone if the partly updated
+ *       image still boots; otherwise the board needs a BOOTSEL recovery.
+ */
+void ota_swap(const ota_flash_t * flash, const ota_meta_t * meta);
+
+#endif // OTA_H
@@ -0,0 +1,299 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: params.c
+-- Description: Runtime parameters: typed, range-checked values applied as a
+--              whole, on trial until committed, persisted as a sealed record
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "params.h"
+#include "crc32.h"
+#include "deadman.h"
+#include "power.h"
+#include "adv_state.h"
+#include "changeover.h"
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+/** @brief Parameter table, by identifier; the defaults are the compiled-in values */
+static const params_info_t params_table[PARAM_NB] = {
+    [PARAM_ADV_INTERVAL]        = { "adv_interval",      2, 0x0020, 0x4000,  0x0030 },
+    [PARAM_CONN_INTERVAL_MIN]   = { "conn_interval_min", 2, 6,      3200,    12 },
+    [PARAM_CONN_INTERVAL_MAX]   = { "conn_interval_max", 2, 6,      3200,    12 },
+    [PARAM_CONN_LATENCY]        = { "conn_latency",      2, 0,      499,     0 },
+    [PARAM_SUPERVISION_TIMEOUT] = { "supervision",       2, 10,     3200,    0x0048 },
+    [PARAM_KEEPALIVE_PERIOD_MS] = { "keepalive_ms",      2, 20,     1000,    DEADMAN_KEEPALIVE_PERIOD_MS },
+    [PARAM_MISSED_INTERVALS]    = { "missed_intervals",  1, 1,      16,      DEADMAN_MISSED_INTERVALS },
+    [PARAM_CONNECTED_IDLE_MS]   = { "idle_ms",           4, 1000,   3600000, POWER_CONNECTED_IDLE_MS },
+    [PARAM_ADV_MIN_INTERVAL_MS] = { "adv_min_ms",        2, 0,      10000,   ADV_STATE_MIN_INTERVAL_MS },
+    [PARAM_CHANGEOVER_MS]       = { "changeover_ms",     2, 10,     1000,    CHANGEOVER_DEAD_TIME_MS },
+};
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Applied or stored set changed: let the application apply or store it
+ */
+static void params_changed(params_t * params, bool applied, bool stored) {
+    if (applied) { params->revision++; }
+    if (stored) { params->store_revision++; }
+    if (params->event) { params->event(params->event_context); }
+}
+
+/**
+ * @brief Record the result of a command
+ */
+static bool params_result(params_t * params, params_error_t error, uint8_t error_param) {
+    params->error = error;
+    params->error_param = error_param;
+    if (error != PARAMS_ERROR_NONE) { params->nb_rejected++; }
+    return error == PARAMS_ERROR_NONE;
+}
+
+/**
+ * @brief Seal the stored record
+ */
+static void params_seal(params_record_t * record) {
+    record->crc = crc32_update(0, (const uint8_t *)record, offsetof(params_record_t, crc));
+}
+
+/**
+ * @brief Apply a checked set, on trial until committed
+ */
+static void params_apply(params_t * params, const uint32_t * values, uint64_t now_us) {
+    memcpy(params->values, values, sizeof(params->values));
+    params->trial = true;
+    params->trial_deadline_us = now_us + (uint64_t)PARAMS_TRIAL_TIMEOUT_MS * 1000;
+    params->nb_applied++;
+    params_changed(params, true, false);
+}
+
+/**
+ * @brief Stage the APPLY entries over the applied values, then check the whole set
+ */
+static params_error_t params_stage(const params_t * params, const uint8_t * entries, uint16_t len, uint32_t * values, uint8_t * error_param) {
+    memcpy(values, params->values, sizeof(params->values));
+    *error_param = PARAMS_NO_PARAM;
+    if (len == 0) { return PARAMS_ERROR_COMMAND; }
+
+    uint16_t pos = 0;
+    while (pos < len) {
+        uint8_t id = entries[pos++];
+        const params_info_t * info = params_info(id);
+        if (info == NULL) {
+            *error_param = id;
+            return PARAMS_ERROR_PARAM;
+        }
+        if (pos + info->size > len) {
+            *error_param = id;
+            return PARAMS_ERROR_COMMAND;
+        }
+
+        uint32_t value = 0;
+        for (uint8_t i = 0; i < info->size; i++) { value |= (uint32_t)entries[pos + i] << (8 * i); }
+        pos += info->size;
+        values[id] = value;
+    }
+
+    return params_check(values, error_param);
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file params.h
+ * @name params_init
+ */
+void params_init(params_t * params, params_event_callback_t event, void * event_context) {
+    memset(params, 0, sizeof(params_t));
+    params->event = event;
+    params->event_context = event_context;
+    params->error_param = PARAMS_NO_PARAM;
+
+    for (int id = 0; id < PARAM_NB; id++) { params->values[id] = params_table[id].value; }
+    params->stored.version = PARAMS_RECORD_VERSION;
+    params->stored.nb_params = PARAM_NB;
+    memcpy(params->stored.values, params->values, sizeof(params->values));
+    params_seal(&params->stored);
+}
+
+/**
+ * @file params.h
+ * @name params_info
+ */
+const params_info_t * params_info(uint8_t id) {
+    return (id < PARAM_NB) ? &params_table[id] : NULL;
+}
+
+/**
+ * @file params.h
+ * @name params_get
+ */
+uint32_t params_get(const params_t * params, param_id_t id) {
+    return params->values[id];
+}
+
+/**
+ * @file params.h
+ * @name params_check
+ */
+params_error_t params_check(const uint32_t * values, uint8_t * error_param) {
+    *error_param = PARAMS_NO_PARAM;
+
+    for (int id = 0; id < PARAM_NB; id++) {
+        if ((values[id] < params_table[id].min) || (values[id] > params_table[id].max)) {
+            *error_param = (uint8_t)id;
+            return PARAMS_ERROR_RANGE;
+        }
+    }
+
+    if (values[PARAM_CONN_INTERVAL_MIN] > values[PARAM_CONN_INTERVAL_MAX]) {
+        *error_param = PARAM_CONN_INTERVAL_MIN;
+        return PARAMS_ERROR_CONSISTENCY;
+    }
+
+    // Supervision timeout (10 ms) above twice the effective interval (1.25 ms):
+    // the link is not dropped while the peripheral skips events
+    if (values[PARAM_SUPERVISION_TIMEOUT] * 4 <= (1 + values[PARAM_CONN_LATENCY]) * values[PARAM_CONN_INTERVAL_MAX]) {
+        *error_param = PARAM_SUPERVISION_TIMEOUT;
+        return PARAMS_ERROR_CONSISTENCY;
+    }
+
+    // Same computation as deadman_set_conn_interval(), at the slowest interval
+    uint32_t deadman_us = values[PARAM_KEEPALIVE_PERIOD_MS] * 1000 + values[PARAM_MISSED_INTERVALS] * values[PARAM_CONN_INTERVAL_MAX] * 1250;
+    if (deadman_us > (uint32_t)PARAMS_MAX_DEADMAN_MS * 1000) {
+        *error_param = PARAM_KEEPALIVE_PERIOD_MS;
+        return PARAMS_ERROR_CONSISTENCY;
+    }
+
+    return PARAMS_ERROR_NONE;
+}
+
+/**
+ * @file params.h
+ * @name params_load
+ */
+bool params_load(params_t * params, const params_record_t * record) {
+    uint8_t error_param;
+
+    if (record->crc != crc32_update(0, (const uint8_t *)record, offsetof(params_record_t, crc))) { return false; }
+    if ((record->version != PARAMS_RECORD_VERSION) || (record->nb_params != PARAM_NB)) { return false; }
+    if (params_check(record->values, &error_param) != PARAMS_ERROR_NONE) { return false; }
+
+    params->stored = *record;
+    memcpy(params->values, record->values, sizeof(params->values));
+    return true;
+}
+
+/**
+ * @file params.h
+ * @name params_control
+ */
+bool params_control(params_t * params, const uint8_t * command, uint16_t len, uint64_t now_us) {
+    uint32_t values[PARAM_NB];
+    uint8_t error_param = PARAMS_NO_PARAM;
+    params_error_t error;
+
+    if (len == 0) { return params_result(params, PARAMS_ERROR_COMMAND, PARAMS_NO_PARAM); }
+
+    switch (command[0]) {
+        case PARAMS_CMD_APPLY:
+            error = params_stage(params, &command[1], len - 1, values, &error_param);
+            if (error == PARAMS_ERROR_NONE) { params_apply(params, values, now_us); }
+            return params_result(params, error, error_param);
+
+        case PARAMS_CMD_DEFAULTS:
+            if (len != 1) { return params_result(params, PARAMS_ERROR_COMMAND, PARAMS_NO_PARAM); }
+            for (int id = 0; id < PARAM_NB; id++) { values[id] = params_table[id].value; }
+            params_apply(params, values, now_us);
+            return params_result(params, PARAMS_ERROR_NONE, PARAMS_NO_PARAM);
+
+        case PARAMS_CMD_COMMIT:
+            if (len != 1) { return params_result(params, PARAMS_ERROR_COMMAND, PARAMS_NO_PARAM); }
+            if (!params->trial) { return params_result(params, PARAMS_ERROR_STATE, PARAMS_NO_PARAM); }
+            memcpy(params->stored.values, params->values, sizeof(params->values));
+            params_seal(&params->stored);
+            params->trial = false;
+            params_changed(params, false, true);
+            return params_result(params, PARAMS_ERROR_NONE, PARAMS_NO_PARAM);
+
+        case PARAMS_CMD_ROLLBACK:
+            if (len != 1) { return params_result(params, PARAMS_ERROR_COMMAND, PARAMS_NO_PARAM); }
+            if (!params_rollback(params)) { return params_result(params, PARAMS_ERROR_STATE, PARAMS_NO_PARAM); }
+            return params_result(params, PARAMS_ERROR_NONE, PARAMS_NO_PARAM);
+
+        default:
+            return params_result(params, PARAMS_ERROR_COMMAND, PARAMS_NO_PARAM);
+    }
+}
+
+/**
+ * @file params.h
+ * @name params_rollback
+ */
+bool params_rollback(params_t * params) {
+    if (!params->trial) { return false; }
+
+    memcpy(params->values, params->stored.values, sizeof(params->values));
+    params->trial = false;
+    params->nb_rollbacks++;
+    params_changed(params, true, false);
+    return true;
+}
+
+/**
+ * @file params.h
+ * @name params_expire
+ */
+bool params_expire(params_t * params, uint64_t now_us) {
+    if (!params->trial || (now_us < params->trial_deadline_us)) { return false; }
+    return params_rollback(params);
+}
+
+/**
+ * @file params.h
+ * @name params_next_deadline_us
+ */
+uint64_t params_next_deadline_us(const params_t * params) {
+    return params->trial ? params->trial_deadline_us : 0;
+}
+
+/**
+ * @file params.h
+ * @name params_snapshot
+ */
+void params_snapshot(const params_t * params, uint8_t * snapshot) {
+    snapshot[0] = PARAMS_RECORD_VERSION;
+    snapshot[1] = (uint8_t)params->error;
+    snapshot[2] = params->error_param;
+    snapshot[3] = params->trial ? 0x01 : 0x00;
+    snapshot[4] = PARAM_NB;
+
+    uint16_t pos = PARAMS_SNAPSHOT_HEADER_SIZE;
+    for (int id = 0; id < PARAM_NB; id++) {
+        for (uint8_t i = 0; i < params_table[id].size; i++) { snapshot[pos++] = (uint8_t)(params->values[id] >> (8 * i)); }
+    }
+}
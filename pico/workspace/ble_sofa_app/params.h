@@ -0,0 +1,225 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: params.h
+-- Description: Runtime parameters: typed, range-checked values applied as a
+--              whole, on trial until committed, persisted as a sealed record
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Stored record version, a record of another version is ignored */
+#define PARAMS_RECORD_VERSION       2
+/** @brief Time an applied set waits for its commit before it is rolled back */
+#define PARAMS_TRIAL_TIMEOUT_MS     10000
+/** @brief Longest hold-to-run overrun accepted: keep-alive period plus the
+ *         missed intervals at the maximum connection interval */
+#define PARAMS_MAX_DEADMAN_MS       2000
+/** @brief Snapshot header size, followed by the values */
+#define PARAMS_SNAPSHOT_HEADER_SIZE 5
+/** @brief Snapshot size: header, then each value on its type size */
+#define PARAMS_SNAPSHOT_SIZE        (PARAMS_SNAPSHOT_HEADER_SIZE + 21)
+/** @brief No parameter involved in the last error */
+#define PARAMS_NO_PARAM             0xFF
+
+// Control commands
+#define PARAMS_CMD_APPLY        0x01    /**> (identifier, value) entries: validate and apply as a whole, on trial */
+#define PARAMS_CMD_COMMIT       0x02    /**> Keep the set on trial and store it */
+#define PARAMS_CMD_ROLLBACK     0x03    /**> Drop the set on trial, back to the stored set */
+#define PARAMS_CMD_DEFAULTS     0x04    /**> Apply the default values, on trial */
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef enum {
+    PARAM_ADV_INTERVAL = 0,         /**> Advertising interval (0.625 ms units) */
+    PARAM_CONN_INTERVAL_MIN,        /**> Requested minimum connection interval (1.25 ms units) */
+    PARAM_CONN_INTERVAL_MAX,        /**> Requested maximum connection interval (1.25 ms units) */
+    PARAM_CONN_LATENCY,             /**> Requested peripheral latency (connection events) */
+    PARAM_SUPERVISION_TIMEOUT,      /**> Requested supervision timeout (10 ms units) */
+    PARAM_KEEPALIVE_PERIOD_MS,      /**> Hold-to-run keep-alive period */
+    PARAM_MISSED_INTERVALS,         /**> Connection intervals a keep-alive may be late */
+    PARAM_CONNECTED_IDLE_MS,        /**> Time without activity before a link drops to low clock */
+    PARAM_ADV_MIN_INTERVAL_MS,      /**> Minimum time between two advertised state changes */
+    PARAM_CHANGEOVER_MS,            /**> Dead-time between the release of a line and the drive of the other one */
+    PARAM_NB
+} param_id_t;
+
+typedef enum {
+    PARAMS_ERROR_NONE = 0,      /**> No error */
+    PARAMS_ERROR_COMMAND,       /**> Unknown or malformed command */
+    PARAMS_ERROR_PARAM,         /**> Unknown parameter identifier */
+    PARAMS_ERROR_RANGE,         /**> Value out of the parameter range */
+    PARAMS_ERROR_CONSISTENCY,   /**> Values valid one by one, not together */
+    PARAMS_ERROR_STATE          /**> No set on trial */
+} params_error_t;
+
+/** @brief Parameter description */
+typedef struct {
+    const char * name;      /**> Short name, for the tools */
+    uint8_t size;           /**> Value type: 1, 2 or 4 bytes */
+    uint32_t min;           /**> Smallest value */
+    uint32_t max;           /**> Largest value */
+    uint32_t value;         /**> Default value */
+} params_info_t;
+
+/** @brief Stored set, as is in the BTstack TLV */
+typedef struct {
+    uint8_t version;            /**> PARAMS_RECORD_VERSION */
+    uint8_t nb_params;          /**> PARAM_NB */
+    uint16_t reserved;          /**> Zero */
+    uint32_t values[PARAM_NB];  /**> Values, by identifier */
+    uint32_t crc;               /**> CRC-32 of the fields above */
+} params_record_t;
+
+/** @brief Notify that the applied or the stored set changed */
+typedef void (*params_event_callback_t)(void * context);
+
+typedef struct {
+    params_event_callback_t event;  /**> Applied or stored set changed */
+    void * event_context;           /**> Event callback context */
+    uint32_t values[PARAM_NB];      /**> Applied values */
+    params_record_t stored;         /**> Stored values, restored on rollback */
+    bool trial;                     /**> Applied values not committed yet */
+    uint64_t trial_deadline_us;     /**> Rollback time of the set on trial */
+    params_error_t error;           /**> Last command error */
+    uint8_t error_param;            /**> Parameter of the last error, PARAMS_NO_PARAM if none */
+    uint32_t revision;              /**> Incremented when the applied values change */
+    uint32_t store_revision;        /**> Incremented when the stored values change */
+    uint32_t nb_applied;            /**> Sets applied */
+    uint32_t nb_rejected;           /**> Commands rejected */
+    uint32_t nb_rollbacks;          /**> Sets rolled back, by command, timeout or disconnection */
+} params_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Initialize the parameters with the default values, stored, no trial
+ *
+ * @param params The parameters
+ * @param event Applied or stored set changed callback
+ * @param event_context Event callback context
+ */
+void params_init(params_t * params, params_event_callback_t event, void * event_context);
+
+/**
+ * @brief Describe a parameter
+ *
+ * @param id The parameter identifier
+ * @return const params_info_t* The description, NULL if unknown
+ */
+const params_info_t * params_info(uint8_t id);
+
+/**
+ * @brief Get an applied value
+ *
+ * @param params The parameters
+ * @param id The parameter identifier
+ * @return uint32_t The value
+ */
+uint32_t params_get(const params_t * params, param_id_t id);
+
+/**
+ * @brief Check a whole set: each value in its range, and together:
+ *        - minimum connection interval <= maximum connection interval
+ *        - supervision timeout > (1 + latency) * maximum interval * 2
+ *        - keep-alive period + missed intervals at the maximum connection
+ *          interval <= PARAMS_MAX_DEADMAN_MS
+ *
+ * @param values The values, by identifier
+ * @param error_param Output parameter of the error, PARAMS_NO_PARAM if none
+ * @return params_error_t PARAMS_ERROR_NONE if the set can be applied
+ */
+params_error_t params_check(const uint32_t * values, uint8_t * error_param);
+
+/**
+ * @brief Adopt a record read from the flash at boot, without event
+ *
+ * @param params The parameters
+ * @param record The record
+ * @return true if the record is sealed, of this version and valid; the
+ *         default values are kept otherwise
+ */
+bool params_load(params_t * params, const params_record_t * record);
+
+/**
+ * @brief Control command, written to the parameters characteristic. An
+ *        applied set is on trial: it is rolled back after
+ *        PARAMS_TRIAL_TIMEOUT_MS or on disconnection unless committed.
+ *        APPLY entries are the identifier, then the value little-endian on
+ *        the parameter type size; the parameters not listed keep their
+ *        applied value, and nothing changes if one entry is rejected.
+ *
+ * @param params The parameters
+ * @param command The command: PARAMS_CMD_* and its arguments
+ * @param len The command size
+ * @param now_us Current time in microseconds
+ * @return true if the command was accepted
+ */
+bool params_control(params_t * params, const uint8_t * command, uint16_t len, uint64_t now_us);
+
+/**
+ * @brief Drop the set on trial, back to the stored set
+ *
+ * @param params The parameters
+ * @return true if a set was on trial
+ */
+bool params_rollback(params_t * params);
+
+/**
+ * @brief Roll the set on trial back if its commit is late
+ *
+ * @param params The parameters
+ * @param now_us Current time in microseconds
+ * @return true if the set was rolled back
+ */
+bool params_expire(params_t * params, uint64_t now_us);
+
+/**
+ * @brief Get the rollback time of the set on trial
+ *
+ * @param params The parameters
+ * @return uint64_t The deadline in microseconds, 0 if no set is on trial
+ */
+uint64_t params_next_deadline_us(const params_t * params);
+
+/**
+ * @brief Serialize the applied set, little-endian:
+ *        - [0] Record version
+ *        - [1] Last error
+ *        - [2] Parameter of the last error, PARAMS_NO_PARAM if none
+ *        - [3] Flags: bit [0] set on trial
+ *        - [4] Number of parameters
+ *        - [5..] Values, by identifier, each on its type size
+ *
+ * @param params The parameters
+ * @param snapshot Output record of PARAMS_SNAPSHOT_SIZE bytes
+ */
+void params_snapshot(const params_t * params, uint8_t * snapshot);
+
+#endif // PARAMS_H
@@ -0,0 +1,150 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: power.c
+-- Description: Power manager: system clock scaling state machine and
+--              residency/wake-up statistics
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "power.h"
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Compute the state required by the current inputs
+ */
+static power_state_t power_target_state(const power_manager_t * pm, uint64_t now_us) {
+    // Motion always requires the full clock
+    if (pm->motion) { return POWER_STATE_FULL; }
+
+    // A connected client keeps the full clock until it stops writing
+    if ((pm->nb_connections > 0) &&
+        (now_us - pm->last_activity_us < (uint64_t)pm->idle_timeout_ms * 1000)) {
+        return POWER_STATE_FULL;
+    }
+
+    return POWER_STATE_LOW;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file power.h
+ * @name power_init
+ */
+void power_init(power_manager_t * pm, uint64_t now_us) {
+    memset(pm, 0, sizeof(power_manager_t));
+    pm->state = POWER_STATE_LOW;
+    pm->idle_timeout_ms = POWER_CONNECTED_IDLE_MS;
+    pm->last_activity_us = now_us;
+    pm->state_since_us = now_us;
+}
+
+/**
+ * @file power.h
+ * @name power_set_idle_timeout
+ */
+void power_set_idle_timeout(power_manager_t * pm, uint32_t idle_timeout_ms) {
+    pm->idle_timeout_ms = idle_timeout_ms;
+}
+
+/**
+ * @file power.h
+ * @name power_notify
+ */
+power_state_t power_notify(power_manager_t * pm, power_event_t event, uint64_t now_us) {
+    switch (event) {
+        case POWER_EVENT_CONNECTED:
+            pm->nb_connections++;
+            pm->last_activity_us = now_us;
+            break;
+        case POWER_EVENT_DISCONNECTED:
+            if (pm->nb_connections > 0) { pm->nb_connections--; }
+            break;
+        case POWER_EVENT_ATT_WRITE:
+            pm->last_activity_us = now_us;
+            break;
+        case POWER_EVENT_MOTION_START:
+            pm->motion = true;
+            break;
+        case POWER_EVENT_MOTION_STOP:
+            pm->motion = false;
+            pm->last_activity_us = now_us;
+            break;
+        case POWER_EVENT_TIMEOUT:
+        default:
+            break;
+    }
+
+    power_state_t target = power_target_state(pm, now_us);
+    if (target != pm->state) {
+        pm->stats.residency_us[pm->state] += now_us - pm->state_since_us;
+        pm->state_since_us = now_us;
+        pm->state = target;
+        pm->stats.nb_transitions++;
+    }
+
+    return pm->state;
+}
+
+/**
+ * @file power.h
+ * @name power_next_deadline_us
+ */
+uint64_t power_next_deadline_us(const power_manager_t * pm) {
+    // Only a connected, non-moving, full-clock state can time out
+    if ((pm->state != POWER_STATE_FULL) || pm->motion || (pm->nb_connections == 0)) {
+        return 0;
+    }
+
+    return pm->last_activity_us + (uint64_t)pm->idle_timeout_ms * 1000;
+}
+
+/**
+ * @file power.h
+ * @name power_account_sleep
+ */
+void power_account_sleep(power_manager_t * pm, uint32_t sleep_us) {
+    pm->stats.sleep_us += sleep_us;
+    pm->stats.nb_wakeups++;
+}
+
+/**
+ * @file power.h
+ * @name power_account_wakeup
+ */
+void power_account_wakeup(power_manager_t * pm, uint32_t latency_us) {
+    pm->stats.wake_latency_us_total += latency_us;
+    if (latency_us > pm->stats.wake_latency_us_max) {
+        pm->stats.wake_latency_us_max = latency_us;
+    }
+}
+
+/**
+ * @file power.h
+ * @name power_get_stats
+ */
+void power_get_stats(const power_manager_t * pm, uint64_t now_us, power_stats_t * stats) {
+    *stats = pm->stats;
+    stats->residency_us[pm->state] += now_us - pm->state_since_us;
+}
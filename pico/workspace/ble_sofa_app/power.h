@@ -0,0 +1,141 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: power.h
+-- Description: Power manager: system clock scaling state machine and
+--              residency/wake-up statistics
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief System clock used while a client is active or the sofa is moving */
+#define POWER_FULL_CLK_KHZ      125000
+/** @brief System clock used while only advertising */
+#define POWER_LOW_CLK_KHZ        48000
+/** @brief Default time without ATT write before a connected link drops to low clock */
+#define POWER_CONNECTED_IDLE_MS  30000
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef enum {
+    POWER_STATE_LOW = 0,    /**> Reduced clk_sys, advertising or idle link only */
+    POWER_STATE_FULL,       /**> Full clk_sys, connection activity or motion */
+    POWER_NB_STATES
+} power_state_t;
+
+typedef enum {
+    POWER_EVENT_CONNECTED = 0,  /**> A central connected */
+    POWER_EVENT_DISCONNECTED,   /**> A central disconnected */
+    POWER_EVENT_ATT_WRITE,      /**> An ATT write has been received */
+    POWER_EVENT_MOTION_START,   /**> A relay has been turned on */
+    POWER_EVENT_MOTION_STOP,    /**> All relays have been turned off */
+    POWER_EVENT_TIMEOUT         /**> Periodic/deadline re-evaluation */
+} power_event_t;
+
+typedef struct {
+    uint64_t residency_us[POWER_NB_STATES]; /**> Time spent in each power state */
+    uint64_t sleep_us;                      /**> Time spent waiting for work (WFE) */
+    uint32_t nb_transitions;                /**> Number of state changes */
+    uint32_t nb_wakeups;                    /**> Number of returns from sleep */
+    uint32_t wake_latency_us_total;         /**> Cumulated clock restore latency */
+    uint32_t wake_latency_us_max;           /**> Worst clock restore latency */
+} power_stats_t;
+
+typedef struct {
+    power_state_t state;        /**> Current power state */
+    uint8_t nb_connections;     /**> Number of active connections */
+    bool motion;                /**> At least one relay is on */
+    uint32_t idle_timeout_ms;   /**> Time without ATT write before a connected link drops to low clock */
+    uint64_t last_activity_us;  /**> Timestamp of the last connection/ATT write */
+    uint64_t state_since_us;    /**> Timestamp of the last state change */
+    power_stats_t stats;        /**> Accumulated statistics */
+} power_manager_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Initialize the power manager in the low power state
+ *
+ * @param pm The power manager structure
+ * @param now_us Current time in microseconds
+ */
+void power_init(power_manager_t * pm, uint64_t now_us);
+
+/**
+ * @brief Change the connected idle timeout, applied at the next event
+ *
+ * @param pm The power manager structure
+ * @param idle_timeout_ms Time without ATT write before a connected link drops to low clock
+ */
+void power_set_idle_timeout(power_manager_t * pm, uint32_t idle_timeout_ms);
+
+/**
+ * @brief Feed an event to the state machine
+ *
+ * @param pm The power manager structure
+ * @param event The event to be processed
+ * @param now_us Current time in microseconds
+ * @return power_state_t The state to be applied (may be unchanged)
+ */
+power_state_t power_notify(power_manager_t * pm, power_event_t event, uint64_t now_us);
+
+/**
+ * @brief Get the time at which the state machine must be re-evaluated
+ *
+ * @param pm The power manager structure
+ * @return uint64_t Deadline in microseconds, 0 if no deadline is pending
+ */
+uint64_t power_next_deadline_us(const power_manager_t * pm);
+
+/**
+ * @brief Account time spent sleeping between two run loop iterations
+ *
+ * @param pm The power manager structure
+ * @param sleep_us Sleep duration in microseconds
+ */
+void power_account_sleep(power_manager_t * pm, uint32_t sleep_us);
+
+/**
+ * @brief Account the latency added by restoring the full system clock
+ *
+ * @param pm The power manager structure
+ * @param latency_us Clock switch duration in microseconds
+ */
+void power_account_wakeup(power_manager_t * pm, uint32_t latency_us);
+
+/**
+ * @brief Get a snapshot of the statistics, residency accounted up to now
+ *
+ * @param pm The power manager structure
+ * @param now_us Current time in microseconds
+ * @param stats Output statistics
+ */
+void power_get_stats(const power_manager_t * pm, uint64_t now_us, power_stats_t * stats);
+
+#endif // POWER_H
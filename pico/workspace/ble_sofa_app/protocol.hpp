@@ -0,0 +1,417 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: protocol.hpp
+-- Description: Versioned TLV control protocol: header-only, allocation-free
+--              codec shared by the firmware, the host tests and the tools
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Frame layout, all values little-endian:
+//   - [0]  Protocol version (PROTOCOL_VERSION)
+//   - [1]  Sequence number, chosen by the sender
+//   - [2..] Records: type (1 byte), value size (1 byte), value
+// Records of an unknown type are skipped, so that a newer peer can add
+// records without a version change. The version only changes when the
+// meaning of an existing record changes.
+//
+// A single byte written to the control characteristic is a legacy command
+// (version 0): the command byte of a Motion record.
+
+namespace protocol {
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Frame version encoded by this codec */
+constexpr uint8_t kVersion = 1;
+/** @brief Version reported for a legacy single byte command */
+constexpr uint8_t kLegacyVersion = 0;
+/** @brief Frame header size: version, sequence number */
+constexpr size_t kHeaderSize = 2;
+/** @brief Record header size: type, value size */
+constexpr size_t kRecordHeaderSize = 2;
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+/** @brief Record types: commands from 0x01, telemetry from 0x40 */
+enum class Type : uint8_t {
+    Motion  = 0x01, /**> Command byte: bits [1:0] relays, bit [7] hold-to-run */
+    State   = 0x40, /**> Applied command byte */
+    EndStop = 0x41, /**> End-stop status: bits [1:0] active, bits [5:4] last end */
+    Ack     = 0x42, /**> Sequence number of the last command frame received */
+    Power   = 0x43, /**> Power state: 0 = low clock, 1 = full clock */
+    Uptime  = 0x44  /**> Time since boot (ms) */
+};
+
+/** @brief Direction of a record */
+enum class Direction : uint8_t {
+    Command = 0,    /**> Client to sofa, control characteristic write */
+    Telemetry       /**> Sofa to client, telemetry read or notification */
+};
+
+/** @brief Codec status */
+enum class Status : uint8_t {
+    Ok = 0,         /**> Success */
+    Empty,          /**> No data */
+    BadVersion,     /**> Frame version newer than kVersion */
+    Truncated,      /**> Record header or value past the end of the frame */
+    BadSize,        /**> Value size out of the range of a known type */
+    NoSpace         /**> Output buffer too small */
+};
+
+/** @brief Description of a record type */
+struct TypeInfo {
+    Type type;              /**> Record type */
+    Direction direction;    /**> Command or telemetry */
+    uint8_t min_size;       /**> Smallest value size */
+    uint8_t max_size;       /**> Largest value size */
+    const char * name;      /**> Name for the tools */
+};
+
+/** @brief Known record types */
+constexpr TypeInfo kTypes[] = {
+    { Type::Motion,  Direction::Command,   1, 1, "motion"  },
+    { Type::State,   Direction::Telemetry, 1, 1, "state"   },
+    { Type::EndStop, Direction::Telemetry, 1, 1, "endstop" },
+    { Type::Ack,     Direction::Telemetry, 1, 1, "ack"     },
+    { Type::Power,   Direction::Telemetry, 1, 1, "power"   },
+    { Type::Uptime,  Direction::Telemetry, 4, 4, "uptime"  },
+};
+
+/** @brief Record view inside a frame */
+struct Record {
+    uint8_t type;           /**> Raw record type, possibly unknown */
+    uint8_t size;           /**> Value size */
+    const uint8_t * value;  /**> Value, inside the frame buffer */
+};
+
+/** @brief Decoded command frame */
+struct Command {
+    uint8_t version;        /**> Frame version, kLegacyVersion for a single byte */
+    uint8_t sequence;       /**> Sequence number (0 for a legacy command) */
+    bool has_motion;        /**> A Motion record is present */
+    uint8_t motion;         /**> Command byte of the last Motion record */
+    uint8_t nb_skipped;     /**> Unknown or telemetry records skipped */
+};
+
+/** @brief Telemetry frame content */
+struct Telemetry {
+    uint8_t sequence;       /**> Telemetry sequence number */
+    uint8_t state;          /**> Applied command byte */
+    uint8_t endstop;        /**> End-stop status */
+    uint8_t ack;            /**> Sequence number of the last command frame */
+    uint8_t power;          /**> Power state */
+    uint32_t uptime_ms;     /**> Time since boot (ms) */
+};
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Look up a record type
+ *
+ * @param type The raw record type
+ * @return const TypeInfo* The type description, nullptr if unknown
+ */
+constexpr const TypeInfo * find_type(uint8_t type) {
+    for (const TypeInfo & info : kTypes) {
+        if (static_cast<uint8_t>(info.type) == type) { return &info; }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Encoded size of a record
+ *
+ * @param type The record type
+ * @return size_t Header and largest value size, 0 if the type is unknown
+ */
+constexpr size_t record_size(Type type) {
+    const TypeInfo * info = find_type(static_cast<uint8_t>(type));
+    return (info != nullptr) ? kRecordHeaderSize + info->max_size : 0;
+}
+
+/** @brief Size of a full telemetry frame */
+constexpr size_t kTelemetrySize = kHeaderSize + record_size(Type::State) + record_size(Type::EndStop) +
+    record_size(Type::Ack) + record_size(Type::Power) + record_size(Type::Uptime);
+/** @brief Size of a command frame carrying one Motion record */
+constexpr size_t kCommandSize = kHeaderSize + record_size(Type::Motion);
+
+// Both fit in one ATT PDU at the default 23-byte MTU
+static_assert(kTelemetrySize <= 20, "telemetry frame larger than the default ATT payload");
+static_assert(kCommandSize <= 20, "command frame larger than the default ATT payload");
+
+/**
+ * @brief Record iterator over a received frame
+ */
+class Reader {
+public:
+    /**
+     * @brief Parse the frame header
+     *
+     * @param data The frame
+     * @param size The frame size
+     */
+    constexpr Reader(const uint8_t * data, size_t size)
+        : data_(data), size_(size), pos_(kHeaderSize), status_(Status::Ok) {
+        if (size < kHeaderSize) { status_ = (size == 0) ? Status::Empty : Status::Truncated; }
+        else if (data[0] > kVersion) { status_ = Status::BadVersion; }
+    }
+
+    /** @brief Frame version */
+    constexpr uint8_t version() const { return (size_ > 0) ? data_[0] : 0; }
+    /** @brief Frame sequence number */
+    constexpr uint8_t sequence() const { return (size_ > 1) ? data_[1] : 0; }
+    /** @brief First error, Status::Ok while the frame is valid */
+    constexpr Status status() const { return status_; }
+
+    /**
+     * @brief Get the next record, checking the value size of the known types
+     *
+     * @param record Output record
+     * @return bool false at the end of the frame or on error (see status())
+     */
+    constexpr bool next(Record & record) {
+        if ((status_ != Status::Ok) || (pos_ == size_)) { return false; }
+        if (size_ - pos_ < kRecordHeaderSize) { status_ = Status::Truncated; return false; }
+
+        record.type = data_[pos_];
+        record.size = data_[pos_ + 1];
+        if (size_ - pos_ - kRecordHeaderSize < record.size) { status_ = Status::Truncated; return false; }
+        record.value = &data_[pos_ + kRecordHeaderSize];
+
+        const TypeInfo * info = find_type(record.type);
+        if ((info != nullptr) && ((record.size < info->min_size) || (record.size > info->max_size))) {
+            status_ = Status::BadSize;
+            return false;
+        }
+
+        pos_ += kRecordHeaderSize + record.size;
+        return true;
+    }
+
+private:
+    const uint8_t * data_;
+    size_t size_;
+    size_t pos_;
+    Status status_;
+};
+
+/**
+ * @brief Frame builder into a caller buffer; the first error is sticky
+ */
+class Writer {
+public:
+    /**
+     * @brief Write the frame header
+     *
+     * @param data Output buffer
+     * @param capacity Output buffer size
+     * @param sequence Frame sequence number
+     */
+    constexpr Writer(uint8_t * data, size_t capacity, uint8_t sequence)
+        : data_(data), capacity_(capacity), size_(0), status_(Status::Ok) {
+        if (capacity < kHeaderSize) { status_ = Status::NoSpace; return; }
+        data_[0] = kVersion;
+        data_[1] = sequence;
+        size_ = kHeaderSize;
+    }
+
+    /** @brief Frame size so far */
+    constexpr size_t size() const { return size_; }
+    /** @brief First error, Status::Ok while every record fitted */
+    constexpr Status status() const { return status_; }
+
+    /**
+     * @brief Append a record, checking the value size of the known types
+     *
+     * @param type The record type
+     * @param value The value
+     * @param size The value size
+     * @return Writer& This writer
+     */
+    constexpr Writer & put(uint8_t type, const uint8_t * value, uint8_t size) {
+        if (status_ != Status::Ok) { return *this; }
+
+        const TypeInfo * info = find_type(type);
+        if ((info != nullptr) && ((size < info->min_size) || (size > info->max_size))) {
+            status_ = Status::BadSize;
+            return *this;
+        }
+        if (capacity_ - size_ < kRecordHeaderSize + size) {
+            status_ = Status::NoSpace;
+            return *this;
+        }
+
+        data_[size_++] = type;
+        data_[size_++] = size;
+        for (uint8_t i = 0; i < size; i++) { data_[size_++] = value[i]; }
+        return *this;
+    }
+
+    /** @brief Append a one byte record */
+    constexpr Writer & put_u8(Type type, uint8_t value) {
+        const uint8_t bytes[1] = { value };
+        return put(static_cast<uint8_t>(type), bytes, 1);
+    }
+
+    /** @brief Append a 32-bit record */
+    constexpr Writer & put_u32(Type type, uint32_t value) {
+        const uint8_t bytes[4] = { static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+                                   static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24) };
+        return put(static_cast<uint8_t>(type), bytes, 4);
+    }
+
+private:
+    uint8_t * data_;
+    size_t capacity_;
+    size_t size_;
+    Status status_;
+};
+
+/**
+ * @brief Decode a control characteristic write: legacy byte or command frame
+ *
+ * @param data The written value
+ * @param size The written size
+ * @param command Output command
+ * @return Status Status::Ok on success
+ */
+constexpr Status decode_command(const uint8_t * data, size_t size, Command & command) {
+    command = Command{};
+
+    if (size == 1) {
+        command.version = kLegacyVersion;
+        command.has_motion = true;
+        command.motion = data[0];
+        return Status::Ok;
+    }
+
+    Reader reader(data, size);
+    Record record{};
+    command.version = reader.version();
+    command.sequence = reader.sequence();
+    while (reader.next(record)) {
+        const TypeInfo * info = find_type(record.type);
+        if ((info == nullptr) || (info->direction != Direction::Command)) {
+            command.nb_skipped++;
+            continue;
+        }
+        if (info->type == Type::Motion) {
+            command.has_motion = true;
+            command.motion = record.value[0];
+        }
+    }
+
+    return reader.status();
+}
+
+/**
+ * @brief Encode a command frame carrying one Motion record
+ *
+ * @param sequence Frame sequence number
+ * @param motion The command byte
+ * @param data Output buffer
+ * @param capacity Output buffer size
+ * @return size_t Frame size, 0 if the buffer is too small
+ */
+constexpr size_t encode_command(uint8_t sequence, uint8_t motion, uint8_t * data, size_t capacity) {
+    Writer writer(data, capacity, sequence);
+    writer.put_u8(Type::Motion, motion);
+    return (writer.status() == Status::Ok) ? writer.size() : 0;
+}
+
+/**
+ * @brief Encode a full telemetry frame (kTelemetrySize bytes)
+ *
+ * @param telemetry The telemetry content
+ * @param data Output buffer
+ * @param capacity Output buffer size
+ * @return size_t Frame size, 0 if the buffer is too small
+ */
+constexpr size_t encode_telemetry(const Telemetry & telemetry, uint8_t * data, size_t capacity) {
+    Writer writer(data, capacity, telemetry.sequence);
+    writer.put_u8(Type::State, telemetry.state)
+          .put_u8(Type::EndStop, telemetry.endstop)
+          .put_u8(Type::Ack, telemetry.ack)
+          .put_u8(Type::Power, telemetry.power)
+          .put_u32(Type::Uptime, telemetry.uptime_ms);
+    return (writer.status() == Status::Ok) ? writer.size() : 0;
+}
+
+/**
+ * @brief Decode a telemetry frame; missing records are left to 0
+ *
+ * @param data The frame
+ * @param size The frame size
+ * @param telemetry Output telemetry content
+ * @return Status Status::Ok on success
+ */
+constexpr Status decode_telemetry(const uint8_t * data, size_t size, Telemetry & telemetry) {
+    telemetry = Telemetry{};
+
+    Reader reader(data, size);
+    Record record{};
+    telemetry.sequence = reader.sequence();
+    while (reader.next(record)) {
+        switch (static_cast<Type>(record.type)) {
+            case Type::State: telemetry.state = record.value[0]; break;
+            case Type::EndStop: telemetry.endstop = record.value[0]; break;
+            case Type::Ack: telemetry.ack = record.value[0]; break;
+            case Type::Power: telemetry.power = record.value[0]; break;
+            case Type::Uptime:
+                telemetry.uptime_ms = static_cast<uint32_t>(record.value[0]) | (static_cast<uint32_t>(record.value[1]) << 8) |
+                                      (static_cast<uint32_t>(record.value[2]) << 16) | (static_cast<uint32_t>(record.value[3]) << 24);
+                break;
+            default: break;
+        }
+    }
+
+    return reader.status();
+}
+
+/**
+ * @brief Get the name of a status
+ *
+ * @param status The codec status
+ * @return const char* Status name
+ */
+constexpr const char * status_name(Status status) {
+    switch (status) {
+        case Status::Ok: return "ok";
+        case Status::Empty: return "empty";
+        case Status::BadVersion: return "bad version";
+        case Status::Truncated: return "truncated";
+        case Status::BadSize: return "bad size";
+        case Status::NoSpace: return "no space";
+    }
+    return "?";
+}
+
+} // namespace protocol
+
+#endif // PROTOCOL_HPP
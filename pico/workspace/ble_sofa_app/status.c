@@ -0,0 +1,109 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: status.c
+-- Description: Fixed-layout status record: relay state, position, timers,
+--              counters and link parameters, read in one ATT PDU
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "status.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+// Defaults before the ATT MTU exchange and the LE data length update
+#define STATUS_DEFAULT_MTU          23
+#define STATUS_DEFAULT_DATA_LENGTH  27
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Store a 16-bit value, little-endian
+ */
+static void status_store_16(uint8_t * buffer, uint16_t value) {
+    buffer[0] = (uint8_t)value;
+    buffer[1] = (uint8_t)(value >> 8);
+}
+
+/**
+ * @brief Store a 32-bit value, little-endian
+ */
+static void status_store_32(uint8_t * buffer, uint32_t value) {
+    buffer[0] = (uint8_t)value;
+    buffer[1] = (uint8_t)(value >> 8);
+    buffer[2] = (uint8_t)(value >> 16);
+    buffer[3] = (uint8_t)(value >> 24);
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file status.h
+ * @name status_link_init
+ */
+void status_link_init(status_link_t * link) {
+    link->mtu = STATUS_DEFAULT_MTU;
+    link->tx_octets = STATUS_DEFAULT_DATA_LENGTH;
+    link->rx_octets = STATUS_DEFAULT_DATA_LENGTH;
+}
+
+/**
+ * @file status.h
+ * @name status_snapshot
+ */
+void status_snapshot(const motion_t * motion, const deadman_t * deadman, const power_manager_t * power,
+                     const status_link_t * link, uint64_t now_us, uint8_t * record) {
+    memset(record, 0, STATUS_RECORD_SIZE);
+
+    record[0] = STATUS_VERSION;
+    record[1] = motion->command;
+    record[2] = motion->limits;
+    record[3] = (uint8_t)motion->position;
+    record[4] = (uint8_t)motion->last_source;
+    record[5] = (uint8_t)power->state;
+    record[6] = deadman->armed ? 1 : 0;
+
+    uint32_t deadman_left_ms = 0;
+    if (deadman->armed && (deadman->deadline_us > now_us)) {
+        deadman_left_ms = (uint32_t)((deadman->deadline_us - now_us) / 1000);
+    }
+    status_store_32(&record[8], (uint32_t)(now_us / 1000));
+    status_store_32(&record[12], deadman_left_ms);
+    status_store_32(&record[16], (uint32_t)((now_us - power->state_since_us) / 1000));
+    status_store_32(&record[20], deadman->timeout_us);
+
+    // Touch pads drive the button source, deadman stops are counted as trips
+    status_store_32(&record[24], motion->nb_commands[MOTION_SOURCE_BLE] + motion->nb_commands[MOTION_SOURCE_USB]);
+    status_store_32(&record[28], motion->nb_commands[MOTION_SOURCE_BUTTON]);
+    status_store_32(&record[32], deadman->nb_trips);
+    status_store_32(&record[36], motion->nb_rejected);
+    status_store_32(&record[40], motion->nb_blocked);
+    status_store_32(&record[44], motion->nb_limit_cuts);
+    status_store_32(&record[48], deadman->max_gap_us);
+    status_store_32(&record[52], power->stats.nb_transitions);
+
+    status_store_16(&record[56], link->mtu);
+    status_store_16(&record[58], link->tx_octets);
+    status_store_16(&record[60], link->rx_octets);
+}
@@ -0,0 +1,100 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: status.h
+-- Description: Fixed-layout status record: relay state, position, timers,
+--              counters and link parameters, read in one ATT PDU
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef STATUS_H
+#define STATUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "motion.h"
+#include "deadman.h"
+#include "power.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Record layout version */
+#define STATUS_VERSION      1
+/** @brief Record size, one read response from an ATT MTU of STATUS_MIN_MTU */
+#define STATUS_RECORD_SIZE  62
+#define STATUS_MIN_MTU      (STATUS_RECORD_SIZE + 1)
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    uint16_t mtu;           /**> Negotiated ATT MTU */
+    uint16_t tx_octets;     /**> LE data length: maximum LL payload sent */
+    uint16_t rx_octets;     /**> LE data length: maximum LL payload received */
+} status_link_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Link parameters before any MTU exchange or data length update
+ *
+ * @param link The link parameters
+ */
+void status_link_init(status_link_t * link);
+
+/**
+ * @brief Serialize the status, little-endian:
+ *        - [0]      Version
+ *        - [1]      Applied command byte
+ *        - [2]      Active end-stops (bit [0]: Up, bit [1]: Down)
+ *        - [3]      Last end-stop reached (0 = unknown, 1 = Up, 2 = Down)
+ *        - [4]      Source of the last command (0 = BLE, 1 = button, 2 = deadman, 3 = USB)
+ *        - [5]      Power state (0 = low clock, 1 = full clock)
+ *        - [6]      Hold-to-run deadman armed
+ *        - [7]      Reserved (0)
+ *        - [8..11]  Time since boot (ms)
+ *        - [12..15] Time left before the deadman cuts the relays (ms), 0 if disarmed
+ *        - [16..19] Time in the current power state (ms)
+ *        - [20..23] Deadman timeout (us)
+ *        - [24..27] Client commands (BLE and USB)
+ *        - [28..31] Local commands (buttons and touch pads)
+ *        - [32..35] Deadman trips
+ *        - [36..39] Rejected commands (both directions)
+ *        - [40..43] Commands blocked by an end-stop
+ *        - [44..47] Motions cut by an end-stop
+ *        - [48..51] Worst time between two keep-alives (us)
+ *        - [52..55] Power state transitions
+ *        - [56..57] ATT MTU
+ *        - [58..59] LE data length, TX octets
+ *        - [60..61] LE data length, RX octets
+ *
+ * @param motion The motion command path
+ * @param deadman The hold-to-run deadman
+ * @param power The power manager
+ * @param link The link parameters
+ * @param now_us Current time in microseconds
+ * @param record Output record of STATUS_RECORD_SIZE bytes
+ */
+void status_snapshot(const motion_t * motion, const deadman_t * deadman, const power_manager_t * power,
+                     const status_link_t * link, uint64_t now_us, uint8_t * record);
+
+#endif // STATUS_H
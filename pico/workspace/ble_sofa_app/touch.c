@@ -0,0 +1,117 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: touch.c
+-- Description: Fixed-point baseline-tracking filter turning capacitive pad
+--              charge times into press/release events
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "touch.h"
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Move the baseline towards the sample by 1/2^shift of the error
+ */
+static void touch_track(touch_t * touch, uint32_t sample, int shift) {
+    int32_t error = ((int32_t)sample << 8) - touch->baseline_q8;
+
+    // Shift magnitudes only: right shifts of negative values are implementation-defined
+    if (error >= 0) { touch->baseline_q8 += error >> shift; }
+    else { touch->baseline_q8 -= (-error) >> shift; }
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file touch.h
+ * @name touch_init
+ */
+void touch_init(touch_t * touch, uint16_t threshold) {
+    memset(touch, 0, sizeof(touch_t));
+    touch->threshold = threshold;
+}
+
+/**
+ * @file touch.h
+ * @name touch_process
+ */
+button_event_t touch_process(touch_t * touch, uint32_t sample) {
+    // Calibration: start from the first sample, then average quickly
+    if (touch->nb_calibration < TOUCH_CALIBRATION_SAMPLES) {
+        if (touch->nb_calibration == 0) { touch->baseline_q8 = (int32_t)sample << 8; }
+        else { touch_track(touch, sample, TOUCH_BASELINE_DOWN_SHIFT); }
+        touch->nb_calibration++;
+        return BUTTON_EVENT_NONE;
+    }
+
+    int32_t delta = (int32_t)sample - (touch->baseline_q8 >> 8);
+
+    if (!touch->pressed) {
+        if (delta >= (int32_t)touch->threshold) {
+            if (++touch->count >= TOUCH_DEBOUNCE_SAMPLES) {
+                touch->pressed = true;
+                touch->count = 0;
+                touch->press_samples = 0;
+                return BUTTON_EVENT_PRESS;
+            }
+        }
+        else {
+            // The baseline only follows the untouched pad
+            touch->count = 0;
+            touch_track(touch, sample, (delta >= 0) ? TOUCH_BASELINE_SHIFT : TOUCH_BASELINE_DOWN_SHIFT);
+        }
+        return BUTTON_EVENT_NONE;
+    }
+
+    // Stuck press (object lying on the pad, water): take it as the new baseline
+    if (++touch->press_samples >= TOUCH_MAX_PRESS_SAMPLES) {
+        touch->baseline_q8 = (int32_t)sample << 8;
+        touch->nb_recalibrations++;
+        touch->pressed = false;
+        touch->count = 0;
+        return BUTTON_EVENT_RELEASE;
+    }
+
+    // Release with hysteresis
+    if (delta < (int32_t)(touch->threshold - touch->threshold / 4)) {
+        if (++touch->count >= TOUCH_DEBOUNCE_SAMPLES) {
+            touch->pressed = false;
+            touch->count = 0;
+            return BUTTON_EVENT_RELEASE;
+        }
+    }
+    else {
+        touch->count = 0;
+    }
+
+    return BUTTON_EVENT_NONE;
+}
+
+/**
+ * @file touch.h
+ * @name touch_get_baseline
+ */
+uint32_t touch_get_baseline(const touch_t * touch) {
+    return (uint32_t)(touch->baseline_q8 >> 8);
+}
@@ -0,0 +1,90 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: touch.h
+-- Description: Fixed-point baseline-tracking filter turning capacitive pad
+--              charge times into press/release events
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef TOUCH_H
+#define TOUCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "button.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Number of samples used to set the initial baseline */
+#define TOUCH_CALIBRATION_SAMPLES   16
+/** @brief Baseline drift tracking: 1/2^n of the error per sample */
+#define TOUCH_BASELINE_SHIFT        6
+/** @brief Faster tracking when the counts fall below the baseline */
+#define TOUCH_BASELINE_DOWN_SHIFT   2
+/** @brief Consecutive samples needed to change state */
+#define TOUCH_DEBOUNCE_SAMPLES      2
+/** @brief Pressed samples after which the pad is considered stuck and recalibrated */
+#define TOUCH_MAX_PRESS_SAMPLES     3000
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    int32_t baseline_q8;        /**> Untouched charge time, Q24.8 */
+    uint16_t threshold;         /**> Press threshold above the baseline */
+    uint16_t nb_calibration;    /**> Calibration samples processed */
+    uint8_t count;              /**> Consecutive samples beyond the threshold */
+    bool pressed;               /**> Debounced state */
+    uint32_t press_samples;     /**> Samples since the press */
+    uint32_t nb_recalibrations; /**> Stuck press recalibrations */
+} touch_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Initialize a touch channel, the baseline is set by the first samples
+ *
+ * @param touch The touch channel structure
+ * @param threshold Press threshold above the baseline, in counts.
+ *                  The release threshold is 3/4 of it.
+ */
+void touch_init(touch_t * touch, uint16_t threshold);
+
+/**
+ * @brief Process a charge time sample
+ *
+ * @param touch The touch channel structure
+ * @param sample The charge time, in counts
+ * @return button_event_t The event to be applied
+ */
+button_event_t touch_process(touch_t * touch, uint32_t sample);
+
+/**
+ * @brief Get the current baseline
+ *
+ * @param touch The touch channel structure
+ * @return uint32_t Baseline, in counts
+ */
+uint32_t touch_get_baseline(const touch_t * touch);
+
+#endif // TOUCH_H
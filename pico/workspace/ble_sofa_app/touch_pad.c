@@ -0,0 +1,121 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: touch_pad.c
+-- Description: PIO capacitive touch pads: parallel charge time measurement
+--              and batched filtering from a periodic timer
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include "hardware/clocks.h"
+#include "hardware/pio.h"
+
+#include "touch_pad.h"
+#include "touch.pio.h"
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+static PIO touch_pio;
+static uint touch_sm[TOUCH_PAD_MAX_CHANNELS];
+static uint touch_nb_channels;
+static touch_t touch_channels[TOUCH_PAD_MAX_CHANNELS];
+static touch_pad_callback_t touch_callback;
+static repeating_timer_t touch_timer;
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Filter period: average the measurements of each pad and feed the filters
+ *
+ * @param rt The repeating timer
+ * @return true to keep the timer running
+ */
+static bool touch_timer_callback(repeating_timer_t * rt) {
+    (void)rt;
+    // The state machines run from clk_sys, which the power manager scales
+    uint32_t clk_khz = clock_get_hz(clk_sys) / 1000;
+
+    for (uint ch = 0; ch < touch_nb_channels; ch++) {
+        uint32_t sum = 0;
+        uint32_t n = 0;
+
+        while (!pio_sm_is_rx_fifo_empty(touch_pio, touch_sm[ch])) {
+            sum += pio_sm_get(touch_pio, touch_sm[ch]);
+            n++;
+        }
+        if (n == 0) { continue; }
+
+        uint32_t sample = (uint32_t)((uint64_t)sum * TOUCH_PAD_REF_CLK_KHZ / ((uint64_t)n * clk_khz));
+        button_event_t event = touch_process(&touch_channels[ch], sample);
+        if (event != BUTTON_EVENT_NONE) { touch_callback(ch, event); }
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file touch_pad.h
+ * @name touch_pad_init
+ */
+bool touch_pad_init(const uint * gpios, uint nb_channels, uint16_t threshold, touch_pad_callback_t callback) {
+    if ((nb_channels == 0) || (nb_channels > TOUCH_PAD_MAX_CHANNELS)) { return false; }
+
+    // The CYW43 SPI bus uses a PIO too: take the first one with room left
+    touch_pio = pio1;
+    if (!pio_can_add_program(touch_pio, &touch_program)) {
+        touch_pio = pio0;
+        if (!pio_can_add_program(touch_pio, &touch_program)) { return false; }
+    }
+    uint offset = pio_add_program(touch_pio, &touch_program);
+
+    // One period worth of measurements per pad, at the current clk_sys
+    uint32_t pacing = clock_get_hz(clk_sys) / 1000 * TOUCH_PAD_PERIOD_MS / TOUCH_PAD_OVERSAMPLING;
+
+    uint32_t sm_mask = 0;
+    for (uint ch = 0; ch < nb_channels; ch++) {
+        int sm = pio_claim_unused_sm(touch_pio, false);
+        if (sm < 0) { return false; }
+        touch_sm[ch] = (uint)sm;
+        sm_mask |= 1u << sm;
+        touch_program_init(touch_pio, touch_sm[ch], offset, gpios[ch]);
+        pio_sm_put(touch_pio, touch_sm[ch], pacing);
+        touch_init(&touch_channels[ch], threshold);
+    }
+
+    touch_nb_channels = nb_channels;
+    touch_callback = callback;
+
+    // All the pads are measured in parallel
+    pio_enable_sm_mask_in_sync(touch_pio, sm_mask);
+
+    return add_repeating_timer_ms(-TOUCH_PAD_PERIOD_MS, &touch_timer_callback, NULL, &touch_timer);
+}
+
+/**
+ * @file touch_pad.h
+ * @name touch_pad_get
+ */
+const touch_t * touch_pad_get(uint channel) {
+    return &touch_channels[channel];
+}
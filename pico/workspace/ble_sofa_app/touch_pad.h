@@ -0,0 +1,79 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: touch_pad.h
+-- Description: PIO capacitive touch pads: parallel charge time measurement
+--              and batched filtering from a periodic timer
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef TOUCH_PAD_H
+#define TOUCH_PAD_H
+
+#include "pico/stdlib.h"
+
+#include "touch.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Maximum number of pads, one PIO state machine each */
+#define TOUCH_PAD_MAX_CHANNELS  4
+/** @brief Filter period: the CPU is woken once per period for all the pads */
+#define TOUCH_PAD_PERIOD_MS     10
+/** @brief Measurements per pad and per period, fits in the joined RX FIFO */
+#define TOUCH_PAD_OVERSAMPLING  8
+/** @brief Reference clk_sys for the counts, they are scaled when clk_sys changes */
+#define TOUCH_PAD_REF_CLK_KHZ   48000
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+/**
+ * @brief Touch event callback
+ *
+ * @param channel The pad channel
+ * @param event The press/release event
+ * @note Called from the timer interrupt
+ */
+typedef void (*touch_pad_callback_t)(uint channel, button_event_t event);
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Start measuring the pads and filtering them periodically
+ *
+ * @param gpios The pad GPIOs
+ * @param nb_channels The number of pads, up to TOUCH_PAD_MAX_CHANNELS
+ * @param threshold The press threshold, in counts at TOUCH_PAD_REF_CLK_KHZ
+ * @param callback The touch event callback
+ * @return true on success, false if no PIO is available
+ */
+bool touch_pad_init(const uint * gpios, uint nb_channels, uint16_t threshold, touch_pad_callback_t callback);
+
+/**
+ * @brief Get the filter state of a pad
+ *
+ * @param channel The pad channel
+ * @return const touch_t* The filter state
+ */
+const touch_t * touch_pad_get(uint channel);
+
+#endif // TOUCH_PAD_H
@@ -0,0 +1,44 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: tusb_config.h
+-- Description: TinyUSB device configuration: one CDC interface for the wired
+--              control channel (usb_link.h)
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef TUSB_CONFIG_H
+#define TUSB_CONFIG_H
+
+// CFG_TUSB_MCU and CFG_TUSB_OS are set by the Pico SDK tinyusb_device target
+
+#define CFG_TUSB_RHPORT0_MODE   OPT_MODE_DEVICE
+#define CFG_TUD_ENDPOINT0_SIZE  64
+
+// Control channel only: no stdio, no other class
+#define CFG_TUD_CDC             1
+#define CFG_TUD_MSC             0
+#define CFG_TUD_HID             0
+#define CFG_TUD_MIDI            0
+#define CFG_TUD_VENDOR          0
+
+// Full speed bulk endpoints (USB_LINK_PACKET_SIZE); the FIFOs hold a few
+// packets while the run loop is busy with the radio
+#define CFG_TUD_CDC_EP_BUFSIZE  64
+#define CFG_TUD_CDC_RX_BUFSIZE  256
+#define CFG_TUD_CDC_TX_BUFSIZE  256
+
+#endif // TUSB_CONFIG_H
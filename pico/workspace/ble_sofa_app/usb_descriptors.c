@@ -0,0 +1,154 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: usb_descriptors.c
+-- Description: USB device, configuration and string descriptors of the CDC
+--              control channel
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "tusb.h"
+#include "pico/unique_id.h"
+
+#include "usb_link.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+// Raspberry Pi vendor identifier, product identifier of the Pico SDK CDC
+// device: the host loads its CDC ACM driver (/dev/ttyACMx, COMx)
+#define USB_VID         0x2E8A
+#define USB_PID         0x000A
+#define USB_BCD_DEVICE  0x0100
+
+// Interfaces: CDC communication and data
+#define USB_ITF_CDC         0
+#define USB_ITF_CDC_DATA    1
+#define USB_NB_ITF          2
+
+// Endpoints: CDC notification, data out and in
+#define USB_EP_CDC_NOTIF    0x81
+#define USB_EP_CDC_OUT      0x02
+#define USB_EP_CDC_IN       0x82
+#define USB_CDC_NOTIF_SIZE  8
+
+#define USB_CONFIG_SIZE     (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN)
+#define USB_MAX_POWER_MA    100
+
+// String indexes
+#define USB_STR_LANGID          0
+#define USB_STR_MANUFACTURER    1
+#define USB_STR_PRODUCT         2
+#define USB_STR_SERIAL          3
+#define USB_STR_CDC             4
+
+/** @brief Longest string descriptor, in characters */
+#define USB_STR_MAX_CHARS   31
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+/** @brief Device descriptor, with an interface association for the CDC function */
+static const tusb_desc_device_t usb_device_desc = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bDeviceClass = TUSB_CLASS_MISC,
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = USB_VID,
+    .idProduct = USB_PID,
+    .bcdDevice = USB_BCD_DEVICE,
+    .iManufacturer = USB_STR_MANUFACTURER,
+    .iProduct = USB_STR_PRODUCT,
+    .iSerialNumber = USB_STR_SERIAL,
+    .bNumConfigurations = 1,
+};
+
+/** @brief Configuration descriptor: one CDC ACM function */
+static const uint8_t usb_config_desc[USB_CONFIG_SIZE] = {
+    TUD_CONFIG_DESCRIPTOR(1, USB_NB_ITF, 0, USB_CONFIG_SIZE, 0, USB_MAX_POWER_MA),
+    TUD_CDC_DESCRIPTOR(USB_ITF_CDC, USB_STR_CDC, USB_EP_CDC_NOTIF, USB_CDC_NOTIF_SIZE, USB_EP_CDC_OUT, USB_EP_CDC_IN, USB_LINK_PACKET_SIZE),
+};
+
+/** @brief Strings, the serial number is the flash unique identifier */
+static const char * const usb_strings[] = {
+    [USB_STR_MANUFACTURER] = "LGANTEL",
+    [USB_STR_PRODUCT] = "BLE Sofa",
+    [USB_STR_CDC] = "BLE Sofa Control",
+};
+
+/** @brief String descriptor returned to TinyUSB, UTF-16 */
+static uint16_t usb_string_desc[1 + USB_STR_MAX_CHARS];
+
+//----------------------------------------------------------------
+// TinyUSB callbacks
+//----------------------------------------------------------------
+
+/**
+ * @brief Device descriptor request
+ */
+const uint8_t * tud_descriptor_device_cb(void) {
+    return (const uint8_t *)&usb_device_desc;
+}
+
+/**
+ * @brief Configuration descriptor request
+ */
+const uint8_t * tud_descriptor_configuration_cb(uint8_t index) {
+    (void)index;
+    return usb_config_desc;
+}
+
+/**
+ * @brief String descriptor request
+ */
+const uint16_t * tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    (void)langid;
+    char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+    const char * str;
+    size_t len;
+
+    if (index == USB_STR_LANGID) {
+        // English (United States)
+        usb_string_desc[1] = 0x0409;
+        len = 1;
+    }
+    else {
+        if (index == USB_STR_SERIAL) {
+            pico_get_unique_board_id_string(serial, sizeof(serial));
+            str = serial;
+        }
+        else if ((index < sizeof(usb_strings) / sizeof(usb_strings[0])) && (usb_strings[index] != NULL)) {
+            str = usb_strings[index];
+        }
+        else {
+            return NULL;
+        }
+
+        len = strlen(str);
+        if (len > USB_STR_MAX_CHARS) { len = USB_STR_MAX_CHARS; }
+        for (size_t i = 0; i < len; i++) { usb_string_desc[1 + i] = (uint8_t)str[i]; }
+    }
+
+    usb_string_desc[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * len + 2));
+    return usb_string_desc;
+}
@@ -0,0 +1,203 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: usb_link.c
+-- Description: Wired control channel: control protocol frames over a byte
+--              stream (USB CDC), decoded in place in the receive buffer
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "usb_link.h"
+#include "control.h"
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Telemetry state compared to the last frame sent, as for the BLE
+ *        notifications: each command frame is acknowledged
+ */
+static uint32_t usb_link_state(const usb_link_t * link) {
+    return ((uint32_t)link->command_ack << 16) | ((uint32_t)link->config.motion->command << 8) |
+           motion_endstop_status(link->config.motion);
+}
+
+/**
+ * @brief Send the current telemetry frame
+ *
+ * @return true if it was queued
+ */
+static bool usb_link_send_telemetry(usb_link_t * link) {
+    control_telemetry_t telemetry;
+    telemetry.sequence = link->telemetry_sequence;
+    telemetry.state = link->config.motion->command;
+    telemetry.endstop = motion_endstop_status(link->config.motion);
+    telemetry.ack = link->command_ack;
+    telemetry.power = (uint8_t)link->config.power->state;
+    telemetry.uptime_ms = (uint32_t)(link->config.now_us() / 1000);
+
+    uint8_t frame[CONTROL_TELEMETRY_SIZE];
+    uint8_t stream[USB_LINK_HEADER_SIZE + CONTROL_TELEMETRY_SIZE];
+    uint16_t len = usb_link_wrap(frame, (uint8_t)control_encode_telemetry(&telemetry, frame), stream);
+    if (!link->config.write(stream, len)) {
+        link->nb_tx_full++;
+        return false;
+    }
+
+    link->telemetry_sequence++;
+    link->nb_telemetry++;
+    return true;
+}
+
+/**
+ * @brief Apply a frame, pointing into the receive buffer
+ */
+static void usb_link_apply(usb_link_t * link, const uint8_t * frame, uint8_t size) {
+    // Any frame brings the system clock back to full speed
+    link->config.activity();
+
+    control_command_t command;
+    if (control_decode_command(frame, size, &command) != 0) {
+        link->nb_errors++;
+        return;
+    }
+    link->nb_frames++;
+    link->command_ack = command.sequence;
+    if (command.has_motion) { link->config.command(command.motion); }
+
+    // Acknowledge each frame in its own telemetry frame
+    if (command.version != CONTROL_LEGACY_VERSION) { usb_link_update(link); }
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file usb_link.h
+ * @name usb_link_init
+ */
+void usb_link_init(usb_link_t * link, const usb_link_config_t * config) {
+    memset(link, 0, sizeof(usb_link_t));
+    link->config = *config;
+}
+
+/**
+ * @file usb_link.h
+ * @name usb_link_next_frame
+ */
+const uint8_t * usb_link_next_frame(const uint8_t * data, uint16_t size, uint16_t * pos, uint8_t * frame_size, uint32_t * nb_skipped) {
+    while (size - *pos >= USB_LINK_HEADER_SIZE) {
+        const uint8_t * header = &data[*pos];
+        if ((header[0] != USB_LINK_SYNC) || (header[1] == 0) || (header[1] > USB_LINK_MAX_FRAME_SIZE)) {
+            if (nb_skipped != NULL) { (*nb_skipped)++; }
+            (*pos)++;
+            continue;
+        }
+
+        // Incomplete frame: wait for the next packet
+        if (size - *pos - USB_LINK_HEADER_SIZE < header[1]) { return NULL; }
+
+        *frame_size = header[1];
+        *pos += USB_LINK_HEADER_SIZE + header[1];
+        return &header[USB_LINK_HEADER_SIZE];
+    }
+
+    // A lone byte can only start a frame if it is a sync byte
+    if ((size - *pos == 1) && (data[*pos] != USB_LINK_SYNC)) {
+        if (nb_skipped != NULL) { (*nb_skipped)++; }
+        (*pos)++;
+    }
+
+    return NULL;
+}
+
+/**
+ * @file usb_link.h
+ * @name usb_link_wrap
+ */
+uint16_t usb_link_wrap(const uint8_t * frame, uint8_t size, uint8_t * out) {
+    if ((size == 0) || (size > USB_LINK_MAX_FRAME_SIZE)) { return 0; }
+    out[0] = USB_LINK_SYNC;
+    out[1] = size;
+    memcpy(&out[USB_LINK_HEADER_SIZE], frame, size);
+    return USB_LINK_HEADER_SIZE + size;
+}
+
+/**
+ * @file usb_link.h
+ * @name usb_link_rx_buffer
+ */
+uint8_t * usb_link_rx_buffer(usb_link_t * link, uint16_t * capacity) {
+    *capacity = USB_LINK_RX_SIZE - link->rx_len;
+    return &link->rx[link->rx_len];
+}
+
+/**
+ * @file usb_link.h
+ * @name usb_link_received
+ */
+void usb_link_received(usb_link_t * link, uint16_t size) {
+    link->rx_len += size;
+
+    // The frames are decoded where the driver wrote them
+    uint16_t pos = 0;
+    uint8_t frame_size;
+    const uint8_t * frame;
+    while ((frame = usb_link_next_frame(link->rx, link->rx_len, &pos, &frame_size, &link->nb_skipped)) != NULL) {
+        usb_link_apply(link, frame, frame_size);
+    }
+
+    // Only an incomplete frame is moved, to the start of the buffer
+    link->rx_len -= pos;
+    if ((pos > 0) && (link->rx_len > 0)) { memmove(link->rx, &link->rx[pos], link->rx_len); }
+}
+
+/**
+ * @file usb_link.h
+ * @name usb_link_set_connected
+ */
+void usb_link_set_connected(usb_link_t * link, bool connected) {
+    link->connected = connected;
+    link->rx_len = 0;
+
+    // The host gets the current state as soon as it opens the port
+    if (connected) {
+        link->telemetry_state_sent = ~usb_link_state(link);
+        usb_link_update(link);
+    }
+}
+
+/**
+ * @file usb_link.h
+ * @name usb_link_update
+ */
+void usb_link_update(usb_link_t * link) {
+    // Applied command, end-stop status or acknowledged frame changed: send the telemetry
+    uint32_t state = usb_link_state(link);
+    if (state == link->telemetry_state_sent) { return; }
+
+    if (!link->connected) {
+        link->telemetry_state_sent = state;
+        return;
+    }
+    if (usb_link_send_telemetry(link)) {
+        link->telemetry_state_sent = state;
+    }
+}
@@ -0,0 +1,166 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Application
+-- Version: 0.1.0
+-- File Name: usb_link.h
+-- Description: Wired control channel: control protocol frames over a byte
+--              stream (USB CDC), decoded in place in the receive buffer
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef USB_LINK_H
+#define USB_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "motion.h"
+#include "power.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+// Stream framing, in both directions:
+//   - [0]  Sync byte (USB_LINK_SYNC)
+//   - [1]  Frame size, 1 to USB_LINK_MAX_FRAME_SIZE
+//   - [2..] The frame: a legacy command byte or a protocol.hpp frame
+// The receiver skips the bytes up to the next sync byte followed by a valid
+// size, so that it resynchronizes after a partial write of the host.
+
+/** @brief Start of a frame */
+#define USB_LINK_SYNC           0xA5
+/** @brief Sync byte and frame size */
+#define USB_LINK_HEADER_SIZE    2
+/** @brief Largest frame accepted, as a control characteristic write at the default MTU */
+#define USB_LINK_MAX_FRAME_SIZE 20
+/** @brief Bulk endpoint size of a full speed CDC interface */
+#define USB_LINK_PACKET_SIZE    64
+/** @brief Receive buffer: a partial frame left from the last packet, then a full packet */
+#define USB_LINK_RX_SIZE        (USB_LINK_HEADER_SIZE + USB_LINK_MAX_FRAME_SIZE + USB_LINK_PACKET_SIZE)
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+/** @brief Apply a command byte received from the host */
+typedef void (*usb_link_command_callback_t)(uint8_t command);
+
+/** @brief Host activity (any frame), before the command is applied */
+typedef void (*usb_link_activity_callback_t)(void);
+
+/** @brief Time since boot in microseconds */
+typedef uint64_t (*usb_link_time_callback_t)(void);
+
+/** @brief Queue bytes to the host, all or nothing: false if there is no room */
+typedef bool (*usb_link_write_callback_t)(const uint8_t * data, uint16_t size);
+
+typedef struct {
+    motion_t * motion;                      /**> Relay command state */
+    power_manager_t * power;                /**> Power manager */
+    usb_link_command_callback_t command;    /**> Command handler */
+    usb_link_activity_callback_t activity;  /**> Host activity handler */
+    usb_link_time_callback_t now_us;        /**> Time source */
+    usb_link_write_callback_t write;        /**> Transmit path */
+} usb_link_config_t;
+
+typedef struct {
+    usb_link_config_t config;       /**> Application state and handlers */
+    uint8_t rx[USB_LINK_RX_SIZE];   /**> Received bytes, frames are decoded in place */
+    uint16_t rx_len;                /**> Bytes in rx not consumed yet */
+    bool connected;                 /**> The host opened the port (DTR) */
+    uint8_t command_ack;            /**> Sequence number of the last command frame */
+    uint8_t telemetry_sequence;     /**> Telemetry frame sequence number */
+    uint32_t telemetry_state_sent;  /**> Last telemetry state sent (acknowledged frame, command, end-stop status) */
+    uint32_t nb_frames;             /**> Frames received and decoded */
+    uint32_t nb_errors;             /**> Frames rejected by the codec */
+    uint32_t nb_skipped;            /**> Bytes skipped to resynchronize */
+    uint32_t nb_telemetry;          /**> Telemetry frames sent */
+    uint32_t nb_tx_full;            /**> Telemetry delayed by a full transmit buffer */
+} usb_link_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Initialize the link, host not connected
+ *
+ * @param link The link
+ * @param config The application state and handlers, copied
+ */
+void usb_link_init(usb_link_t * link, const usb_link_config_t * config);
+
+/**
+ * @brief Find the next complete frame in a byte stream
+ *
+ * @param data The received bytes
+ * @param size The number of received bytes
+ * @param pos Read position, updated past the frame or to the first byte of
+ *            an incomplete frame
+ * @param frame_size Output frame size
+ * @param nb_skipped Incremented by the number of bytes skipped, may be NULL
+ * @return const uint8_t* The frame, inside data, NULL if no complete frame is left
+ */
+const uint8_t * usb_link_next_frame(const uint8_t * data, uint16_t size, uint16_t * pos, uint8_t * frame_size, uint32_t * nb_skipped);
+
+/**
+ * @brief Add the stream header to a frame
+ *
+ * @param frame The frame
+ * @param size The frame size, up to USB_LINK_MAX_FRAME_SIZE
+ * @param out Output buffer, at least USB_LINK_HEADER_SIZE + size bytes
+ * @return uint16_t The stream size, 0 if the frame is too large
+ */
+uint16_t usb_link_wrap(const uint8_t * frame, uint8_t size, uint8_t * out);
+
+/**
+ * @brief Get the free part of the receive buffer, where the driver reads the
+ *        next packet
+ *
+ * @param link The link
+ * @param capacity Output free size, at least USB_LINK_PACKET_SIZE
+ * @return uint8_t* The free part of the receive buffer
+ */
+uint8_t * usb_link_rx_buffer(usb_link_t * link, uint16_t * capacity);
+
+/**
+ * @brief Bytes were read into the receive buffer: apply the complete frames,
+ *        acknowledge each command frame with a telemetry frame, and keep the
+ *        incomplete one for the next packet
+ *
+ * @param link The link
+ * @param size The number of bytes read
+ */
+void usb_link_received(usb_link_t * link, uint16_t size);
+
+/**
+ * @brief The host opened or closed the port: the current telemetry is sent
+ *        on opening, and the bytes of a partial frame are dropped
+ *
+ * @param link The link
+ * @param connected true if the host opened the port
+ */
+void usb_link_set_connected(usb_link_t * link, bool connected);
+
+/**
+ * @brief Send the telemetry if it changed, called from the run loop after a
+ *        relay change
+ *
+ * @param link The link
+ */
+void usb_link_update(usb_link_t * link);
+
+#endif // USB_LINK_H
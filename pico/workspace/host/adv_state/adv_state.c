@@ -0,0 +1,185 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: adv_state.c
+-- Description: Advertising data layout and rate limiting of the advertised
+--              state, seen from an observer
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "adv_state.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define MS  1000ULL
+#define NB_RANDOM_EVENTS 100000
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Observer side: find the state record in the advertising data
+ *
+ * @return const uint8_t* The record after the company identifier, NULL if absent
+ */
+static const uint8_t * find_record(const uint8_t * data, uint8_t len) {
+    uint8_t pos = 0;
+    while (pos < len) {
+        uint8_t size = data[pos];
+        if ((size == 0) || (pos + 1 + size > len)) { return NULL; }
+        if ((data[pos + 1] == 0xFF) && (size >= 7) &&
+            (data[pos + 2] == (uint8_t)ADV_STATE_COMPANY_ID) && (data[pos + 3] == (uint8_t)(ADV_STATE_COMPANY_ID >> 8))) {
+            return &data[pos + 4];
+        }
+        pos += 1 + size;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Layout: AD structures, name, service UUID and the state record
+ */
+static int test_layout(void) {
+    adv_state_t adv;
+    adv_state_init(&adv, "ble-sofa", 0x81, 0x21);
+
+    static const uint8_t expected[] = {
+        2, 0x01, 0x06,
+        9, 0x09, 'b', 'l', 'e', '-', 's', 'o', 'f', 'a',
+        3, 0x02, 0x10, 0xFF,
+        7, 0xFF, 0xFF, 0xFF, ADV_STATE_VERSION, 0, 0x81, 0x21,
+    };
+    CHECK(adv.len == sizeof(expected));
+    CHECK(memcmp(adv.data, expected, sizeof(expected)) == 0);
+
+    // A long name is truncated so that the record still fits
+    adv_state_init(&adv, "a-very-long-sofa-name-for-the-living-room", 0, 0);
+    CHECK(adv.len == ADV_STATE_MAX_DATA_SIZE);
+    CHECK(find_record(adv.data, adv.len) != NULL);
+
+    return 0;
+}
+
+/**
+ * @brief Rate limit: the first change is immediate, the next ones wait,
+ *        a change undone before the deadline is dropped
+ */
+static int test_rate_limit(void) {
+    adv_state_t adv;
+    uint64_t t = 1000 * MS;
+    adv_state_init(&adv, "ble-sofa", 0, 0);
+
+    CHECK(!adv_state_update(&adv, 0, 0, t));
+    CHECK(adv_state_update(&adv, 0x01, 0, t));
+    CHECK(find_record(adv.data, adv.len)[1] == 1);
+    CHECK(adv_state_next_deadline_us(&adv) == 0);
+
+    t += 10 * MS;
+    CHECK(!adv_state_update(&adv, 0x00, 0x01, t));
+    CHECK(adv_state_next_deadline_us(&adv) == t - 10 * MS + ADV_STATE_MIN_INTERVAL_MS * MS);
+    t = adv_state_next_deadline_us(&adv);
+    CHECK(adv_state_update(&adv, 0x00, 0x01, t));
+    CHECK(find_record(adv.data, adv.len)[1] == 2);
+
+    // Undone before the deadline
+    t += 10 * MS;
+    CHECK(!adv_state_update(&adv, 0x02, 0x01, t));
+    CHECK(!adv_state_update(&adv, 0x00, 0x01, t + 10 * MS));
+    CHECK(adv_state_next_deadline_us(&adv) == 0);
+    CHECK(adv.nb_updates == 2);
+    CHECK(adv.nb_deferred == 2);
+
+    return 0;
+}
+
+/**
+ * @brief Random changes, with the firmware timer: the update rate is
+ *        bounded and an observer always ends up with the final state
+ */
+static int test_random(void) {
+    adv_state_t adv;
+    uint64_t t = 0;
+    uint8_t command = 0;
+    uint8_t endstop = 0;
+    uint8_t seen_sequence = 0;
+    uint32_t nb_seen = 0;
+
+    srand(1);
+    adv_state_init(&adv, "ble-sofa", command, endstop);
+
+    for (int i = 0; i < NB_RANDOM_EVENTS; i++) {
+        // Next event: a state change or the rate limit timer, whichever comes first
+        uint64_t next = t + (uint64_t)(rand() % 400) * MS;
+        uint64_t deadline = adv_state_next_deadline_us(&adv);
+        bool timer = (deadline != 0) && (deadline <= next);
+        t = timer ? deadline : next;
+        if (!timer) {
+            command = (uint8_t)(rand() % 3);
+            endstop = (uint8_t)(rand() % 2);
+        }
+
+        uint64_t last = adv.last_update_us;
+        if (adv_state_update(&adv, command, endstop, t)) {
+            CHECK((adv.nb_updates == 1) || (t - last >= ADV_STATE_MIN_INTERVAL_MS * MS));
+
+            // The observer sees every update through the sequence number
+            const uint8_t * record = find_record(adv.data, adv.len);
+            CHECK(record[1] == (uint8_t)(seen_sequence + 1));
+            CHECK((record[2] == command) && (record[3] == endstop));
+            seen_sequence = record[1];
+            nb_seen++;
+        }
+
+        // Nothing is left behind without a pending deadline
+        const uint8_t * record = find_record(adv.data, adv.len);
+        bool advertised = (record[2] == command) && (record[3] == endstop);
+        CHECK(advertised || (adv_state_next_deadline_us(&adv) > t));
+    }
+
+    printf("adv_state: %u updates, %u changes deferred, %.1f updates/s\n", nb_seen, adv.nb_deferred,
+           (double)nb_seen / ((double)t / 1e6));
+    CHECK((double)nb_seen / ((double)t / 1e6) <= 1000.0 / ADV_STATE_MIN_INTERVAL_MS);
+
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(void)
+{
+    if (test_layout()) { return 1; }
+    if (test_rate_limit()) { return 1; }
+    if (test_random()) { return 1; }
+
+    printf("adv_state: PASS\n");
+    return 0;
+}
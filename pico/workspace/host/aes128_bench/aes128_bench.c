@@ -0,0 +1,165 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: aes128_bench.c
+-- Description: AES-128 known-answer tests and throughput benchmark
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "aes128.h"
+
+#ifdef HAVE_RIJNDAEL
+#include "rijndael.h"
+#endif
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define NB_BENCH_BLOCKS   1000000
+#define NB_RANDOM_VECTORS 10000
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+/** @brief Known-answer vectors: key, plaintext, ciphertext */
+static const uint8_t aes128_kat[][3][16] = {
+    // FIPS-197 Appendix C.1
+    { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f },
+      { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff },
+      { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a } },
+    // FIPS-197 Appendix B
+    { { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c },
+      { 0x32, 0x43, 0xf6, 0xa8, 0x88, 0x5a, 0x30, 0x8d, 0x31, 0x31, 0x98, 0xa2, 0xe0, 0x37, 0x07, 0x34 },
+      { 0x39, 0x25, 0x84, 0x1d, 0x02, 0xdc, 0x09, 0xfb, 0xdc, 0x11, 0x85, 0x97, 0x19, 0x6a, 0x0b, 0x32 } },
+    // SP 800-38A F.1.1 ECB-AES128, block 1
+    { { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c },
+      { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a },
+      { 0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60, 0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97 } },
+};
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+static uint64_t time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Known-answer tests
+ */
+static int test_kat(void) {
+    uint32_t rk[AES128_RK_WORDS];
+    uint8_t out[16];
+
+    for (size_t i = 0; i < sizeof(aes128_kat) / sizeof(aes128_kat[0]); i++) {
+        aes128_setup(rk, aes128_kat[i][0]);
+        aes128_encrypt(rk, aes128_kat[i][1], out);
+        CHECK(memcmp(out, aes128_kat[i][2], 16) == 0);
+    }
+
+    // In-place encryption, as done by some BTstack callers
+    memcpy(out, aes128_kat[0][1], 16);
+    aes128_setup(rk, aes128_kat[0][0]);
+    aes128_encrypt(rk, out, out);
+    CHECK(memcmp(out, aes128_kat[0][2], 16) == 0);
+
+    return 0;
+}
+
+#ifdef HAVE_RIJNDAEL
+/**
+ * @brief Random vectors compared against the BTstack reference
+ */
+static int test_reference(void) {
+    uint32_t rk[AES128_RK_WORDS];
+    uint32_t rk_ref[RKLENGTH(128)];
+    uint8_t key[16], in[16], out[16], out_ref[16];
+
+    srand(1);
+    for (int i = 0; i < NB_RANDOM_VECTORS; i++) {
+        for (int j = 0; j < 16; j++) { key[j] = (uint8_t)rand(); in[j] = (uint8_t)rand(); }
+        aes128_setup(rk, key);
+        aes128_encrypt(rk, in, out);
+        int nrounds = rijndaelSetupEncrypt(rk_ref, key, 128);
+        rijndaelEncrypt(rk_ref, nrounds, in, out_ref);
+        CHECK(memcmp(out, out_ref, 16) == 0);
+    }
+    printf("aes128_bench: %d random vectors match the BTstack reference\n", NB_RANDOM_VECTORS);
+
+    return 0;
+}
+#endif
+
+/**
+ * @brief Throughput benchmark, key setup included as in btstack_aes128_calc()
+ */
+static void bench(void) {
+    uint32_t rk[AES128_RK_WORDS];
+    uint8_t block[16] = { 0 };
+
+    uint64_t start = time_ns();
+    for (int i = 0; i < NB_BENCH_BLOCKS; i++) {
+        aes128_setup(rk, aes128_kat[0][0]);
+        aes128_encrypt(rk, block, block);
+    }
+    uint64_t elapsed = time_ns() - start;
+    printf("aes128_bench: setup+encrypt %.0f blocks/s, %.1f ns/block (%02x)\n",
+           NB_BENCH_BLOCKS * 1e9 / (double)elapsed, (double)elapsed / NB_BENCH_BLOCKS, block[0]);
+
+#ifdef HAVE_RIJNDAEL
+    uint32_t rk_ref[RKLENGTH(128)];
+    start = time_ns();
+    for (int i = 0; i < NB_BENCH_BLOCKS; i++) {
+        int nrounds = rijndaelSetupEncrypt(rk_ref, aes128_kat[0][0], 128);
+        rijndaelEncrypt(rk_ref, nrounds, block, block);
+    }
+    elapsed = time_ns() - start;
+    printf("aes128_bench: reference     %.0f blocks/s, %.1f ns/block (%02x)\n",
+           NB_BENCH_BLOCKS * 1e9 / (double)elapsed, (double)elapsed / NB_BENCH_BLOCKS, block[0]);
+#endif
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(void)
+{
+    if (test_kat()) { return 1; }
+#ifdef HAVE_RIJNDAEL
+    if (test_reference()) { return 1; }
+#endif
+    bench();
+
+    printf("aes128_bench: PASS\n");
+    return 0;
+}
@@ -0,0 +1,712 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: att_harness.cpp
+-- Description: End-to-end ATT tests and throughput of the control service:
+--              raw ATT PDUs through the BTstack attribute database
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "protocol.hpp"
+
+extern "C" {
+#include "btstack_config.h"
+#include "btstack_util.h"
+#include "ble/att_db.h"
+#include "gatt_service.h"
+#include "motion.h"
+#include "deadman.h"
+#include "power.h"
+#include "cpuprof.h"
+#include "ecc_keys.h"
+#include "mem_report.h"
+#include "ota.h"
+#include "params.h"
+#include "crc32.h"
+}
+
+// The mock transport stands for HCI/L2CAP and att_server.c: a request PDU
+// goes to att_handle_request() and the response PDU comes back, then the
+// pending relay change is handled as the firmware motion worker does. The
+// handles are found with the discovery procedures, as a central does.
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define NB_BENCH_ROUNDS     200000
+#define CON_HANDLE          0x0040
+#define MAX_PDU_SIZE        (HCI_ACL_PAYLOAD_SIZE - 4)
+
+// ATT opcodes
+#define ATT_OP_ERROR                0x01
+#define ATT_OP_MTU_REQUEST          0x02
+#define ATT_OP_MTU_RESPONSE         0x03
+#define ATT_OP_FIND_INFO_REQUEST    0x04
+#define ATT_OP_FIND_INFO_RESPONSE   0x05
+#define ATT_OP_READ_TYPE_REQUEST    0x08
+#define ATT_OP_READ_TYPE_RESPONSE   0x09
+#define ATT_OP_READ_REQUEST         0x0A
+#define ATT_OP_READ_RESPONSE        0x0B
+#define ATT_OP_READ_BLOB_REQUEST    0x0C
+#define ATT_OP_READ_BLOB_RESPONSE   0x0D
+#define ATT_OP_WRITE_REQUEST        0x12
+#define ATT_OP_WRITE_RESPONSE       0x13
+#define ATT_OP_NOTIFICATION         0x1B
+#define ATT_OP_WRITE_COMMAND        0x52
+
+#define UUID_CHARACTERISTIC         0x2803
+#define UUID_CLIENT_CONFIGURATION   0x2902
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    uint16_t uuid16;        /**> 16-bit alias of the characteristic UUID */
+    uint16_t value_handle;  /**> Value handle */
+    uint8_t properties;     /**> Characteristic properties */
+} characteristic_t;
+
+typedef struct {
+    uint64_t nb_pdus;       /**> Number of request and response PDUs */
+    uint64_t total_ns;      /**> Cumulated request latency */
+    uint64_t max_ns;        /**> Worst request latency */
+} latency_t;
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+/** @brief Application state behind the service */
+static motion_t motion;
+static deadman_t deadman;
+static power_manager_t power;
+static cpuprof_t cpuprof;
+static ecc_profile_t ecc_profile;
+static ota_t ota;
+static params_t params;
+
+/** @brief Flash behind the update receiver: bank A, bank B, update record */
+static uint8_t flash_memory[OTA_META_OFFSET + OTA_SECTOR_SIZE];
+
+/** @brief Simulated time since boot */
+static uint64_t now_us = 0;
+
+/** @brief Relay change waiting for the motion worker */
+static bool update_pending = false;
+
+/** @brief Link bonded, as the application checks it */
+static bool link_bonded = false;
+
+/** @brief Mock ATT bearer */
+static att_connection_t connection;
+
+/** @brief Last response PDU */
+static uint8_t response[MAX_PDU_SIZE];
+static uint16_t response_len = 0;
+
+/** @brief Last notification PDU and number of notifications */
+static uint8_t notification[MAX_PDU_SIZE];
+static uint16_t notification_len = 0;
+static uint32_t nb_notifications = 0;
+
+/** @brief Discovered characteristics */
+static characteristic_t characteristics[16];
+static int nb_characteristics = 0;
+
+//----------------------------------------------------------------
+// Firmware stubs
+//----------------------------------------------------------------
+
+extern "C" {
+
+/**
+ * @brief att_server.c: the notification PDU is captured, truncated to the MTU
+ */
+uint8_t att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t * value, uint16_t value_len) {
+    if (con_handle != connection.con_handle) { return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER; }
+    uint16_t len = btstack_min(value_len, connection.mtu - 3);
+    notification[0] = ATT_OP_NOTIFICATION;
+    little_endian_store_16(notification, 1, attribute_handle);
+    memcpy(&notification[3], value, len);
+    notification_len = 3 + len;
+    nb_notifications++;
+    return ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief ecc_keys.c: empty profile
+ */
+const ecc_profile_t * ecc_keys_get_profile(void) {
+    return &ecc_profile;
+}
+
+/**
+ * @brief mem_report.c: byte index pattern, to check long reads
+ */
+void mem_report_get_record(uint8_t * record) {
+    for (int i = 0; i < MEM_REPORT_RECORD_SIZE; i++) { record[i] = (uint8_t)i; }
+}
+
+}
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+static uint64_t time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Relays driver: nothing to drive
+ */
+static void motion_output(uint8_t relays, void * context) {
+    (void)relays;
+    (void)context;
+}
+
+/**
+ * @brief Flash operations: erase to 0xFF, program clears bits only
+ */
+static bool flash_erase(uint32_t offset, uint32_t size, void * context) {
+    (void)context;
+    memset(&flash_memory[offset], 0xFF, size);
+    return true;
+}
+
+static bool flash_program(uint32_t offset, const uint8_t * data, uint32_t size, void * context) {
+    (void)context;
+    for (uint32_t i = 0; i < size; i++) { flash_memory[offset + i] &= data[i]; }
+    return true;
+}
+
+/**
+ * @brief Flash writes allowed while the relays are off, as the firmware
+ */
+static bool flash_allowed(void * context) {
+    (void)context;
+    return !motion_is_moving(&motion);
+}
+
+static const ota_flash_t harness_flash = { flash_memory, &flash_erase, &flash_program, NULL, &flash_allowed };
+
+/**
+ * @brief Update receiver event: handled with the relay changes
+ */
+static void ota_event(void * context) {
+    (void)context;
+    update_pending = true;
+}
+
+/**
+ * @brief Control service handlers, without the deadman
+ */
+static void command_apply(hci_con_handle_t con_handle, uint8_t command) {
+    motion_command(&motion, command, MOTION_SOURCE_BLE);
+    update_pending = true;
+}
+
+static void activity(void) {
+    power_notify(&power, POWER_EVENT_ATT_WRITE, now_us);
+}
+
+static uint64_t time_us(void) {
+    return now_us;
+}
+
+static bool link_secured(hci_con_handle_t con_handle) {
+    return (con_handle == connection.con_handle) && (connection.encryption_key_size == 16) && connection.authenticated && link_bonded;
+}
+
+/**
+ * @brief New connection at the default MTU, application state reset
+ */
+static void harness_connect(void) {
+    motion_init(&motion, &motion_output, NULL);
+    deadman_init(&deadman);
+    power_init(&power, 0);
+    cpuprof_init(&cpuprof);
+    ota_init(&ota, &harness_flash, &ota_event, NULL);
+    params_init(&params, NULL, NULL);
+
+    gatt_service_config_t config = {};
+    config.motion = &motion;
+    config.deadman = &deadman;
+    config.power = &power;
+    config.cpuprof = &cpuprof;
+    config.ota = &ota;
+    config.params = &params;
+    config.command = &command_apply;
+    config.activity = &activity;
+    config.now_us = &time_us;
+    config.secured = &link_secured;
+    gatt_service_init(&config);
+
+    att_set_db(gatt_service_get_db());
+    att_set_read_callback(&gatt_service_read);
+    att_set_write_callback(&gatt_service_write);
+
+    memset(&connection, 0, sizeof(connection));
+    link_bonded = false;
+    connection.con_handle = CON_HANDLE;
+    connection.mtu = ATT_DEFAULT_MTU;
+    connection.max_mtu = MAX_PDU_SIZE;
+    gatt_service_connected(CON_HANDLE);
+    power_notify(&power, POWER_EVENT_CONNECTED, now_us);
+}
+
+/**
+ * @brief Send a request or command PDU, then run the motion worker
+ *
+ * @return uint16_t The response size, 0 for a command
+ */
+static uint16_t transact(const uint8_t * request, uint16_t request_len) {
+    uint8_t pdu[MAX_PDU_SIZE];
+    memcpy(pdu, request, request_len);
+    response_len = att_handle_request(&connection, pdu, request_len, response);
+    if (update_pending) {
+        update_pending = false;
+        ota_flush(&ota);
+        gatt_service_update();
+    }
+    now_us += 1000;
+    return response_len;
+}
+
+/**
+ * @brief Exchange MTU request, then the event att_server.c would emit
+ */
+static uint16_t exchange_mtu(uint16_t mtu) {
+    uint8_t request[3] = { ATT_OP_MTU_REQUEST };
+    little_endian_store_16(request, 1, mtu);
+    uint16_t len = transact(request, sizeof(request));
+    gatt_service_set_mtu(connection.mtu);
+    return len;
+}
+
+/**
+ * @brief Read request (offset 0) or read blob request
+ */
+static uint16_t read_value(uint16_t handle, uint16_t offset) {
+    uint8_t request[5] = { (uint8_t)((offset == 0) ? ATT_OP_READ_REQUEST : ATT_OP_READ_BLOB_REQUEST) };
+    little_endian_store_16(request, 1, handle);
+    little_endian_store_16(request, 3, offset);
+    return transact(request, (offset == 0) ? 3 : 5);
+}
+
+/**
+ * @brief Write request or write command
+ */
+static uint16_t write_value(uint8_t opcode, uint16_t handle, const uint8_t * value, uint16_t len) {
+    uint8_t request[MAX_PDU_SIZE];
+    request[0] = opcode;
+    little_endian_store_16(request, 1, handle);
+    memcpy(&request[3], value, len);
+    return transact(request, 3 + len);
+}
+
+/**
+ * @brief Discover the characteristics with Read By Type requests
+ */
+static int discover(void) {
+    uint16_t start = 0x0001;
+    nb_characteristics = 0;
+
+    while (true) {
+        uint8_t request[7] = { ATT_OP_READ_TYPE_REQUEST };
+        little_endian_store_16(request, 1, start);
+        little_endian_store_16(request, 3, 0xFFFF);
+        little_endian_store_16(request, 5, UUID_CHARACTERISTIC);
+        CHECK(transact(request, sizeof(request)) > 0);
+        if (response[0] == ATT_OP_ERROR) {
+            CHECK(response[4] == ATT_ERROR_ATTRIBUTE_NOT_FOUND);
+            break;
+        }
+        CHECK(response[0] == ATT_OP_READ_TYPE_RESPONSE);
+
+        // Declaration handle, properties, value handle, 16 or 128-bit UUID
+        uint8_t entry_len = response[1];
+        CHECK((entry_len == 7) || (entry_len == 21));
+        for (uint16_t pos = 2; pos + entry_len <= response_len; pos += entry_len) {
+            CHECK(nb_characteristics < 16);
+            characteristic_t * c = &characteristics[nb_characteristics++];
+            c->properties = response[pos + 2];
+            c->value_handle = little_endian_read_16(response, pos + 3);
+            c->uuid16 = little_endian_read_16(response, pos + ((entry_len == 7) ? 5 : 5 + 12));
+            start = little_endian_read_16(response, pos) + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Value handle of a discovered characteristic, 0 if absent
+ */
+static uint16_t value_handle(uint16_t uuid16) {
+    for (int i = 0; i < nb_characteristics; i++) {
+        if (characteristics[i].uuid16 == uuid16) { return characteristics[i].value_handle; }
+    }
+    return 0;
+}
+
+/**
+ * @brief Enable the notifications of a characteristic: its client
+ *        configuration descriptor follows the value
+ */
+static int enable_notifications(uint16_t handle) {
+    uint8_t request[5] = { ATT_OP_FIND_INFO_REQUEST };
+    little_endian_store_16(request, 1, handle + 1);
+    little_endian_store_16(request, 3, handle + 1);
+    CHECK(transact(request, sizeof(request)) > 0);
+    CHECK(response[0] == ATT_OP_FIND_INFO_RESPONSE);
+    CHECK(little_endian_read_16(response, 4) == UUID_CLIENT_CONFIGURATION);
+
+    uint8_t ccc[2] = { 0x01, 0x00 };
+    CHECK(write_value(ATT_OP_WRITE_REQUEST, handle + 1, ccc, 2) == 1);
+    CHECK(response[0] == ATT_OP_WRITE_RESPONSE);
+    return 0;
+}
+
+/**
+ * @brief Decode the telemetry of a read response or a notification
+ */
+static int check_telemetry(const uint8_t * value, uint16_t len, protocol::Telemetry & telemetry) {
+    CHECK(protocol::decode_telemetry(value, len, telemetry) == protocol::Status::Ok);
+    return 0;
+}
+
+/**
+ * @brief Discovery, MTU exchange, reads and writes of the control service
+ */
+static int test_service(void) {
+    harness_connect();
+    CHECK(discover() == 0);
+
+    uint16_t control = value_handle(0xFF11);
+    uint16_t endstop = value_handle(0xFF14);
+    uint16_t memory = value_handle(0xFF15);
+    uint16_t telemetry = value_handle(0xFF17);
+    CHECK(value_handle(0x2A00) != 0);
+    CHECK((control != 0) && (endstop != 0) && (memory != 0) && (telemetry != 0));
+    CHECK(value_handle(0xFF12) != 0);
+    CHECK(value_handle(0xFF13) != 0);
+    CHECK(value_handle(0xFF16) != 0);
+    printf("att_harness: %d characteristics\n", nb_characteristics);
+
+    // Legacy command byte, read back
+    uint8_t legacy = MOTION_UP;
+    CHECK(write_value(ATT_OP_WRITE_COMMAND, control, &legacy, 1) == 0);
+    CHECK(motion.command == MOTION_UP);
+    CHECK(read_value(control, 0) == 2);
+    CHECK((response[0] == ATT_OP_READ_RESPONSE) && (response[1] == MOTION_UP));
+
+    // Command frame, acknowledged in the telemetry
+    uint8_t frame[protocol::kCommandSize];
+    size_t frame_len = protocol::encode_command(0x5A, MOTION_DOWN, frame, sizeof(frame));
+    CHECK(write_value(ATT_OP_WRITE_COMMAND, control, frame, (uint16_t)frame_len) == 0);
+    CHECK(motion.command == MOTION_DOWN);
+
+    protocol::Telemetry state;
+    CHECK(read_value(telemetry, 0) == 1 + protocol::kTelemetrySize);
+    CHECK(check_telemetry(&response[1], response_len - 1, state) == 0);
+    CHECK((state.state == MOTION_DOWN) && (state.ack == 0x5A));
+
+    // Unsupported frame version: discarded, as any failed write command
+    uint8_t bad[3] = { 0x7F, 0x01, 0x00 };
+    CHECK(write_value(ATT_OP_WRITE_COMMAND, control, bad, sizeof(bad)) == 0);
+    CHECK(motion.command == MOTION_DOWN);
+
+    // Client configuration: a value of another size is rejected, notifications stay off
+    uint8_t short_ccc = 0x01;
+    CHECK(write_value(ATT_OP_WRITE_REQUEST, telemetry + 1, &short_ccc, 1) == 5);
+    CHECK((response[0] == ATT_OP_ERROR) && (response[4] == ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH));
+    uint32_t nb_before = nb_notifications;
+    legacy = MOTION_STOP;
+    CHECK(write_value(ATT_OP_WRITE_COMMAND, control, &legacy, 1) == 0);
+    CHECK(nb_notifications == nb_before);
+
+    // Notifications: relay change and end-stop
+    legacy = MOTION_DOWN;
+    CHECK(write_value(ATT_OP_WRITE_COMMAND, control, &legacy, 1) == 0);
+    CHECK(enable_notifications(telemetry) == 0);
+    CHECK(enable_notifications(endstop) == 0);
+    uint32_t nb = nb_notifications;
+    legacy = MOTION_STOP;
+    CHECK(write_value(ATT_OP_WRITE_COMMAND, control, &legacy, 1) == 0);
+    CHECK(nb_notifications == nb + 1);
+    CHECK((notification[0] == ATT_OP_NOTIFICATION) && (little_endian_read_16(notification, 1) == telemetry));
+    CHECK(check_telemetry(&notification[3], notification_len - 3, state) == 0);
+    CHECK(state.state == MOTION_STOP);
+
+    motion_limit(&motion, MOTION_UP, true);
+    gatt_service_update();
+    CHECK(nb_notifications == nb + 3);
+    CHECK(read_value(endstop, 0) == 2);
+    CHECK(response[1] == gatt_service_endstop_status());
+
+    // Command frame repeating the applied command: notified for its acknowledgement
+    nb = nb_notifications;
+    frame_len = protocol::encode_command(0x5B, motion.command, frame, sizeof(frame));
+    CHECK(write_value(ATT_OP_WRITE_COMMAND, control, frame, (uint16_t)frame_len) == 0);
+    CHECK(nb_notifications == nb + 1);
+    CHECK(check_telemetry(&notification[3], notification_len - 3, state) == 0);
+    CHECK((state.state == MOTION_STOP) && (state.ack == 0x5B));
+
+    // Long read of the memory usage at the default MTU, then in one PDU
+    uint8_t record[MEM_REPORT_RECORD_SIZE];
+    uint16_t size = 0;
+    int nb_reads = 0;
+    do {
+        CHECK(read_value(memory, size) > 0);
+        CHECK(response[0] == ((size == 0) ? ATT_OP_READ_RESPONSE : ATT_OP_READ_BLOB_RESPONSE));
+        memcpy(&record[size], &response[1], response_len - 1);
+        size += response_len - 1;
+        nb_reads++;
+    } while ((response_len == connection.mtu) && (size < MEM_REPORT_RECORD_SIZE));
+    CHECK(size == MEM_REPORT_RECORD_SIZE);
+    for (int i = 0; i < MEM_REPORT_RECORD_SIZE; i++) { CHECK(record[i] == (uint8_t)i); }
+
+    CHECK(exchange_mtu(517) == 3);
+    CHECK((response[0] == ATT_OP_MTU_RESPONSE) && (little_endian_read_16(response, 1) == MAX_PDU_SIZE));
+    CHECK(connection.mtu == MAX_PDU_SIZE);
+    CHECK(read_value(memory, 0) == 1 + MEM_REPORT_RECORD_SIZE);
+
+    // Status record in one PDU, with the link parameters
+    uint16_t status = value_handle(0xFF18);
+    CHECK(status != 0);
+    CHECK(read_value(status, 0) == 1 + STATUS_RECORD_SIZE);
+    CHECK((response[1] == STATUS_VERSION) && (response[2] == motion.command) && (response[3] == motion.limits));
+    CHECK(little_endian_read_16(response, 1 + 56) == MAX_PDU_SIZE);
+    printf("att_harness: memory usage read in %d PDUs at MTU %u, 1 at MTU %u\n",
+           nb_reads, ATT_DEFAULT_MTU, connection.mtu);
+
+    // Firmware update at MTU 247: started by a write request, streamed with
+    // write commands, status notified on each sector and once staged
+    uint16_t ota_control_handle = value_handle(0xFF31);
+    uint16_t ota_data_handle = value_handle(0xFF32);
+    CHECK((ota_control_handle != 0) && (ota_data_handle != 0));
+    CHECK(enable_notifications(ota_control_handle) == 0);
+
+    static uint8_t image[3 * OTA_SECTOR_SIZE + 100];
+    for (uint32_t i = 0; i < sizeof(image); i++) { image[i] = (uint8_t)(i * 7 + 3); }
+    uint8_t start[9] = { OTA_CMD_START };
+    little_endian_store_32(start, 1, sizeof(image));
+    little_endian_store_32(start, 5, crc32_update(0, image, sizeof(image)));
+
+    // Not paired, then Just Works: rejected by the attribute database
+    CHECK(write_value(ATT_OP_WRITE_REQUEST, ota_control_handle, start, sizeof(start)) == 5);
+    CHECK((response[0] == ATT_OP_ERROR) && (response[4] == ATT_ERROR_INSUFFICIENT_AUTHENTICATION));
+    connection.encryption_key_size = 16;
+    CHECK(write_value(ATT_OP_WRITE_REQUEST, ota_control_handle, start, sizeof(start)) == 5);
+    CHECK((response[0] == ATT_OP_ERROR) && (response[4] == ATT_ERROR_INSUFFICIENT_AUTHENTICATION));
+
+    // Passkey pairing without bonding: rejected by the service
+    connection.authenticated = 1;
+    CHECK(write_value(ATT_OP_WRITE_REQUEST, ota_control_handle, start, sizeof(start)) == 5);
+    CHECK((response[0] == ATT_OP_ERROR) && (response[4] == ATT_ERROR_INSUFFICIENT_AUTHENTICATION));
+    uint8_t packet[MAX_PDU_SIZE] = { 0 };
+    CHECK(write_value(ATT_OP_WRITE_COMMAND, ota_data_handle, packet, OTA_DATA_HEADER_SIZE + 16) == 0);
+    CHECK((ota.state == OTA_STATE_IDLE) && (ota.received == 0));
+
+    // Bonded, but the sofa is moving: refused until it stops
+    link_bonded = true;
+    uint8_t down = MOTION_DOWN;
+    CHECK(write_value(ATT_OP_WRITE_COMMAND, control, &down, 1) == 0);
+    CHECK(motion_is_moving(&motion));
+    CHECK(write_value(ATT_OP_WRITE_REQUEST, ota_control_handle, start, sizeof(start)) == 5);
+    CHECK((response[0] == ATT_OP_ERROR) && (response[4] == ATT_ERROR_VALUE_NOT_ALLOWED));
+    CHECK((ota.state == OTA_STATE_IDLE) && (ota.error == OTA_ERROR_BUSY));
+    uint8_t stop = MOTION_STOP;
+    CHECK(write_value(ATT_OP_WRITE_COMMAND, control, &stop, 1) == 0);
+    CHECK(write_value(ATT_OP_WRITE_REQUEST, ota_control_handle, start, sizeof(start)) == 1);
+    CHECK(response[0] == ATT_OP_WRITE_RESPONSE);
+    CHECK((little_endian_read_16(notification, 1) == ota_control_handle) && (notification[3] == OTA_STATE_RECEIVING));
+
+    uint16_t chunk = connection.mtu - 3 - OTA_DATA_HEADER_SIZE;
+    for (uint32_t pos = 0; pos < sizeof(image); pos += chunk) {
+        uint16_t len = (uint16_t)btstack_min(chunk, sizeof(image) - pos);
+        little_endian_store_32(packet, 0, pos);
+        memcpy(&packet[OTA_DATA_HEADER_SIZE], &image[pos], len);
+        CHECK(write_value(ATT_OP_WRITE_COMMAND, ota_data_handle, packet, OTA_DATA_HEADER_SIZE + len) == 0);
+    }
+    CHECK(ota.programmed == sizeof(image));
+
+    uint8_t commit = OTA_CMD_COMMIT;
+    CHECK(write_value(ATT_OP_WRITE_REQUEST, ota_control_handle, &commit, 1) == 1);
+    CHECK(notification[3] == OTA_STATE_READY);
+    CHECK(memcmp(&flash_memory[OTA_BANK_B_OFFSET], image, sizeof(image)) == 0);
+    ota_meta_t meta;
+    CHECK(ota_boot_pending(&harness_flash, &meta) && (meta.size == sizeof(image)));
+
+    // Unknown command: rejected with an error response
+    uint8_t unknown = 0x7F;
+    CHECK(write_value(ATT_OP_WRITE_REQUEST, ota_control_handle, &unknown, 1) == 5);
+    CHECK((response[0] == ATT_OP_ERROR) && (response[4] == ATT_ERROR_VALUE_NOT_ALLOWED));
+    CHECK(read_value(ota_control_handle, 0) == 1 + OTA_STATUS_SIZE);
+    CHECK((response[1] == OTA_STATE_ERROR) && (response[2] == OTA_ERROR_COMMAND));
+    printf("att_harness: %u-byte update staged in %u-byte packets\n", (unsigned)sizeof(image), chunk);
+
+    // Parameters: written over a bonded link only, read by anybody
+    uint16_t params_handle = value_handle(0xFF19);
+    CHECK(params_handle != 0);
+    uint8_t apply[] = { PARAMS_CMD_APPLY, PARAM_KEEPALIVE_PERIOD_MS, 200, 0 };
+    link_bonded = false;
+    CHECK(write_value(ATT_OP_WRITE_REQUEST, params_handle, apply, sizeof(apply)) == 5);
+    CHECK((response[0] == ATT_OP_ERROR) && (response[4] == ATT_ERROR_INSUFFICIENT_AUTHENTICATION));
+    CHECK(!params.trial && (params_get(&params, PARAM_KEEPALIVE_PERIOD_MS) == DEADMAN_KEEPALIVE_PERIOD_MS));
+    link_bonded = true;
+    CHECK(write_value(ATT_OP_WRITE_REQUEST, params_handle, apply, sizeof(apply)) == 1);
+    CHECK(params.trial && (params_get(&params, PARAM_KEEPALIVE_PERIOD_MS) == 200));
+    CHECK(read_value(params_handle, 0) == 1 + PARAMS_SNAPSHOT_SIZE);
+
+    // Disconnection: no more notifications
+    gatt_service_disconnected(CON_HANDLE);
+    nb = nb_notifications;
+    motion_limit(&motion, MOTION_UP, false);
+    gatt_service_update();
+    CHECK(nb_notifications == nb);
+
+    return 0;
+}
+
+/**
+ * @brief Time one request
+ */
+static void timed(latency_t * latency, uint16_t (*request)(uint16_t, uint8_t), uint16_t handle, uint8_t arg) {
+    uint64_t start = time_ns();
+    uint16_t len = request(handle, arg);
+    uint64_t elapsed = time_ns() - start;
+    latency->nb_pdus += (len > 0) ? 2 : 1;
+    latency->total_ns += elapsed;
+    if (elapsed > latency->max_ns) { latency->max_ns = elapsed; }
+}
+
+static uint16_t bench_write(uint16_t handle, uint8_t command) {
+    return write_value(ATT_OP_WRITE_COMMAND, handle, &command, 1);
+}
+
+static uint16_t bench_read(uint16_t handle, uint8_t arg) {
+    (void)arg;
+    return read_value(handle, 0);
+}
+
+/**
+ * @brief Print the PDU rate and the request latencies
+ */
+static void bench_report(const char * name, const latency_t * latency, uint64_t nb_requests) {
+    printf("att_harness: %-16s %9.0f PDUs/s, latency avg %6.0f ns, max %8.0f ns\n", name,
+           1e9 * (double)latency->nb_pdus / (double)latency->total_ns,
+           (double)latency->total_ns / (double)nb_requests, (double)latency->max_ns);
+}
+
+/**
+ * @brief Read a whole value: read, then read blobs while the response is full
+ *
+ * @return int The number of round trips
+ */
+static int read_long(uint16_t handle, uint16_t size) {
+    uint16_t offset = 0;
+    int nb = 0;
+    do {
+        offset += read_value(handle, offset) - 1;
+        nb++;
+    } while ((offset < size) && (response_len == connection.mtu));
+    return nb;
+}
+
+/**
+ * @brief Round trips and time of a full status refresh: the control,
+ *        end-stop, power and telemetry values, or the status record
+ */
+static void bench_refresh(uint16_t mtu) {
+    harness_connect();
+    discover();
+    if (mtu != ATT_DEFAULT_MTU) { exchange_mtu(mtu); }
+
+    static const uint16_t uuids[] = { 0xFF11, 0xFF14, 0xFF12, 0xFF17 };
+    static const uint16_t sizes[] = { 1, 1, 28, protocol::kTelemetrySize };
+    uint16_t status = value_handle(0xFF18);
+    int before = 0;
+    int after = 0;
+    uint64_t before_ns = 0;
+    uint64_t after_ns = 0;
+
+    for (int i = 0; i < NB_BENCH_ROUNDS / 10; i++) {
+        uint64_t start = time_ns();
+        before = 0;
+        for (int j = 0; j < 4; j++) { before += read_long(value_handle(uuids[j]), sizes[j]); }
+        uint64_t middle = time_ns();
+        after = read_long(status, STATUS_RECORD_SIZE);
+        after_ns += time_ns() - middle;
+        before_ns += middle - start;
+    }
+    printf("att_harness: refresh at MTU %3u: 4 characteristics %d round trips (%4.0f ns), status record %d (%4.0f ns)\n",
+           connection.mtu, before, (double)before_ns / (NB_BENCH_ROUNDS / 10), after, (double)after_ns / (NB_BENCH_ROUNDS / 10));
+}
+
+/**
+ * @brief Throughput: write commands with notification, telemetry reads
+ */
+static void bench(void) {
+    harness_connect();
+    discover();
+    enable_notifications(value_handle(0xFF17));
+
+    uint16_t control = value_handle(0xFF11);
+    uint16_t telemetry = value_handle(0xFF17);
+    latency_t writes = {};
+    latency_t reads = {};
+    for (int i = 0; i < NB_BENCH_ROUNDS; i++) {
+        timed(&writes, &bench_write, control, (i & 1) ? MOTION_UP : MOTION_STOP);
+        timed(&reads, &bench_read, telemetry, 0);
+    }
+    bench_report("write_command", &writes, NB_BENCH_ROUNDS);
+    bench_report("read_telemetry", &reads, NB_BENCH_ROUNDS);
+
+    bench_refresh(ATT_DEFAULT_MTU);
+    bench_refresh(247);
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(void)
+{
+    if (test_service()) { return 1; }
+    bench();
+
+    printf("att_harness: PASS\n");
+    return 0;
+}
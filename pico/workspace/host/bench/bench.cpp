@@ -0,0 +1,437 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: bench.cpp
+-- Description: Micro-benchmarks of the firmware hot paths, compared against
+--              a recorded baseline
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "protocol.hpp"
+
+extern "C" {
+#include "crc32.h"
+#include "motion.h"
+#include "deadman.h"
+#include "oled_fb.h"
+}
+
+// Each benchmark run of at least MIN_RUN_NS is paired with a run of a
+// calibration loop (CRC-32 of 256 bytes), and the median of NB_REPEATS
+// time ratios is kept: a slower or loaded host slows both down. The
+// baseline records the calibration time and, per benchmark, its time and
+// its regression margin, widened by the spread of the repeated runs; the
+// times measured on another host are scaled to the baseline calibration.
+// A benchmark over its margin is measured NB_RETRIES more times, and the
+// median of the measurements is kept.
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define MIN_RUN_NS          2000000ULL
+#define NB_REPEATS          21
+#define NB_RETRIES          2
+#define MAX_LINE_SIZE       256
+#define DEFAULT_THRESHOLD   50
+/** @brief Recorded margin: this many times the spread of the repeated runs, at least the threshold */
+#define NOISE_FACTOR        4
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef uint32_t (*bench_body_t)(uint32_t nb_ops);
+
+typedef struct {
+    const char * name;  /**> Benchmark name, baseline key */
+    bench_body_t body;  /**> Runs nb_ops operations, returns a checksum */
+    double ns_per_op;   /**> Time per operation, at the calibration time */
+    double noise;       /**> Interquartile range of the repeated runs, relative to the median (%) */
+} bench_t;
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+/** @brief Checksums sink, keeps the results alive */
+static volatile uint32_t sink;
+
+static uint8_t calibration_data[256];
+static oled_fb_t fb;
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Make a value, and the memory it may point to, observable: each
+ *        iteration must then be computed and cannot be hoisted or folded
+ *        out of its loop
+ */
+template <typename T>
+static inline void do_not_optimize(T const & value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+static uint64_t time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Relay outputs stub
+ */
+static void relays_output(uint8_t relays, void * context) {
+    *(uint8_t *)context = relays;
+}
+
+/**
+ * @brief Calibration loop: CRC-32 of 256 bytes
+ */
+static uint32_t bench_calibration(uint32_t nb_ops) {
+    uint32_t crc = 0;
+    for (uint32_t i = 0; i < nb_ops; i++) {
+        calibration_data[0] = (uint8_t)i;
+        crc = crc32_update(crc, calibration_data, sizeof(calibration_data));
+        do_not_optimize(crc);
+    }
+    return crc;
+}
+
+/**
+ * @brief Legacy single byte command decoding
+ */
+static uint32_t bench_decode_legacy(uint32_t nb_ops) {
+    uint8_t data[1];
+    protocol::Command command;
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < nb_ops; i++) {
+        data[0] = (uint8_t)(i & 0x83);
+        sum += (uint32_t)protocol::decode_command(data, sizeof(data), command) + command.motion;
+        do_not_optimize(sum);
+    }
+    return sum;
+}
+
+/**
+ * @brief Command frame decoding, one Motion record
+ */
+static uint32_t bench_decode_frame(uint32_t nb_ops) {
+    uint8_t frame[protocol::kCommandSize];
+    protocol::Command command;
+    uint32_t sum = 0;
+    protocol::encode_command(0, 0, frame, sizeof(frame));
+    for (uint32_t i = 0; i < nb_ops; i++) {
+        frame[1] = (uint8_t)i;
+        frame[4] = (uint8_t)(i & 0x83);
+        sum += (uint32_t)protocol::decode_command(frame, sizeof(frame), command) + command.motion;
+        do_not_optimize(sum);
+    }
+    return sum;
+}
+
+/**
+ * @brief Telemetry frame encoding
+ */
+static uint32_t bench_encode_telemetry(uint32_t nb_ops) {
+    uint8_t frame[protocol::kTelemetrySize];
+    protocol::Telemetry telemetry{};
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < nb_ops; i++) {
+        telemetry.sequence = (uint8_t)i;
+        telemetry.uptime_ms = i;
+        sum += (uint32_t)protocol::encode_telemetry(telemetry, frame, sizeof(frame)) + frame[i % sizeof(frame)];
+        do_not_optimize(sum);
+    }
+    return sum;
+}
+
+/**
+ * @brief Relay scheduling: commands from every source, with end-stops
+ *        blocking a direction from time to time
+ */
+static uint32_t bench_motion_command(uint32_t nb_ops) {
+    static const uint8_t commands[8] = { MOTION_UP, MOTION_STOP, MOTION_DOWN, MOTION_UP | MOTION_HOLD_TO_RUN,
+                                         MOTION_UP | MOTION_DOWN, MOTION_DOWN | MOTION_HOLD_TO_RUN, MOTION_STOP, MOTION_UP };
+    motion_t motion;
+    uint8_t relays = 0;
+    uint32_t sum = 0;
+    motion_init(&motion, relays_output, &relays);
+    for (uint32_t i = 0; i < nb_ops; i++) {
+        if ((i & 0x3F) == 0) { motion_limit(&motion, (i & 0x40) ? MOTION_UP : MOTION_DOWN, (i & 0x80) != 0); }
+        sum += motion_command(&motion, commands[i & 7], (motion_source_t)(i % MOTION_NB_SOURCES)) + relays;
+        do_not_optimize(sum);
+    }
+    return sum;
+}
+
+/**
+ * @brief Hold-to-run keep-alive and deadline check
+ */
+static uint32_t bench_deadman(uint32_t nb_ops) {
+    deadman_t deadman;
+    uint64_t now = 0;
+    uint32_t sum = 0;
+    deadman_init(&deadman);
+    for (uint32_t i = 0; i < nb_ops; i++) {
+        now += 100000 + (i & 0xFFF);
+        sum += (uint32_t)deadman_kick(&deadman, now);
+        sum += deadman_trip(&deadman, now + 50000);
+        do_not_optimize(sum);
+    }
+    return sum;
+}
+
+/**
+ * @brief Frame buffer rendering: clear and write 4 lines of text
+ */
+static uint32_t bench_fb_text(uint32_t nb_ops) {
+    static const char * lines[OLED_NB_DISPLAY_PAGE] = { "ABCDEFGHIJKLMNOP", "QRSTUVWXYZ012345",
+                                                        "6789abcdefghijkl", "mnopqrstuvwxyz" };
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < nb_ops; i++) {
+        oled_fb_clear(&fb);
+        for (uint32_t page = 0; page < OLED_NB_DISPLAY_PAGE; page++) { oled_fb_write_str(&fb, lines[page], page); }
+        sum += fb.gddram[i % OLED_FB_SIZE];
+        do_not_optimize(sum);
+    }
+    return sum;
+}
+
+/**
+ * @brief Frame buffer rendering: every pixel of the screen
+ */
+static uint32_t bench_fb_pixels(uint32_t nb_ops) {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < nb_ops; i++) {
+        for (uint32_t row = 0; row < OLED_NB_DISPLAY_ROW; row++) {
+            for (uint32_t col = 0; col < OLED_NB_DISPLAY_COL; col++) {
+                oled_fb_set_pixel(&fb, row, col, ((row + col + i) & 1) != 0);
+            }
+        }
+        sum += fb.gddram[i % OLED_FB_SIZE];
+        do_not_optimize(sum);
+    }
+    return sum;
+}
+
+/**
+ * @brief OLED flush encoding of the 4 pages
+ */
+static uint32_t bench_oled_flush(uint32_t nb_ops) {
+    uint8_t msg[OLED_FLUSH_PAGE_SIZE];
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < nb_ops; i++) {
+        fb.gddram[i % OLED_FB_SIZE] = (uint8_t)i;
+        for (uint32_t page = 0; page < OLED_NB_DISPLAY_PAGE; page++) {
+            sum += (uint32_t)oled_fb_encode_page(&fb, page, msg) + msg[i % OLED_FLUSH_PAGE_SIZE];
+        }
+        do_not_optimize(sum);
+    }
+    return sum;
+}
+
+/**
+ * @brief Number of operations of a run lasting at least MIN_RUN_NS
+ */
+static uint32_t calibrate(bench_body_t body) {
+    uint32_t nb_ops = 1;
+    for (;;) {
+        uint64_t start = time_ns();
+        sink = body(nb_ops);
+        if ((time_ns() - start >= MIN_RUN_NS) || (nb_ops >= 0x40000000)) { return nb_ops; }
+        nb_ops *= 2;
+    }
+}
+
+/**
+ * @brief Time per operation of one run
+ */
+static double run(bench_body_t body, uint32_t nb_ops) {
+    uint64_t start = time_ns();
+    sink = body(nb_ops);
+    return (double)(time_ns() - start) / nb_ops;
+}
+
+/**
+ * @brief Sort doubles in increasing order
+ */
+static int compare_double(const void * a, const void * b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+/**
+ * @brief Median ratio of the benchmark time to the calibration time
+ * @param noise Output interquartile range of the ratios, relative to the median (%)
+ */
+static double measure(bench_body_t body, bench_body_t calibration_body, double * noise) {
+    uint32_t nb_ops = calibrate(body);
+    uint32_t nb_calibration_ops = calibrate(calibration_body);
+    double ratios[NB_REPEATS];
+
+    for (int i = 0; i < NB_REPEATS; i++) {
+        double calibration = run(calibration_body, nb_calibration_ops);
+        ratios[i] = run(body, nb_ops) / calibration;
+    }
+    qsort(ratios, NB_REPEATS, sizeof(double), compare_double);
+
+    double median = ratios[NB_REPEATS / 2];
+    *noise = 100.0 * (ratios[(3 * NB_REPEATS) / 4] - ratios[NB_REPEATS / 4]) / median;
+    return median;
+}
+
+/**
+ * @brief Look up a benchmark in a baseline file
+ * @param margin Output recorded regression margin (%), 0 if none
+ * @return double The recorded time (ns), 0 if not found
+ */
+static double baseline_lookup(FILE * f, const char * name, double * margin) {
+    char line[MAX_LINE_SIZE];
+    char key[MAX_LINE_SIZE];
+    double ns;
+    double percent;
+
+    rewind(f);
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#') { continue; }
+        int nb_fields = sscanf(line, "%255s %lf %lf", key, &ns, &percent);
+        if ((nb_fields >= 2) && (strcmp(key, name) == 0)) {
+            if (margin != NULL) { *margin = (nb_fields == 3) ? percent : 0.0; }
+            return ns;
+        }
+    }
+    return 0.0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success, 1 if a benchmark regressed
+ */
+int main(int argc, char ** argv)
+{
+    bench_t benches[] = {
+        { "decode_legacy",    bench_decode_legacy,    0, 0 },
+        { "decode_frame",     bench_decode_frame,     0, 0 },
+        { "encode_telemetry", bench_encode_telemetry, 0, 0 },
+        { "motion_command",   bench_motion_command,   0, 0 },
+        { "deadman",          bench_deadman,          0, 0 },
+        { "fb_text",          bench_fb_text,          0, 0 },
+        { "fb_pixels",        bench_fb_pixels,        0, 0 },
+        { "oled_flush",       bench_oled_flush,       0, 0 },
+    };
+    const int nb_benches = (int)(sizeof(benches) / sizeof(benches[0]));
+    const char * baseline = NULL;
+    int threshold = DEFAULT_THRESHOLD;
+    bool update = false;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-b") == 0) && (i + 1 < argc)) { baseline = argv[++i]; }
+        else if ((strcmp(argv[i], "-t") == 0) && (i + 1 < argc)) { threshold = atoi(argv[++i]); }
+        else if (strcmp(argv[i], "-u") == 0) { update = true; }
+        else {
+            fprintf(stderr, "usage: bench [-b baseline] [-t threshold %%] [-u]\n");
+            return 1;
+        }
+    }
+
+    // Calibration time, then benchmark times relative to it
+    double times[NB_REPEATS];
+    uint32_t nb_calibration_ops = calibrate(bench_calibration);
+    for (int i = 0; i < NB_REPEATS; i++) { times[i] = run(bench_calibration, nb_calibration_ops); }
+    qsort(times, NB_REPEATS, sizeof(double), compare_double);
+    double calibration = times[NB_REPEATS / 2];
+    for (int i = 0; i < nb_benches; i++) { benches[i].ns_per_op = measure(benches[i].body, bench_calibration, &benches[i].noise) * calibration; }
+
+    // Record a new baseline
+    if (update) {
+        FILE * f = (baseline != NULL) ? fopen(baseline, "w") : stdout;
+        if (f == NULL) { fprintf(stderr, "bench: cannot write %s\n", baseline); return 1; }
+        fprintf(f, "# Time per operation (ns), calibration: CRC-32 of %u bytes\n", (unsigned)sizeof(calibration_data));
+        fprintf(f, "# Regression margin (%%): %d x the spread of the repeated runs, at least %d\n", NOISE_FACTOR, threshold);
+        fprintf(f, "%-18s %.3f\n", "calibration", calibration);
+        for (int i = 0; i < nb_benches; i++) {
+            double margin = NOISE_FACTOR * benches[i].noise;
+            fprintf(f, "%-18s %-10.3f %.0f\n", benches[i].name, benches[i].ns_per_op, (margin > threshold) ? margin + 0.5 : (double)threshold);
+        }
+        if (f != stdout) { fclose(f); }
+    }
+
+    FILE * f = ((baseline != NULL) && !update) ? fopen(baseline, "r") : NULL;
+    if ((baseline != NULL) && !update && (f == NULL)) { fprintf(stderr, "bench: cannot read %s\n", baseline); return 1; }
+
+    // Times scaled to the baseline host
+    double base_calibration = (f != NULL) ? baseline_lookup(f, "calibration", NULL) : 0.0;
+    double scale = (base_calibration > 0.0) ? base_calibration / calibration : 1.0;
+    printf("bench: calibration %.1f ns, baseline %.1f ns\n", calibration, base_calibration);
+
+    int nb_regressions = 0;
+    printf("  benchmark            ns/op     scaled  noise   baseline    change  margin\n");
+    for (int i = 0; i < nb_benches; i++) {
+        bench_t * b = &benches[i];
+        double margin = 0.0;
+        double reference = (base_calibration > 0.0) ? baseline_lookup(f, b->name, &margin) : 0.0;
+        if (margin < threshold) { margin = threshold; }
+
+        // Over the margin: measured again, the median of the measurements is kept
+        double change = (reference > 0.0) ? 100.0 * (b->ns_per_op * scale / reference - 1.0) : 0.0;
+        if (change > margin) {
+            double retries[NB_RETRIES + 1] = { b->ns_per_op };
+            for (int retry = 1; retry <= NB_RETRIES; retry++) {
+                double noise;
+                retries[retry] = measure(b->body, bench_calibration, &noise) * calibration;
+            }
+            qsort(retries, NB_RETRIES + 1, sizeof(double), compare_double);
+            b->ns_per_op = retries[NB_RETRIES / 2];
+            change = 100.0 * (b->ns_per_op * scale / reference - 1.0);
+        }
+
+        printf("  %-18s %9.2f %10.2f %5.1f%%", b->name, b->ns_per_op, b->ns_per_op * scale, b->noise);
+        if (reference > 0.0) {
+            bool regressed = (change > margin);
+            printf(" %10.2f %+8.1f %% %5.0f %%%s\n", reference, change, margin, regressed ? "  REGRESSION" : "");
+            if (regressed) { nb_regressions++; }
+        }
+        else {
+            printf("          -         -       -\n");
+        }
+    }
+    if (f != NULL) { fclose(f); }
+
+    if (nb_regressions > 0) {
+        printf("bench: %d benchmark(s) slower than the baseline by more than their margin\n", nb_regressions);
+        printf("bench: FAIL\n");
+        return 1;
+    }
+
+    printf("bench: PASS\n");
+    return 0;
+}
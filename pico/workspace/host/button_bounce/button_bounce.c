@@ -0,0 +1,273 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: button_bounce.c
+-- Description: Replay of recorded-like button bounce traces through the
+--              debouncer and the motion command path
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "button.h"
+#include "motion.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define MAX_EDGES    64
+#define MAX_CHANGES  64
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+/** @brief Input edge: level after the edge at a given time */
+typedef struct {
+    uint32_t time_us;
+    bool pressed;
+} edge_t;
+
+/** @brief Relay outputs log */
+typedef struct {
+    uint32_t now_us;
+    int nb_changes;
+    uint8_t relays[MAX_CHANGES];
+    uint32_t time_us[MAX_CHANGES];
+} output_log_t;
+
+/** @brief Replay result */
+typedef struct {
+    int nb_press;
+    int nb_release;
+    bool pressed;
+    uint32_t settled_us;
+} replay_t;
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Relay outputs driver: log every change with its time
+ */
+static void output_record(uint8_t relays, void * context) {
+    output_log_t * log = (output_log_t *)context;
+    if ((log->nb_changes > 0) && (log->relays[log->nb_changes - 1] == relays)) { return; }
+    if (log->nb_changes < MAX_CHANGES) {
+        log->relays[log->nb_changes] = relays;
+        log->time_us[log->nb_changes] = log->now_us;
+        log->nb_changes++;
+    }
+}
+
+/**
+ * @brief Same policy as the firmware: press drives, release of the driven
+ *        direction stops
+ */
+static void apply(motion_t * motion, button_event_t event, replay_t * replay) {
+    if (event == BUTTON_EVENT_PRESS) {
+        replay->nb_press++;
+        motion_command(motion, MOTION_UP, MOTION_SOURCE_BUTTON);
+    }
+    else if (event == BUTTON_EVENT_RELEASE) {
+        replay->nb_release++;
+        if ((motion->command & MOTION_RELAYS_MASK) == MOTION_UP) {
+            motion_command(motion, MOTION_STOP, MOTION_SOURCE_BUTTON);
+        }
+    }
+}
+
+/**
+ * @brief Replay an edge trace: edge interrupts and debounce timer callbacks
+ *        are interleaved in time order, as on the target
+ */
+static void replay_trace(const edge_t * edges, int nb_edges, motion_t * motion,
+                         output_log_t * log, replay_t * replay) {
+    button_t button;
+    bool level = false;
+    uint32_t timer_us = 0;
+    bool timer_armed = false;
+    int i = 0;
+
+    button_init(&button);
+    memset(replay, 0, sizeof(replay_t));
+
+    while ((i < nb_edges) || timer_armed) {
+        // Next event: edge interrupt or debounce timer, whichever comes first
+        if ((i < nb_edges) && (!timer_armed || (edges[i].time_us < timer_us))) {
+            log->now_us = edges[i].time_us;
+            level = edges[i].pressed;
+            bool settling = button.settling;
+            apply(motion, button_edge(&button, level, log->now_us), replay);
+            if (!settling) {
+                timer_armed = true;
+                timer_us = log->now_us + BUTTON_DEBOUNCE_US;
+            }
+            i++;
+        }
+        else {
+            button_event_t event;
+            log->now_us = timer_us;
+            uint32_t delay_us = button_settle(&button, level, log->now_us, &event);
+            apply(motion, event, replay);
+            if (delay_us == 0) {
+                timer_armed = false;
+                replay->settled_us = log->now_us;
+            }
+            else {
+                timer_us += delay_us;
+            }
+        }
+    }
+
+    replay->pressed = button.pressed;
+}
+
+/**
+ * @brief Build a bouncy transition: the contact chatters between both levels
+ *        before it settles on the final one
+ */
+static int make_bounce(edge_t * edges, int n, uint32_t start_us, bool final,
+                       int nb_bounces, uint32_t bounce_us) {
+    for (int b = 0; b < nb_bounces; b++) {
+        edges[n].time_us = start_us + 2 * b * bounce_us;
+        edges[n].pressed = final;
+        n++;
+        edges[n].time_us = start_us + (2 * b + 1) * bounce_us;
+        edges[n].pressed = !final;
+        n++;
+    }
+    edges[n].time_us = start_us + 2 * nb_bounces * bounce_us;
+    edges[n].pressed = final;
+    return n + 1;
+}
+
+/**
+ * @brief Bouncy press then bouncy release: one event each, zero press latency
+ */
+static int test_bouncy_press_release(void) {
+    edge_t edges[MAX_EDGES];
+    motion_t motion;
+    output_log_t log = {0};
+    replay_t replay;
+
+    int n = make_bounce(edges, 0, 1000, true, 6, 150);
+    n = make_bounce(edges, n, 400000, false, 8, 200);
+
+    motion_init(&motion, &output_record, &log);
+    replay_trace(edges, n, &motion, &log, &replay);
+
+    CHECK(replay.nb_press == 1);
+    CHECK(replay.nb_release == 1);
+    CHECK(!replay.pressed);
+
+    // Off (init), on at the very first edge, off at the first release edge
+    CHECK(log.nb_changes == 3);
+    CHECK(log.relays[1] == MOTION_UP);
+    CHECK(log.time_us[1] == edges[0].time_us);
+    CHECK(log.relays[2] == MOTION_STOP);
+    CHECK(log.time_us[2] == 400000);
+
+    return 0;
+}
+
+/**
+ * @brief Slow bounces, longer than the first debounce window would allow:
+ *        the timer re-arms itself until the level is quiet
+ */
+static int test_slow_bounce(void) {
+    edge_t edges[MAX_EDGES];
+    motion_t motion;
+    output_log_t log = {0};
+    replay_t replay;
+
+    int n = make_bounce(edges, 0, 0, true, 5, BUTTON_DEBOUNCE_US - 1000);
+
+    motion_init(&motion, &output_record, &log);
+    replay_trace(edges, n, &motion, &log, &replay);
+
+    CHECK(replay.nb_press == 1);
+    CHECK(replay.nb_release == 0);
+    CHECK(replay.pressed);
+    CHECK(motion.command == MOTION_UP);
+    CHECK(replay.settled_us == edges[n - 1].time_us + BUTTON_DEBOUNCE_US);
+
+    return 0;
+}
+
+/**
+ * @brief A short noise spike is applied, then reverted by the confirmation
+ */
+static int test_noise_spike(void) {
+    edge_t edges[2] = {{ 1000, true }, { 1020, false }};
+    motion_t motion;
+    output_log_t log = {0};
+    replay_t replay;
+
+    motion_init(&motion, &output_record, &log);
+    replay_trace(edges, 2, &motion, &log, &replay);
+
+    CHECK(replay.nb_press == 1);
+    CHECK(replay.nb_release == 1);
+    CHECK(!replay.pressed);
+    CHECK(motion.command == MOTION_STOP);
+    CHECK(log.time_us[log.nb_changes - 1] == 1020 + BUTTON_DEBOUNCE_US);
+
+    return 0;
+}
+
+/**
+ * @brief Both directions requested together never drive both relays
+ */
+static int test_interlock(void) {
+    motion_t motion;
+    output_log_t log = {0};
+
+    motion_init(&motion, &output_record, &log);
+    CHECK(motion_command(&motion, MOTION_UP | MOTION_HOLD_TO_RUN, MOTION_SOURCE_BLE) == MOTION_UP);
+    CHECK(motion.command == (MOTION_UP | MOTION_HOLD_TO_RUN));
+    CHECK(motion_command(&motion, MOTION_RELAYS_MASK, MOTION_SOURCE_BLE) == MOTION_STOP);
+    CHECK(!motion_is_moving(&motion));
+    CHECK(motion.nb_rejected == 1);
+    CHECK(motion.nb_commands[MOTION_SOURCE_BLE] == 2);
+
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(void)
+{
+    if (test_bouncy_press_release()) { return 1; }
+    if (test_slow_bounce()) { return 1; }
+    if (test_noise_spike()) { return 1; }
+    if (test_interlock()) { return 1; }
+
+    printf("button_bounce: PASS\n");
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: cpuprof.c
+-- Description: Run loop CPU profiler: nesting, wrapping cycle counter and
+--              snapshot layout
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+
+#include "cpuprof.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Read a 32-bit little-endian value
+ */
+static uint32_t read_32(const uint8_t * buffer) {
+    return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+/**
+ * @brief Nested handlers: the poll self time excludes the handlers it calls
+ */
+static int test_nesting(void) {
+    cpuprof_t prof;
+    uint32_t t = 0xFFFFF000u; // Wraps during the test
+
+    cpuprof_init(&prof);
+
+    for (int i = 0; i < 10; i++) {
+        cpuprof_enter(&prof, CPUPROF_SLOT_POLL, t);
+        t += 300;
+        cpuprof_enter(&prof, CPUPROF_SLOT_HCI_EVENT, t);
+        t += 1000;
+        cpuprof_exit(&prof, t);
+        t += 200;
+        cpuprof_enter(&prof, CPUPROF_SLOT_ATT_WRITE, t);
+        t += 400;
+        cpuprof_enter(&prof, CPUPROF_SLOT_WORKER, t);
+        t += 100 * (i + 1);
+        cpuprof_exit(&prof, t);
+        cpuprof_exit(&prof, t);
+        cpuprof_exit(&prof, t);
+        t += 10000 - (1900 + 100 * (i + 1));
+        cpuprof_account(&prof, 10000);
+    }
+
+    CHECK(prof.depth == 0);
+    CHECK(prof.slots[CPUPROF_SLOT_POLL].count == 10);
+    CHECK(prof.slots[CPUPROF_SLOT_POLL].self_cycles == 10 * 500);
+    CHECK(prof.slots[CPUPROF_SLOT_POLL].max_cycles == 1900 + 1000);
+    CHECK(prof.slots[CPUPROF_SLOT_HCI_EVENT].self_cycles == 10 * 1000);
+    CHECK(prof.slots[CPUPROF_SLOT_ATT_WRITE].self_cycles == 10 * 400);
+    CHECK(prof.slots[CPUPROF_SLOT_ATT_WRITE].max_cycles == 400 + 1000);
+    CHECK(prof.slots[CPUPROF_SLOT_WORKER].self_cycles == 100 * 55);
+    CHECK(prof.slots[CPUPROF_SLOT_WORKER].max_cycles == 1000);
+
+    // Self times and idle add up to the window
+    uint64_t busy = 0;
+    for (int i = 0; i < CPUPROF_NB_SLOTS; i++) { busy += prof.slots[i].self_cycles; }
+    CHECK(busy == prof.busy_cycles);
+    CHECK(busy + cpuprof_idle_cycles(&prof) == prof.window_cycles);
+
+    return 0;
+}
+
+/**
+ * @brief Nesting deeper than the tracked depth is left to the enclosing handler
+ */
+static int test_overflow(void) {
+    cpuprof_t prof;
+    uint32_t t = 0;
+
+    cpuprof_init(&prof);
+    for (int i = 0; i < CPUPROF_MAX_DEPTH + 2; i++) { cpuprof_enter(&prof, CPUPROF_SLOT_TIMER, t); t += 10; }
+    for (int i = 0; i < CPUPROF_MAX_DEPTH + 2; i++) { cpuprof_exit(&prof, t); }
+    cpuprof_exit(&prof, t); // Unbalanced exit is ignored
+
+    CHECK(prof.depth == 0);
+    CHECK(prof.nb_overflows == 2);
+    CHECK(prof.slots[CPUPROF_SLOT_TIMER].count == CPUPROF_MAX_DEPTH);
+    CHECK(prof.slots[CPUPROF_SLOT_TIMER].self_cycles == (CPUPROF_MAX_DEPTH + 2) * 10);
+
+    return 0;
+}
+
+/**
+ * @brief Snapshot layout and reset
+ */
+static int test_snapshot(void) {
+    cpuprof_t prof;
+    uint8_t snapshot[CPUPROF_SNAPSHOT_SIZE];
+
+    cpuprof_init(&prof);
+    cpuprof_enter(&prof, CPUPROF_SLOT_ATT_READ, 0);
+    cpuprof_exit(&prof, 1000000);
+    cpuprof_account(&prof, 5000000);
+    cpuprof_snapshot(&prof, snapshot);
+
+    CHECK(snapshot[0] == CPUPROF_VERSION);
+    CHECK(snapshot[1] == CPUPROF_NB_SLOTS);
+    CHECK(read_32(&snapshot[4]) == 5000);
+    CHECK(read_32(&snapshot[8]) == 4000);
+    const uint8_t * record = &snapshot[CPUPROF_HEADER_SIZE + CPUPROF_SLOT_SIZE * CPUPROF_SLOT_ATT_READ];
+    CHECK(read_32(&record[0]) == 1);
+    CHECK(read_32(&record[4]) == 1000);
+    CHECK(read_32(&record[8]) == 1000000);
+
+    // Reset during a handler: the handler is still accounted on exit
+    cpuprof_enter(&prof, CPUPROF_SLOT_ATT_WRITE, 0);
+    cpuprof_reset(&prof);
+    cpuprof_exit(&prof, 50);
+    CHECK(prof.slots[CPUPROF_SLOT_ATT_READ].count == 0);
+    CHECK(prof.slots[CPUPROF_SLOT_ATT_WRITE].count == 1);
+    CHECK(prof.window_cycles == 0);
+    CHECK(cpuprof_idle_cycles(&prof) == 0);
+
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(void)
+{
+    if (test_nesting()) { return 1; }
+    if (test_overflow()) { return 1; }
+    if (test_snapshot()) { return 1; }
+
+    printf("cpuprof: PASS\n");
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: cpuprof_view.c
+-- Description: Flat profile of a CPU profile snapshot read from the CPU
+--              profile characteristic.
+--              Usage: cpuprof_view <hex string | file>
+--              The file holds the raw snapshot or its hex dump; the hex
+--              dump may contain spaces, '-' or ':' separators and a 0x prefix.
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpuprof.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define MAX_SNAPSHOT_SIZE 512
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    int slot;
+    uint32_t calls;
+    uint32_t self_kcycles;
+    uint32_t max_cycles;
+} row_t;
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Read a 32-bit little-endian value
+ */
+static uint32_t read_32(const uint8_t * buffer) {
+    return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+/**
+ * @brief Decode a hex dump, separators ignored
+ * @return int Number of bytes, -1 if the text is not hex
+ */
+static int hex_decode(const char * text, size_t len, uint8_t * out, int size) {
+    int n = 0;
+    int nibble = -1;
+
+    for (size_t i = 0; i < len; i++) {
+        char c = text[i];
+        if ((c == '0') && (i + 1 < len) && ((text[i + 1] == 'x') || (text[i + 1] == 'X'))) { i++; continue; }
+        if (isspace((unsigned char)c) || (c == ':') || (c == '-') || (c == ',')) { continue; }
+        if (!isxdigit((unsigned char)c)) { return -1; }
+        int v = isdigit((unsigned char)c) ? c - '0' : tolower((unsigned char)c) - 'a' + 10;
+        if (nibble < 0) { nibble = v; continue; }
+        if (n == size) { return -1; }
+        out[n++] = (uint8_t)((nibble << 4) | v);
+        nibble = -1;
+    }
+
+    return (nibble < 0) ? n : -1;
+}
+
+/**
+ * @brief Load the snapshot from a file (raw or hex) or from the argument
+ */
+static int load(const char * arg, uint8_t * snapshot) {
+    static char text[4 * MAX_SNAPSHOT_SIZE];
+    FILE * f = fopen(arg, "rb");
+
+    if (f == NULL) { return hex_decode(arg, strlen(arg), snapshot, MAX_SNAPSHOT_SIZE); }
+
+    size_t len = fread(text, 1, sizeof(text), f);
+    fclose(f);
+
+    int n = hex_decode(text, len, snapshot, MAX_SNAPSHOT_SIZE);
+    if (n >= 0) { return n; }
+    if (len > MAX_SNAPSHOT_SIZE) { return -1; }
+    memcpy(snapshot, text, len);
+    return (int)len;
+}
+
+/**
+ * @brief Sort by decreasing self time
+ */
+static int compare_self(const void * a, const void * b) {
+    const row_t * ra = (const row_t *)a;
+    const row_t * rb = (const row_t *)b;
+    if (ra->self_kcycles != rb->self_kcycles) { return (ra->self_kcycles < rb->self_kcycles) ? 1 : -1; }
+    return ra->slot - rb->slot;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(int argc, char ** argv)
+{
+    uint8_t snapshot[MAX_SNAPSHOT_SIZE];
+    row_t rows[256];
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: cpuprof_view <hex string | file>\n");
+        return 1;
+    }
+
+    int len = load(argv[1], snapshot);
+    if ((len < CPUPROF_HEADER_SIZE) || (snapshot[0] != CPUPROF_VERSION) ||
+        (len < CPUPROF_HEADER_SIZE + CPUPROF_SLOT_SIZE * snapshot[1])) {
+        fprintf(stderr, "cpuprof_view: not a version %d snapshot (%d bytes)\n", CPUPROF_VERSION, len);
+        return 1;
+    }
+
+    int nb_slots = snapshot[1];
+    uint32_t window = read_32(&snapshot[4]);
+    uint32_t idle = read_32(&snapshot[8]);
+    uint64_t busy = 0;
+
+    for (int i = 0; i < nb_slots; i++) {
+        const uint8_t * record = &snapshot[CPUPROF_HEADER_SIZE + CPUPROF_SLOT_SIZE * i];
+        rows[i].slot = i;
+        rows[i].calls = read_32(&record[0]);
+        rows[i].self_kcycles = read_32(&record[4]);
+        rows[i].max_cycles = read_32(&record[8]);
+        busy += rows[i].self_kcycles;
+    }
+    qsort(rows, (size_t)nb_slots, sizeof(row_t), compare_self);
+
+    double scale = (window != 0) ? 100.0 / (double)window : 0.0;
+    printf("window %u kcycles, idle %.2f %%, handlers %.2f %%, other %.2f %%\n", window,
+           idle * scale, (double)busy * scale, ((double)window - idle - (double)busy) * scale);
+    if (snapshot[2] | snapshot[3]) {
+        printf("warning: %u handlers nested too deep, counted in their caller\n", snapshot[2] | (snapshot[3] << 8));
+    }
+    printf("  %% self    self kcyc      calls   avg cyc    max cyc  handler\n");
+    for (int i = 0; i < nb_slots; i++) {
+        const row_t * row = &rows[i];
+        uint64_t avg = (row->calls != 0) ? (uint64_t)row->self_kcycles * 1000 / row->calls : 0;
+        printf("%8.2f %12u %10u %9llu %10u  %s\n", row->self_kcycles * scale, row->self_kcycles,
+               row->calls, (unsigned long long)avg, row->max_cycles, cpuprof_slot_name((cpuprof_slot_id_t)row->slot));
+    }
+
+    return 0;
+}
@@ -0,0 +1,206 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: deadman_jitter.c
+-- Description: Hold-to-run deadman with simulated keep-alive jitter
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "deadman.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Connection interval used by the simulation: 15 ms */
+#define CONN_INTERVAL   12
+#define CONN_INTERVAL_US (CONN_INTERVAL * 1250)
+#define NB_KEEPALIVES   100000
+/** @brief Hardware alarm granularity (1 MHz timer) */
+#define ALARM_RESOLUTION_US 1
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+/** @brief Simulated relay output and alarm */
+typedef struct {
+    deadman_t deadman;
+    int relays_on;
+    uint64_t alarm_target_us;   /**> 0 if the alarm is not set */
+    uint64_t cut_time_us;       /**> Time at which the relays were cut */
+} sim_t;
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Alarm interrupt model, same logic as deadman_alarm_callback()
+ */
+static void sim_alarm(sim_t * sim, uint64_t now_us) {
+    if (deadman_trip(&sim->deadman, now_us)) {
+        sim->relays_on = 0;
+        sim->cut_time_us = now_us;
+        sim->alarm_target_us = 0;
+    }
+    else if (sim->deadman.armed) {
+        sim->alarm_target_us = sim->deadman.deadline_us;
+    }
+}
+
+/**
+ * @brief Run the alarm until the given time
+ */
+static void sim_advance(sim_t * sim, uint64_t until_us) {
+    while ((sim->alarm_target_us != 0) && (sim->alarm_target_us <= until_us)) {
+        uint64_t fire = sim->alarm_target_us;
+        sim->alarm_target_us = 0;
+        sim_alarm(sim, fire);
+    }
+}
+
+/**
+ * @brief Keep-alive write model, same logic as deadman_handle_kick()
+ */
+static void sim_keepalive(sim_t * sim, uint64_t now_us) {
+    sim_advance(sim, now_us);
+    sim->alarm_target_us = deadman_kick(&sim->deadman, now_us);
+    sim->relays_on = 1;
+}
+
+/**
+ * @brief Random delay of a write: next connection event plus lost packets
+ */
+static uint64_t link_delay_us(int max_lost) {
+    uint64_t delay = (uint64_t)(rand() % CONN_INTERVAL_US);
+    return delay + (uint64_t)(rand() % (max_lost + 1)) * CONN_INTERVAL_US;
+}
+
+/**
+ * @brief Jitter within the budget never cuts the relays
+ */
+static int test_jitter_no_trip(void) {
+    sim_t sim = { 0 };
+    uint64_t t = 0;
+
+    deadman_init(&sim.deadman);
+    deadman_set_conn_interval(&sim.deadman, CONN_INTERVAL);
+
+    for (int i = 0; i < NB_KEEPALIVES; i++) {
+        // Periodic keep-alive, delayed up to (DEADMAN_MISSED_INTERVALS - 1) lost packets
+        uint64_t send = (uint64_t)i * DEADMAN_KEEPALIVE_PERIOD_MS * 1000;
+        uint64_t arrival = send + link_delay_us(DEADMAN_MISSED_INTERVALS - 1);
+        if (arrival < t) { arrival = t; }
+        t = arrival;
+        sim_keepalive(&sim, t);
+        CHECK(sim.relays_on);
+    }
+    CHECK(sim.deadman.nb_trips == 0);
+    CHECK(sim.deadman.max_gap_us <= sim.deadman.timeout_us);
+
+    printf("deadman_jitter: %d keep-alives, worst gap %u us / timeout %u us\n",
+           NB_KEEPALIVES, sim.deadman.max_gap_us, sim.deadman.timeout_us);
+    return 0;
+}
+
+/**
+ * @brief Keep-alives stopping (lost client or stalled stack) cut the relays
+ *        within the timeout
+ */
+static int test_stop_latency(void) {
+    uint32_t worst = 0;
+
+    for (int run = 0; run < 1000; run++) {
+        sim_t sim = { 0 };
+        uint64_t t = 0;
+
+        deadman_init(&sim.deadman);
+        deadman_set_conn_interval(&sim.deadman, CONN_INTERVAL);
+
+        int nb = 1 + rand() % 50;
+        for (int i = 0; i < nb; i++) {
+            t += DEADMAN_KEEPALIVE_PERIOD_MS * 1000 / 2 + link_delay_us(1);
+            sim_keepalive(&sim, t);
+        }
+
+        // The run loop stalls: nothing but the alarm runs anymore
+        sim_advance(&sim, t + 10ULL * sim.deadman.timeout_us);
+        CHECK(!sim.relays_on);
+        CHECK(sim.deadman.nb_trips == 1);
+
+        uint32_t latency = (uint32_t)(sim.cut_time_us - t);
+        CHECK(latency <= sim.deadman.timeout_us + ALARM_RESOLUTION_US);
+        if (latency > worst) { worst = latency; }
+    }
+
+    printf("deadman_jitter: worst stop latency %u us after the last keep-alive\n", worst);
+    return 0;
+}
+
+/**
+ * @brief Late keep-alives trip, a disarmed deadman never trips
+ */
+static int test_late_and_disarm(void) {
+    sim_t sim = { 0 };
+
+    deadman_init(&sim.deadman);
+    deadman_set_conn_interval(&sim.deadman, CONN_INTERVAL);
+    uint32_t timeout = sim.deadman.timeout_us;
+    CHECK(timeout == DEADMAN_KEEPALIVE_PERIOD_MS * 1000 + DEADMAN_MISSED_INTERVALS * CONN_INTERVAL_US);
+
+    sim_keepalive(&sim, 1000);
+    sim_advance(&sim, 1000 + timeout - 1);
+    CHECK(sim.relays_on);
+    sim_advance(&sim, 1000 + timeout);
+    CHECK(!sim.relays_on);
+    CHECK(sim.cut_time_us == 1000 + timeout);
+
+    // Disarm before the deadline: the alarm fires but does nothing
+    sim_keepalive(&sim, 1000000);
+    deadman_disarm(&sim.deadman);
+    sim_advance(&sim, 1000000 + 2 * timeout);
+    CHECK(sim.relays_on);
+    CHECK(sim.deadman.nb_trips == 1);
+
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(void)
+{
+    srand(1);
+
+    if (test_late_and_disarm()) { return 1; }
+    if (test_jitter_no_trip()) { return 1; }
+    if (test_stop_latency()) { return 1; }
+
+    printf("deadman_jitter: PASS\n");
+    return 0;
+}
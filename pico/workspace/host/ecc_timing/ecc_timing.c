@@ -0,0 +1,169 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: ecc_timing.c
+-- Description: ECC key cache checks and micro-ecc timing harness
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "crc32.h"
+#include "ecc_cache.h"
+
+#ifdef HAVE_UECC
+#include "uECC.h"
+#endif
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define NB_TIMING_RUNS 20
+/** @brief Exit code reported to ctest as a skipped test (SKIP_RETURN_CODE) */
+#define SKIP_EXIT_CODE 77
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Record integrity and rotation policy
+ */
+static int test_cache_record(void) {
+    const uint8_t check[] = "123456789";
+    CHECK(crc32_update(0, check, 9) == 0xCBF43926);
+    // Incremental computation gives the same result
+    CHECK(crc32_update(crc32_update(0, check, 4), check + 4, 5) == 0xCBF43926);
+
+    uint8_t public_key[64];
+    uint8_t private_key[32];
+    for (int i = 0; i < 64; i++) { public_key[i] = (uint8_t)i; }
+    for (int i = 0; i < 32; i++) { private_key[i] = (uint8_t)(0xA0 + i); }
+
+    ecc_cache_record_t record;
+    ecc_cache_record_init(&record, public_key, private_key);
+    CHECK(ecc_cache_record_valid(&record));
+    CHECK(!ecc_cache_record_expired(&record));
+
+    // Any corruption is detected
+    record.private_key[7] ^= 0x10;
+    CHECK(!ecc_cache_record_valid(&record));
+    record.private_key[7] ^= 0x10;
+    record.nb_pairings++;
+    CHECK(!ecc_cache_record_valid(&record));
+    ecc_cache_record_seal(&record);
+    CHECK(ecc_cache_record_valid(&record));
+
+    // Rotation after too many pairings
+    CHECK(record.reserved == 0);
+    record.nb_pairings = ECC_CACHE_MAX_PAIRINGS - 1;
+    CHECK(!ecc_cache_record_expired(&record));
+    record.nb_pairings = ECC_CACHE_MAX_PAIRINGS;
+    CHECK(ecc_cache_record_expired(&record));
+
+    // Profile accumulation
+    ecc_profile_t profile;
+    memset(&profile, 0, sizeof(profile));
+    ecc_profile_record(&profile, ECC_STEP_DHKEY, 100);
+    ecc_profile_record(&profile, ECC_STEP_DHKEY, 300);
+    CHECK(profile.steps[ECC_STEP_DHKEY].count == 2);
+    CHECK(profile.steps[ECC_STEP_DHKEY].total_us == 400);
+    CHECK(profile.steps[ECC_STEP_DHKEY].max_us == 300);
+    CHECK(profile.steps[ECC_STEP_KEYGEN].count == 0);
+
+    return 0;
+}
+
+#ifdef HAVE_UECC
+/**
+ * @brief Monotonic time in microseconds
+ */
+static uint32_t time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+/**
+ * @brief Test random source for micro-ecc
+ */
+static int test_rng(uint8_t * dest, unsigned size) {
+    while (size--) { *dest++ = (uint8_t)rand(); }
+    return 1;
+}
+
+/**
+ * @brief Time key generation and DH key computation, as done during pairing
+ */
+static int test_timing(void) {
+    ecc_profile_t profile;
+    memset(&profile, 0, sizeof(profile));
+    uECC_set_rng(&test_rng);
+
+    for (int i = 0; i < NB_TIMING_RUNS; i++) {
+        uint8_t public_a[64], private_a[32], public_b[64], private_b[32];
+        uint8_t secret_a[32], secret_b[32];
+
+        uint32_t start = time_us();
+        CHECK(uECC_make_key(public_a, private_a));
+        ecc_profile_record(&profile, ECC_STEP_KEYGEN, time_us() - start);
+        CHECK(uECC_make_key(public_b, private_b));
+
+        start = time_us();
+        CHECK(uECC_shared_secret(public_b, private_a, secret_a));
+        ecc_profile_record(&profile, ECC_STEP_DHKEY, time_us() - start);
+        CHECK(uECC_shared_secret(public_a, private_b, secret_b));
+        CHECK(memcmp(secret_a, secret_b, 32) == 0);
+    }
+
+    const char * names[] = { "keygen", "dhkey" };
+    for (int i = ECC_STEP_KEYGEN; i <= ECC_STEP_DHKEY; i++) {
+        printf("ecc_timing: %-6s avg %u us, max %u us (%u runs)\n", names[i],
+               profile.steps[i].total_us / profile.steps[i].count, profile.steps[i].max_us, profile.steps[i].count);
+    }
+
+    return 0;
+}
+#endif
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success, SKIP_EXIT_CODE if the timing cannot run
+ */
+int main(void)
+{
+    if (test_cache_record()) { return 1; }
+#ifdef HAVE_UECC
+    if (test_timing()) { return 1; }
+#else
+    printf("ecc_timing: record checks passed, micro-ecc not available (PICO_SDK_PATH): SKIP\n");
+    return SKIP_EXIT_CODE;
+#endif
+
+    printf("ecc_timing: PASS\n");
+    return 0;
+}
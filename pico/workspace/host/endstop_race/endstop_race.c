@@ -0,0 +1,221 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: endstop_race.c
+-- Description: End-stop interrupt to relay path, and races between end-stop
+--              interrupts and BLE commands
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "motion.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define NB_RANDOM_STEPS 1000000
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+/** @brief Model of the relay GPIOs and of the interrupt controller */
+typedef struct {
+    uint8_t gpios;              /**> Relay GPIO levels */
+    uint32_t nb_writes;         /**> Relay output writes */
+    bool irq_pending;           /**> End-stop edge raised while interrupts are disabled */
+    uint8_t pending_direction;
+    bool pending_active;
+} board_t;
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+static board_t board;
+static motion_t motion;
+static bool raise_during_output = false;
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief End-stop interrupt, as in the firmware: direct GPIO clear, then the
+ *        serialized state update
+ */
+static bool endstop_isr(uint8_t direction, bool active) {
+    if (active) { board.gpios &= ~direction; }
+    return motion_limit(&motion, direction, active);
+}
+
+/**
+ * @brief Relay outputs driver. Optionally raises an end-stop edge in the
+ *        middle of a command, which is served once the command returns
+ *        (interrupts are disabled around motion_command() in the firmware).
+ */
+static void output_board(uint8_t relays, void * context) {
+    (void)context;
+    board.gpios = relays;
+    board.nb_writes++;
+    if (raise_during_output) {
+        raise_during_output = false;
+        board.irq_pending = true;
+    }
+}
+
+/**
+ * @brief BLE command with interrupts disabled, pending end-stop interrupt
+ *        served on restore
+ */
+static void ble_command(uint8_t command) {
+    motion_command(&motion, command, MOTION_SOURCE_BLE);
+    if (board.irq_pending) {
+        board.irq_pending = false;
+        endstop_isr(board.pending_direction, board.pending_active);
+    }
+}
+
+/**
+ * @brief End-stop while moving: the relay is off when the interrupt returns
+ */
+static int test_cut(void) {
+    motion_init(&motion, &output_board, NULL);
+
+    ble_command(MOTION_UP);
+    CHECK(board.gpios == MOTION_UP);
+    CHECK(endstop_isr(MOTION_UP, true));
+    CHECK(board.gpios == MOTION_STOP);
+    CHECK(motion.command == MOTION_STOP);
+    CHECK(motion.position == MOTION_POSITION_UP_END);
+    CHECK(motion.nb_limit_cuts == 1);
+
+    // The other end-stop does not cut a motion it does not block
+    ble_command(MOTION_DOWN);
+    CHECK(!endstop_isr(MOTION_UP, true));
+    CHECK(board.gpios == MOTION_DOWN);
+    CHECK(motion.position == MOTION_POSITION_UP_END);
+
+    return 0;
+}
+
+/**
+ * @brief Commands towards an active end-stop are blocked, away from it accepted
+ */
+static int test_blocked(void) {
+    motion_init(&motion, &output_board, NULL);
+
+    endstop_isr(MOTION_DOWN, true);
+    ble_command(MOTION_DOWN | MOTION_HOLD_TO_RUN);
+    CHECK(board.gpios == MOTION_STOP);
+    CHECK(motion.nb_blocked == 1);
+    CHECK(motion.position == MOTION_POSITION_DOWN_END);
+
+    ble_command(MOTION_UP);
+    CHECK(board.gpios == MOTION_UP);
+    CHECK(motion.position == MOTION_POSITION_UNKNOWN);
+
+    // Leaving the end-stop releases the direction
+    endstop_isr(MOTION_DOWN, false);
+    ble_command(MOTION_DOWN);
+    CHECK(board.gpios == MOTION_DOWN);
+
+    return 0;
+}
+
+/**
+ * @brief End-stop edge raised while a BLE command drives the relay: the
+ *        interrupt is served after the command and still cuts it
+ */
+static int test_race_during_command(void) {
+    motion_init(&motion, &output_board, NULL);
+
+    board.pending_direction = MOTION_UP;
+    board.pending_active = true;
+    raise_during_output = true;
+    ble_command(MOTION_UP);
+    CHECK(board.gpios == MOTION_STOP);
+    CHECK(motion.command == MOTION_STOP);
+    CHECK(motion.nb_limit_cuts == 1);
+
+    // Repeated hold-to-run keep-alives after the cut stay blocked
+    ble_command(MOTION_UP | MOTION_HOLD_TO_RUN);
+    ble_command(MOTION_UP | MOTION_HOLD_TO_RUN);
+    CHECK(board.gpios == MOTION_STOP);
+    CHECK(motion.nb_blocked == 2);
+
+    return 0;
+}
+
+/**
+ * @brief Random interleaving of commands and end-stop edges: a relay is never
+ *        left on towards an active end-stop
+ */
+static int test_random(void) {
+    motion_init(&motion, &output_board, NULL);
+    srand(7);
+
+    for (int i = 0; i < NB_RANDOM_STEPS; i++) {
+        int r = rand() % 8;
+        if (r < 4) {
+            static const uint8_t commands[] = {
+                MOTION_STOP, MOTION_UP, MOTION_DOWN, MOTION_RELAYS_MASK,
+                MOTION_UP | MOTION_HOLD_TO_RUN, MOTION_DOWN | MOTION_HOLD_TO_RUN,
+            };
+            board.pending_direction = (rand() & 1) ? MOTION_UP : MOTION_DOWN;
+            board.pending_active = rand() & 1;
+            raise_during_output = (rand() % 4) == 0;
+            ble_command(commands[rand() % 6]);
+            raise_during_output = false;
+        }
+        else {
+            endstop_isr((r & 1) ? MOTION_UP : MOTION_DOWN, r & 2);
+        }
+
+        CHECK((board.gpios & motion.limits) == 0);
+        CHECK(board.gpios != MOTION_RELAYS_MASK);
+        CHECK(board.gpios == (motion.command & MOTION_RELAYS_MASK));
+    }
+
+    printf("endstop_race: %u cuts, %u blocked commands\n", motion.nb_limit_cuts, motion.nb_blocked);
+
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(void)
+{
+    if (test_cut()) { return 1; }
+    if (test_blocked()) { return 1; }
+    if (test_race_during_command()) { return 1; }
+    if (test_random()) { return 1; }
+
+    printf("endstop_race: PASS\n");
+    return 0;
+}
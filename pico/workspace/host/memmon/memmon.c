@@ -0,0 +1,121 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: memmon.c
+-- Description: Stack painting high-water marks and pool usage counters
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+
+#include "memmon.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define STACK_WORDS 256
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief High-water mark of a simulated downward-growing stack
+ */
+static int test_stack(void) {
+    static uint32_t stack[STACK_WORDS];
+    uint32_t * top = &stack[STACK_WORDS];
+
+    memmon_stack_paint(stack, top);
+    CHECK(memmon_stack_used(stack, top) == 0);
+
+    // Frames pushed from the top: the deepest one sets the mark
+    for (int i = 1; i <= 40; i++) { top[-i] = (uint32_t)i; }
+    CHECK(memmon_stack_used(stack, top) == 40 * sizeof(uint32_t));
+
+    // Returning does not lower the mark, a deeper call raises it
+    for (int i = 1; i <= 10; i++) { top[-i] = MEMMON_STACK_PATTERN; }
+    CHECK(memmon_stack_used(stack, top) == 40 * sizeof(uint32_t));
+    stack[100] = 0;
+    CHECK(memmon_stack_used(stack, top) == (STACK_WORDS - 100) * sizeof(uint32_t));
+
+    // A local holding the pattern below the deepest frame is still counted
+    stack[90] = 1;
+    stack[100] = MEMMON_STACK_PATTERN;
+    CHECK(memmon_stack_used(stack, top) == (STACK_WORDS - 90) * sizeof(uint32_t));
+
+    // Overflow: the whole stack is reported
+    stack[0] = 0;
+    CHECK(memmon_stack_used(stack, top) == STACK_WORDS * sizeof(uint32_t));
+
+    return 0;
+}
+
+/**
+ * @brief Pool counters: use, peak, exhaustion and level pools
+ */
+static int test_pool(void) {
+    memmon_pool_t pool;
+
+    memmon_pool_init(&pool, 3);
+    memmon_pool_get(&pool, true);
+    memmon_pool_get(&pool, true);
+    memmon_pool_free(&pool);
+    memmon_pool_get(&pool, true);
+    memmon_pool_get(&pool, true);
+    memmon_pool_get(&pool, false);
+    CHECK(pool.capacity == 3);
+    CHECK(pool.used == 3);
+    CHECK(pool.peak == 3);
+    CHECK(pool.nb_failures == 1);
+
+    memmon_pool_free(&pool);
+    memmon_pool_free(&pool);
+    memmon_pool_free(&pool);
+    memmon_pool_free(&pool);
+    CHECK(pool.used == 0);
+    CHECK(pool.peak == 3);
+
+    memmon_pool_init(&pool, 259);
+    memmon_pool_set(&pool, 27);
+    memmon_pool_set(&pool, 251);
+    memmon_pool_set(&pool, 27);
+    CHECK(pool.used == 27);
+    CHECK(pool.peak == 251);
+
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(void)
+{
+    if (test_stack()) { return 1; }
+    if (test_pool()) { return 1; }
+
+    printf("memmon: PASS\n");
+    return 0;
+}
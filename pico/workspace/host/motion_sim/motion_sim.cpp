@@ -0,0 +1,251 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: motion_sim.cpp
+-- Description: Accelerated-time closed-loop simulator: randomized scenarios on
+--              all cores, each fault injected first to check that the
+--              invariants catch it, then the firmware as is
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sim_model.hpp"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define DEFAULT_SCENARIOS       20000
+/** @brief Scenarios per injected fault, each fault must be caught at least once */
+#define FAULT_SCENARIOS         500
+/** @brief Scenarios taken at once by a thread */
+#define BATCH_SIZE              64
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    uint64_t nb_scenarios;
+    uint64_t nb_events;
+    uint64_t nb_commands;
+    uint64_t nb_limit_cuts;
+    uint64_t nb_blocked;
+    uint64_t nb_trips;
+    uint64_t travel_um;
+    uint64_t stall_us;
+    uint64_t nb_failed[SIM_NB_VIOLATIONS];      /**> Scenarios violating each invariant */
+    uint64_t first_seed[SIM_NB_VIOLATIONS];     /**> Smallest seed violating each invariant */
+    double wall_s;
+} report_t;
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+static uint64_t time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void report_add(report_t * report, uint64_t seed, const sim_result_t * result) {
+    report->nb_scenarios++;
+    report->nb_events += result->nb_events;
+    report->nb_commands += result->nb_commands;
+    report->nb_limit_cuts += result->nb_limit_cuts;
+    report->nb_blocked += result->nb_blocked;
+    report->nb_trips += result->nb_trips;
+    report->travel_um += result->travel_um;
+    report->stall_us += result->stall_us;
+
+    for (int violation = 0; violation < SIM_NB_VIOLATIONS; violation++) {
+        if (!(result->violations & (1u << violation))) { continue; }
+        if ((report->nb_failed[violation] == 0) || (seed < report->first_seed[violation])) { report->first_seed[violation] = seed; }
+        report->nb_failed[violation]++;
+    }
+}
+
+static void report_merge(report_t * report, const report_t * other) {
+    report->nb_scenarios += other->nb_scenarios;
+    report->nb_events += other->nb_events;
+    report->nb_commands += other->nb_commands;
+    report->nb_limit_cuts += other->nb_limit_cuts;
+    report->nb_blocked += other->nb_blocked;
+    report->nb_trips += other->nb_trips;
+    report->travel_um += other->travel_um;
+    report->stall_us += other->stall_us;
+
+    for (int violation = 0; violation < SIM_NB_VIOLATIONS; violation++) {
+        if (other->nb_failed[violation] == 0) { continue; }
+        if ((report->nb_failed[violation] == 0) || (other->first_seed[violation] < report->first_seed[violation])) {
+            report->first_seed[violation] = other->first_seed[violation];
+        }
+        report->nb_failed[violation] += other->nb_failed[violation];
+    }
+}
+
+/**
+ * @brief Run scenarios first_seed .. first_seed + nb_scenarios - 1 on all the
+ *        threads; the report does not depend on the number of threads
+ */
+static void run_scenarios(uint64_t first_seed, uint64_t nb_scenarios, unsigned nb_threads, sim_fault_t fault, report_t * report) {
+    std::atomic<uint64_t> next(0);
+    std::mutex lock;
+    std::vector<std::thread> threads;
+
+    memset(report, 0, sizeof(report_t));
+    uint64_t start_ns = time_ns();
+
+    for (unsigned i = 0; i < nb_threads; i++) {
+        threads.emplace_back([&]() {
+            report_t local;
+            sim_result_t result;
+            memset(&local, 0, sizeof(local));
+
+            while (true) {
+                uint64_t begin = next.fetch_add(BATCH_SIZE);
+                if (begin >= nb_scenarios) { break; }
+                uint64_t end = (begin + BATCH_SIZE < nb_scenarios) ? begin + BATCH_SIZE : nb_scenarios;
+
+                for (uint64_t index = begin; index < end; index++) {
+                    sim_run(first_seed + index, fault, false, &result);
+                    report_add(&local, first_seed + index, &result);
+                }
+            }
+
+            std::lock_guard<std::mutex> guard(lock);
+            report_merge(report, &local);
+        });
+    }
+    for (std::thread & thread : threads) { thread.join(); }
+
+    report->wall_s = (time_ns() - start_ns) / 1e9;
+}
+
+static void print_report(const report_t * report, unsigned nb_threads) {
+    double virtual_s = report->nb_scenarios * (SIM_SCENARIO_US / 1e6);
+
+    printf("%" PRIu64 " scenarios on %u threads in %.2f s: %.0f scenarios/s, %.1f M events/s\n",
+           report->nb_scenarios, nb_threads, report->wall_s, report->nb_scenarios / report->wall_s, report->nb_events / report->wall_s / 1e6);
+    printf("virtual time %.1f h, %.0fx real time\n", virtual_s / 3600, virtual_s / report->wall_s);
+    printf("%" PRIu64 " commands, %" PRIu64 " blocked, %" PRIu64 " end-stop cuts, %" PRIu64 " deadman trips, travel %.1f km, stalled %.1f h\n",
+           report->nb_commands, report->nb_blocked, report->nb_limit_cuts, report->nb_trips, report->travel_um / 1e9, report->stall_us / 3.6e9);
+
+    for (int violation = 0; violation < SIM_NB_VIOLATIONS; violation++) {
+        printf("  %-12s %8" PRIu64, sim_violation_name((sim_violation_t)violation), report->nb_failed[violation]);
+        if (report->nb_failed[violation] != 0) { printf("  first seed %" PRIu64, report->first_seed[violation]); }
+        printf("\n");
+    }
+}
+
+/**
+ * @brief Each injected fault must be caught by its invariant
+ */
+static bool check_faults(uint64_t first_seed, unsigned nb_threads) {
+    // By sim_fault_t
+    static const sim_violation_t expected[SIM_NB_FAULTS] = {
+        SIM_NB_VIOLATIONS, SIM_VIOLATION_ENDSTOP, SIM_VIOLATION_HOLD_TO_RUN, SIM_VIOLATION_SHORT,
+    };
+    bool caught = true;
+
+    for (int fault = SIM_FAULT_NONE + 1; fault < SIM_NB_FAULTS; fault++) {
+        report_t report;
+        run_scenarios(first_seed, FAULT_SCENARIOS, nb_threads, (sim_fault_t)fault, &report);
+
+        uint64_t nb_failed = report.nb_failed[expected[fault]];
+        printf("fault %-15s caught as %-12s in %" PRIu64 "/%d scenarios\n",
+               sim_fault_name((sim_fault_t)fault), sim_violation_name(expected[fault]), nb_failed, FAULT_SCENARIOS);
+        if (nb_failed == 0) { caught = false; }
+    }
+    return caught;
+}
+
+static sim_fault_t parse_fault(const char * name) {
+    for (int fault = 0; fault < SIM_NB_FAULTS; fault++) {
+        if (strcmp(name, sim_fault_name((sim_fault_t)fault)) == 0) { return (sim_fault_t)fault; }
+    }
+    return SIM_NB_FAULTS;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+int main(int argc, char ** argv)
+{
+    uint64_t nb_scenarios = DEFAULT_SCENARIOS;
+    uint64_t first_seed = 1;
+    uint64_t replay_seed = 0;
+    bool replay = false;
+    unsigned nb_threads = std::thread::hardware_concurrency();
+    sim_fault_t fault = SIM_FAULT_NONE;
+    bool fault_set = false;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) { nb_scenarios = strtoull(argv[++i], NULL, 0); }
+        else if ((strcmp(argv[i], "-j") == 0) && (i + 1 < argc)) { nb_threads = (unsigned)strtoul(argv[++i], NULL, 0); }
+        else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) { first_seed = strtoull(argv[++i], NULL, 0); }
+        else if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc)) { replay_seed = strtoull(argv[++i], NULL, 0); replay = true; }
+        else if ((strcmp(argv[i], "-f") == 0) && (i + 1 < argc)) { fault = parse_fault(argv[++i]); fault_set = true; }
+        else { fault = SIM_NB_FAULTS; break; }
+    }
+    if (fault == SIM_NB_FAULTS) {
+        fprintf(stderr, "usage: %s [-n scenarios] [-j threads] [-s first seed] [-r replayed seed] "
+                        "[-f none|no-endstop-isr|no-deadman|no-dead-time]\n", argv[0]);
+        return 2;
+    }
+    if (nb_threads == 0) { nb_threads = 1; }
+
+    // One scenario, event by event
+    if (replay) {
+        sim_result_t result;
+        sim_run(replay_seed, fault, true, &result);
+        printf("seed %" PRIu64 ": %u events, violations 0x%02x\n", replay_seed, result.nb_events, result.violations);
+        return (result.violations != 0) ? 1 : 0;
+    }
+
+    // The invariants are checked against known faults before they are trusted
+    if (!fault_set && !check_faults(first_seed, nb_threads)) {
+        printf("motion_sim: FAIL, injected fault not caught\n");
+        return 1;
+    }
+
+    report_t report;
+    run_scenarios(first_seed, nb_scenarios, nb_threads, fault, &report);
+    print_report(&report, nb_threads);
+
+    for (int violation = 0; violation < SIM_NB_VIOLATIONS; violation++) {
+        if (report.nb_failed[violation] != 0) {
+            printf("motion_sim: FAIL, replay with -r %" PRIu64 "%s%s\n", report.first_seed[violation],
+                   fault_set ? " -f " : "", fault_set ? sim_fault_name(fault) : "");
+            return 1;
+        }
+    }
+
+    printf("motion_sim: PASS\n");
+    return 0;
+}
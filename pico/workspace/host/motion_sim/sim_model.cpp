@@ -0,0 +1,637 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: sim_model.cpp
+-- Description: Closed-loop scenario on a virtual clock: the firmware command
+--              path (motion.c, deadman.c, changeover.c) driving a model of
+--              the relays and of the actuator, with the safety invariants
+--              checked on each event
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sim_model.hpp"
+
+extern "C" {
+#include "motion.h"
+#include "deadman.h"
+#include "changeover.h"
+}
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define NEVER           UINT64_MAX
+
+/** @brief Relays and end-stops, by direction index: 0 Up, 1 Down */
+#define NB_DIRECTIONS   2
+
+/** @brief Connection intervals (1.25 ms units), keep-alive periods and missed
+ *         intervals drawn for each scenario, all within the parameter ranges */
+static const uint16_t conn_intervals[] = { 6, 12, 24, 40 };
+static const uint16_t keepalive_periods_ms[] = { 50, 100, 200 };
+static const uint8_t missed_intervals[] = { 2, 4, 6 };
+/** @brief Changeover dead-times drawn for each scenario, within the parameter
+ *         range: the shortest one plus the fastest operate time is above the
+ *         slowest release */
+static const uint16_t dead_times_ms[] = { 10, 20, 50, 100 };
+
+/** @brief Latched client commands, by weight: both directions, and the
+ *         hold-to-run bit without relay, are part of the mix */
+static const uint8_t latched_commands[] = {
+    MOTION_UP, MOTION_UP, MOTION_UP, MOTION_DOWN, MOTION_DOWN, MOTION_DOWN,
+    MOTION_STOP, MOTION_STOP, MOTION_UP | MOTION_DOWN, MOTION_HOLD_TO_RUN,
+};
+
+#define ARRAY_SIZE(a)   (sizeof(a) / sizeof((a)[0]))
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+/** @brief Relay: coil driven by the firmware, contact following after a delay */
+typedef struct {
+    bool coil;              /**> Coil driven */
+    bool contact;           /**> Contact closed */
+    uint64_t switch_us;     /**> Time the contact follows the coil, NEVER if settled */
+} relay_model_t;
+
+typedef enum {
+    CLIENT_IDLE = 0,        /**> Next latched command or hold-to-run session at client_us */
+    CLIENT_HOLD             /**> Hold-to-run session, next write arrives at client_us */
+} client_state_t;
+
+typedef struct {
+    // Scenario
+    uint64_t rng;                           /**> Random generator state */
+    sim_fault_t fault;                      /**> Firmware fault injected */
+    bool trace;                             /**> Print each event */
+    sim_result_t * result;                  /**> Output result */
+    uint64_t now_us;                        /**> Virtual clock */
+
+    // Firmware
+    motion_t motion;                        /**> Command path under test */
+    deadman_t deadman;                      /**> Hold-to-run deadman under test */
+    uint64_t alarm_us;                      /**> Deadman hardware alarm target, NEVER if none */
+    changeover_t changeover;                /**> Changeover dead-time under test */
+    uint64_t changeover_us;                 /**> Changeover hardware alarm target, NEVER if none */
+
+    // Relays and actuator
+    relay_model_t relays[NB_DIRECTIONS];    /**> Relay1 (Up), Relay2 (Down) */
+    uint32_t operate_us;                    /**> Coil on to contact closed */
+    uint32_t release_us;                    /**> Coil off to contact open */
+    uint32_t rate_um_s[NB_DIRECTIONS];      /**> Travel rate, by direction */
+    int64_t position_um;                    /**> 0 at the Down mechanical stop */
+    bool obstacle;                          /**> Motion blocked: the motor stalls */
+    uint64_t obstacle_us;                   /**> Next obstacle change */
+
+    // End-stops
+    bool inputs[NB_DIRECTIONS];             /**> End-stop input levels, true if active */
+    uint64_t input_us[NB_DIRECTIONS];       /**> Time of the last input change */
+    uint64_t isr_us[NB_DIRECTIONS];         /**> Pending end-stop interrupt, NEVER if none */
+    bool wire_cut[NB_DIRECTIONS];           /**> Cut end-stop wire: the pull-up reads active */
+    uint64_t wire_cut_us;                   /**> Time of the wire cut, NEVER if none */
+    int wire_cut_index;                     /**> End-stop of the wire cut */
+
+    // Client
+    client_state_t client;                  /**> Client script state */
+    uint64_t client_us;                     /**> Next client event */
+    motion_source_t client_source;          /**> BLE or USB */
+    uint8_t hold_command;                   /**> Write of the hold-to-run session in flight */
+    uint64_t hold_send_us;                  /**> Send time of that write */
+    uint64_t hold_end_us;                   /**> Last keep-alive sent before this time */
+    bool hold_stop;                         /**> Session ended by a STOP, by a lost link otherwise */
+
+    // Button
+    bool button_pressed;                    /**> Button held */
+    uint8_t button_direction;               /**> Direction of the button */
+    uint64_t button_us;                     /**> Next press or release */
+
+    // Invariants
+    bool hold_active;                       /**> Last command applied was hold-to-run */
+    uint64_t hold_kick_us;                  /**> Time of its last keep-alive */
+} sim_t;
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief splitmix64: scenarios are independent and reproducible from the seed
+ */
+static uint64_t sim_random(sim_t * sim) {
+    uint64_t z = (sim->rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Random value in [min, max]
+ */
+static uint64_t sim_range(sim_t * sim, uint64_t min, uint64_t max) {
+    return min + sim_random(sim) % (max - min + 1);
+}
+
+static void sim_trace(const sim_t * sim, const char * format, ...) {
+    if (!sim->trace) { return; }
+
+    va_list args;
+    va_start(args, format);
+    printf("%11.6f  ", sim->now_us / 1e6);
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+static void sim_violation(sim_t * sim, sim_violation_t violation) {
+    if (sim->result->violations & (1u << violation)) { return; }
+
+    sim->result->violations |= 1u << violation;
+    sim->result->violation_us[violation] = sim->now_us;
+    sim_trace(sim, "VIOLATION %s", sim_violation_name(violation));
+}
+
+static uint8_t sim_coils(const sim_t * sim) {
+    return (sim->relays[0].coil ? MOTION_UP : 0) | (sim->relays[1].coil ? MOTION_DOWN : 0);
+}
+
+/**
+ * @brief Motor drive from the contacts: +1 Up, -1 Down, 0 off or shorted
+ */
+static int sim_drive(const sim_t * sim) {
+    if (sim->relays[0].contact == sim->relays[1].contact) { return 0; }
+    return sim->relays[0].contact ? 1 : -1;
+}
+
+/**
+ * @brief Drive a coil: the contact follows after its delay, unless the coil
+ *        changes back before
+ */
+static void sim_coil(sim_t * sim, int index, bool on) {
+    relay_model_t * relay = &sim->relays[index];
+    if (relay->coil == on) { return; }
+
+    relay->coil = on;
+    relay->switch_us = (relay->contact == on) ? NEVER : sim->now_us + (on ? sim->operate_us : sim->release_us);
+}
+
+/**
+ * @brief Relay outputs driver, same as the firmware: release a line before
+ *        engaging the other one, after the changeover dead-time; the
+ *        changeover alarm drives a deferred line
+ */
+static void sim_output(uint8_t relays, void * context) {
+    sim_t * sim = (sim_t *)context;
+    uint64_t retry_us;
+    uint8_t driven = changeover_update(&sim->changeover, relays, sim->now_us, &retry_us);
+
+    if (!(driven & MOTION_UP)) { sim_coil(sim, 0, false); }
+    if (!(driven & MOTION_DOWN)) { sim_coil(sim, 1, false); }
+    if (driven & MOTION_UP) { sim_coil(sim, 0, true); }
+    if (driven & MOTION_DOWN) { sim_coil(sim, 1, true); }
+
+    if (retry_us != 0) { sim->changeover_us = retry_us; }
+}
+
+/**
+ * @brief Changeover alarm: drive the deferred line if the command still
+ *        requests it
+ */
+static void sim_changeover_alarm(sim_t * sim) {
+    sim->changeover_us = NEVER;
+    sim_output(sim->motion.command & MOTION_RELAYS_MASK, sim);
+}
+
+/**
+ * @brief Apply a command, recording whether it is a hold-to-run one
+ */
+static void sim_apply(sim_t * sim, uint8_t command, motion_source_t source, bool hold) {
+    uint8_t relays = motion_command(&sim->motion, command, source);
+    sim->hold_active = hold;
+    sim_trace(sim, "%s command 0x%02x -> relays 0x%02x",
+              (source == MOTION_SOURCE_BLE) ? "BLE" : (source == MOTION_SOURCE_USB) ? "USB" :
+              (source == MOTION_SOURCE_BUTTON) ? "button" : "deadman", command, relays);
+}
+
+/**
+ * @brief Same policy as the firmware: a hold-to-run command arms the
+ *        deadman and its alarm before any relay is turned on
+ */
+static void sim_client_command(sim_t * sim, uint8_t command) {
+    bool hold = (command & MOTION_HOLD_TO_RUN) && (command & MOTION_RELAYS_MASK);
+    if (hold) {
+        sim->alarm_us = deadman_kick(&sim->deadman, sim->now_us);
+        sim->hold_kick_us = sim->now_us;
+    }
+    else {
+        deadman_disarm(&sim->deadman);
+    }
+
+    sim_apply(sim, command, sim->client_source, hold);
+}
+
+/**
+ * @brief Deadman alarm: cut the relays if the keep-alive is late, follow the
+ *        deadline otherwise
+ */
+static void sim_alarm(sim_t * sim) {
+    sim->alarm_us = NEVER;
+
+    if (deadman_trip(&sim->deadman, sim->now_us)) {
+        // The session keep-alives all arrive within the deadman timeout
+        if (sim->client == CLIENT_HOLD) { sim_violation(sim, SIM_VIOLATION_FALSE_TRIP); }
+        sim_trace(sim, "deadman trip");
+        if (sim->fault != SIM_FAULT_NO_DEADMAN) { sim_apply(sim, MOTION_STOP, MOTION_SOURCE_DEADMAN, false); }
+    }
+    else if (sim->deadman.armed) {
+        sim->alarm_us = sim->deadman.deadline_us;
+    }
+}
+
+/**
+ * @brief End-stop interrupt: cut the relay of the blocked direction first,
+ *        then update the command state, on the level read at that time
+ */
+static void sim_endstop_isr(sim_t * sim, int index) {
+    sim->isr_us[index] = NEVER;
+    if (sim->fault == SIM_FAULT_NO_ENDSTOP_ISR) { return; }
+
+    bool active = sim->inputs[index];
+    if (active) { sim_coil(sim, index, false); }
+
+    if (motion_limit(&sim->motion, (index == 0) ? MOTION_UP : MOTION_DOWN, active)) {
+        sim_trace(sim, "%s end-stop cut", (index == 0) ? "Up" : "Down");
+    }
+}
+
+/**
+ * @brief Move the actuator to the given time
+ */
+static void sim_advance(sim_t * sim, uint64_t time_us) {
+    uint64_t elapsed_us = time_us - sim->now_us;
+    int drive = sim_drive(sim);
+    sim->now_us = time_us;
+    if ((drive == 0) || (elapsed_us == 0)) { return; }
+
+    if (sim->obstacle) {
+        sim->result->stall_us += elapsed_us;
+        return;
+    }
+
+    int64_t distance = (int64_t)(sim->rate_um_s[(drive > 0) ? 0 : 1] * elapsed_us / 1000000);
+    int64_t position = sim->position_um + drive * distance;
+    if (position > SIM_TRAVEL_UM) { position = SIM_TRAVEL_UM; }
+    if (position < 0) { position = 0; }
+
+    sim->result->travel_um += (position > sim->position_um) ? position - sim->position_um : sim->position_um - position;
+    sim->position_um = position;
+}
+
+/**
+ * @brief Next position where an end-stop switches or the motor hits a
+ *        mechanical stop
+ */
+static uint64_t sim_crossing_us(const sim_t * sim) {
+    int drive = sim_drive(sim);
+    if ((drive == 0) || sim->obstacle) { return NEVER; }
+
+    const int64_t up[] = { SIM_SWITCH_MARGIN_UM + 1, SIM_TRAVEL_UM - SIM_SWITCH_MARGIN_UM, SIM_TRAVEL_UM };
+    const int64_t down[] = { SIM_TRAVEL_UM - SIM_SWITCH_MARGIN_UM - 1, SIM_SWITCH_MARGIN_UM, 0 };
+    const int64_t * boundaries = (drive > 0) ? up : down;
+
+    for (int i = 0; i < 3; i++) {
+        int64_t distance = (boundaries[i] - sim->position_um) * drive;
+        if (distance > 0) {
+            uint64_t rate = sim->rate_um_s[(drive > 0) ? 0 : 1];
+            return sim->now_us + ((uint64_t)distance * 1000000 + rate - 1) / rate;
+        }
+    }
+    return NEVER;
+}
+
+/**
+ * @brief Update the end-stop inputs from the position, an edge raises the
+ *        interrupt unless one is already pending
+ *
+ * @param interrupt false at boot: the levels are read, not their edges
+ */
+static void sim_inputs(sim_t * sim, bool interrupt) {
+    for (int index = 0; index < NB_DIRECTIONS; index++) {
+        bool reached = (index == 0) ? (sim->position_um >= SIM_TRAVEL_UM - SIM_SWITCH_MARGIN_UM) : (sim->position_um <= SIM_SWITCH_MARGIN_UM);
+        bool active = reached || sim->wire_cut[index];
+        if (active == sim->inputs[index]) { continue; }
+
+        sim->inputs[index] = active;
+        sim->input_us[index] = sim->now_us;
+        if (interrupt && (sim->isr_us[index] == NEVER)) { sim->isr_us[index] = sim->now_us + SIM_ISR_LATENCY_US; }
+        sim_trace(sim, "%s end-stop %s at %.3f mm", (index == 0) ? "Up" : "Down", active ? "active" : "released", sim->position_um / 1e3);
+    }
+}
+
+/**
+ * @brief Deadline of the end-stop invariant: a contact towards an active
+ *        end-stop opens within the interrupt latency and the release delay
+ */
+static uint64_t sim_endstop_limit_us(const sim_t * sim, int index) {
+    return sim->input_us[index] + SIM_ISR_LATENCY_US + sim->release_us;
+}
+
+/**
+ * @brief Deadline of the hold-to-run invariant: the motor stops within the
+ *        deadman timeout and the release delay after the last keep-alive
+ */
+static uint64_t sim_hold_limit_us(const sim_t * sim) {
+    return sim->hold_kick_us + sim->deadman.timeout_us + sim->release_us;
+}
+
+/**
+ * @brief Check the invariants after an event
+ */
+static void sim_check(sim_t * sim) {
+    bool closed = sim->relays[0].contact || sim->relays[1].contact;
+
+    if (sim->relays[0].contact && sim->relays[1].contact) { sim_violation(sim, SIM_VIOLATION_SHORT); }
+
+    // A requested line may only wait for the end of its dead-time
+    uint8_t coils = sim_coils(sim);
+    uint8_t expected = sim->motion.command & MOTION_RELAYS_MASK;
+    for (int index = 0; index < NB_DIRECTIONS; index++) {
+        uint8_t mask = (index == 0) ? MOTION_UP : MOTION_DOWN;
+        if ((expected & mask) && !(coils & mask) && (sim->now_us < sim->changeover.ready_us[index])) { expected &= ~mask; }
+    }
+    if ((coils != expected) || (coils == MOTION_RELAYS_MASK)) { sim_violation(sim, SIM_VIOLATION_STATE); }
+
+    int drive = sim_drive(sim);
+    if (((drive > 0) && (sim->position_um >= SIM_TRAVEL_UM)) || ((drive < 0) && (sim->position_um <= 0))) {
+        sim_violation(sim, SIM_VIOLATION_HARD_STOP);
+    }
+
+    for (int index = 0; index < NB_DIRECTIONS; index++) {
+        if (sim->inputs[index] && sim->relays[index].contact && (sim->now_us > sim_endstop_limit_us(sim, index))) {
+            sim_violation(sim, SIM_VIOLATION_ENDSTOP);
+        }
+    }
+
+    if (sim->hold_active && closed && (sim->now_us > sim_hold_limit_us(sim))) { sim_violation(sim, SIM_VIOLATION_HOLD_TO_RUN); }
+}
+
+/**
+ * @brief Time a write sent now reaches the firmware: at a later connection
+ *        event, after up to the missed intervals, never before the previous one
+ */
+static uint64_t sim_arrival_us(sim_t * sim, uint64_t send_us) {
+    uint64_t delay_us = sim_range(sim, 0, (uint64_t)sim->deadman.missed_intervals * sim->deadman.conn_interval * 1250 - 1);
+    return (send_us + delay_us > sim->client_us) ? send_us + delay_us : sim->client_us;
+}
+
+/**
+ * @brief Client script: latched commands and hold-to-run sessions, over BLE
+ *        or USB
+ */
+static void sim_client(sim_t * sim) {
+    if (sim->client == CLIENT_IDLE) {
+        sim->client_source = (sim_range(sim, 0, 1) == 0) ? MOTION_SOURCE_BLE : MOTION_SOURCE_USB;
+
+        if (sim_range(sim, 0, 99) < 45) {
+            sim_client_command(sim, latched_commands[sim_range(sim, 0, ARRAY_SIZE(latched_commands) - 1)]);
+            sim->client_us = sim->now_us + sim_range(sim, 50000, 15000000);
+            return;
+        }
+
+        // Hold-to-run session: the first write is applied now
+        sim->client = CLIENT_HOLD;
+        sim->hold_command = MOTION_HOLD_TO_RUN | ((sim_range(sim, 0, 1) == 0) ? MOTION_UP : MOTION_DOWN);
+        sim->hold_send_us = sim->now_us;
+        sim->hold_end_us = sim->now_us + sim_range(sim, 100000, 20000000);
+        sim->hold_stop = sim_range(sim, 0, 3) != 0;
+    }
+
+    uint8_t command = sim->hold_command;
+    sim_client_command(sim, command);
+    if (command == MOTION_STOP) {
+        sim->client = CLIENT_IDLE;
+        sim->client_us = sim->now_us + sim_range(sim, 50000, 15000000);
+        return;
+    }
+
+    sim->hold_send_us += (uint64_t)sim->deadman.keepalive_ms * 1000;
+    if (sim->hold_send_us >= sim->hold_end_us) {
+        if (!sim->hold_stop) {
+            sim_trace(sim, "link lost");
+            sim->client = CLIENT_IDLE;
+            sim->client_us = sim->now_us + sim_range(sim, 50000, 15000000);
+            return;
+        }
+        // Released between two keep-alives
+        sim->hold_command = MOTION_STOP;
+    }
+    sim->client_us = sim_arrival_us(sim, sim->hold_send_us);
+}
+
+/**
+ * @brief Debounced button events, same policy as the firmware: a press
+ *        takes over a hold-to-run command, a release stops only its direction
+ */
+static void sim_button(sim_t * sim) {
+    sim->button_pressed = !sim->button_pressed;
+
+    if (sim->button_pressed) {
+        sim->button_direction = (sim_range(sim, 0, 1) == 0) ? MOTION_UP : MOTION_DOWN;
+        deadman_disarm(&sim->deadman);
+        sim_apply(sim, sim->button_direction, MOTION_SOURCE_BUTTON, false);
+        sim->button_us = sim->now_us + sim_range(sim, 50000, 15000000);
+    }
+    else {
+        if ((sim->motion.command & MOTION_RELAYS_MASK) == sim->button_direction) {
+            sim_apply(sim, MOTION_STOP, MOTION_SOURCE_BUTTON, false);
+        }
+        sim->button_us = sim->now_us + sim_range(sim, 1000000, 30000000);
+    }
+}
+
+static void sim_obstacle(sim_t * sim) {
+    sim->obstacle = !sim->obstacle;
+    sim->obstacle_us = sim->now_us + (sim->obstacle ? sim_range(sim, 200000, 8000000) : sim_range(sim, 5000000, 60000000));
+    sim_trace(sim, "obstacle %s", sim->obstacle ? "hit" : "cleared");
+}
+
+static inline void sim_min(uint64_t * next_us, uint64_t time_us) {
+    if (time_us < *next_us) { *next_us = time_us; }
+}
+
+/**
+ * @brief Earliest event: scripts, firmware timers, relay contacts, actuator
+ *        crossings, and the invariant deadlines still ahead
+ */
+static uint64_t sim_next_us(const sim_t * sim) {
+    uint64_t next_us = NEVER;
+
+    sim_min(&next_us, sim->client_us);
+    sim_min(&next_us, sim->button_us);
+    sim_min(&next_us, sim->obstacle_us);
+    sim_min(&next_us, sim->wire_cut_us);
+    sim_min(&next_us, sim->alarm_us);
+    sim_min(&next_us, sim->changeover_us);
+    sim_min(&next_us, sim_crossing_us(sim));
+
+    for (int index = 0; index < NB_DIRECTIONS; index++) {
+        sim_min(&next_us, sim->relays[index].switch_us);
+        sim_min(&next_us, sim->isr_us[index]);
+
+        uint64_t limit_us = sim_endstop_limit_us(sim, index) + 1;
+        if (sim->inputs[index] && sim->relays[index].contact && (limit_us > sim->now_us)) { sim_min(&next_us, limit_us); }
+    }
+
+    uint64_t hold_us = sim_hold_limit_us(sim) + 1;
+    if (sim->hold_active && (hold_us > sim->now_us)) { sim_min(&next_us, hold_us); }
+
+    return next_us;
+}
+
+/**
+ * @brief Draw the scenario and initialize the firmware on it, as at boot
+ */
+static void sim_init(sim_t * sim, uint64_t seed, sim_fault_t fault, bool trace, sim_result_t * result) {
+    memset(sim, 0, sizeof(sim_t));
+    memset(result, 0, sizeof(sim_result_t));
+    sim->rng = seed;
+    sim->fault = fault;
+    sim->trace = trace;
+    sim->result = result;
+
+    sim->operate_us = (uint32_t)sim_range(sim, SIM_OPERATE_MIN_US, SIM_OPERATE_MAX_US);
+    sim->release_us = (uint32_t)sim_range(sim, SIM_RELEASE_MIN_US, SIM_RELEASE_MAX_US);
+    uint16_t dead_time_ms = dead_times_ms[sim_range(sim, 0, ARRAY_SIZE(dead_times_ms) - 1)];
+    if (fault == SIM_FAULT_NO_DEAD_TIME) {
+        sim->release_us = sim->operate_us + (uint32_t)sim_range(sim, 1000, 5000);
+        dead_time_ms = 0;
+    }
+    sim->rate_um_s[0] = (uint32_t)sim_range(sim, SIM_RATE_UP_MIN, SIM_RATE_UP_MAX);
+    sim->rate_um_s[1] = (uint32_t)sim_range(sim, SIM_RATE_DOWN_MIN, SIM_RATE_DOWN_MAX);
+    sim->position_um = (int64_t)sim_range(sim, 0, SIM_TRAVEL_UM);
+    sim->relays[0].switch_us = NEVER;
+    sim->relays[1].switch_us = NEVER;
+
+    changeover_init(&sim->changeover, dead_time_ms);
+    sim->changeover_us = NEVER;
+    motion_init(&sim->motion, &sim_output, sim);
+    deadman_init(&sim->deadman);
+    deadman_set_timing(&sim->deadman, keepalive_periods_ms[sim_range(sim, 0, ARRAY_SIZE(keepalive_periods_ms) - 1)],
+                       missed_intervals[sim_range(sim, 0, ARRAY_SIZE(missed_intervals) - 1)]);
+    deadman_set_conn_interval(&sim->deadman, conn_intervals[sim_range(sim, 0, ARRAY_SIZE(conn_intervals) - 1)]);
+    sim->alarm_us = NEVER;
+
+    // Inputs read at boot, as endstop_gpio_init() does
+    sim->isr_us[0] = sim->isr_us[1] = NEVER;
+    sim_inputs(sim, false);
+    motion_limit(&sim->motion, MOTION_UP, sim->inputs[0]);
+    motion_limit(&sim->motion, MOTION_DOWN, sim->inputs[1]);
+
+    sim->client = CLIENT_IDLE;
+    sim->client_us = sim_range(sim, 0, 2000000);
+    sim->button_us = sim_range(sim, 1000000, 30000000);
+    sim->obstacle_us = sim_range(sim, 5000000, 60000000);
+    sim->wire_cut_us = NEVER;
+    if (sim_range(sim, 0, 31) == 0) {
+        sim->wire_cut_us = sim_range(sim, 0, SIM_SCENARIO_US);
+        sim->wire_cut_index = (int)sim_range(sim, 0, 1);
+    }
+
+    sim_trace(sim, "operate %u us, release %u us, dead-time %u ms, rates %u/%u um/s, position %.3f mm, deadman %u us",
+              sim->operate_us, sim->release_us, dead_time_ms, sim->rate_um_s[0], sim->rate_um_s[1], sim->position_um / 1e3, sim->deadman.timeout_us);
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file sim_model.hpp
+ * @name sim_violation_name
+ */
+const char * sim_violation_name(sim_violation_t violation) {
+    static const char * names[SIM_NB_VIOLATIONS] = {
+        "short", "end-stop", "hard stop", "hold-to-run", "false trip", "state",
+    };
+    return (violation < SIM_NB_VIOLATIONS) ? names[violation] : "?";
+}
+
+/**
+ * @file sim_model.hpp
+ * @name sim_fault_name
+ */
+const char * sim_fault_name(sim_fault_t fault) {
+    static const char * names[SIM_NB_FAULTS] = {
+        "none", "no-endstop-isr", "no-deadman", "no-dead-time",
+    };
+    return (fault < SIM_NB_FAULTS) ? names[fault] : "?";
+}
+
+/**
+ * @file sim_model.hpp
+ * @name sim_run
+ */
+void sim_run(uint64_t seed, sim_fault_t fault, bool trace, sim_result_t * result) {
+    sim_t sim;
+    sim_init(&sim, seed, fault, trace, result);
+
+    while (true) {
+        uint64_t next_us = sim_next_us(&sim);
+        if (next_us > SIM_SCENARIO_US) {
+            sim_advance(&sim, SIM_SCENARIO_US);
+            break;
+        }
+
+        sim_advance(&sim, next_us);
+        sim_inputs(&sim, true);
+        result->nb_events++;
+
+        for (int index = 0; index < NB_DIRECTIONS; index++) {
+            relay_model_t * relay = &sim.relays[index];
+            if (relay->switch_us == next_us) {
+                relay->contact = relay->coil;
+                relay->switch_us = NEVER;
+                sim_trace(&sim, "Relay%d contact %s", index + 1, relay->contact ? "closed" : "open");
+            }
+        }
+        for (int index = 0; index < NB_DIRECTIONS; index++) {
+            if (sim.isr_us[index] == next_us) { sim_endstop_isr(&sim, index); }
+        }
+        if (sim.alarm_us == next_us) { sim_alarm(&sim); }
+        if (sim.changeover_us == next_us) { sim_changeover_alarm(&sim); }
+        if (sim.client_us == next_us) { sim_client(&sim); }
+        if (sim.button_us == next_us) { sim_button(&sim); }
+        if (sim.obstacle_us == next_us) { sim_obstacle(&sim); }
+        if (sim.wire_cut_us == next_us) {
+            sim.wire_cut[sim.wire_cut_index] = true;
+            sim.wire_cut_us = NEVER;
+            sim_trace(&sim, "%s end-stop wire cut", (sim.wire_cut_index == 0) ? "Up" : "Down");
+            sim_inputs(&sim, true);
+        }
+
+        sim_check(&sim);
+    }
+
+    for (int source = 0; source < MOTION_NB_SOURCES; source++) { result->nb_commands += sim.motion.nb_commands[source]; }
+    result->nb_limit_cuts = sim.motion.nb_limit_cuts;
+    result->nb_blocked = sim.motion.nb_blocked;
+    result->nb_trips = sim.deadman.nb_trips;
+}
@@ -0,0 +1,125 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: sim_model.hpp
+-- Description: Closed-loop scenario on a virtual clock: the firmware command
+--              path (motion.c, deadman.c, changeover.c) driving a model of
+--              the relays and of the actuator, with the safety invariants
+--              checked on each event
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef SIM_MODEL_HPP
+#define SIM_MODEL_HPP
+
+#include <stdint.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Virtual duration of a scenario */
+#define SIM_SCENARIO_US         (120 * 1000000ULL)
+
+/** @brief Actuator stroke between the mechanical stops */
+#define SIM_TRAVEL_UM           300000
+/** @brief End-stop switch position, before each mechanical stop */
+#define SIM_SWITCH_MARGIN_UM    3000
+/** @brief Travel rate ranges (um/s), drawn for each scenario */
+#define SIM_RATE_UP_MIN         8000
+#define SIM_RATE_UP_MAX         12000
+#define SIM_RATE_DOWN_MIN       10000
+#define SIM_RATE_DOWN_MAX       14000
+
+/** @brief Relay contact delays, drawn for each scenario. The ranges overlap:
+ *         a release may be slower than the operate time, the changeover
+ *         dead-time keeps the contacts apart as long as the release is
+ *         shorter than the dead-time plus the operate time */
+#define SIM_OPERATE_MIN_US      3000
+#define SIM_OPERATE_MAX_US      10000
+#define SIM_RELEASE_MIN_US      2000
+#define SIM_RELEASE_MAX_US      12000
+
+/** @brief End-stop edge to interrupt handler */
+#define SIM_ISR_LATENCY_US      20
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef enum {
+    SIM_VIOLATION_SHORT = 0,    /**> Up and Down contacts closed together */
+    SIM_VIOLATION_ENDSTOP,      /**> Contact still closed towards an active end-stop after the interrupt and release delays */
+    SIM_VIOLATION_HARD_STOP,    /**> Motor driven against a mechanical stop */
+    SIM_VIOLATION_HOLD_TO_RUN,  /**> Hold-to-run motion past the last keep-alive, deadman timeout and release delay */
+    SIM_VIOLATION_FALSE_TRIP,   /**> Deadman trip while the keep-alives arrive in time */
+    SIM_VIOLATION_STATE,        /**> Relay outputs differ from the applied command */
+    SIM_NB_VIOLATIONS
+} sim_violation_t;
+
+/** @brief Firmware fault injected to check that the invariants catch it */
+typedef enum {
+    SIM_FAULT_NONE = 0,         /**> Firmware as is */
+    SIM_FAULT_NO_ENDSTOP_ISR,   /**> End-stop edges ignored */
+    SIM_FAULT_NO_DEADMAN,       /**> Deadman trip does not stop the motor */
+    SIM_FAULT_NO_DEAD_TIME,     /**> No changeover dead-time, relays releasing slower than they operate */
+    SIM_NB_FAULTS
+} sim_fault_t;
+
+typedef struct {
+    uint32_t nb_events;                         /**> Events processed */
+    uint32_t nb_commands;                       /**> Commands applied, all sources */
+    uint32_t nb_limit_cuts;                     /**> Motions cut by an end-stop */
+    uint32_t nb_blocked;                        /**> Commands blocked by an end-stop */
+    uint32_t nb_trips;                          /**> Deadman trips */
+    uint64_t travel_um;                         /**> Distance travelled */
+    uint64_t stall_us;                          /**> Time driven while blocked by an obstacle */
+    uint32_t violations;                        /**> Violated invariants, bit per sim_violation_t */
+    uint64_t violation_us[SIM_NB_VIOLATIONS];   /**> Time of the first violation of each invariant */
+} sim_result_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Name of an invariant
+ *
+ * @param violation The invariant
+ * @return const char* Its name
+ */
+const char * sim_violation_name(sim_violation_t violation);
+
+/**
+ * @brief Name of a fault
+ *
+ * @param fault The fault
+ * @return const char* Its name
+ */
+const char * sim_fault_name(sim_fault_t fault);
+
+/**
+ * @brief Run one scenario: actuator, relays and command scripts drawn from
+ *        the seed, so that a scenario is replayed from its seed alone
+ *
+ * @param seed The scenario seed
+ * @param fault Firmware fault injected
+ * @param trace Print each event
+ * @param result Output result
+ */
+void sim_run(uint64_t seed, sim_fault_t fault, bool trace, sim_result_t * result);
+
+#endif // SIM_MODEL_HPP
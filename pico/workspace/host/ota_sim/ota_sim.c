@@ -0,0 +1,483 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: ota_sim.c
+-- Description: Firmware update streamed over a simulated link into a
+--              simulated flash: throughput, resume, staging and boot copy
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ota.h"
+#include "crc32.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Flash size of the Pico W */
+#define FLASH_SIZE          (2 * 1024 * 1024)
+
+/** @brief Flash timings, typical values of the W25Q16JV */
+#define FLASH_SECTOR_ERASE_US   45000
+#define FLASH_PAGE_PROGRAM_US   400
+
+/** @brief Connection interval: 7.5 ms */
+#define CONN_INTERVAL_US    7500
+/** @brief ATT MTU negotiated by the client, with the LE data length at 251 */
+#define LINK_MTU            247
+/** @brief Write commands sent by the client per connection event */
+#define PACKETS_PER_EVENT   6
+/** @brief Packets held by the controller while the run loop is blocked */
+#define CONTROLLER_BUFFERS  8
+/** @brief Packets dropped by the stack, per thousand */
+#define PACKET_LOSS         5
+/** @brief Link dropped at this fraction of the image, then reconnected */
+#define LINK_DROP_PERCENT   40
+#define RECONNECT_US        1000000
+
+/** @brief Image size of the streaming test, a typical firmware */
+#define IMAGE_SIZE          (600 * 1024)
+/** @brief Lowest sustained throughput accepted (bytes/s) */
+#define MIN_THROUGHPUT      50000
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+/** @brief Simulated flash and receiver side */
+typedef struct {
+    uint8_t memory[FLASH_SIZE];     /**> Flash contents */
+    uint64_t busy_us;               /**> Flash time of the last operations */
+    uint32_t nb_errors;             /**> Misaligned or 0 to 1 programs */
+    uint32_t nb_bank_a_writes;      /**> Writes to the running image */
+    uint32_t max_erase;             /**> Largest erase, the longest time with the interrupts disabled */
+    bool moving;                    /**> Relays on: flash writes not allowed */
+    bool broken;                    /**> Flash operations fail */
+    bool pending;                   /**> Worker notified */
+    ota_flash_t * boot_flash;       /**> Operations overwritten by the first bank A erase, as if they sat in the running image */
+} sim_t;
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+static sim_t sim;
+static uint8_t image[IMAGE_SIZE];
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Erase model: sector aligned, at the sector erase time
+ */
+static bool sim_erase(uint32_t offset, uint32_t size, void * context) {
+    sim_t * s = (sim_t *)context;
+    if (s->broken) { return false; }
+    if ((offset % OTA_SECTOR_SIZE) || (size % OTA_SECTOR_SIZE) || (offset + size > FLASH_SIZE)) { s->nb_errors++; return true; }
+    if (s->moving) { s->nb_errors++; }
+    if (offset < OTA_BANK_SIZE) { s->nb_bank_a_writes++; }
+    if ((offset < OTA_BANK_SIZE) && (s->boot_flash != NULL)) { memset(s->boot_flash, 0, sizeof(ota_flash_t)); }
+    if (size > s->max_erase) { s->max_erase = size; }
+    memset(&s->memory[offset], 0xFF, size);
+    s->busy_us += (size / OTA_SECTOR_SIZE) * FLASH_SECTOR_ERASE_US;
+    return true;
+}
+
+/**
+ * @brief Program model: page aligned, bits can only be cleared
+ */
+static bool sim_program(uint32_t offset, const uint8_t * data, uint32_t size, void * context) {
+    sim_t * s = (sim_t *)context;
+    if (s->broken) { return false; }
+    if ((offset % OTA_PAGE_SIZE) || (size % OTA_PAGE_SIZE) || (offset + size > FLASH_SIZE)) { s->nb_errors++; return true; }
+    if (s->moving) { s->nb_errors++; }
+    if (offset < OTA_BANK_SIZE) { s->nb_bank_a_writes++; }
+    for (uint32_t i = 0; i < size; i++) {
+        if ((s->memory[offset + i] & data[i]) != data[i]) { s->nb_errors++; }
+        s->memory[offset + i] &= data[i];
+    }
+    s->busy_us += (size / OTA_PAGE_SIZE) * FLASH_PAGE_PROGRAM_US;
+    return true;
+}
+
+/**
+ * @brief Flash writes allowed while the relays are off, as ota_flash_allowed()
+ */
+static bool sim_allowed(void * context) {
+    return !((sim_t *)context)->moving;
+}
+
+static const ota_flash_t sim_flash = { sim.memory, &sim_erase, &sim_program, &sim, &sim_allowed };
+
+/**
+ * @brief Receiver event, as ota_handle_event() notifies the worker
+ */
+static void sim_event(void * context) {
+    ((sim_t *)context)->pending = true;
+}
+
+/**
+ * @brief Worker model, as ota_worker_handler(): the run loop is blocked for
+ *        the flash time
+ *
+ * @return uint64_t Time spent in the flash operations
+ */
+static uint64_t sim_worker(ota_t * ota) {
+    if (!sim.pending) { return 0; }
+    sim.pending = false;
+    sim.busy_us = 0;
+    ota_flush(ota);
+    return sim.busy_us;
+}
+
+/**
+ * @brief Fresh flash: bank A holds an old image, the rest is erased
+ */
+static void sim_reset(ota_t * ota) {
+    memset(&sim, 0, sizeof(sim));
+    memset(sim.memory, 0xFF, FLASH_SIZE);
+    memset(sim.memory, 0xA5, 64 * 1024);
+    ota_init(ota, &sim_flash, &sim_event, &sim);
+}
+
+/**
+ * @brief START or COMMIT command
+ */
+static bool sim_command(ota_t * ota, uint8_t command, uint32_t size, uint32_t crc, uint64_t now_us) {
+    uint8_t frame[9] = { command };
+    for (int i = 0; i < 4; i++) {
+        frame[1 + i] = (uint8_t)(size >> (8 * i));
+        frame[5 + i] = (uint8_t)(crc >> (8 * i));
+    }
+    return ota_control(ota, frame, (command == OTA_CMD_START) ? 9 : 1, now_us);
+}
+
+/**
+ * @brief Data packet of the image at an offset, sized for the link MTU
+ */
+static bool sim_data(ota_t * ota, const uint8_t * data, uint32_t size, uint32_t offset, uint64_t now_us) {
+    uint8_t packet[LINK_MTU - 3];
+    uint32_t len = size - offset;
+    if (len > sizeof(packet) - OTA_DATA_HEADER_SIZE) { len = sizeof(packet) - OTA_DATA_HEADER_SIZE; }
+    for (int i = 0; i < 4; i++) { packet[i] = (uint8_t)(offset >> (8 * i)); }
+    memcpy(&packet[OTA_DATA_HEADER_SIZE], &data[offset], len);
+    return ota_data(ota, packet, (uint16_t)(OTA_DATA_HEADER_SIZE + len), now_us);
+}
+
+/**
+ * @brief Status field: next image offset expected
+ */
+static uint32_t status_offset(const ota_t * ota) {
+    uint8_t status[OTA_STATUS_SIZE];
+    ota_status(ota, status);
+    return (uint32_t)status[2] | ((uint32_t)status[3] << 8) | ((uint32_t)status[4] << 16) | ((uint32_t)status[5] << 24);
+}
+
+/**
+ * @brief Stream an image over the simulated link: the client sends write
+ *        commands every connection event, goes back to the expected offset on
+ *        a gap notification, and resumes with START after a link drop
+ */
+static int test_stream(void) {
+    static ota_t ota;
+    sim_reset(&ota);
+    srand(1);
+    for (uint32_t i = 0; i < IMAGE_SIZE; i++) { image[i] = (uint8_t)rand(); }
+    uint32_t crc = crc32_update(0, image, IMAGE_SIZE);
+
+    uint64_t now = 0;
+    uint64_t busy_until = 0;
+    uint32_t next = 0;                      // Client: next offset to send
+    uint32_t queue[CONTROLLER_BUFFERS];     // Controller: packets held while the run loop is blocked
+    uint32_t nb_queued = 0;
+    uint32_t revision = 0;                  // Client: last status seen
+    uint32_t nb_packets = 0;
+    uint32_t nb_lost = 0;
+    bool dropped = false;
+
+    CHECK(sim_command(&ota, OTA_CMD_START, IMAGE_SIZE, crc, now));
+    revision = ota.revision;
+
+    while (ota.received < IMAGE_SIZE) {
+        now += CONN_INTERVAL_US;
+
+        // Link drop: the packets in flight are lost, the client reconnects
+        // and resumes from the offset given in the status
+        if (!dropped && (ota.received >= (uint64_t)IMAGE_SIZE * LINK_DROP_PERCENT / 100)) {
+            dropped = true;
+            nb_queued = 0;
+            now += RECONNECT_US;
+            CHECK(sim_command(&ota, OTA_CMD_START, IMAGE_SIZE, crc, now));
+            next = status_offset(&ota);
+            revision = ota.revision;
+            continue;
+        }
+
+        // Run loop back: the packets held by the controller are delivered first
+        bool blocked = now < busy_until;
+        if (!blocked) {
+            for (uint32_t i = 0; i < nb_queued; i++) { sim_data(&ota, image, IMAGE_SIZE, queue[i], now); }
+            nb_queued = 0;
+        }
+
+        // Run loop blocked by the flash: the controller holds a few packets,
+        // then the link layer flow control holds the client
+        for (int i = 0; (i < PACKETS_PER_EVENT) && (next < IMAGE_SIZE); i++) {
+            if (blocked && (nb_queued >= CONTROLLER_BUFFERS)) { break; }
+            uint32_t offset = next;
+            next += LINK_MTU - 3 - OTA_DATA_HEADER_SIZE;
+            if (next > IMAGE_SIZE) { next = IMAGE_SIZE; }
+            nb_packets++;
+            if ((rand() % 1000) < PACKET_LOSS) { nb_lost++; continue; }
+            if (blocked) { queue[nb_queued++] = offset; } else { sim_data(&ota, image, IMAGE_SIZE, offset, now); }
+        }
+        if (blocked) { continue; }
+
+        busy_until = now + sim_worker(&ota);
+
+        // Status notification received at the next event: rewind on a gap.
+        // Once the last packet is sent, the client reads the status instead
+        if (((ota.revision != revision) && ota.gap) || (next >= IMAGE_SIZE)) { next = status_offset(&ota); }
+        revision = ota.revision;
+    }
+
+    // Last sectors programmed, then the image is checked and staged
+    while (ota.programmed < IMAGE_SIZE) {
+        now = (busy_until > now) ? busy_until : now + CONN_INTERVAL_US;
+        busy_until = now + sim_worker(&ota);
+    }
+    CHECK(sim_command(&ota, OTA_CMD_COMMIT, 0, 0, now));
+    now += sim_worker(&ota);
+    CHECK(ota.state == OTA_STATE_READY);
+    CHECK(ota.error == OTA_ERROR_NONE);
+    CHECK(sim.nb_errors == 0);
+    CHECK(sim.nb_bank_a_writes == 0);
+    CHECK(sim.max_erase == OTA_SECTOR_SIZE);
+    CHECK(memcmp(&sim.memory[OTA_BANK_B_OFFSET], image, IMAGE_SIZE) == 0);
+
+    uint32_t sustained = (uint32_t)((uint64_t)IMAGE_SIZE * 1000000 / now);
+    printf("ota_sim: %u KB in %.2f s: %u B/s sustained, %u B/s in the status\n",
+           IMAGE_SIZE / 1024, (double)now / 1e6, sustained, ota_throughput(&ota));
+    printf("ota_sim: %u packets, %u lost, %u out of sequence, %u overruns, 1 link drop\n",
+           nb_packets, nb_lost, ota.nb_gaps, ota.nb_overruns);
+    CHECK(sustained >= MIN_THROUGHPUT);
+
+    // Next boot: the staged image is copied over the running one
+    ota_meta_t meta;
+    CHECK(ota_boot_pending(&sim_flash, &meta));
+    CHECK((meta.size == IMAGE_SIZE) && (meta.crc == crc));
+    // The operations are read once: the copy loop survives their sector
+    // being rewritten under it
+    ota_flash_t boot_flash = sim_flash;
+    sim.boot_flash = &boot_flash;
+    ota_swap(&boot_flash, &meta);
+    sim.boot_flash = NULL;
+    CHECK(sim.nb_errors == 0);
+    CHECK(memcmp(&sim.memory[OTA_BANK_A_OFFSET], image, IMAGE_SIZE) == 0);
+    CHECK(!ota_boot_pending(&sim_flash, &meta));
+
+    printf("test_stream: PASS\n");
+    return 0;
+}
+
+/**
+ * @brief Worker late: the packet overflowing the second buffer finds the
+ *        first one still full and is dropped, then resent from the offset
+ *        given in the status
+ */
+static int test_overrun(void) {
+    static ota_t ota;
+    static uint8_t data[4 * OTA_SECTOR_SIZE];
+    sim_reset(&ota);
+    for (uint32_t i = 0; i < sizeof(data); i++) { data[i] = (uint8_t)(i * 13); }
+
+    CHECK(sim_command(&ota, OTA_CMD_START, sizeof(data), crc32_update(0, data, sizeof(data)), 0));
+    uint32_t offset = 0;
+    while (sim_data(&ota, data, sizeof(data), offset, 0)) { offset = ota.received; }
+    CHECK((ota.received > OTA_SECTOR_SIZE) && (ota.received <= 2 * OTA_SECTOR_SIZE));
+    CHECK(ota.gap && (ota.nb_overruns == 1));
+
+    // Still full: counted, reported once
+    uint32_t revision = ota.revision;
+    CHECK(!sim_data(&ota, data, sizeof(data), offset, 0));
+    CHECK((ota.nb_overruns == 2) && (ota.revision == revision));
+
+    sim_worker(&ota);
+    CHECK(ota.programmed == OTA_SECTOR_SIZE);
+    for (offset = status_offset(&ota); offset < sizeof(data); offset = ota.received) {
+        CHECK(sim_data(&ota, data, sizeof(data), offset, 0));
+        sim_worker(&ota);
+    }
+    CHECK(!ota.gap);
+    CHECK(sim_command(&ota, OTA_CMD_COMMIT, 0, 0, 0));
+    sim_worker(&ota);
+    CHECK(ota.state == OTA_STATE_READY);
+    CHECK(memcmp(&sim.memory[OTA_BANK_B_OFFSET], data, sizeof(data)) == 0);
+
+    printf("test_overrun: PASS\n");
+    return 0;
+}
+
+/**
+ * @brief Corrupted image, oversized image, data past the end, commands out
+ *        of sequence: the transfer fails and nothing is staged
+ */
+static int test_errors(void) {
+    static ota_t ota;
+    static uint8_t data[OTA_SECTOR_SIZE + 1000];
+    ota_meta_t meta;
+    for (uint32_t i = 0; i < sizeof(data); i++) { data[i] = (uint8_t)(i ^ 0x5A); }
+    uint32_t crc = crc32_update(0, data, sizeof(data));
+
+    // Wrong CRC: detected once the whole image is in the flash
+    sim_reset(&ota);
+    CHECK(sim_command(&ota, OTA_CMD_START, sizeof(data), crc ^ 1, 0));
+    for (uint32_t offset = 0; offset < sizeof(data); offset = ota.received) { CHECK(sim_data(&ota, data, sizeof(data), offset, 0)); }
+    CHECK(sim_command(&ota, OTA_CMD_COMMIT, 0, 0, 0));
+    sim_worker(&ota);
+    CHECK((ota.state == OTA_STATE_ERROR) && (ota.error == OTA_ERROR_CRC));
+    CHECK(!ota_boot_pending(&sim_flash, &meta));
+
+    // Image larger than a bank
+    sim_reset(&ota);
+    CHECK(!sim_command(&ota, OTA_CMD_START, OTA_BANK_SIZE + 1, crc, 0));
+    CHECK((ota.state == OTA_STATE_ERROR) && (ota.error == OTA_ERROR_SIZE));
+
+    // Data past the announced size
+    CHECK(sim_command(&ota, OTA_CMD_START, 100, crc, 0));
+    CHECK(!sim_data(&ota, data, sizeof(data), 0, 0));
+    CHECK(ota.error == OTA_ERROR_SIZE);
+
+    // Commit before the end, malformed and unknown commands
+    CHECK(sim_command(&ota, OTA_CMD_START, sizeof(data), crc, 0));
+    CHECK(sim_data(&ota, data, sizeof(data), 0, 0));
+    CHECK(!sim_command(&ota, OTA_CMD_COMMIT, 0, 0, 0));
+    CHECK(ota.error == OTA_ERROR_STATE);
+    uint8_t unknown = 0x7F;
+    CHECK(!ota_control(&ota, &unknown, 1, 0));
+    CHECK(ota.error == OTA_ERROR_COMMAND);
+    CHECK(!ota_control(&ota, data, 0, 0));
+
+    // Abort: back to idle, data ignored
+    uint8_t abort_command = OTA_CMD_ABORT;
+    CHECK(sim_command(&ota, OTA_CMD_START, sizeof(data), crc, 0));
+    CHECK(ota_control(&ota, &abort_command, 1, 0));
+    CHECK(ota.state == OTA_STATE_IDLE);
+    CHECK(!sim_data(&ota, data, sizeof(data), 0, 0));
+
+    // Corrupted update record: ignored at boot
+    sim_reset(&ota);
+    CHECK(sim_command(&ota, OTA_CMD_START, sizeof(data), crc, 0));
+    for (uint32_t offset = 0; offset < sizeof(data); offset = ota.received) { CHECK(sim_data(&ota, data, sizeof(data), offset, 0)); }
+    CHECK(sim_command(&ota, OTA_CMD_COMMIT, 0, 0, 0));
+    sim_worker(&ota);
+    CHECK(ota.state == OTA_STATE_READY);
+    CHECK(ota_boot_pending(&sim_flash, &meta));
+    sim.memory[OTA_META_OFFSET + 4] ^= 0x01;
+    CHECK(!ota_boot_pending(&sim_flash, &meta));
+    CHECK(sim.nb_errors == 0);
+
+    printf("test_errors: PASS\n");
+    return 0;
+}
+
+/**
+ * @brief Sofa moving: no flash write, START and data refused without losing
+ *        the transfer, deferred sectors programmed once stopped; a flash
+ *        failure fails the transfer
+ */
+static int test_moving(void) {
+    static ota_t ota;
+    static uint8_t data[3 * OTA_SECTOR_SIZE];
+    for (uint32_t i = 0; i < sizeof(data); i++) { data[i] = (uint8_t)(i * 7); }
+    uint32_t crc = crc32_update(0, data, sizeof(data));
+
+    // START refused while moving
+    sim_reset(&ota);
+    sim.moving = true;
+    CHECK(!sim_command(&ota, OTA_CMD_START, sizeof(data), crc, 0));
+    CHECK((ota.state == OTA_STATE_IDLE) && (ota.error == OTA_ERROR_BUSY));
+    sim.moving = false;
+    CHECK(sim_command(&ota, OTA_CMD_START, sizeof(data), crc, 0));
+    CHECK(ota.error == OTA_ERROR_NONE);
+
+    // A full sector waits while the sofa moves, data refused once reported
+    uint32_t offset = 0;
+    while (ota.received < OTA_SECTOR_SIZE) { CHECK(sim_data(&ota, data, sizeof(data), offset, 0)); offset = ota.received; }
+    sim.moving = true;
+    sim_worker(&ota);
+    CHECK((ota.programmed == 0) && ota_pending(&ota));
+    uint32_t revision = ota.revision;
+    CHECK(!sim_data(&ota, data, sizeof(data), offset, 0));
+    CHECK((ota.state == OTA_STATE_RECEIVING) && (ota.error == OTA_ERROR_BUSY) && (ota.revision == revision + 1));
+    CHECK(!sim_data(&ota, data, sizeof(data), offset, 0));
+    CHECK(ota.revision == revision + 1);
+
+    // Stopped: the deferred sector is programmed, data waits for START
+    sim.moving = false;
+    sim.pending = true;
+    sim_worker(&ota);
+    CHECK((ota.programmed == OTA_SECTOR_SIZE) && !ota_pending(&ota));
+    CHECK(!sim_data(&ota, data, sizeof(data), offset, 0));
+    CHECK(sim_command(&ota, OTA_CMD_START, sizeof(data), crc, 0));
+    CHECK((ota.error == OTA_ERROR_NONE) && (status_offset(&ota) == offset));
+    for (; offset < sizeof(data); offset = ota.received) {
+        CHECK(sim_data(&ota, data, sizeof(data), offset, 0));
+        sim_worker(&ota);
+    }
+    CHECK(sim_command(&ota, OTA_CMD_COMMIT, 0, 0, 0));
+    sim_worker(&ota);
+    CHECK(ota.state == OTA_STATE_READY);
+    CHECK(sim.nb_errors == 0);
+    CHECK(memcmp(&sim.memory[OTA_BANK_B_OFFSET], data, sizeof(data)) == 0);
+
+    // Flash failure: the transfer fails, nothing is staged
+    sim_reset(&ota);
+    CHECK(sim_command(&ota, OTA_CMD_START, sizeof(data), crc, 0));
+    for (offset = 0; ota.received < OTA_SECTOR_SIZE; offset = ota.received) { CHECK(sim_data(&ota, data, sizeof(data), offset, 0)); }
+    sim.broken = true;
+    sim_worker(&ota);
+    CHECK((ota.state == OTA_STATE_ERROR) && (ota.error == OTA_ERROR_FLASH));
+    CHECK(!ota_pending(&ota));
+    ota_meta_t meta;
+    CHECK(!ota_boot_pending(&sim_flash, &meta));
+
+    printf("test_moving: PASS\n");
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Main
+//----------------------------------------------------------------
+
+int main(void)
+{
+    if (test_stream()) { return 1; }
+    if (test_overrun()) { return 1; }
+    if (test_errors()) { return 1; }
+    if (test_moving()) { return 1; }
+
+    printf("ota_sim: PASS\n");
+    return 0;
+}
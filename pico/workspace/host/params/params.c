@@ -0,0 +1,473 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: params.c
+-- Description: Runtime parameters: range and consistency checks, atomic
+--              apply, commit and rollback, stored record, module timings
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "params.h"
+#include "deadman.h"
+#include "power.h"
+#include "adv_state.h"
+#include "changeover.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define MS  1000ULL
+#define NB_RANDOM_COMMANDS 100000
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+/** @brief Number of events received */
+static uint32_t nb_events = 0;
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+static void params_event(void * context) {
+    (void)context;
+    nb_events++;
+}
+
+/**
+ * @brief Append an APPLY entry: identifier, then the value on the type size
+ */
+static uint16_t append_entry(uint8_t * command, uint16_t len, uint8_t id, uint32_t value) {
+    const params_info_t * info = params_info(id);
+    uint8_t size = (info != NULL) ? info->size : 2;
+
+    command[len++] = id;
+    for (uint8_t i = 0; i < size; i++) { command[len++] = (uint8_t)(value >> (8 * i)); }
+    return len;
+}
+
+/**
+ * @brief Check that the applied values are the given ones
+ */
+static bool values_equal(const params_t * params, const uint32_t * values) {
+    return memcmp(params->values, values, sizeof(params->values)) == 0;
+}
+
+/**
+ * @brief Defaults: the compiled-in values, valid, and the snapshot layout
+ */
+static int test_defaults(void) {
+    params_t params;
+    uint8_t error_param;
+    params_init(&params, &params_event, NULL);
+
+    CHECK(params_check(params.values, &error_param) == PARAMS_ERROR_NONE);
+    CHECK(error_param == PARAMS_NO_PARAM);
+    CHECK(params_get(&params, PARAM_ADV_INTERVAL) == 0x0030);
+    CHECK(params_get(&params, PARAM_CONN_INTERVAL_MIN) == 12);
+    CHECK(params_get(&params, PARAM_CONN_INTERVAL_MAX) == 12);
+    CHECK(params_get(&params, PARAM_SUPERVISION_TIMEOUT) == 0x0048);
+    CHECK(params_get(&params, PARAM_KEEPALIVE_PERIOD_MS) == DEADMAN_KEEPALIVE_PERIOD_MS);
+    CHECK(params_get(&params, PARAM_MISSED_INTERVALS) == DEADMAN_MISSED_INTERVALS);
+    CHECK(params_get(&params, PARAM_CONNECTED_IDLE_MS) == POWER_CONNECTED_IDLE_MS);
+    CHECK(params_get(&params, PARAM_ADV_MIN_INTERVAL_MS) == ADV_STATE_MIN_INTERVAL_MS);
+    CHECK(params_get(&params, PARAM_CHANGEOVER_MS) == CHANGEOVER_DEAD_TIME_MS);
+    CHECK(!params.trial && (params_next_deadline_us(&params) == 0));
+    CHECK(params_info(PARAM_NB) == NULL);
+
+    // Each value on its type size, the sizes add up to the snapshot
+    uint16_t size = PARAMS_SNAPSHOT_HEADER_SIZE;
+    for (int id = 0; id < PARAM_NB; id++) { size += params_info((uint8_t)id)->size; }
+    CHECK(size == PARAMS_SNAPSHOT_SIZE);
+
+    static const uint8_t expected[PARAMS_SNAPSHOT_SIZE] = {
+        PARAMS_RECORD_VERSION, PARAMS_ERROR_NONE, PARAMS_NO_PARAM, 0x00, PARAM_NB,
+        0x30, 0x00,
+        12, 0,
+        12, 0,
+        0, 0,
+        0x48, 0x00,
+        DEADMAN_KEEPALIVE_PERIOD_MS, 0,
+        DEADMAN_MISSED_INTERVALS,
+        (uint8_t)POWER_CONNECTED_IDLE_MS, (uint8_t)(POWER_CONNECTED_IDLE_MS >> 8), 0, 0,
+        (uint8_t)ADV_STATE_MIN_INTERVAL_MS, (uint8_t)(ADV_STATE_MIN_INTERVAL_MS >> 8),
+        CHANGEOVER_DEAD_TIME_MS, 0,
+    };
+    uint8_t snapshot[PARAMS_SNAPSHOT_SIZE];
+    params_snapshot(&params, snapshot);
+    CHECK(memcmp(snapshot, expected, sizeof(expected)) == 0);
+
+    return 0;
+}
+
+/**
+ * @brief Apply: the listed values change together, the others are kept; a
+ *        rejected command changes nothing
+ */
+static int test_apply(void) {
+    params_t params;
+    uint32_t before[PARAM_NB];
+    uint8_t command[64];
+    uint16_t len;
+
+    nb_events = 0;
+    params_init(&params, &params_event, NULL);
+
+    // Two values in one command, on trial
+    len = 0;
+    command[len++] = PARAMS_CMD_APPLY;
+    len = append_entry(command, len, PARAM_CONN_INTERVAL_MIN, 24);
+    len = append_entry(command, len, PARAM_CONN_INTERVAL_MAX, 40);
+    CHECK(params_control(&params, command, len, 1000 * MS));
+    CHECK((params_get(&params, PARAM_CONN_INTERVAL_MIN) == 24) && (params_get(&params, PARAM_CONN_INTERVAL_MAX) == 40));
+    CHECK(params_get(&params, PARAM_ADV_INTERVAL) == 0x0030);
+    CHECK(params.trial && (params_next_deadline_us(&params) == 1000 * MS + PARAMS_TRIAL_TIMEOUT_MS * MS));
+    CHECK((params.revision == 1) && (params.store_revision == 0) && (nb_events == 1));
+    CHECK(params.stored.values[PARAM_CONN_INTERVAL_MAX] == 12);
+
+    uint8_t snapshot[PARAMS_SNAPSHOT_SIZE];
+    params_snapshot(&params, snapshot);
+    CHECK((snapshot[3] & 0x01) && (snapshot[7] == 24) && (snapshot[9] == 40));
+
+    // One valid entry and one out of range: nothing is applied
+    memcpy(before, params.values, sizeof(before));
+    len = 0;
+    command[len++] = PARAMS_CMD_APPLY;
+    len = append_entry(command, len, PARAM_ADV_INTERVAL, 0x0100);
+    len = append_entry(command, len, PARAM_CONNECTED_IDLE_MS, 10);
+    CHECK(!params_control(&params, command, len, 1001 * MS));
+    CHECK(values_equal(&params, before));
+    CHECK((params.error == PARAMS_ERROR_RANGE) && (params.error_param == PARAM_CONNECTED_IDLE_MS));
+    CHECK((params.revision == 1) && (nb_events == 1));
+    params_snapshot(&params, snapshot);
+    CHECK((snapshot[1] == PARAMS_ERROR_RANGE) && (snapshot[2] == PARAM_CONNECTED_IDLE_MS));
+
+    // Unknown identifier, truncated value, empty and unknown commands
+    len = 0;
+    command[len++] = PARAMS_CMD_APPLY;
+    len = append_entry(command, len, PARAM_ADV_INTERVAL, 0x0100);
+    len = append_entry(command, len, PARAM_NB, 0);
+    CHECK(!params_control(&params, command, len, 1001 * MS));
+    CHECK((params.error == PARAMS_ERROR_PARAM) && (params.error_param == PARAM_NB));
+    CHECK(!params_control(&params, command, 3, 1001 * MS));
+    CHECK((params.error == PARAMS_ERROR_COMMAND) && (params.error_param == PARAM_ADV_INTERVAL));
+    CHECK(!params_control(&params, command, 1, 1001 * MS));
+    CHECK(params.error == PARAMS_ERROR_COMMAND);
+    CHECK(!params_control(&params, command, 0, 1001 * MS));
+    const uint8_t unknown = 0x7F;
+    CHECK(!params_control(&params, &unknown, 1, 1001 * MS));
+    CHECK(values_equal(&params, before));
+    CHECK((params.revision == 1) && (nb_events == 1) && (params.nb_rejected == 6));
+
+    // Valid one by one, not together
+    len = 0;
+    command[len++] = PARAMS_CMD_APPLY;
+    len = append_entry(command, len, PARAM_CONN_INTERVAL_MIN, 80);
+    CHECK(!params_control(&params, command, len, 1002 * MS));
+    CHECK((params.error == PARAMS_ERROR_CONSISTENCY) && (params.error_param == PARAM_CONN_INTERVAL_MIN));
+
+    // 40 x 1.25 ms with 3 skipped events: 400 ms, the timeout must exceed it
+    len = 0;
+    command[len++] = PARAMS_CMD_APPLY;
+    len = append_entry(command, len, PARAM_CONN_LATENCY, 3);
+    len = append_entry(command, len, PARAM_SUPERVISION_TIMEOUT, 40);
+    CHECK(!params_control(&params, command, len, 1002 * MS));
+    CHECK((params.error == PARAMS_ERROR_CONSISTENCY) && (params.error_param == PARAM_SUPERVISION_TIMEOUT));
+    command[len - 2] = 41;
+    CHECK(params_control(&params, command, len, 1002 * MS));
+    CHECK(params.error == PARAMS_ERROR_NONE);
+
+    // Hold-to-run overrun above PARAMS_MAX_DEADMAN_MS at the slowest interval
+    len = 0;
+    command[len++] = PARAMS_CMD_APPLY;
+    len = append_entry(command, len, PARAM_CONN_LATENCY, 0);
+    len = append_entry(command, len, PARAM_CONN_INTERVAL_MAX, 60);
+    len = append_entry(command, len, PARAM_KEEPALIVE_PERIOD_MS, 1000);
+    len = append_entry(command, len, PARAM_MISSED_INTERVALS, 16);
+    CHECK(!params_control(&params, command, len, 1003 * MS));
+    CHECK((params.error == PARAMS_ERROR_CONSISTENCY) && (params.error_param == PARAM_KEEPALIVE_PERIOD_MS));
+    command[len - 1] = 13;
+    CHECK(params_control(&params, command, len, 1003 * MS));
+    CHECK(params.revision == 3);
+
+    return 0;
+}
+
+/**
+ * @brief Commit, rollback by command, by timeout and on disconnection
+ */
+static int test_trial(void) {
+    params_t params;
+    uint8_t command[16];
+    uint16_t len;
+    const uint8_t commit = PARAMS_CMD_COMMIT;
+    const uint8_t rollback = PARAMS_CMD_ROLLBACK;
+    const uint8_t defaults = PARAMS_CMD_DEFAULTS;
+
+    nb_events = 0;
+    params_init(&params, &params_event, NULL);
+    params_record_t initial = params.stored;
+
+    // Nothing on trial
+    CHECK(!params_control(&params, &commit, 1, 0));
+    CHECK(params.error == PARAMS_ERROR_STATE);
+    CHECK(!params_control(&params, &rollback, 1, 0));
+    CHECK(!params_rollback(&params));
+    CHECK(!params_expire(&params, 1000000 * MS));
+    CHECK(nb_events == 0);
+
+    // Apply then commit: stored
+    len = 0;
+    command[len++] = PARAMS_CMD_APPLY;
+    len = append_entry(command, len, PARAM_ADV_INTERVAL, 0x00A0);
+    CHECK(params_control(&params, command, len, 0));
+    CHECK(params_control(&params, &commit, 1, 5000 * MS));
+    CHECK(!params.trial && (params.stored.values[PARAM_ADV_INTERVAL] == 0x00A0));
+    CHECK((params.revision == 1) && (params.store_revision == 1) && (nb_events == 2));
+    CHECK(memcmp(&params.stored, &initial, sizeof(initial)) != 0);
+    CHECK(!params_expire(&params, 1000000 * MS));
+
+    // Apply twice, then rollback: back to the stored set, not the first apply
+    CHECK(params_control(&params, command, len, 6000 * MS));
+    command[2] = 0x00;
+    command[3] = 0x01;
+    CHECK(params_control(&params, command, len, 7000 * MS));
+    CHECK(params_get(&params, PARAM_ADV_INTERVAL) == 0x0100);
+    CHECK(params_next_deadline_us(&params) == 7000 * MS + PARAMS_TRIAL_TIMEOUT_MS * MS);
+    CHECK(params_control(&params, &rollback, 1, 8000 * MS));
+    CHECK(!params.trial && (params_get(&params, PARAM_ADV_INTERVAL) == 0x00A0));
+    CHECK((params.revision == 4) && (params.nb_rollbacks == 1));
+
+    // No commit in time
+    CHECK(params_control(&params, command, len, 10000 * MS));
+    CHECK(!params_expire(&params, 10000 * MS + PARAMS_TRIAL_TIMEOUT_MS * MS - 1));
+    CHECK(params_expire(&params, 10000 * MS + PARAMS_TRIAL_TIMEOUT_MS * MS));
+    CHECK(params_get(&params, PARAM_ADV_INTERVAL) == 0x00A0);
+    CHECK(params_next_deadline_us(&params) == 0);
+
+    // Disconnection during the trial
+    CHECK(params_control(&params, command, len, 30000 * MS));
+    CHECK(params_rollback(&params));
+    CHECK(params_get(&params, PARAM_ADV_INTERVAL) == 0x00A0);
+    CHECK(params.nb_rollbacks == 3);
+
+    // Defaults are on trial too, then stored
+    CHECK(!params_control(&params, command, 2, 40000 * MS));
+    CHECK(params_control(&params, &defaults, 1, 40000 * MS));
+    CHECK(params.trial && (params_get(&params, PARAM_ADV_INTERVAL) == 0x0030));
+    uint32_t store_revision = params.store_revision;
+    CHECK(params_control(&params, &commit, 1, 41000 * MS));
+    CHECK(params.store_revision == store_revision + 1);
+    CHECK(memcmp(&params.stored, &initial, sizeof(initial)) == 0);
+
+    return 0;
+}
+
+/**
+ * @brief Stored record: adopted at boot if sealed and valid only
+ */
+static int test_load(void) {
+    params_t params;
+    params_t loaded;
+    params_record_t record;
+    uint8_t command[16];
+    const uint8_t commit = PARAMS_CMD_COMMIT;
+
+    params_init(&params, NULL, NULL);
+    uint16_t len = 0;
+    command[len++] = PARAMS_CMD_APPLY;
+    len = append_entry(command, len, PARAM_CONNECTED_IDLE_MS, 120000);
+    CHECK(params_control(&params, command, len, 0));
+    CHECK(params_control(&params, &commit, 1, 0));
+
+    // Committed record: adopted without event
+    nb_events = 0;
+    params_init(&loaded, &params_event, NULL);
+    CHECK(params_load(&loaded, &params.stored));
+    CHECK(params_get(&loaded, PARAM_CONNECTED_IDLE_MS) == 120000);
+    CHECK(!loaded.trial && (loaded.revision == 0) && (nb_events == 0));
+
+    // Corrupted record
+    params_init(&loaded, NULL, NULL);
+    record = params.stored;
+    record.values[PARAM_CONNECTED_IDLE_MS] ^= 1;
+    CHECK(!params_load(&loaded, &record));
+    CHECK(params_get(&loaded, PARAM_CONNECTED_IDLE_MS) == POWER_CONNECTED_IDLE_MS);
+
+    // Sealed records of another version, or out of the current ranges: the
+    // record is sealed by a commit of a trial set patched behind the checks
+    params_t other;
+    params_init(&other, NULL, NULL);
+    len = 0;
+    command[len++] = PARAMS_CMD_APPLY;
+    len = append_entry(command, len, PARAM_ADV_INTERVAL, 0x0040);
+    CHECK(params_control(&other, command, len, 0));
+    other.stored.version = PARAMS_RECORD_VERSION + 1;
+    CHECK(params_control(&other, &commit, 1, 0));
+    CHECK(!params_load(&loaded, &other.stored));
+
+    params_init(&other, NULL, NULL);
+    CHECK(params_control(&other, command, len, 0));
+    other.values[PARAM_ADV_INTERVAL] = 0x0010;
+    CHECK(params_control(&other, &commit, 1, 0));
+    CHECK(!params_load(&loaded, &other.stored));
+    CHECK(params_get(&loaded, PARAM_ADV_INTERVAL) == 0x0030);
+
+    return 0;
+}
+
+/**
+ * @brief The modules follow the applied values
+ */
+static int test_modules(void) {
+    params_t params;
+    deadman_t deadman;
+    power_manager_t pm;
+    adv_state_t adv;
+    changeover_t changeover;
+    uint8_t command[32];
+    uint64_t retry_us;
+
+    params_init(&params, NULL, NULL);
+    deadman_init(&deadman);
+    power_init(&pm, 0);
+    adv_state_init(&adv, "ble-sofa", 0, 0);
+    changeover_init(&changeover, (uint16_t)params_get(&params, PARAM_CHANGEOVER_MS));
+
+    uint16_t len = 0;
+    command[len++] = PARAMS_CMD_APPLY;
+    len = append_entry(command, len, PARAM_KEEPALIVE_PERIOD_MS, 200);
+    len = append_entry(command, len, PARAM_MISSED_INTERVALS, 2);
+    len = append_entry(command, len, PARAM_CONNECTED_IDLE_MS, 5000);
+    len = append_entry(command, len, PARAM_ADV_MIN_INTERVAL_MS, 1000);
+    len = append_entry(command, len, PARAM_CHANGEOVER_MS, 120);
+    CHECK(params_control(&params, command, len, 0));
+
+    // Deadman: the new timing with the current connection interval
+    deadman_set_conn_interval(&deadman, 24);
+    deadman_set_timing(&deadman, (uint16_t)params_get(&params, PARAM_KEEPALIVE_PERIOD_MS), (uint8_t)params_get(&params, PARAM_MISSED_INTERVALS));
+    CHECK(deadman.timeout_us == 200 * 1000 + 2 * 24 * 1250);
+    deadman_set_conn_interval(&deadman, 12);
+    CHECK(deadman.timeout_us == 200 * 1000 + 2 * 12 * 1250);
+    CHECK(deadman_kick(&deadman, 1000 * MS) == 1000 * MS + deadman.timeout_us);
+
+    // Power: connected idle timeout
+    power_set_idle_timeout(&pm, params_get(&params, PARAM_CONNECTED_IDLE_MS));
+    CHECK(power_notify(&pm, POWER_EVENT_CONNECTED, 1000 * MS) == POWER_STATE_FULL);
+    CHECK(power_next_deadline_us(&pm) == 6000 * MS);
+    CHECK(power_notify(&pm, POWER_EVENT_TIMEOUT, 6000 * MS) == POWER_STATE_LOW);
+
+    // Advertised state: rate limit
+    adv_state_set_min_interval(&adv, params_get(&params, PARAM_ADV_MIN_INTERVAL_MS));
+    CHECK(adv_state_update(&adv, 0x01, 0, 1000 * MS));
+    CHECK(!adv_state_update(&adv, 0x02, 0, 1500 * MS));
+    CHECK(adv_state_next_deadline_us(&adv) == 2000 * MS);
+
+    // Changeover: a reversal waits for the new dead-time after the release,
+    // a line released and driven again does not
+    changeover_set_dead_time(&changeover, (uint16_t)params_get(&params, PARAM_CHANGEOVER_MS));
+    CHECK((changeover_update(&changeover, 0x01, 1000 * MS, &retry_us) == 0x01) && (retry_us == 0));
+    CHECK((changeover_update(&changeover, 0x02, 2000 * MS, &retry_us) == 0x00) && (retry_us == 2120 * MS));
+    CHECK((changeover_update(&changeover, 0x02, 2119 * MS, &retry_us) == 0x00) && (retry_us == 2120 * MS));
+    CHECK((changeover_update(&changeover, 0x02, 2120 * MS, &retry_us) == 0x02) && (retry_us == 0));
+    CHECK((changeover_update(&changeover, 0x00, 3000 * MS, &retry_us) == 0x00) && (retry_us == 0));
+    CHECK((changeover_update(&changeover, 0x02, 3000 * MS, &retry_us) == 0x02) && (retry_us == 0));
+    CHECK((changeover_update(&changeover, 0x03, 4000 * MS, &retry_us) == 0x02));
+
+    return 0;
+}
+
+/**
+ * @brief Random commands: the applied set is always valid, and equal to the
+ *        stored one outside a trial
+ */
+static int test_random(void) {
+    params_t params;
+    uint8_t command[32];
+    uint8_t error_param;
+    uint64_t t = 0;
+
+    srand(1);
+    params_init(&params, NULL, NULL);
+    uint32_t nb_accepted = 0;
+
+    for (uint32_t i = 0; i < NB_RANDOM_COMMANDS; i++) {
+        t += (uint64_t)(rand() % 2000) * MS;
+        uint16_t len = 0;
+        int kind = rand() % 8;
+
+        if (kind < 5) {
+            command[len++] = PARAMS_CMD_APPLY;
+            int nb_entries = 1 + rand() % 4;
+            for (int e = 0; e < nb_entries; e++) {
+                uint8_t id = (uint8_t)(rand() % (PARAM_NB + 1));
+                const params_info_t * info = params_info(id);
+                uint32_t value = (info != NULL) ? info->min + (uint32_t)rand() % (info->max - info->min + 2) : 0;
+                if ((rand() % 16) == 0) { value = (uint32_t)rand(); }
+                len = append_entry(command, len, id, value);
+            }
+            if ((rand() % 32) == 0) { len--; }
+        }
+        else {
+            command[len++] = (uint8_t)(PARAMS_CMD_COMMIT + kind - 5);
+        }
+
+        if (params_control(&params, command, len, t)) { nb_accepted++; }
+        params_expire(&params, t);
+
+        CHECK(params_check(params.values, &error_param) == PARAMS_ERROR_NONE);
+        CHECK(params_check(params.stored.values, &error_param) == PARAMS_ERROR_NONE);
+        if (!params.trial) { CHECK(memcmp(params.values, params.stored.values, sizeof(params.values)) == 0); }
+
+        params_t loaded;
+        params_init(&loaded, NULL, NULL);
+        CHECK(params_load(&loaded, &params.stored));
+    }
+
+    printf("params: %u commands accepted, %u rejected, %u rollbacks\n", nb_accepted, params.nb_rejected, params.nb_rollbacks);
+    CHECK(nb_accepted + params.nb_rejected == NB_RANDOM_COMMANDS);
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(void)
+{
+    if (test_defaults()) { return 1; }
+    if (test_apply()) { return 1; }
+    if (test_trial()) { return 1; }
+    if (test_load()) { return 1; }
+    if (test_modules()) { return 1; }
+    if (test_random()) { return 1; }
+
+    printf("params: PASS\n");
+    return 0;
+}
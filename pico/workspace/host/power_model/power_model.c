@@ -0,0 +1,168 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: power_model.c
+-- Description: Host model of the power manager state machine
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "power.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define MS  1000ULL
+#define NB_RANDOM_EVENTS 100000
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Nominal scenario: advertise, connect, write, idle, move, disconnect
+ */
+static int test_scenario(void) {
+    power_manager_t pm;
+    uint64_t t = 0;
+
+    power_init(&pm, t);
+    CHECK(pm.state == POWER_STATE_LOW);
+    CHECK(power_next_deadline_us(&pm) == 0);
+
+    // Connection goes to full clock and arms the idle deadline
+    t += 5000 * MS;
+    CHECK(power_notify(&pm, POWER_EVENT_CONNECTED, t) == POWER_STATE_FULL);
+    CHECK(power_next_deadline_us(&pm) == t + POWER_CONNECTED_IDLE_MS * MS);
+
+    // A write pushes the deadline
+    t += 10000 * MS;
+    CHECK(power_notify(&pm, POWER_EVENT_ATT_WRITE, t) == POWER_STATE_FULL);
+    CHECK(power_next_deadline_us(&pm) == t + POWER_CONNECTED_IDLE_MS * MS);
+
+    // Early timeout does nothing, deadline timeout drops the clock
+    CHECK(power_notify(&pm, POWER_EVENT_TIMEOUT, t + 1000 * MS) == POWER_STATE_FULL);
+    t += POWER_CONNECTED_IDLE_MS * MS;
+    CHECK(power_notify(&pm, POWER_EVENT_TIMEOUT, t) == POWER_STATE_LOW);
+    CHECK(power_next_deadline_us(&pm) == 0);
+
+    // Motion keeps the full clock regardless of the idle time
+    CHECK(power_notify(&pm, POWER_EVENT_ATT_WRITE, t) == POWER_STATE_FULL);
+    CHECK(power_notify(&pm, POWER_EVENT_MOTION_START, t) == POWER_STATE_FULL);
+    CHECK(power_next_deadline_us(&pm) == 0);
+    t += 10 * POWER_CONNECTED_IDLE_MS * MS;
+    CHECK(power_notify(&pm, POWER_EVENT_TIMEOUT, t) == POWER_STATE_FULL);
+
+    // Disconnection while moving keeps full clock until motion stops
+    CHECK(power_notify(&pm, POWER_EVENT_DISCONNECTED, t) == POWER_STATE_FULL);
+    CHECK(power_notify(&pm, POWER_EVENT_MOTION_STOP, t) == POWER_STATE_LOW);
+
+    // Residency covers the whole scenario
+    power_stats_t stats;
+    power_get_stats(&pm, t, &stats);
+    CHECK(stats.residency_us[POWER_STATE_LOW] + stats.residency_us[POWER_STATE_FULL] == t);
+    CHECK(stats.residency_us[POWER_STATE_LOW] == 5000 * MS);
+    CHECK(stats.nb_transitions == 4);
+
+    // Wake-up statistics
+    power_account_wakeup(&pm, 40);
+    power_account_wakeup(&pm, 120);
+    power_account_sleep(&pm, 500);
+    CHECK(pm.stats.wake_latency_us_total == 160);
+    CHECK(pm.stats.wake_latency_us_max == 120);
+    CHECK(pm.stats.nb_wakeups == 1);
+    CHECK(pm.stats.sleep_us == 500);
+
+    return 0;
+}
+
+/**
+ * @brief Random event sequences checked against the reference rule
+ */
+static int test_random(void) {
+    power_manager_t pm;
+    uint64_t t = 0;
+    uint64_t last_activity = 0;
+    int nb_connections = 0;
+    int motion = 0;
+    uint32_t nb_transitions = 0;
+
+    srand(1);
+    power_init(&pm, t);
+    power_state_t prev = pm.state;
+
+    for (int i = 0; i < NB_RANDOM_EVENTS; i++) {
+        t += (uint64_t)(rand() % 20000) * MS;
+        power_event_t event = (power_event_t)(rand() % (POWER_EVENT_TIMEOUT + 1));
+
+        // Reference model of the inputs
+        switch (event) {
+            case POWER_EVENT_CONNECTED: nb_connections++; last_activity = t; break;
+            case POWER_EVENT_DISCONNECTED: if (nb_connections > 0) { nb_connections--; } break;
+            case POWER_EVENT_ATT_WRITE: last_activity = t; break;
+            case POWER_EVENT_MOTION_START: motion = 1; break;
+            case POWER_EVENT_MOTION_STOP: motion = 0; last_activity = t; break;
+            default: break;
+        }
+
+        power_state_t state = power_notify(&pm, event, t);
+        int full = motion || ((nb_connections > 0) && (t - last_activity < POWER_CONNECTED_IDLE_MS * MS));
+        CHECK(state == (full ? POWER_STATE_FULL : POWER_STATE_LOW));
+
+        // A pending deadline is never in the past and only exists in connected full state
+        uint64_t deadline = power_next_deadline_us(&pm);
+        if (deadline != 0) {
+            CHECK(state == POWER_STATE_FULL);
+            CHECK(deadline > t);
+        }
+
+        if (state != prev) { nb_transitions++; }
+        prev = state;
+    }
+
+    power_stats_t stats;
+    power_get_stats(&pm, t, &stats);
+    CHECK(stats.residency_us[POWER_STATE_LOW] + stats.residency_us[POWER_STATE_FULL] == t);
+    CHECK(stats.nb_transitions == nb_transitions);
+
+    printf("power_model: %u transitions, low residency %.1f %%\n", nb_transitions,
+           100.0 * (double)stats.residency_us[POWER_STATE_LOW] / (double)t);
+
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(void)
+{
+    if (test_scenario()) { return 1; }
+    if (test_random()) { return 1; }
+
+    printf("power_model: PASS\n");
+    return 0;
+}
@@ -0,0 +1,204 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: protocol.cpp
+-- Description: TLV control protocol codec tests and encode/decode throughput
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "protocol.hpp"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define NB_BENCH_FRAMES 2000000
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+static uint64_t time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Compile-time telemetry round trip
+ */
+constexpr bool constexpr_round_trip() {
+    uint8_t frame[protocol::kTelemetrySize] = {};
+    protocol::Telemetry in{ 7, 0x81, 0x21, 3, 1, 0x12345678 };
+    protocol::Telemetry out{};
+    size_t size = protocol::encode_telemetry(in, frame, sizeof(frame));
+    return (size == protocol::kTelemetrySize) &&
+           (protocol::decode_telemetry(frame, size, out) == protocol::Status::Ok) &&
+           (out.sequence == 7) && (out.state == 0x81) && (out.endstop == 0x21) &&
+           (out.ack == 3) && (out.power == 1) && (out.uptime_ms == 0x12345678);
+}
+static_assert(constexpr_round_trip(), "telemetry round trip");
+static_assert(protocol::find_type(0x01)->type == protocol::Type::Motion, "motion type");
+static_assert(protocol::find_type(0x3f) == nullptr, "unknown type");
+
+/**
+ * @brief Command frames, legacy byte and error cases
+ */
+static int test_command(void) {
+    protocol::Command command;
+
+    // Legacy single byte
+    const uint8_t legacy[] = { 0x81 };
+    CHECK(protocol::decode_command(legacy, sizeof(legacy), command) == protocol::Status::Ok);
+    CHECK(command.version == protocol::kLegacyVersion);
+    CHECK(command.has_motion && (command.motion == 0x81));
+
+    // Encoded frame, byte for byte
+    uint8_t frame[protocol::kCommandSize];
+    CHECK(protocol::encode_command(42, 0x02, frame, sizeof(frame)) == protocol::kCommandSize);
+    const uint8_t expected[] = { 0x01, 42, 0x01, 0x01, 0x02 };
+    CHECK(memcmp(frame, expected, sizeof(expected)) == 0);
+    CHECK(protocol::decode_command(frame, sizeof(frame), command) == protocol::Status::Ok);
+    CHECK((command.version == 1) && (command.sequence == 42));
+    CHECK(command.has_motion && (command.motion == 0x02) && (command.nb_skipped == 0));
+    CHECK(protocol::encode_command(42, 0x02, frame, sizeof(frame) - 1) == 0);
+
+    // Unknown and telemetry records are skipped, the last motion record wins
+    const uint8_t mixed[] = { 0x01, 9, 0x30, 0x03, 1, 2, 3, 0x01, 0x01, 0x01, 0x40, 0x01, 0x55, 0x01, 0x01, 0x00 };
+    CHECK(protocol::decode_command(mixed, sizeof(mixed), command) == protocol::Status::Ok);
+    CHECK(command.has_motion && (command.motion == 0x00) && (command.nb_skipped == 2));
+
+    // Header only: valid, nothing to do
+    const uint8_t header[] = { 0x01, 3 };
+    CHECK(protocol::decode_command(header, sizeof(header), command) == protocol::Status::Ok);
+    CHECK(!command.has_motion && (command.sequence == 3));
+
+    // Errors
+    const uint8_t newer[] = { 0x02, 0, 0x01, 0x01, 0x01 };
+    const uint8_t truncated_header[] = { 0x01, 0, 0x01 };
+    const uint8_t truncated_value[] = { 0x01, 0, 0x30, 0x04, 0, 0 };
+    const uint8_t bad_size[] = { 0x01, 0, 0x01, 0x02, 0x01, 0x00 };
+    CHECK(protocol::decode_command(legacy, 0, command) == protocol::Status::Empty);
+    CHECK(protocol::decode_command(newer, sizeof(newer), command) == protocol::Status::BadVersion);
+    CHECK(protocol::decode_command(truncated_header, sizeof(truncated_header), command) == protocol::Status::Truncated);
+    CHECK(protocol::decode_command(truncated_value, sizeof(truncated_value), command) == protocol::Status::Truncated);
+    CHECK(protocol::decode_command(bad_size, sizeof(bad_size), command) == protocol::Status::BadSize);
+
+    return 0;
+}
+
+/**
+ * @brief Telemetry frames and writer errors
+ */
+static int test_telemetry(void) {
+    uint8_t frame[protocol::kTelemetrySize + 1];
+    protocol::Telemetry telemetry{ 200, 0x01, 0x02, 42, 1, 1000 };
+    protocol::Telemetry decoded;
+
+    CHECK(protocol::kTelemetrySize == 20);
+    CHECK(protocol::encode_telemetry(telemetry, frame, sizeof(frame)) == protocol::kTelemetrySize);
+    const uint8_t expected[] = { 0x01, 200, 0x40, 1, 0x01, 0x41, 1, 0x02, 0x42, 1, 42,
+                                 0x43, 1, 0x01, 0x44, 4, 0xe8, 0x03, 0x00, 0x00 };
+    CHECK(memcmp(frame, expected, sizeof(expected)) == 0);
+    CHECK(protocol::decode_telemetry(frame, protocol::kTelemetrySize, decoded) == protocol::Status::Ok);
+    CHECK((decoded.sequence == 200) && (decoded.ack == 42) && (decoded.uptime_ms == 1000));
+
+    // Too small: nothing is written past the buffer
+    memset(frame, 0xa5, sizeof(frame));
+    CHECK(protocol::encode_telemetry(telemetry, frame, protocol::kTelemetrySize - 1) == 0);
+    CHECK(frame[protocol::kTelemetrySize - 1] == 0xa5);
+
+    // Writer: size checked against the table, sticky error
+    uint8_t value[2] = { 0, 0 };
+    protocol::Writer writer(frame, sizeof(frame), 0);
+    writer.put(static_cast<uint8_t>(protocol::Type::Uptime), value, 2).put_u8(protocol::Type::State, 0);
+    CHECK(writer.status() == protocol::Status::BadSize);
+    CHECK(writer.size() == protocol::kHeaderSize);
+    CHECK(protocol::Writer(frame, 1, 0).status() == protocol::Status::NoSpace);
+
+    return 0;
+}
+
+/**
+ * @brief Encode/decode throughput
+ */
+static void bench(void) {
+    uint8_t frame[protocol::kTelemetrySize];
+    protocol::Telemetry telemetry{};
+    protocol::Command command;
+    uint32_t checksum = 0;
+
+    uint64_t start = time_ns();
+    for (int i = 0; i < NB_BENCH_FRAMES; i++) {
+        telemetry.sequence = (uint8_t)i;
+        telemetry.state = (uint8_t)(checksum & 0x83);
+        telemetry.uptime_ms = (uint32_t)i;
+        checksum += (uint32_t)protocol::encode_telemetry(telemetry, frame, sizeof(frame));
+        checksum += frame[2 + 2] ^ frame[protocol::kTelemetrySize - 1];
+    }
+    uint64_t elapsed = time_ns() - start;
+    printf("protocol: telemetry encode %.1f Mframes/s, %.1f MB/s (%u)\n", NB_BENCH_FRAMES * 1e3 / (double)elapsed,
+           NB_BENCH_FRAMES * protocol::kTelemetrySize * 1e3 / (double)elapsed, checksum);
+
+    start = time_ns();
+    for (int i = 0; i < NB_BENCH_FRAMES; i++) {
+        frame[1] = (uint8_t)i;
+        checksum += (uint32_t)protocol::decode_telemetry(frame, sizeof(frame), telemetry);
+        checksum += telemetry.sequence;
+    }
+    elapsed = time_ns() - start;
+    printf("protocol: telemetry decode %.1f Mframes/s, %.1f MB/s (%u)\n", NB_BENCH_FRAMES * 1e3 / (double)elapsed,
+           NB_BENCH_FRAMES * protocol::kTelemetrySize * 1e3 / (double)elapsed, checksum);
+
+    protocol::encode_command(0, 0x01, frame, sizeof(frame));
+    start = time_ns();
+    for (int i = 0; i < NB_BENCH_FRAMES; i++) {
+        frame[4] = (uint8_t)(i & 0x03);
+        checksum += (uint32_t)protocol::decode_command(frame, protocol::kCommandSize, command);
+        checksum += command.motion;
+    }
+    elapsed = time_ns() - start;
+    printf("protocol: command decode   %.1f Mframes/s, %.1f MB/s (%u)\n", NB_BENCH_FRAMES * 1e3 / (double)elapsed,
+           NB_BENCH_FRAMES * protocol::kCommandSize * 1e3 / (double)elapsed, checksum);
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(void)
+{
+    if (test_command()) { return 1; }
+    if (test_telemetry()) { return 1; }
+    bench();
+
+    printf("protocol: PASS\n");
+    return 0;
+}
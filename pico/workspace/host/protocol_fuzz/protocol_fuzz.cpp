@@ -0,0 +1,153 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: protocol_fuzz.cpp
+-- Description: Fuzz target of the TLV control protocol decoders, with a
+--              built-in random/mutation driver when libFuzzer is not used
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "protocol.hpp"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define NB_FUZZ_INPUTS  2000000
+#define MAX_INPUT_SIZE  64
+#define GUARD_SIZE      16
+#define GUARD_BYTE      0xa5
+
+#define FUZZ_CHECK(cond) do { if (!(cond)) { \
+    fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); abort(); } } while (0)
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Fuzz entry point: decode any input as a command and a telemetry
+ *        frame, and check the codec invariants
+ *
+ * @param data The input
+ * @param size The input size
+ * @return int Always 0
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size) {
+    // Records stay inside the frame and cover it exactly when it is valid
+    protocol::Reader reader(data, size);
+    protocol::Record record;
+    size_t covered = protocol::kHeaderSize;
+    while (reader.next(record)) {
+        FUZZ_CHECK((record.value >= data + protocol::kHeaderSize) && (record.value + record.size <= data + size));
+        covered += protocol::kRecordHeaderSize + record.size;
+    }
+    if (reader.status() == protocol::Status::Ok) { FUZZ_CHECK(covered == size); }
+
+    // Command: a valid frame re-encodes to a frame decoding the same way
+    protocol::Command command;
+    protocol::Status status = protocol::decode_command(data, size, command);
+    FUZZ_CHECK((size != 1) || (status == protocol::Status::Ok));
+    if ((status == protocol::Status::Ok) && command.has_motion) {
+        uint8_t frame[protocol::kCommandSize];
+        protocol::Command again;
+        FUZZ_CHECK(protocol::encode_command(command.sequence, command.motion, frame, sizeof(frame)) == sizeof(frame));
+        FUZZ_CHECK(protocol::decode_command(frame, sizeof(frame), again) == protocol::Status::Ok);
+        FUZZ_CHECK(again.has_motion && (again.motion == command.motion) && (again.sequence == command.sequence));
+    }
+
+    // Telemetry: same round trip, and the writer never goes past its buffer
+    protocol::Telemetry telemetry;
+    if (protocol::decode_telemetry(data, size, telemetry) == protocol::Status::Ok) {
+        uint8_t frame[protocol::kTelemetrySize + GUARD_SIZE];
+        size_t capacity = (size < sizeof(frame) - GUARD_SIZE) ? size : sizeof(frame) - GUARD_SIZE;
+        memset(frame, GUARD_BYTE, sizeof(frame));
+        size_t len = protocol::encode_telemetry(telemetry, frame, capacity);
+        for (size_t i = capacity; i < sizeof(frame); i++) { FUZZ_CHECK(frame[i] == GUARD_BYTE); }
+        if (len != 0) {
+            protocol::Telemetry again;
+            FUZZ_CHECK(protocol::decode_telemetry(frame, len, again) == protocol::Status::Ok);
+            FUZZ_CHECK(memcmp(&again, &telemetry, sizeof(telemetry)) == 0);
+        }
+    }
+
+    return 0;
+}
+
+#ifndef HAVE_LIBFUZZER
+/**
+ * @brief Random/mutation driver: valid frames with random edits, and the
+ *        files given as arguments (corpus or crash inputs)
+ * @return int 0 on success
+ */
+int main(int argc, char ** argv)
+{
+    uint8_t input[MAX_INPUT_SIZE];
+
+    for (int i = 1; i < argc; i++) {
+        FILE * f = fopen(argv[i], "rb");
+        if (f == NULL) { fprintf(stderr, "protocol_fuzz: cannot open %s\n", argv[i]); return 1; }
+        size_t size = fread(input, 1, sizeof(input), f);
+        fclose(f);
+        LLVMFuzzerTestOneInput(input, size);
+    }
+    if (argc > 1) { return 0; }
+
+    srand(1);
+    for (int i = 0; i < NB_FUZZ_INPUTS; i++) {
+        size_t size;
+
+        // Start from a valid command or telemetry frame, or from random bytes
+        switch (rand() % 3) {
+            case 0:
+                size = protocol::encode_command((uint8_t)rand(), (uint8_t)rand(), input, sizeof(input));
+                break;
+            case 1: {
+                protocol::Telemetry telemetry{ (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand(),
+                                               (uint8_t)rand(), (uint8_t)rand(), (uint32_t)rand() };
+                size = protocol::encode_telemetry(telemetry, input, sizeof(input));
+                break;
+            }
+            default:
+                size = (size_t)(rand() % (MAX_INPUT_SIZE + 1));
+                for (size_t j = 0; j < size; j++) { input[j] = (uint8_t)rand(); }
+                if ((size > 0) && (rand() & 1)) { input[0] = protocol::kVersion; }
+                break;
+        }
+
+        // Flip, overwrite, truncate or extend
+        int nb_edits = rand() % 4;
+        for (int j = 0; j < nb_edits; j++) {
+            switch (rand() % 4) {
+                case 0: if (size > 0) { input[rand() % size] ^= (uint8_t)(1 << (rand() % 8)); } break;
+                case 1: if (size > 0) { input[rand() % size] = (uint8_t)rand(); } break;
+                case 2: if (size > 0) { size = (size_t)(rand() % size); } break;
+                default: if (size < sizeof(input)) { input[size++] = (uint8_t)rand(); } break;
+            }
+        }
+
+        LLVMFuzzerTestOneInput(input, size);
+    }
+
+    printf("protocol_fuzz: %d inputs\n", NB_FUZZ_INPUTS);
+    printf("protocol_fuzz: PASS\n");
+    return 0;
+}
+#endif
@@ -0,0 +1,133 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: protocol_view.cpp
+-- Description: Print the records of a TLV control protocol frame, or encode
+--              a command frame
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "protocol.hpp"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define MAX_FRAME_SIZE 512
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Decode a hex dump, separators ignored
+ * @return int Number of bytes, -1 if the text is not hex
+ */
+static int hex_decode(const char * text, uint8_t * out, int size) {
+    int n = 0;
+    int nibble = -1;
+    size_t len = strlen(text);
+
+    for (size_t i = 0; i < len; i++) {
+        char c = text[i];
+        if ((c == '0') && (i + 1 < len) && ((text[i + 1] == 'x') || (text[i + 1] == 'X'))) { i++; continue; }
+        if (isspace((unsigned char)c) || (c == ':') || (c == '-') || (c == ',')) { continue; }
+        if (!isxdigit((unsigned char)c)) { return -1; }
+        int v = isdigit((unsigned char)c) ? c - '0' : tolower((unsigned char)c) - 'a' + 10;
+        if (nibble < 0) { nibble = v; continue; }
+        if (n == size) { return -1; }
+        out[n++] = (uint8_t)((nibble << 4) | v);
+        nibble = -1;
+    }
+
+    return (nibble < 0) ? n : -1;
+}
+
+/**
+ * @brief Print the records of a frame
+ * @return int 0 if the frame is valid
+ */
+static int view(const uint8_t * frame, int size) {
+    if (size == 1) {
+        printf("legacy command 0x%02x\n", frame[0]);
+        return 0;
+    }
+
+    protocol::Reader reader(frame, (size_t)size);
+    protocol::Record record;
+    printf("version %u, sequence %u\n", reader.version(), reader.sequence());
+    while (reader.next(record)) {
+        const protocol::TypeInfo * info = protocol::find_type(record.type);
+        printf("  0x%02x %-8s", record.type, (info != nullptr) ? info->name : "unknown");
+        uint32_t value = 0;
+        for (int i = record.size - 1; i >= 0; i--) { value = (value << 8) | record.value[i]; }
+        if ((info != nullptr) && (record.size <= 4)) {
+            printf(" %u (0x%0*x)\n", value, 2 * record.size, value);
+        }
+        else {
+            for (int i = 0; i < record.size; i++) { printf(" %02x", record.value[i]); }
+            printf("\n");
+        }
+    }
+
+    if (reader.status() != protocol::Status::Ok) {
+        printf("error: %s\n", protocol::status_name(reader.status()));
+        return 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(int argc, char ** argv)
+{
+    uint8_t frame[MAX_FRAME_SIZE];
+
+    // Encode a command frame
+    if ((argc >= 3) && (argc <= 4) && (strcmp(argv[1], "-c") == 0)) {
+        uint8_t motion = (uint8_t)strtoul(argv[2], NULL, 0);
+        uint8_t sequence = (argc == 4) ? (uint8_t)strtoul(argv[3], NULL, 0) : 0;
+        size_t size = protocol::encode_command(sequence, motion, frame, sizeof(frame));
+        for (size_t i = 0; i < size; i++) { printf("%02x", frame[i]); }
+        printf("\n");
+        return 0;
+    }
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: protocol_view <hex frame>\n"
+                        "       protocol_view -c <command byte> [sequence]\n");
+        return 1;
+    }
+
+    int size = hex_decode(argv[1], frame, MAX_FRAME_SIZE);
+    if (size <= 0) {
+        fprintf(stderr, "protocol_view: not a hex frame\n");
+        return 1;
+    }
+
+    return view(frame, size);
+}
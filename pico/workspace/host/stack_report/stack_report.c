@@ -0,0 +1,360 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: stack_report.c
+-- Description: Build-time memory report of the firmware.
+--              Usage: stack_report [-s <project>.sizes.txt] [-r root]... <build dir>
+--              Reads the call graphs written by -fcallgraph-info=su (*.ci)
+--              and prints the worst-case stack of each callback (functions
+--              named *_callback, *_handler, *_entry and main, or the -r roots).
+--              With -s, also prints the largest RAM objects from the nm
+--              output written next to the firmware.
+--              Flags: D dynamic frame, I indirect call (not followed),
+--              R recursion (counted once), U callee without stack information.
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#define _XOPEN_SOURCE 700
+
+#include <ftw.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define MAX_NODES       16384
+#define MAX_EDGES       65536
+#define MAX_NAME        128
+#define MAX_ROOTS       64
+#define NB_RAM_OBJECTS  20
+
+#define FLAG_DYNAMIC    0x01
+#define FLAG_INDIRECT   0x02
+#define FLAG_RECURSION  0x04
+#define FLAG_UNKNOWN    0x08
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    char title[MAX_NAME];   /**> Graph title: name, or file:name for static functions */
+    char name[MAX_NAME];    /**> Function name */
+    bool known;             /**> Stack frame size available */
+    uint32_t frame;         /**> Stack frame size in bytes */
+    uint8_t flags;          /**> Own flags */
+    int first_edge;         /**> First outgoing edge, -1 if none */
+    int state;              /**> 0: not visited, 1: visiting, 2: done */
+    uint32_t worst;         /**> Worst-case stack from this function */
+    uint8_t worst_flags;    /**> Flags on the worst-case call tree */
+} node_t;
+
+typedef struct {
+    int target;
+    int next;
+} edge_t;
+
+typedef struct {
+    uint32_t size;
+    char type;
+    char name[MAX_NAME];
+} ram_object_t;
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+static node_t nodes[MAX_NODES];
+static int nb_nodes = 0;
+static edge_t edges[MAX_EDGES];
+static int nb_edges = 0;
+static int nb_files = 0;
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Find or create a node by title
+ */
+static int node_get(const char * title) {
+    for (int i = 0; i < nb_nodes; i++) {
+        if (strcmp(nodes[i].title, title) == 0) { return i; }
+    }
+    if (nb_nodes == MAX_NODES) {
+        fprintf(stderr, "stack_report: too many functions\n");
+        exit(1);
+    }
+
+    node_t * node = &nodes[nb_nodes];
+    memset(node, 0, sizeof(node_t));
+    snprintf(node->title, MAX_NAME, "%s", title);
+    const char * colon = strrchr(title, ':');
+    snprintf(node->name, MAX_NAME, "%s", colon ? colon + 1 : title);
+    node->first_edge = -1;
+
+    return nb_nodes++;
+}
+
+/**
+ * @brief Copy the quoted value following a key in a .ci line
+ */
+static bool ci_field(const char * line, const char * key, char * value, size_t size) {
+    const char * p = strstr(line, key);
+    if (p == NULL) { return false; }
+    p += strlen(key);
+    const char * q = strchr(p, '"');
+    if (q == NULL) { return false; }
+    size_t len = (size_t)(q - p);
+    if (len >= size) { len = size - 1; }
+    memcpy(value, p, len);
+    value[len] = '\0';
+    return true;
+}
+
+/**
+ * @brief Parse one call graph file
+ */
+static void ci_parse(const char * path) {
+    FILE * f = fopen(path, "r");
+    char line[1024];
+    char title[MAX_NAME];
+    char target[MAX_NAME];
+    char label[512];
+
+    if (f == NULL) { return; }
+    nb_files++;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (strncmp(line, "node:", 5) == 0) {
+            if (!ci_field(line, "title: \"", title, sizeof(title))) { continue; }
+            int n = node_get(title);
+
+            // Label: "name\nfile:line:col\n<bytes> bytes (<qualifier>)"
+            if (!ci_field(line, "label: \"", label, sizeof(label))) { continue; }
+            const char * bytes = strstr(label, " bytes (");
+            if (bytes == NULL) { continue; }
+            while ((bytes > label) && (bytes[-1] >= '0') && (bytes[-1] <= '9')) { bytes--; }
+            nodes[n].known = true;
+            nodes[n].frame = (uint32_t)strtoul(bytes, NULL, 10);
+            if (strstr(bytes, "dynamic") != NULL) { nodes[n].flags |= FLAG_DYNAMIC; }
+        }
+        else if (strncmp(line, "edge:", 5) == 0) {
+            if (!ci_field(line, "sourcename: \"", title, sizeof(title))) { continue; }
+            if (!ci_field(line, "targetname: \"", target, sizeof(target))) { continue; }
+            if (nb_edges == MAX_EDGES) {
+                fprintf(stderr, "stack_report: too many calls\n");
+                exit(1);
+            }
+            int src = node_get(title);
+            edges[nb_edges].target = node_get(target);
+            edges[nb_edges].next = nodes[src].first_edge;
+            nodes[src].first_edge = nb_edges++;
+        }
+    }
+
+    fclose(f);
+}
+
+/**
+ * @brief Directory walk callback: parse the *.ci files
+ */
+static int ci_walk(const char * path, const struct stat * sb, int type, struct FTW * ftw) {
+    (void)sb;
+    (void)ftw;
+    size_t len = strlen(path);
+    if ((type == FTW_F) && (len > 3) && (strcmp(path + len - 3, ".ci") == 0)) { ci_parse(path); }
+    return 0;
+}
+
+/**
+ * @brief Worst-case stack from a function, depth first with memoization
+ */
+static uint32_t node_worst(int n, uint8_t * flags) {
+    node_t * node = &nodes[n];
+
+    if (node->state == 2) { *flags |= node->worst_flags; return node->worst; }
+    if (node->state == 1) { *flags |= FLAG_RECURSION; return 0; }
+
+    node->state = 1;
+    uint8_t own = node->flags;
+    uint32_t deepest = 0;
+
+    if (strcmp(node->title, "__indirect_call") == 0) { own |= FLAG_INDIRECT; }
+    else if (!node->known) { own |= FLAG_UNKNOWN; }
+
+    for (int e = node->first_edge; e >= 0; e = edges[e].next) {
+        uint32_t callee = node_worst(edges[e].target, &own);
+        if (callee > deepest) { deepest = callee; }
+    }
+
+    node->worst = node->frame + deepest;
+    node->worst_flags = own;
+    node->state = 2;
+    *flags |= own;
+
+    return node->worst;
+}
+
+/**
+ * @brief Default roots: run loop callbacks, interrupt handlers, core entries
+ */
+static bool is_default_root(const char * name) {
+    static const char * suffixes[] = { "_callback", "_handler", "_entry" };
+    size_t len = strlen(name);
+
+    if (strcmp(name, "main") == 0) { return true; }
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        size_t slen = strlen(suffixes[i]);
+        if ((len > slen) && (strcmp(name + len - slen, suffixes[i]) == 0)) { return true; }
+    }
+    return false;
+}
+
+/**
+ * @brief Sort by decreasing worst-case stack
+ */
+static int compare_worst(const void * a, const void * b) {
+    const node_t * na = &nodes[*(const int *)a];
+    const node_t * nb = &nodes[*(const int *)b];
+    if (na->worst != nb->worst) { return (na->worst < nb->worst) ? 1 : -1; }
+    return strcmp(na->name, nb->name);
+}
+
+/**
+ * @brief Sort by decreasing size
+ */
+static int compare_size(const void * a, const void * b) {
+    const ram_object_t * oa = (const ram_object_t *)a;
+    const ram_object_t * ob = (const ram_object_t *)b;
+    if (oa->size != ob->size) { return (oa->size < ob->size) ? 1 : -1; }
+    return strcmp(oa->name, ob->name);
+}
+
+/**
+ * @brief Print the largest RAM objects (.data/.bss) from "nm -S --size-sort"
+ */
+static int print_ram_objects(const char * path) {
+    static ram_object_t objects[MAX_NODES];
+    int nb_objects = 0;
+    uint32_t total = 0;
+    char line[512];
+    FILE * f = fopen(path, "r");
+
+    if (f == NULL) {
+        fprintf(stderr, "stack_report: cannot open %s\n", path);
+        return 1;
+    }
+
+    while ((fgets(line, sizeof(line), f) != NULL) && (nb_objects < MAX_NODES)) {
+        unsigned long address;
+        unsigned long size;
+        char type;
+        char name[MAX_NAME];
+        if (sscanf(line, "%lx %lx %c %127s", &address, &size, &type, name) != 4) { continue; }
+        if (strchr("bBdD", type) == NULL) { continue; }
+        objects[nb_objects].size = (uint32_t)size;
+        objects[nb_objects].type = type;
+        snprintf(objects[nb_objects].name, MAX_NAME, "%s", name);
+        total += (uint32_t)size;
+        nb_objects++;
+    }
+    fclose(f);
+
+    qsort(objects, (size_t)nb_objects, sizeof(ram_object_t), compare_size);
+
+    printf("\nRAM objects: %d, %u bytes\n", nb_objects, total);
+    printf("   bytes  section  object\n");
+    for (int i = 0; (i < nb_objects) && (i < NB_RAM_OBJECTS); i++) {
+        printf("%8u  %-7s  %s\n", objects[i].size,
+               ((objects[i].type == 'b') || (objects[i].type == 'B')) ? ".bss" : ".data", objects[i].name);
+    }
+
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(int argc, char ** argv)
+{
+    const char * roots[MAX_ROOTS];
+    int nb_roots = 0;
+    const char * sizes = NULL;
+    const char * dir = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc) && (nb_roots < MAX_ROOTS)) { roots[nb_roots++] = argv[++i]; }
+        else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) { sizes = argv[++i]; }
+        else { dir = argv[i]; }
+    }
+    if (dir == NULL) {
+        fprintf(stderr, "usage: stack_report [-s <project>.sizes.txt] [-r root]... <build dir>\n");
+        return 1;
+    }
+
+    nftw(dir, &ci_walk, 16, FTW_PHYS);
+    if (nb_files == 0) {
+        fprintf(stderr, "stack_report: no .ci file in %s (build with -fcallgraph-info=su)\n", dir);
+        return 1;
+    }
+
+    // Select the roots among the defined functions
+    static int selected[MAX_NODES];
+    int nb_selected = 0;
+    int nb_defined = 0;
+    for (int n = 0; n < nb_nodes; n++) {
+        if (!nodes[n].known) { continue; }
+        nb_defined++;
+        bool root = (nb_roots == 0) && is_default_root(nodes[n].name);
+        for (int r = 0; r < nb_roots; r++) {
+            if (strcmp(nodes[n].name, roots[r]) == 0) { root = true; }
+        }
+        if (root) {
+            uint8_t flags = 0;
+            node_worst(n, &flags);
+            selected[nb_selected++] = n;
+        }
+    }
+
+    qsort(selected, (size_t)nb_selected, sizeof(int), compare_worst);
+
+    printf("Worst-case stack: %d functions in %d files\n", nb_defined, nb_files);
+    printf("   bytes  flags  function\n");
+    for (int i = 0; i < nb_selected; i++) {
+        const node_t * node = &nodes[selected[i]];
+        printf("%8u  %c%c%c%c   %s\n", node->worst,
+               (node->worst_flags & FLAG_DYNAMIC) ? 'D' : '-',
+               (node->worst_flags & FLAG_INDIRECT) ? 'I' : '-',
+               (node->worst_flags & FLAG_RECURSION) ? 'R' : '-',
+               (node->worst_flags & FLAG_UNKNOWN) ? 'U' : '-',
+               node->name);
+    }
+
+    if (sizes != NULL) { return print_ram_objects(sizes); }
+
+    return 0;
+}
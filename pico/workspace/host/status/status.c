@@ -0,0 +1,185 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: status.c
+-- Description: Status record layout, and round trips of a full status
+--              refresh depending on the ATT MTU
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+
+#include "status.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define MS  1000ULL
+
+// Values read for a status refresh before the status record: control
+// (FF11), end-stop status (FF14), power statistics (FF12), telemetry (FF17)
+#define NB_LEGACY_VALUES 4
+static const uint16_t legacy_sizes[NB_LEGACY_VALUES] = { 1, 1, 28, 20 };
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Read a 16-bit little-endian value
+ */
+static uint16_t read_16(const uint8_t * buffer) {
+    return (uint16_t)(buffer[0] | (buffer[1] << 8));
+}
+
+/**
+ * @brief Read a 32-bit little-endian value
+ */
+static uint32_t read_32(const uint8_t * buffer) {
+    return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+/**
+ * @brief Relays driver: nothing to drive
+ */
+static void motion_output(uint8_t relays, void * context) {
+    (void)relays;
+    (void)context;
+}
+
+/**
+ * @brief Read requests for a value of known size: read, then read blobs
+ */
+static int nb_round_trips(uint16_t size, uint16_t mtu) {
+    return (size + (mtu - 2)) / (mtu - 1);
+}
+
+/**
+ * @brief Record fields after a short scenario
+ */
+static int test_layout(void) {
+    motion_t motion;
+    deadman_t deadman;
+    power_manager_t power;
+    status_link_t link;
+    uint8_t record[STATUS_RECORD_SIZE];
+    uint64_t t = 0;
+
+    motion_init(&motion, &motion_output, NULL);
+    deadman_init(&deadman);
+    power_init(&power, t);
+    status_link_init(&link);
+
+    // Connection, hold-to-run Up from BLE, then the Up end-stop is reached
+    t += 1000 * MS;
+    power_notify(&power, POWER_EVENT_CONNECTED, t);
+    motion_command(&motion, MOTION_UP | MOTION_HOLD_TO_RUN, MOTION_SOURCE_BLE);
+    deadman_kick(&deadman, t);
+    power_notify(&power, POWER_EVENT_MOTION_START, t);
+    t += 40 * MS;
+    deadman_kick(&deadman, t);
+    motion_limit(&motion, MOTION_UP, true);
+
+    // Blocked towards the end-stop from USB and the button, rejected in both directions
+    motion_command(&motion, MOTION_UP, MOTION_SOURCE_USB);
+    motion_command(&motion, MOTION_UP, MOTION_SOURCE_BUTTON);
+    motion_command(&motion, MOTION_UP | MOTION_DOWN, MOTION_SOURCE_BUTTON);
+    link.mtu = 247;
+    link.tx_octets = 251;
+    link.rx_octets = 251;
+
+    t += 30 * MS;
+    status_snapshot(&motion, &deadman, &power, &link, t, record);
+    CHECK(record[0] == STATUS_VERSION);
+    CHECK(record[1] == motion.command);
+    CHECK(record[2] == MOTION_UP);
+    CHECK(record[3] == MOTION_POSITION_UP_END);
+    CHECK(record[4] == MOTION_SOURCE_BUTTON);
+    CHECK(record[5] == POWER_STATE_FULL);
+    CHECK(record[6] == 1);
+    CHECK(record[7] == 0);
+    CHECK(read_32(&record[8]) == 1070);
+    CHECK(read_32(&record[12]) == (deadman.timeout_us - 30 * MS) / 1000);
+    CHECK(read_32(&record[16]) == 70);
+    CHECK(read_32(&record[20]) == deadman.timeout_us);
+    CHECK(read_32(&record[24]) == 2);
+    CHECK(read_32(&record[28]) == 2);
+    CHECK(read_32(&record[32]) == 0);
+    CHECK(read_32(&record[36]) == 1);
+    CHECK(read_32(&record[40]) == 2);
+    CHECK(read_32(&record[44]) == 1);
+    CHECK(read_32(&record[48]) == 40 * MS);
+    CHECK(read_32(&record[52]) == 1);
+    CHECK(read_16(&record[56]) == 247);
+    CHECK(read_16(&record[58]) == 251);
+    CHECK(read_16(&record[60]) == 251);
+
+    // Deadman tripped: disarmed, no time left
+    t += deadman.timeout_us;
+    CHECK(deadman_trip(&deadman, t));
+    status_snapshot(&motion, &deadman, &power, &link, t, record);
+    CHECK(record[6] == 0);
+    CHECK(read_32(&record[12]) == 0);
+    CHECK(read_32(&record[32]) == 1);
+
+    // One PDU once the MTU is raised to 247 (one LE packet of 251 octets)
+    CHECK(STATUS_MIN_MTU <= 247);
+
+    return 0;
+}
+
+/**
+ * @brief Round trips per full status refresh, before and after the record
+ */
+static int test_round_trips(void) {
+    static const uint16_t mtus[] = { 23, STATUS_MIN_MTU, 247 };
+
+    for (unsigned i = 0; i < sizeof(mtus) / sizeof(mtus[0]); i++) {
+        int before = 0;
+        for (int j = 0; j < NB_LEGACY_VALUES; j++) { before += nb_round_trips(legacy_sizes[j], mtus[i]); }
+        int after = nb_round_trips(STATUS_RECORD_SIZE, mtus[i]);
+        printf("status: MTU %3u, %d round trips per refresh with 4 characteristics, %d with the status record\n",
+               mtus[i], before, after);
+        if (mtus[i] >= STATUS_MIN_MTU) { CHECK(after == 1); }
+    }
+
+    CHECK(nb_round_trips(22, 23) == 1);
+    CHECK(nb_round_trips(23, 23) == 2);
+    CHECK(nb_round_trips(STATUS_RECORD_SIZE, 23) == 3);
+
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(void)
+{
+    if (test_layout()) { return 1; }
+    if (test_round_trips()) { return 1; }
+
+    printf("status: PASS\n");
+    return 0;
+}
@@ -0,0 +1,316 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: touch_filter.c
+-- Description: Capacitive touch filter replayed against charge time traces,
+--              and filter throughput benchmark.
+--              Usage: touch_filter [trace.csv ...]
+--              A trace has one "count,touched" line per filter period, the
+--              touched column being the expected state (0/1).
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "touch.h"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define MAX_SAMPLES       20000
+#define THRESHOLD         40
+#define BASELINE          400
+#define NB_BENCH_SAMPLES  20000000
+
+/** @brief Samples allowed between the touch and the press/release events */
+#define MAX_LATENCY       (TOUCH_DEBOUNCE_SAMPLES + 2)
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    int nb_samples;
+    uint32_t count[MAX_SAMPLES];
+    bool touched[MAX_SAMPLES];
+} trace_t;
+
+typedef struct {
+    int nb_press;
+    int nb_release;
+    int nb_touches;
+    int max_latency;
+    int nb_missed;
+} replay_t;
+
+//----------------------------------------------------------------
+// Static variables
+//----------------------------------------------------------------
+
+static trace_t trace;
+static uint32_t rng = 1;
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+static uint64_t time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Pseudo-random noise, roughly gaussian, +/- amplitude
+ */
+static int noise(int amplitude) {
+    int sum = 0;
+    for (int i = 0; i < 4; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        sum += (int)((rng >> 16) % (2 * amplitude + 1)) - amplitude;
+    }
+    return sum / 2;
+}
+
+/**
+ * @brief Synthesize a trace: noisy baseline with a linear drift, plus
+ *        touches given as [start, end[ sample ranges with a 2-sample ramp
+ */
+static void make_trace(int nb_samples, int drift, const int touches[][3], int nb_touches) {
+    trace.nb_samples = nb_samples;
+    for (int i = 0; i < nb_samples; i++) {
+        int count = BASELINE + drift * i / nb_samples + noise(6);
+        bool touched = false;
+        for (int t = 0; t < nb_touches; t++) {
+            if ((i >= touches[t][0]) && (i < touches[t][1])) {
+                int ramp = i - touches[t][0];
+                count += (ramp < 2) ? touches[t][2] * (ramp + 1) / 3 : touches[t][2];
+                touched = true;
+            }
+        }
+        trace.count[i] = (uint32_t)count;
+        trace.touched[i] = touched;
+    }
+}
+
+/**
+ * @brief Replay the trace and match the events against the expected state.
+ *        The samples before the end of the calibration are not checked.
+ */
+static void replay_trace(replay_t * replay) {
+    touch_t touch;
+    int edge = -1;
+    bool pressed = false;
+
+    touch_init(&touch, THRESHOLD);
+    memset(replay, 0, sizeof(replay_t));
+
+    for (int i = 0; i < trace.nb_samples; i++) {
+        if ((i > TOUCH_CALIBRATION_SAMPLES) && (trace.touched[i] != trace.touched[i - 1])) {
+            if (trace.touched[i]) { replay->nb_touches++; }
+            edge = i;
+        }
+
+        button_event_t event = touch_process(&touch, trace.count[i]);
+        if (event == BUTTON_EVENT_NONE) { continue; }
+
+        if (event == BUTTON_EVENT_PRESS) { replay->nb_press++; pressed = true; }
+        else { replay->nb_release++; pressed = false; }
+
+        // Latency from the expected state change, if this event follows one
+        if ((edge >= 0) && (trace.touched[i] == pressed)) {
+            if (i - edge > replay->max_latency) { replay->max_latency = i - edge; }
+            edge = -1;
+        }
+        else {
+            replay->nb_missed++;
+        }
+    }
+}
+
+/**
+ * @brief Untouched pad: noise and thermal drift only, no event
+ */
+static int test_idle_drift(void) {
+    replay_t replay;
+
+    make_trace(MAX_SAMPLES, 3 * THRESHOLD, NULL, 0);
+    replay_trace(&replay);
+    CHECK(replay.nb_press == 0);
+    CHECK(replay.nb_release == 0);
+
+    make_trace(MAX_SAMPLES, -3 * THRESHOLD, NULL, 0);
+    replay_trace(&replay);
+    CHECK(replay.nb_press == 0);
+    CHECK(replay.nb_release == 0);
+
+    return 0;
+}
+
+/**
+ * @brief Short and long touches of various strengths over a drifting baseline
+ */
+static int test_touches(void) {
+    const int touches[][3] = {
+        { 100, 130, 60 }, { 500, 700, 120 }, { 1000, 1005, 80 }, { 2000, 2300, 55 },
+        { 4000, 4010, 200 }, { 6000, 6500, 70 }, { 9000, 9040, 90 }, { 12000, 12100, 65 },
+    };
+    const int nb_touches = sizeof(touches) / sizeof(touches[0]);
+    replay_t replay;
+
+    make_trace(15000, 2 * THRESHOLD, touches, nb_touches);
+    replay_trace(&replay);
+    CHECK(replay.nb_touches == nb_touches);
+    CHECK(replay.nb_press == nb_touches);
+    CHECK(replay.nb_release == nb_touches);
+    CHECK(replay.nb_missed == 0);
+    CHECK(replay.max_latency <= MAX_LATENCY);
+
+    printf("touch_filter: %d touches, max latency %d samples\n", nb_touches, replay.max_latency);
+
+    return 0;
+}
+
+/**
+ * @brief Single-sample spikes (ESD, motor switching) are ignored
+ */
+static int test_spikes(void) {
+    replay_t replay;
+
+    make_trace(2000, 0, NULL, 0);
+    for (int i = 100; i < 2000; i += 97) { trace.count[i] += 5 * THRESHOLD; }
+    replay_trace(&replay);
+    CHECK(replay.nb_press == 0);
+
+    return 0;
+}
+
+/**
+ * @brief An object left on the pad is released after TOUCH_MAX_PRESS_SAMPLES,
+ *        and the pad still works once it is removed
+ */
+static int test_stuck(void) {
+    const int touches[][3] = {
+        { 100, 100 + 2 * TOUCH_MAX_PRESS_SAMPLES, 100 },
+        { 100 + 2 * TOUCH_MAX_PRESS_SAMPLES + 500, 100 + 2 * TOUCH_MAX_PRESS_SAMPLES + 600, 60 },
+    };
+    touch_t touch;
+    int nb_press = 0;
+    int nb_release = 0;
+    int release_at = -1;
+
+    make_trace(100 + 2 * TOUCH_MAX_PRESS_SAMPLES + 1000, 0, touches, 2);
+    touch_init(&touch, THRESHOLD);
+    for (int i = 0; i < trace.nb_samples; i++) {
+        button_event_t event = touch_process(&touch, trace.count[i]);
+        if (event == BUTTON_EVENT_PRESS) { nb_press++; }
+        if (event == BUTTON_EVENT_RELEASE) {
+            nb_release++;
+            if (release_at < 0) { release_at = i; }
+        }
+    }
+
+    CHECK(touch.nb_recalibrations == 1);
+    CHECK(release_at <= 100 + TOUCH_MAX_PRESS_SAMPLES + MAX_LATENCY);
+    CHECK(nb_press == 2);
+    CHECK(nb_release == 2);
+    CHECK(!touch.pressed);
+
+    return 0;
+}
+
+/**
+ * @brief Replay a trace file
+ */
+static int test_file(const char * path) {
+    FILE * f = fopen(path, "r");
+    unsigned count;
+    unsigned touched;
+    replay_t replay;
+
+    CHECK(f != NULL);
+    trace.nb_samples = 0;
+    while ((trace.nb_samples < MAX_SAMPLES) && (fscanf(f, "%u,%u", &count, &touched) == 2)) {
+        trace.count[trace.nb_samples] = count;
+        trace.touched[trace.nb_samples] = (touched != 0);
+        trace.nb_samples++;
+    }
+    fclose(f);
+    CHECK(trace.nb_samples > TOUCH_CALIBRATION_SAMPLES);
+
+    replay_trace(&replay);
+    printf("touch_filter: %s: %d samples, %d touches, %d press, %d release, max latency %d samples\n",
+           path, trace.nb_samples, replay.nb_touches, replay.nb_press, replay.nb_release, replay.max_latency);
+    CHECK(replay.nb_press == replay.nb_touches);
+    CHECK(replay.nb_missed == 0);
+
+    return 0;
+}
+
+/**
+ * @brief Filter throughput over two interleaved channels
+ */
+static void bench_throughput(void) {
+    touch_t touch[2];
+    uint32_t nb_events = 0;
+
+    make_trace(MAX_SAMPLES, THRESHOLD, NULL, 0);
+    touch_init(&touch[0], THRESHOLD);
+    touch_init(&touch[1], THRESHOLD);
+
+    uint64_t start = time_ns();
+    for (int i = 0; i < NB_BENCH_SAMPLES; i++) {
+        nb_events += touch_process(&touch[i & 1], trace.count[(i >> 1) % MAX_SAMPLES] + ((i & 0x3FFF) < 64 ? 100 : 0));
+    }
+    uint64_t elapsed = time_ns() - start;
+
+    printf("touch_filter: %.2f ns/sample, %.1f Msamples/s (%u events)\n",
+           (double)elapsed / NB_BENCH_SAMPLES, 1e3 * NB_BENCH_SAMPLES / (double)elapsed, nb_events);
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Main entry point
+ * @return int 0 on success
+ */
+int main(int argc, char ** argv)
+{
+    if (test_idle_drift()) { return 1; }
+    if (test_touches()) { return 1; }
+    if (test_spikes()) { return 1; }
+    if (test_stuck()) { return 1; }
+    for (int i = 1; i < argc; i++) {
+        if (test_file(argv[i])) { return 1; }
+    }
+
+    bench_throughput();
+
+    printf("touch_filter: PASS\n");
+    return 0;
+}
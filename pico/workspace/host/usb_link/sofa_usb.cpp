@@ -0,0 +1,135 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: sofa_usb.cpp
+-- Description: Control the sofa over its USB CDC interface: send commands,
+--              print the telemetry, measure the command round trip
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "usb_client.hpp"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define TIMEOUT_MS 1000
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+static void usage(const char * name) {
+    printf("usage: %s <device> [-m] [-b count] [command...]\n", name);
+    printf("  command   up, down, stop, or a command byte (0x81: Up, hold-to-run)\n");
+    printf("  -m        print the telemetry until interrupted\n");
+    printf("  -b count  round trip benchmark: count Stop frames, one at a time\n");
+}
+
+/**
+ * @brief Parse a command name or byte
+ * @return int The command byte, -1 if invalid
+ */
+static int parse_command(const char * text) {
+    if (strcmp(text, "up") == 0) { return 0x01; }
+    if (strcmp(text, "down") == 0) { return 0x02; }
+    if (strcmp(text, "stop") == 0) { return 0x00; }
+
+    char * end;
+    long value = strtol(text, &end, 0);
+    return ((*end == '\0') && (value >= 0) && (value <= 0xFF)) ? (int)value : -1;
+}
+
+static void print_telemetry(const protocol::Telemetry & telemetry) {
+    printf("#%u state 0x%02x endstop 0x%02x ack %u power %u uptime %u ms",
+           telemetry.sequence, telemetry.state, telemetry.endstop, telemetry.ack, telemetry.power, telemetry.uptime_ms);
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+int main(int argc, char ** argv) {
+    if ((argc < 2) || (argv[1][0] == '-')) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    usb_client_t client;
+    if (!usb_client_open(&client, argv[1])) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    // Current state, sent by the sofa when the port is opened
+    protocol::Telemetry telemetry;
+    if (usb_client_receive(&client, telemetry, TIMEOUT_MS) == 1) {
+        print_telemetry(telemetry);
+        printf("\n");
+    }
+
+    bool monitor = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-m") == 0) {
+            monitor = true;
+        }
+        else if ((strcmp(argv[i], "-b") == 0) && (i + 1 < argc)) {
+            usb_client_stats_t stats;
+            if (!usb_client_benchmark(&client, (uint32_t)atoi(argv[++i]), TIMEOUT_MS, &stats)) {
+                printf("%s: device error\n", argv[1]);
+                return 1;
+            }
+            printf("%u round trips: min %.3f ms, median %.3f ms, p99 %.3f ms, max %.3f ms, %u lost\n",
+                   stats.nb_sent, stats.min_ns / 1e6, stats.median_ns / 1e6, stats.p99_ns / 1e6, stats.max_ns / 1e6, stats.nb_lost);
+        }
+        else {
+            int command = parse_command(argv[i]);
+            if (command < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+
+            uint64_t round_trip_ns;
+            int status = usb_client_round_trip(&client, (uint8_t)command, TIMEOUT_MS, telemetry, &round_trip_ns);
+            if (status < 0) {
+                printf("%s: device error\n", argv[1]);
+                return 1;
+            }
+            if (status == 0) {
+                printf("command 0x%02x: no acknowledgement\n", command);
+                continue;
+            }
+            print_telemetry(telemetry);
+            printf(", round trip %.3f ms\n", round_trip_ns / 1e6);
+        }
+    }
+
+    while (monitor) {
+        int status = usb_client_receive(&client, telemetry, TIMEOUT_MS);
+        if (status < 0) { break; }
+        if (status == 0) { continue; }
+        print_telemetry(telemetry);
+        printf("\n");
+        fflush(stdout);
+    }
+
+    usb_client_close(&client);
+    return 0;
+}
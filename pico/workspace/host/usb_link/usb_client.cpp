@@ -0,0 +1,228 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: usb_client.cpp
+-- Description: Host side of the wired control channel: command frames and
+--              telemetry over a serial device (USB CDC or pty)
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "usb_client.hpp"
+
+extern "C" {
+#include "usb_link.h"
+}
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Decode the next telemetry frame already received
+ *
+ * @return bool true if a frame was decoded
+ */
+static bool decode_buffered(usb_client_t * client, protocol::Telemetry & telemetry) {
+    uint16_t pos = 0;
+    uint8_t size = 0;
+    const uint8_t * frame;
+    bool found = false;
+
+    while (!found && ((frame = usb_link_next_frame(client->rx, client->rx_len, &pos, &size, &client->nb_skipped)) != nullptr)) {
+        if (protocol::decode_telemetry(frame, size, telemetry) == protocol::Status::Ok) { found = true; }
+        else { client->nb_errors++; }
+    }
+
+    client->rx_len -= pos;
+    memmove(client->rx, &client->rx[pos], client->rx_len);
+    return found;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file usb_client.hpp
+ * @name usb_client_time_ns
+ */
+uint64_t usb_client_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @file usb_client.hpp
+ * @name usb_client_open
+ */
+bool usb_client_open(usb_client_t * client, const char * path) {
+    memset(client, 0, sizeof(usb_client_t));
+    client->fd = open(path, O_RDWR | O_NOCTTY);
+    if (client->fd < 0) { return false; }
+
+    // Raw bytes, reads return what is available
+    struct termios tio;
+    if (tcgetattr(client->fd, &tio) != 0) {
+        usb_client_close(client);
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(client->fd, TCSANOW, &tio) != 0) {
+        usb_client_close(client);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @file usb_client.hpp
+ * @name usb_client_close
+ */
+void usb_client_close(usb_client_t * client) {
+    if (client->fd >= 0) { close(client->fd); }
+    client->fd = -1;
+}
+
+/**
+ * @file usb_client.hpp
+ * @name usb_client_write
+ */
+bool usb_client_write(usb_client_t * client, const uint8_t * data, size_t size) {
+    while (size > 0) {
+        ssize_t len = write(client->fd, data, size);
+        if (len < 0) {
+            if (errno == EINTR) { continue; }
+            return false;
+        }
+        data += len;
+        size -= (size_t)len;
+    }
+    return true;
+}
+
+/**
+ * @file usb_client.hpp
+ * @name usb_client_send
+ */
+uint8_t usb_client_send(usb_client_t * client, uint8_t motion) {
+    uint8_t frame[protocol::kCommandSize];
+    uint8_t stream[USB_LINK_HEADER_SIZE + protocol::kCommandSize];
+
+    // 0 is the sequence number of the legacy commands
+    client->sequence = (uint8_t)((client->sequence % 255) + 1);
+    size_t size = protocol::encode_command(client->sequence, motion, frame, sizeof(frame));
+    uint16_t len = usb_link_wrap(frame, (uint8_t)size, stream);
+
+    return usb_client_write(client, stream, len) ? client->sequence : 0;
+}
+
+/**
+ * @file usb_client.hpp
+ * @name usb_client_receive
+ */
+int usb_client_receive(usb_client_t * client, protocol::Telemetry & telemetry, int timeout_ms) {
+    uint64_t deadline = usb_client_time_ns() + (uint64_t)timeout_ms * 1000000ULL;
+
+    while (!decode_buffered(client, telemetry)) {
+        uint64_t now = usb_client_time_ns();
+        if (now >= deadline) { return 0; }
+
+        struct pollfd fds = { client->fd, POLLIN, 0 };
+        int ready = poll(&fds, 1, (int)((deadline - now + 999999) / 1000000));
+        if (ready < 0) {
+            if (errno == EINTR) { continue; }
+            return -1;
+        }
+        if (ready == 0) { continue; }
+
+        ssize_t len = read(client->fd, &client->rx[client->rx_len], sizeof(client->rx) - client->rx_len);
+        if (len < 0) {
+            if ((errno == EINTR) || (errno == EAGAIN)) { continue; }
+            return -1;
+        }
+        if (len == 0) { return -1; }
+        client->rx_len += (uint16_t)len;
+    }
+
+    return 1;
+}
+
+/**
+ * @file usb_client.hpp
+ * @name usb_client_round_trip
+ */
+int usb_client_round_trip(usb_client_t * client, uint8_t motion, int timeout_ms, protocol::Telemetry & telemetry, uint64_t * round_trip_ns) {
+    uint64_t start = usb_client_time_ns();
+    uint8_t sequence = usb_client_send(client, motion);
+    if (sequence == 0) { return -1; }
+
+    // Telemetry sent for an older frame, or a relay change, is skipped
+    uint64_t deadline = start + (uint64_t)timeout_ms * 1000000ULL;
+    while (true) {
+        uint64_t now = usb_client_time_ns();
+        if (now >= deadline) { return 0; }
+        int status = usb_client_receive(client, telemetry, (int)((deadline - now + 999999) / 1000000));
+        if (status <= 0) { return status; }
+        if (telemetry.ack == sequence) { break; }
+    }
+
+    *round_trip_ns = usb_client_time_ns() - start;
+    return 1;
+}
+
+/**
+ * @file usb_client.hpp
+ * @name usb_client_benchmark
+ */
+bool usb_client_benchmark(usb_client_t * client, uint32_t count, int timeout_ms, usb_client_stats_t * stats) {
+    std::vector<uint64_t> round_trips;
+    round_trips.reserve(count);
+    memset(stats, 0, sizeof(usb_client_stats_t));
+
+    for (uint32_t i = 0; i < count; i++) {
+        protocol::Telemetry telemetry;
+        uint64_t round_trip_ns;
+        int status = usb_client_round_trip(client, 0x00, timeout_ms, telemetry, &round_trip_ns);
+        if (status < 0) { return false; }
+        stats->nb_sent++;
+        if (status == 0) { stats->nb_lost++; } else { round_trips.push_back(round_trip_ns); }
+    }
+
+    if (!round_trips.empty()) {
+        std::sort(round_trips.begin(), round_trips.end());
+        stats->min_ns = round_trips.front();
+        stats->median_ns = round_trips[round_trips.size() / 2];
+        stats->p99_ns = round_trips[std::min(round_trips.size() - 1, round_trips.size() * 99 / 100)];
+        stats->max_ns = round_trips.back();
+    }
+    return true;
+}
@@ -0,0 +1,141 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: usb_client.hpp
+-- Description: Host side of the wired control channel: command frames and
+--              telemetry over a serial device (USB CDC or pty)
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef USB_CLIENT_HPP
+#define USB_CLIENT_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "protocol.hpp"
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+/** @brief Receive buffer size, several telemetry frames */
+#define USB_CLIENT_RX_SIZE 256
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    int fd;                             /**> Serial device, -1 if closed */
+    uint8_t rx[USB_CLIENT_RX_SIZE];     /**> Received bytes not decoded yet */
+    uint16_t rx_len;                    /**> Number of bytes in rx */
+    uint8_t sequence;                   /**> Sequence number of the last command frame */
+    uint32_t nb_skipped;                /**> Bytes skipped to resynchronize */
+    uint32_t nb_errors;                 /**> Frames which are not telemetry */
+} usb_client_t;
+
+/** @brief Round trip statistics */
+typedef struct {
+    uint32_t nb_sent;   /**> Command frames sent */
+    uint32_t nb_lost;   /**> Frames not acknowledged in time */
+    uint64_t min_ns;    /**> Fastest round trip */
+    uint64_t median_ns; /**> Median round trip */
+    uint64_t p99_ns;    /**> 99th percentile */
+    uint64_t max_ns;    /**> Slowest round trip */
+} usb_client_stats_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Monotonic time
+ *
+ * @return uint64_t Time in nanoseconds
+ */
+uint64_t usb_client_time_ns(void);
+
+/**
+ * @brief Open the serial device in raw mode; opening sets DTR, so the sofa
+ *        sends its current telemetry
+ *
+ * @param client The client
+ * @param path The serial device (/dev/ttyACM0)
+ * @return bool true on success
+ */
+bool usb_client_open(usb_client_t * client, const char * path);
+
+/**
+ * @brief Close the serial device
+ *
+ * @param client The client
+ */
+void usb_client_close(usb_client_t * client);
+
+/**
+ * @brief Send raw stream bytes, for the tests
+ *
+ * @param client The client
+ * @param data The bytes
+ * @param size The number of bytes
+ * @return bool true if all the bytes were written
+ */
+bool usb_client_write(usb_client_t * client, const uint8_t * data, size_t size);
+
+/**
+ * @brief Send a command frame with the next sequence number (1 to 255)
+ *
+ * @param client The client
+ * @param motion The command byte
+ * @return uint8_t The frame sequence number, 0 on error
+ */
+uint8_t usb_client_send(usb_client_t * client, uint8_t motion);
+
+/**
+ * @brief Wait for the next telemetry frame
+ *
+ * @param client The client
+ * @param telemetry Output telemetry
+ * @param timeout_ms Timeout
+ * @return int 1 if a frame was received, 0 on timeout, -1 on error
+ */
+int usb_client_receive(usb_client_t * client, protocol::Telemetry & telemetry, int timeout_ms);
+
+/**
+ * @brief Send a command frame and wait for the telemetry acknowledging it
+ *
+ * @param client The client
+ * @param motion The command byte
+ * @param timeout_ms Timeout
+ * @param telemetry Output telemetry
+ * @param round_trip_ns Output time from the write to the acknowledgement
+ * @return int 1 if acknowledged, 0 on timeout, -1 on error
+ */
+int usb_client_round_trip(usb_client_t * client, uint8_t motion, int timeout_ms, protocol::Telemetry & telemetry, uint64_t * round_trip_ns);
+
+/**
+ * @brief Round trip benchmark: Stop frames, one at a time
+ *
+ * @param client The client
+ * @param count Number of frames
+ * @param timeout_ms Timeout of each frame
+ * @param stats Output statistics
+ * @return bool false on a device error
+ */
+bool usb_client_benchmark(usb_client_t * client, uint32_t count, int timeout_ms, usb_client_stats_t * stats);
+
+#endif // USB_CLIENT_HPP
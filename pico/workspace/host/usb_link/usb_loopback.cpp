@@ -0,0 +1,250 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: BLE Sofa Host Tests
+-- Version: 0.1.0
+-- File Name: usb_loopback.cpp
+-- Description: Wired control channel over a pty: the firmware link
+--              (usb_link.c) on the master side stands in for the USB CDC
+--              interface, the host client on the slave side
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+#include "protocol.hpp"
+#include "usb_client.hpp"
+
+extern "C" {
+#include "usb_link.h"
+#include "motion.h"
+#include "power.h"
+}
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define TIMEOUT_MS      1000
+#define NB_ROUND_TRIPS  2000
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+//----------------------------------------------------------------
+// Sofa stand-in
+//----------------------------------------------------------------
+
+/** @brief pty master: the device side of the CDC interface */
+static int master_fd = -1;
+
+/** @brief Firmware state behind the link */
+static motion_t motion;
+static power_manager_t power;
+static usb_link_t sofa_link;
+static uint32_t nb_activity = 0;
+
+/** @brief Stops the device thread */
+static std::atomic<bool> running(false);
+
+static void sofa_output(uint8_t relays, void * context) {
+    (void)relays;
+    (void)context;
+}
+
+static void sofa_command(uint8_t command) {
+    motion_command(&motion, command, MOTION_SOURCE_USB);
+}
+
+static void sofa_activity(void) {
+    nb_activity++;
+}
+
+static uint64_t sofa_time_us(void) {
+    return usb_client_time_ns() / 1000;
+}
+
+static bool sofa_write(const uint8_t * data, uint16_t size) {
+    return write(master_fd, data, size) == (ssize_t)size;
+}
+
+/**
+ * @brief Device thread: the bytes are read at most one bulk packet at a
+ *        time, as tud_cdc_read() does, then the motion worker runs
+ */
+static void sofa_run(void) {
+    usb_link_set_connected(&sofa_link, true);
+
+    while (running) {
+        struct pollfd fds = { master_fd, POLLIN, 0 };
+        if (poll(&fds, 1, 10) <= 0) { continue; }
+
+        uint16_t capacity;
+        uint8_t * buffer = usb_link_rx_buffer(&sofa_link, &capacity);
+        ssize_t len = read(master_fd, buffer, (capacity < USB_LINK_PACKET_SIZE) ? capacity : USB_LINK_PACKET_SIZE);
+        if (len <= 0) { continue; }
+
+        usb_link_received(&sofa_link, (uint16_t)len);
+        usb_link_update(&sofa_link);
+    }
+}
+
+//----------------------------------------------------------------
+// Static functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Check that no telemetry arrives for a while
+ */
+static bool no_telemetry(usb_client_t * client, int delay_ms) {
+    protocol::Telemetry telemetry;
+    return usb_client_receive(client, telemetry, delay_ms) == 0;
+}
+
+/**
+ * @brief Protocol over the stream: opening, command frames, legacy byte,
+ *        resynchronization, split and merged writes, rejected frames
+ */
+static int test_protocol(usb_client_t * client) {
+    protocol::Telemetry telemetry;
+    uint64_t round_trip_ns;
+
+    // Current state on opening
+    CHECK(usb_client_receive(client, telemetry, TIMEOUT_MS) == 1);
+    CHECK((telemetry.state == 0x00) && (telemetry.ack == 0));
+
+    // Command frame: applied and acknowledged
+    CHECK(usb_client_round_trip(client, 0x01, TIMEOUT_MS, telemetry, &round_trip_ns) == 1);
+    CHECK(telemetry.state == 0x01);
+
+    // Legacy byte: applied, the state change is sent
+    const uint8_t legacy[] = { USB_LINK_SYNC, 1, 0x00 };
+    CHECK(usb_client_write(client, legacy, sizeof(legacy)));
+    CHECK(usb_client_receive(client, telemetry, TIMEOUT_MS) == 1);
+    CHECK((telemetry.state == 0x00) && (telemetry.ack == 0));
+
+    // Noise before a frame, including a sync byte with an invalid size
+    uint8_t frame[protocol::kCommandSize];
+    uint8_t stream[64];
+    size_t len = 0;
+    const uint8_t noise[] = { 0x00, 0xFF, USB_LINK_SYNC, 0, USB_LINK_SYNC, USB_LINK_MAX_FRAME_SIZE + 1, 0x42 };
+    memcpy(stream, noise, sizeof(noise));
+    len = sizeof(noise);
+    size_t size = protocol::encode_command(0x10, 0x02, frame, sizeof(frame));
+    len += usb_link_wrap(frame, (uint8_t)size, &stream[len]);
+    CHECK(usb_client_write(client, stream, len));
+    CHECK(usb_client_receive(client, telemetry, TIMEOUT_MS) == 1);
+    CHECK((telemetry.ack == 0x10) && (telemetry.state == 0x02));
+
+    // One byte per write
+    size = protocol::encode_command(0x11, 0x00, frame, sizeof(frame));
+    len = usb_link_wrap(frame, (uint8_t)size, stream);
+    for (size_t i = 0; i < len; i++) {
+        CHECK(usb_client_write(client, &stream[i], 1));
+        usleep(2000);
+    }
+    CHECK(usb_client_receive(client, telemetry, TIMEOUT_MS) == 1);
+    CHECK((telemetry.ack == 0x11) && (telemetry.state == 0x00));
+
+    // Several frames in one write: each one is acknowledged
+    len = 0;
+    for (uint8_t sequence = 0x20; sequence < 0x24; sequence++) {
+        size = protocol::encode_command(sequence, 0x00, frame, sizeof(frame));
+        len += usb_link_wrap(frame, (uint8_t)size, &stream[len]);
+    }
+    CHECK(usb_client_write(client, stream, len));
+    for (uint8_t sequence = 0x20; sequence < 0x24; sequence++) {
+        CHECK(usb_client_receive(client, telemetry, TIMEOUT_MS) == 1);
+        CHECK(telemetry.ack == sequence);
+    }
+
+    // Frame of a newer version: rejected, not acknowledged
+    const uint8_t newer[] = { USB_LINK_SYNC, 5, protocol::kVersion + 1, 0x30, 0x01, 0x01, 0x01 };
+    CHECK(usb_client_write(client, newer, sizeof(newer)));
+    CHECK(no_telemetry(client, 50));
+
+    return 0;
+}
+
+/**
+ * @brief Command round trip through the pty and both ends of the link
+ */
+static int test_round_trip(usb_client_t * client) {
+    usb_client_stats_t stats;
+    CHECK(usb_client_benchmark(client, NB_ROUND_TRIPS, TIMEOUT_MS, &stats));
+    CHECK(stats.nb_sent == NB_ROUND_TRIPS);
+    CHECK(stats.nb_lost == 0);
+
+    printf("%u round trips: min %.1f us, median %.1f us, p99 %.1f us, max %.1f us\n",
+           stats.nb_sent, stats.min_ns / 1e3, stats.median_ns / 1e3, stats.p99_ns / 1e3, stats.max_ns / 1e3);
+    return 0;
+}
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+int main(void)
+{
+    master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((master_fd < 0) || (grantpt(master_fd) != 0) || (unlockpt(master_fd) != 0)) {
+        printf("usb_loopback: no pty available (%s)\n", strerror(errno));
+        return 1;
+    }
+
+    // The host opens the port first, as DTR tells the firmware
+    usb_client_t client;
+    if (!usb_client_open(&client, ptsname(master_fd))) {
+        printf("usb_loopback: cannot open %s (%s)\n", ptsname(master_fd), strerror(errno));
+        return 1;
+    }
+
+    motion_init(&motion, &sofa_output, NULL);
+    power_init(&power, 0);
+    usb_link_config_t config = {
+        &motion, &power, &sofa_command, &sofa_activity, &sofa_time_us, &sofa_write,
+    };
+    usb_link_init(&sofa_link, &config);
+    running = true;
+    std::thread sofa(sofa_run);
+
+    int status = test_protocol(&client);
+    if (status == 0) { status = test_round_trip(&client); }
+
+    running = false;
+    sofa.join();
+    usb_client_close(&client);
+    close(master_fd);
+    if (status != 0) { return status; }
+
+    // Firmware side counters
+    CHECK(sofa_link.nb_errors == 1);
+    CHECK(sofa_link.nb_skipped == 7);
+    CHECK(sofa_link.nb_frames == 1 + 1 + 1 + 1 + 4 + NB_ROUND_TRIPS);
+    CHECK(nb_activity == sofa_link.nb_frames + sofa_link.nb_errors);
+    CHECK(motion.nb_commands[MOTION_SOURCE_USB] == sofa_link.nb_frames);
+    CHECK(sofa_link.nb_tx_full == 0);
+
+    printf("usb_loopback: PASS\n");
+    return 0;
+}
@@ -26,7 +26,7 @@
 #include "hardware/gpio.h"
 #include "hardware/i2c.h"
 
-#include "ascii_bitmap.h"
+#include "oled_fb.h"
 
 //----------------------------------------------------------------
 // Constants
@@ -65,10 +65,6 @@ static const uint8_t SSD1306_I2C_ADDR = 0x3C;
 #define OLED_SET_CHARGE_PUMP        0x8D
 
 
-#define OLED_NB_DISPLAY_COL 128   // Number of display columns
-#define OLED_NB_DISPLAY_ROW  32   // Number of display rows
-#define OLED_NB_DISPLAY_PAGE  4   // Number of display memory pages
-
 #define OLED_CMD_DISPLAYON       0xAF // Display on command
 #define OLED_CMD_DISPLAYOFF      0xAE // Display off command
 
@@ -76,7 +72,7 @@ static const uint8_t SSD1306_I2C_ADDR = 0x3C;
 // Global variables
 //----------------------------------------------------------------
 
-uint16_t gddram[OLED_NB_DISPLAY_COL * OLED_NB_DISPLAY_ROW];
+oled_fb_t fb;
 
 //----------------------------------------------------------------
 // Static Functions
@@ -137,7 +133,7 @@ int oled_write_byte(i2c_inst_t *i2c, const uint addr, const uint8_t byte, const
  * @name oled_clear_buffer
  */
 int oled_clear_buffer(void) {
-  memset(gddram, 0x00, OLED_NB_DISPLAY_COL * OLED_NB_DISPLAY_PAGE);
+  oled_fb_clear(&fb);
 
   return 0;
 }
@@ -147,21 +143,16 @@ int oled_clear_buffer(void) {
  * @name oled_write_buffer
  */
 int oled_write_buffer(i2c_inst_t *i2c, const uint addr) {
-  for (int ipag = 0; ipag < OLED_NB_DISPLAY_PAGE; ipag++) {
-	// Set the page address
-	oled_write_byte(i2c, addr, 0x22, I2C_CMD);
-    oled_write_byte(i2c, addr, ipag, I2C_CMD);
+  uint8_t msg[OLED_FLUSH_PAGE_SIZE];
 
-	// Start at the left column
-	// - Lower nibble of column start address: 0x0<4 bits nibble>
-    oled_write_byte(i2c, addr, 0x00, I2C_CMD);
-	// - Higher nibble of column start address: 0x1<4 bits nibble>
-    oled_write_byte(i2c, addr, 0x10, I2C_CMD);
+  for (int ipag = 0; ipag < OLED_NB_DISPLAY_PAGE; ipag++) {
+    // Page address, left column, then this memory page of display data
+    size_t len = oled_fb_encode_page(&fb, ipag, msg);
 
-	// Copy this memory page of display data (horizontal increment)
-	for (int col = 0; col < OLED_NB_DISPLAY_COL; col++) {
-      oled_write_byte(i2c, addr, gddram[col + ipag*OLED_NB_DISPLAY_COL], I2C_DATA);
-	}
+    // One I2C transaction per command/data byte
+    for (size_t i = 0; i < len; i += 2) {
+      i2c_write_blocking(i2c, addr, &msg[i], 2, false);
+    }
   }
 
   return 0;
@@ -246,63 +237,14 @@ int oled_poweroff(i2c_inst_t *i2c, const uint addr) {
     return 0;
 }
 
-/**
- * @file oled_control.c
- * @name oled_set_pixel
- */
-int oled_set_pixel(uint32_t row, uint32_t col, uint16_t val) {
-  int page = row / 8;
-  uint8_t col_content = gddram[col + page*OLED_NB_DISPLAY_COL];
-  int pixel_pos = row - 8*page;
-
-  if (val) { col_content |= (0x01 << pixel_pos); }
-  else { col_content &= ~(0x01 << pixel_pos);	}
-
-  gddram[col + page*OLED_NB_DISPLAY_COL] = col_content;
-
-  return 0;
-}
-
-/**
- * @file oled_control.c
- * @name oled_set_pagecol
- */
-int oled_set_pagecol(uint32_t page, uint32_t col, uint8_t col_content) {
-  if ((page > OLED_NB_DISPLAY_PAGE) || (col > OLED_NB_DISPLAY_COL)) {
-	  return -1;
-  }
-
-  gddram[col + page*OLED_NB_DISPLAY_COL] = col_content;
-  return 0;
-}
-
-/**
- * @file oled_control.c
- * @name oled_write_letter
- */
-int oled_write_letter(int8_t letter, unsigned int page, unsigned int col) {
-  int status;
-
-  bitmap_char_t ascii_letter = ascii_bitmap_lut[letter];
-  for (int i=0; i<8; i++) {
-	status = oled_set_pagecol(page, col+i, ascii_letter.col[i]);
-	if (status != 0) { return status; }
-  }
-
-  return 0;
-}
-
 /**
  * @file oled_control.c
  * @name oled_write_str
  */
 int oled_write_str(i2c_inst_t *i2c, const uint addr, const char * str, unsigned int page) {
-	if ((str == NULL) || (page > OLED_NB_DISPLAY_PAGE)) { return -1; }
+  int status = oled_fb_write_str(&fb, str, page);
+  if (status != 0) { return status; }
 
-  for (int i=0; i<OLED_NB_DISPLAY_COL/8; i++) {
-	if (str[i] == '\0') { break; }
-	oled_write_letter(str[i], page, i*8);
-  }
   oled_write_buffer(i2c, addr);
 
   return 0;
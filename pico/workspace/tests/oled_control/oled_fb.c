@@ -0,0 +1,116 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: OLED Screen Test Application
+-- Version: 0.1.0
+-- File Name: oled_fb.c
+-- Description: SSD1306 128x32 frame buffer rendering and I2C flush encoding,
+--              independent from the I2C driver
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "oled_fb.h"
+#include "ascii_bitmap.h"
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @file oled_fb.h
+ * @name oled_fb_clear
+ */
+void oled_fb_clear(oled_fb_t * fb) {
+    memset(fb->gddram, 0x00, sizeof(fb->gddram));
+}
+
+/**
+ * @file oled_fb.h
+ * @name oled_fb_set_pixel
+ */
+int oled_fb_set_pixel(oled_fb_t * fb, uint32_t row, uint32_t col, bool val) {
+    if ((row >= OLED_NB_DISPLAY_ROW) || (col >= OLED_NB_DISPLAY_COL)) { return -1; }
+
+    uint8_t mask = (uint8_t)(0x01 << (row % 8));
+    uint8_t * col_content = &fb->gddram[col + (row / 8) * OLED_NB_DISPLAY_COL];
+    if (val) { *col_content |= mask; }
+    else { *col_content &= (uint8_t)~mask; }
+
+    return 0;
+}
+
+/**
+ * @file oled_fb.h
+ * @name oled_fb_set_pagecol
+ */
+int oled_fb_set_pagecol(oled_fb_t * fb, uint32_t page, uint32_t col, uint8_t col_content) {
+    if ((page >= OLED_NB_DISPLAY_PAGE) || (col >= OLED_NB_DISPLAY_COL)) { return -1; }
+
+    fb->gddram[col + page * OLED_NB_DISPLAY_COL] = col_content;
+    return 0;
+}
+
+/**
+ * @file oled_fb.h
+ * @name oled_fb_write_letter
+ */
+int oled_fb_write_letter(oled_fb_t * fb, char letter, uint32_t page, uint32_t col) {
+    if ((page >= OLED_NB_DISPLAY_PAGE) || (col + 8 > OLED_NB_DISPLAY_COL)) { return -1; }
+
+    const bitmap_char_t * ascii_letter = &ascii_bitmap_lut[(uint8_t)letter & 0x7F];
+    memcpy(&fb->gddram[col + page * OLED_NB_DISPLAY_COL], ascii_letter->col, 8);
+    return 0;
+}
+
+/**
+ * @file oled_fb.h
+ * @name oled_fb_write_str
+ */
+int oled_fb_write_str(oled_fb_t * fb, const char * str, uint32_t page) {
+    if ((str == NULL) || (page >= OLED_NB_DISPLAY_PAGE)) { return -1; }
+
+    for (uint32_t i = 0; i < OLED_NB_DISPLAY_COL / 8; i++) {
+        if (str[i] == '\0') { break; }
+        oled_fb_write_letter(fb, str[i], page, i * 8);
+    }
+
+    return 0;
+}
+
+/**
+ * @file oled_fb.h
+ * @name oled_fb_encode_page
+ */
+size_t oled_fb_encode_page(const oled_fb_t * fb, uint32_t page, uint8_t * out) {
+    if (page >= OLED_NB_DISPLAY_PAGE) { return 0; }
+
+    // Page address, then left column: lower nibble 0x0<n>, higher nibble 0x1<n>
+    const uint8_t cmds[OLED_FLUSH_PAGE_NB_CMDS] = { 0x22, (uint8_t)page, 0x00, 0x10 };
+    size_t n = 0;
+    for (int i = 0; i < OLED_FLUSH_PAGE_NB_CMDS; i++) {
+        out[n++] = OLED_I2C_CONTROL_CMD;
+        out[n++] = cmds[i];
+    }
+
+    // Page data (horizontal increment)
+    const uint8_t * data = &fb->gddram[page * OLED_NB_DISPLAY_COL];
+    for (int col = 0; col < OLED_NB_DISPLAY_COL; col++) {
+        out[n++] = OLED_I2C_CONTROL_DATA;
+        out[n++] = data[col];
+    }
+
+    return n;
+}
@@ -0,0 +1,125 @@
+/*--------------------------------------------------------------------------------
+--                          _               _       _
+--                         | |__ _ __ _ _ _| |_ ___| |
+--                         | / _` / _` | ' \  _/ -_) |
+--                         |_\__, \__,_|_||_\__\___|_|
+--                           |___/
+--
+----------------------------------------------------------------------------------
+--
+-- Company: LGANTEL
+-- Engineer: Laurent Gantel <laurent.gantel@gmail.com>
+--
+-- Project Name: OLED Screen Test Application
+-- Version: 0.1.0
+-- File Name: oled_fb.h
+-- Description: SSD1306 128x32 frame buffer rendering and I2C flush encoding,
+--              independent from the I2C driver
+--
+-- Last update: 2026-10-18
+--
+-------------------------------------------------------------------------------*/
+
+#ifndef OLED_FB_H
+#define OLED_FB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//----------------------------------------------------------------
+// Constants
+//----------------------------------------------------------------
+
+#define OLED_NB_DISPLAY_COL 128   // Number of display columns
+#define OLED_NB_DISPLAY_ROW  32   // Number of display rows
+#define OLED_NB_DISPLAY_PAGE  4   // Number of display memory pages
+
+/** @brief Frame buffer size, one byte per column and page */
+#define OLED_FB_SIZE (OLED_NB_DISPLAY_COL * OLED_NB_DISPLAY_PAGE)
+
+/** @brief I2C control byte of a single command (Co=1, D/C#=0) */
+#define OLED_I2C_CONTROL_CMD  0x80
+/** @brief I2C control byte of a single data byte (Co=0, D/C#=1) */
+#define OLED_I2C_CONTROL_DATA 0x40
+
+/** @brief Commands sent before the data of a page */
+#define OLED_FLUSH_PAGE_NB_CMDS 4
+/** @brief Encoded size of a page flush: 2-byte I2C transactions */
+#define OLED_FLUSH_PAGE_SIZE (2 * (OLED_FLUSH_PAGE_NB_CMDS + OLED_NB_DISPLAY_COL))
+
+//----------------------------------------------------------------
+// Types
+//----------------------------------------------------------------
+
+typedef struct {
+    uint8_t gddram[OLED_FB_SIZE];   /**> Display data, page after page */
+} oled_fb_t;
+
+//----------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------
+
+/**
+ * @brief Clear the frame buffer
+ *
+ * @param fb The frame buffer
+ */
+void oled_fb_clear(oled_fb_t * fb);
+
+/**
+ * @brief Set or clear one pixel
+ *
+ * @param fb The frame buffer
+ * @param row The pixel row
+ * @param col The pixel column
+ * @param val The pixel value
+ * @return int 0 on success, -1 if out of the display
+ */
+int oled_fb_set_pixel(oled_fb_t * fb, uint32_t row, uint32_t col, bool val);
+
+/**
+ * @brief Set the 8 pixels of a page column
+ *
+ * @param fb The frame buffer
+ * @param page The memory page
+ * @param col The column
+ * @param col_content The column pixels, bit 0 at the top
+ * @return int 0 on success, -1 if out of the display
+ */
+int oled_fb_set_pagecol(oled_fb_t * fb, uint32_t page, uint32_t col, uint8_t col_content);
+
+/**
+ * @brief Draw an 8x8 ASCII character
+ *
+ * @param fb The frame buffer
+ * @param letter The ASCII character
+ * @param page The memory page
+ * @param col The left column
+ * @return int 0 on success, -1 if out of the display
+ */
+int oled_fb_write_letter(oled_fb_t * fb, char letter, uint32_t page, uint32_t col);
+
+/**
+ * @brief Draw a string on a page, at most 16 characters
+ *
+ * @param fb The frame buffer
+ * @param str The string
+ * @param page The memory page
+ * @return int 0 on success, -1 on error
+ */
+int oled_fb_write_str(oled_fb_t * fb, const char * str, uint32_t page);
+
+/**
+ * @brief Encode the flush of one page as the sequence of 2-byte I2C
+ *        transactions sent to the SSD1306: page address, column start,
+ *        then the page data
+ *
+ * @param fb The frame buffer
+ * @param page The memory page
+ * @param out Output buffer of OLED_FLUSH_PAGE_SIZE bytes
+ * @return size_t Encoded size, 0 if the page is out of the display
+ */
+size_t oled_fb_encode_page(const oled_fb_t * fb, uint32_t page, uint8_t * out);
+
+#endif // OLED_FB_H